@@ -0,0 +1,630 @@
+/**
+ * Asynchronous I/O Engine Implementation
+ * aio_engine.c
+ *
+ * 异步I/O引擎实现 - io_uring（原始系统调用）+ 工作线程池后备
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // syscall()
+#endif
+
+#include "aio_engine.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define AIO_HAVE_URING 1
+#endif
+#endif
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+/**
+ * 请求槽（每个进行中的I/O请求占用一个）
+ */
+typedef struct {
+    uint64_t        user_data;      // 调用方标记
+    uint64_t        offset;         // 文件偏移
+    struct iovec    iov;            // 数据缓冲区
+    uint8_t         is_write;       // 是否为写请求
+} aio_slot_t;
+
+struct aio_engine {
+    int             fd;             // 目标文件描述符
+    uint32_t        depth;          // 最大未回收请求数
+    aio_backend_t   backend;        // 实际使用的后端
+    uint32_t        outstanding;    // 已提交未回收的请求数
+
+    pthread_mutex_t lock;           // 保护以下所有字段
+    pthread_cond_t  done_cond;      // 有新的完成事件
+
+    aio_slot_t      *slots;         // 请求槽数组（depth个）
+    uint32_t        *free_slots;    // 空闲槽栈
+    uint32_t        free_count;
+
+    aio_engine_event_t *done;       // 已完成事件环形队列（depth个）
+    uint32_t        done_head;
+    uint32_t        done_count;
+
+    /* 线程池后端 */
+    uint32_t        *pending;       // 等待工作线程处理的槽环形队列
+    uint32_t        pending_head;
+    uint32_t        pending_count;
+    pthread_cond_t  work_cond;      // 有新的待处理请求
+    pthread_t       workers[AIO_ENGINE_WORKERS];
+    int             worker_count;
+    int             stopping;
+
+#ifdef AIO_HAVE_URING
+    /* io_uring后端 */
+    int             ring_fd;
+    void            *sq_ring;
+    void            *cq_ring;
+    size_t          sq_ring_size;
+    size_t          cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t          sqes_size;
+    unsigned        *sq_head;
+    unsigned        *sq_tail;
+    unsigned        *sq_mask;
+    unsigned        *sq_array;
+    unsigned        *cq_head;
+    unsigned        *cq_tail;
+    unsigned        *cq_mask;
+    struct io_uring_cqe *cqes;
+    uint32_t        to_submit;      // 已放入提交队列但尚未通知内核的请求数
+#endif
+};
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 分配请求槽（调用方持有锁）
+ */
+static uint32_t slot_alloc(aio_engine_t *engine) {
+    return engine->free_slots[--engine->free_count];
+}
+
+/**
+ * 释放请求槽（调用方持有锁）
+ */
+static void slot_free(aio_engine_t *engine, uint32_t slot) {
+    engine->free_slots[engine->free_count++] = slot;
+}
+
+/**
+ * 追加完成事件（调用方持有锁）
+ */
+static void push_done(aio_engine_t *engine, const aio_slot_t *slot, int64_t result) {
+    uint32_t tail = (engine->done_head + engine->done_count) % engine->depth;
+    engine->done[tail].user_data = slot->user_data;
+    engine->done[tail].result = result;
+    engine->done[tail].buf = slot->iov.iov_base;
+    engine->done[tail].length = slot->iov.iov_len;
+    engine->done[tail].offset = slot->offset;
+    engine->done[tail].is_write = slot->is_write;
+    engine->done_count++;
+    pthread_cond_broadcast(&engine->done_cond);
+}
+
+/**
+ * 同步执行一个请求（处理部分读写）
+ */
+static int64_t do_sync_io(int fd, const aio_slot_t *slot) {
+    char *buf = (char *)slot->iov.iov_base;
+    size_t done = 0;
+
+    while (done < slot->iov.iov_len) {
+        ssize_t n = slot->is_write
+            ? pwrite(fd, buf + done, slot->iov.iov_len - done, (off_t)(slot->offset + done))
+            : pread(fd, buf + done, slot->iov.iov_len - done, (off_t)(slot->offset + done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+
+    return (int64_t)done;
+}
+
+/*==============================================================================
+ * 线程池后端
+ *============================================================================*/
+
+/**
+ * 工作线程：取出待处理请求并同步执行
+ */
+static void *worker_main(void *arg) {
+    aio_engine_t *engine = (aio_engine_t *)arg;
+
+    pthread_mutex_lock(&engine->lock);
+    for (;;) {
+        while (engine->pending_count == 0 && !engine->stopping) {
+            pthread_cond_wait(&engine->work_cond, &engine->lock);
+        }
+        if (engine->pending_count == 0) {
+            break;
+        }
+
+        uint32_t slot_id = engine->pending[engine->pending_head];
+        engine->pending_head = (engine->pending_head + 1) % engine->depth;
+        engine->pending_count--;
+        aio_slot_t slot = engine->slots[slot_id];
+
+        pthread_mutex_unlock(&engine->lock);
+        int64_t result = do_sync_io(engine->fd, &slot);
+        pthread_mutex_lock(&engine->lock);
+
+        slot_free(engine, slot_id);
+        push_done(engine, &slot, result);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    return NULL;
+}
+
+/**
+ * 启动工作线程
+ */
+static int threads_setup(aio_engine_t *engine) {
+    engine->pending = (uint32_t *)calloc(engine->depth, sizeof(uint32_t));
+    if (!engine->pending) {
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i < AIO_ENGINE_WORKERS; i++) {
+        if (pthread_create(&engine->workers[i], NULL, worker_main, engine) != 0) {
+            break;
+        }
+        engine->worker_count++;
+    }
+
+    return engine->worker_count > 0 ? 0 : -EAGAIN;
+}
+
+/**
+ * 停止工作线程（待处理请求会先执行完）
+ */
+static void threads_teardown(aio_engine_t *engine) {
+    pthread_mutex_lock(&engine->lock);
+    engine->stopping = 1;
+    pthread_cond_broadcast(&engine->work_cond);
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int i = 0; i < engine->worker_count; i++) {
+        pthread_join(engine->workers[i], NULL);
+    }
+}
+
+/*==============================================================================
+ * io_uring后端
+ *============================================================================*/
+
+#ifdef AIO_HAVE_URING
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+/**
+ * 创建io_uring并映射提交/完成队列
+ */
+static int uring_setup(aio_engine_t *engine) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    engine->ring_fd = sys_io_uring_setup(engine->depth, &params);
+    if (engine->ring_fd < 0) {
+        return -errno;
+    }
+
+    engine->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    engine->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // 新内核中提交队列和完成队列共用一次映射
+    int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        if (engine->cq_ring_size > engine->sq_ring_size) {
+            engine->sq_ring_size = engine->cq_ring_size;
+        }
+        engine->cq_ring_size = engine->sq_ring_size;
+    }
+
+    engine->sq_ring = mmap(NULL, engine->sq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, engine->ring_fd, IORING_OFF_SQ_RING);
+    if (engine->sq_ring == MAP_FAILED) {
+        engine->sq_ring = NULL;
+        return -errno;
+    }
+
+    if (single_mmap) {
+        engine->cq_ring = engine->sq_ring;
+    } else {
+        engine->cq_ring = mmap(NULL, engine->cq_ring_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, engine->ring_fd, IORING_OFF_CQ_RING);
+        if (engine->cq_ring == MAP_FAILED) {
+            engine->cq_ring = NULL;
+            return -errno;
+        }
+    }
+
+    engine->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    engine->sqes = (struct io_uring_sqe *)mmap(NULL, engine->sqes_size, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED, engine->ring_fd, IORING_OFF_SQES);
+    if (engine->sqes == MAP_FAILED) {
+        engine->sqes = NULL;
+        return -errno;
+    }
+
+    char *sq = (char *)engine->sq_ring;
+    char *cq = (char *)engine->cq_ring;
+    engine->sq_head = (unsigned *)(sq + params.sq_off.head);
+    engine->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    engine->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    engine->sq_array = (unsigned *)(sq + params.sq_off.array);
+    engine->cq_head = (unsigned *)(cq + params.cq_off.head);
+    engine->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    engine->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    engine->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+/**
+ * 释放io_uring资源
+ */
+static void uring_teardown(aio_engine_t *engine) {
+    if (engine->sqes) {
+        munmap(engine->sqes, engine->sqes_size);
+    }
+    if (engine->cq_ring && engine->cq_ring != engine->sq_ring) {
+        munmap(engine->cq_ring, engine->cq_ring_size);
+    }
+    if (engine->sq_ring) {
+        munmap(engine->sq_ring, engine->sq_ring_size);
+    }
+    if (engine->ring_fd >= 0) {
+        close(engine->ring_fd);
+    }
+}
+
+/**
+ * 将请求放入提交队列（调用方持有锁）
+ */
+static void uring_queue(aio_engine_t *engine, uint32_t slot_id) {
+    aio_slot_t *slot = &engine->slots[slot_id];
+    unsigned tail = *engine->sq_tail;
+    unsigned index = tail & *engine->sq_mask;
+
+    struct io_uring_sqe *sqe = &engine->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = slot->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = engine->fd;
+    sqe->addr = (uint64_t)(uintptr_t)&slot->iov;
+    sqe->len = 1;
+    sqe->off = slot->offset;
+    sqe->user_data = slot_id;
+
+    engine->sq_array[index] = index;
+    __atomic_store_n(engine->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    engine->to_submit++;
+}
+
+/**
+ * 收取内核已完成的请求（调用方持有锁）
+ */
+static void uring_harvest(aio_engine_t *engine) {
+    unsigned head = *engine->cq_head;
+    unsigned tail = __atomic_load_n(engine->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &engine->cqes[head & *engine->cq_mask];
+        uint32_t slot_id = (uint32_t)cqe->user_data;
+        aio_slot_t *slot = &engine->slots[slot_id];
+
+        push_done(engine, slot, cqe->res);
+        slot_free(engine, slot_id);
+        head++;
+    }
+
+    __atomic_store_n(engine->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * 通知内核处理已排队的请求，可选等待完成（调用方持有锁）
+ */
+static int uring_enter(aio_engine_t *engine, unsigned min_complete) {
+    unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+
+    for (;;) {
+        int ret = sys_io_uring_enter(engine->ring_fd, engine->to_submit, min_complete, flags);
+        if (ret >= 0) {
+            engine->to_submit -= (uint32_t)ret < engine->to_submit ? (uint32_t)ret : engine->to_submit;
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+#endif /* AIO_HAVE_URING */
+
+/*==============================================================================
+ * 异步I/O引擎操作实现
+ *============================================================================*/
+
+/**
+ * 创建异步I/O引擎
+ */
+aio_engine_t* aio_engine_create(int fd, uint32_t depth, aio_backend_t backend) {
+    if (fd < 0 || depth == 0) {
+        return NULL;
+    }
+
+    aio_engine_t *engine = (aio_engine_t *)calloc(1, sizeof(aio_engine_t));
+    if (!engine) {
+        return NULL;
+    }
+
+    engine->fd = fd;
+    engine->depth = depth;
+    engine->slots = (aio_slot_t *)calloc(depth, sizeof(aio_slot_t));
+    engine->free_slots = (uint32_t *)calloc(depth, sizeof(uint32_t));
+    engine->done = (aio_engine_event_t *)calloc(depth, sizeof(aio_engine_event_t));
+    if (!engine->slots || !engine->free_slots || !engine->done) {
+        free(engine->slots);
+        free(engine->free_slots);
+        free(engine->done);
+        free(engine);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < depth; i++) {
+        engine->free_slots[i] = depth - 1 - i;
+    }
+    engine->free_count = depth;
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->done_cond, NULL);
+    pthread_cond_init(&engine->work_cond, NULL);
+
+    // 优先尝试io_uring，不可用时（内核过旧或被禁用）退回线程池
+    int result = -ENOSYS;
+#ifdef AIO_HAVE_URING
+    engine->ring_fd = -1;
+    if (backend != AIO_BACKEND_THREADS) {
+        result = uring_setup(engine);
+        if (result == 0) {
+            engine->backend = AIO_BACKEND_URING;
+        } else {
+            uring_teardown(engine);
+            engine->sq_ring = engine->cq_ring = NULL;
+            engine->sqes = NULL;
+            engine->ring_fd = -1;
+        }
+    }
+#endif
+
+    if (result != 0 && backend != AIO_BACKEND_URING) {
+        result = threads_setup(engine);
+        if (result == 0) {
+            engine->backend = AIO_BACKEND_THREADS;
+        }
+    }
+
+    if (result != 0) {
+        aio_engine_destroy(engine);
+        return NULL;
+    }
+
+    return engine;
+}
+
+/**
+ * 销毁异步I/O引擎
+ */
+void aio_engine_destroy(aio_engine_t *engine) {
+    if (!engine) {
+        return;
+    }
+
+#ifdef AIO_HAVE_URING
+    if (engine->backend == AIO_BACKEND_URING) {
+        // 等待内核中的请求完成后再释放缓冲区相关资源
+        pthread_mutex_lock(&engine->lock);
+        while (engine->free_count < engine->depth) {
+            if (uring_enter(engine, engine->to_submit ? 0 : 1) != 0) {
+                break;
+            }
+            uring_harvest(engine);
+        }
+        pthread_mutex_unlock(&engine->lock);
+    }
+    uring_teardown(engine);
+#endif
+
+    if (engine->backend == AIO_BACKEND_THREADS) {
+        threads_teardown(engine);
+    }
+
+    pthread_cond_destroy(&engine->work_cond);
+    pthread_cond_destroy(&engine->done_cond);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine->pending);
+    free(engine->slots);
+    free(engine->free_slots);
+    free(engine->done);
+    free(engine);
+}
+
+/**
+ * 提交读写请求
+ */
+int aio_engine_submit(aio_engine_t *engine, int is_write, void *buf, size_t len,
+                      uint64_t offset, uint64_t user_data) {
+    if (!engine || !buf || len == 0) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+
+    if (engine->outstanding >= engine->depth) {
+        pthread_mutex_unlock(&engine->lock);
+        return -EAGAIN;
+    }
+
+    uint32_t slot_id = slot_alloc(engine);
+    aio_slot_t *slot = &engine->slots[slot_id];
+    slot->user_data = user_data;
+    slot->offset = offset;
+    slot->iov.iov_base = buf;
+    slot->iov.iov_len = len;
+    slot->is_write = (uint8_t)(is_write != 0);
+    engine->outstanding++;
+
+#ifdef AIO_HAVE_URING
+    if (engine->backend == AIO_BACKEND_URING) {
+        uring_queue(engine, slot_id);
+        pthread_mutex_unlock(&engine->lock);
+        return 0;
+    }
+#endif
+
+    uint32_t tail = (engine->pending_head + engine->pending_count) % engine->depth;
+    engine->pending[tail] = slot_id;
+    engine->pending_count++;
+    pthread_cond_signal(&engine->work_cond);
+
+    pthread_mutex_unlock(&engine->lock);
+    return 0;
+}
+
+/**
+ * 投递已完成的请求
+ */
+int aio_engine_complete(aio_engine_t *engine, int is_write, int64_t result,
+                        uint64_t user_data) {
+    if (!engine) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+
+    if (engine->outstanding >= engine->depth) {
+        pthread_mutex_unlock(&engine->lock);
+        return -EAGAIN;
+    }
+
+    // 立即完成的请求没有缓冲区
+    aio_slot_t slot = {0};
+    slot.user_data = user_data;
+    slot.iov.iov_len = result > 0 ? (size_t)result : 0;
+    slot.is_write = (uint8_t)(is_write != 0);
+
+    engine->outstanding++;
+    push_done(engine, &slot, result);
+
+    pthread_mutex_unlock(&engine->lock);
+    return 0;
+}
+
+/**
+ * 回收完成事件
+ */
+int aio_engine_reap(aio_engine_t *engine, aio_engine_event_t *events,
+                    int max_events, int min_events) {
+    if (!engine || !events || max_events <= 0) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+
+    uint32_t wanted = min_events > 0 ? (uint32_t)min_events : 0;
+    if (wanted > (uint32_t)max_events) {
+        wanted = (uint32_t)max_events;
+    }
+    if (wanted > engine->outstanding) {
+        wanted = engine->outstanding;
+    }
+
+#ifdef AIO_HAVE_URING
+    if (engine->backend == AIO_BACKEND_URING) {
+        // 一次系统调用提交所有排队请求，并在需要时等待完成
+        uring_harvest(engine);
+        while (engine->to_submit > 0 || engine->done_count < wanted) {
+            unsigned need = engine->done_count < wanted ? 1 : 0;
+            int result = uring_enter(engine, need);
+            if (result != 0) {
+                pthread_mutex_unlock(&engine->lock);
+                return result;
+            }
+            uring_harvest(engine);
+        }
+    }
+#endif
+
+    while (engine->done_count < wanted) {
+        pthread_cond_wait(&engine->done_cond, &engine->lock);
+    }
+
+    int count = 0;
+    while (count < max_events && engine->done_count > 0) {
+        events[count++] = engine->done[engine->done_head];
+        engine->done_head = (engine->done_head + 1) % engine->depth;
+        engine->done_count--;
+        engine->outstanding--;
+    }
+
+    pthread_mutex_unlock(&engine->lock);
+    return count;
+}
+
+/**
+ * 获取未回收请求数
+ */
+uint32_t aio_engine_outstanding(aio_engine_t *engine) {
+    if (!engine) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    uint32_t outstanding = engine->outstanding;
+    pthread_mutex_unlock(&engine->lock);
+    return outstanding;
+}
+
+/**
+ * 获取后端名称
+ */
+const char* aio_engine_backend_name(const aio_engine_t *engine) {
+    if (!engine) {
+        return "none";
+    }
+    return engine->backend == AIO_BACKEND_URING ? "io_uring" : "threads";
+}
@@ -0,0 +1,127 @@
+/**
+ * Asynchronous I/O Engine Header
+ * aio_engine.h
+ *
+ * Asynchronous positional I/O on a single file descriptor, used by the
+ * disk simulator's disk_aio_*() API. Requests are submitted with an opaque
+ * user_data tag and reaped later as completion events.
+ *
+ * Two backends are provided:
+ *   - io_uring, driven through the raw io_uring_setup/io_uring_enter
+ *     system calls (no liburing dependency)
+ *   - a small pool of worker threads doing pread()/pwrite(), used when
+ *     io_uring is unavailable or explicitly requested
+ *
+ * The engine knows nothing about blocks: callers pass byte offsets and
+ * lengths. All entry points are serialized by an internal lock.
+ */
+
+#ifndef _AIO_ENGINE_H_
+#define _AIO_ENGINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============================================================================
+ * AIO ENGINE CONSTANTS
+ *============================================================================*/
+
+#define AIO_ENGINE_WORKERS      4           // Worker threads in the fallback backend
+
+/**
+ * Backend selection
+ */
+typedef enum {
+    AIO_BACKEND_AUTO        = 0,    // io_uring if available, else threads
+    AIO_BACKEND_URING       = 1,    // io_uring only
+    AIO_BACKEND_THREADS     = 2     // Worker thread pool only
+} aio_backend_t;
+
+/*==============================================================================
+ * DATA STRUCTURES
+ *============================================================================*/
+
+/**
+ * Completion Event Structure
+ */
+typedef struct {
+    uint64_t    user_data;          // Tag given at submission
+    int64_t     result;             // Bytes transferred, or -errno on failure
+    void        *buf;               // Buffer given at submission (NULL if completed immediately)
+    size_t      length;             // Bytes requested
+    uint64_t    offset;             // File offset given at submission
+    uint8_t     is_write;           // Request was a write
+} aio_engine_event_t;
+
+/* Engine internals live in aio_engine.c */
+typedef struct aio_engine aio_engine_t;
+
+/*==============================================================================
+ * AIO ENGINE OPERATIONS
+ *============================================================================*/
+
+/**
+ * Create an engine
+ *
+ * @param fd File descriptor all requests are issued against
+ * @param depth Maximum number of requests submitted but not yet reaped
+ * @param backend Backend to use (AIO_BACKEND_AUTO picks the best available)
+ * @return New engine, or NULL if the backend could not be set up
+ */
+aio_engine_t* aio_engine_create(int fd, uint32_t depth, aio_backend_t backend);
+
+/**
+ * Destroy an engine
+ *
+ * Waits for requests still in flight; their completions are discarded.
+ */
+void aio_engine_destroy(aio_engine_t *engine);
+
+/**
+ * Queue a read or write
+ *
+ * The buffer must stay valid until the request is reaped. With io_uring,
+ * queued requests are handed to the kernel on the next aio_engine_reap()
+ * call, so many requests can be issued with a single system call.
+ *
+ * @return 0 on success, -EAGAIN if depth requests are outstanding,
+ *         other negative errno on failure
+ */
+int aio_engine_submit(aio_engine_t *engine, int is_write, void *buf, size_t len,
+                      uint64_t offset, uint64_t user_data);
+
+/**
+ * Post an already completed request
+ *
+ * Used for requests the caller satisfied without I/O (e.g. from a cache) so
+ * that they are still reported through aio_engine_reap() in the usual way.
+ * The event's length is taken to be `result` (0 if negative).
+ *
+ * @return 0 on success, -EAGAIN if depth requests are outstanding
+ */
+int aio_engine_complete(aio_engine_t *engine, int is_write, int64_t result,
+                        uint64_t user_data);
+
+/**
+ * Reap completion events
+ *
+ * Submits any queued requests, then waits until at least `min_events`
+ * events are available (capped at the number outstanding) and returns up
+ * to `max_events` of them.
+ *
+ * @return Number of events stored, or negative errno on failure
+ */
+int aio_engine_reap(aio_engine_t *engine, aio_engine_event_t *events,
+                    int max_events, int min_events);
+
+/**
+ * Number of requests submitted but not yet reaped
+ */
+uint32_t aio_engine_outstanding(aio_engine_t *engine);
+
+/**
+ * Name of the active backend ("io_uring" or "threads")
+ */
+const char* aio_engine_backend_name(const aio_engine_t *engine);
+
+#endif /* _AIO_ENGINE_H_ */
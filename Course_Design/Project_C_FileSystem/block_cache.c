@@ -0,0 +1,391 @@
+/**
+ * Block Cache Implementation
+ * block_cache.c
+ *
+ * 块缓存实现 - 哈希表定位 + LRU替换 + 脏块回写
+ */
+
+#include "block_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 计算块号的哈希桶
+ */
+static uint32_t cache_bucket(const block_cache_t *cache, uint64_t block_num) {
+    return (uint32_t)((block_num * 0x9E3779B97F4A7C15ULL) >> 32) & cache->bucket_mask;
+}
+
+/**
+ * 在哈希表中查找条目
+ */
+static block_cache_entry_t* cache_find(const block_cache_t *cache, uint64_t block_num) {
+    block_cache_entry_t *entry = cache->buckets[cache_bucket(cache, block_num)];
+    while (entry) {
+        if (entry->block_num == block_num) {
+            return entry;
+        }
+        entry = entry->hash_next;
+    }
+    return NULL;
+}
+
+/**
+ * 从LRU链表中摘除条目
+ */
+static void lru_unlink(block_cache_t *cache, block_cache_entry_t *entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+/**
+ * 将条目放到LRU链表头部（最近使用）
+ */
+static void lru_push_front(block_cache_t *cache, block_cache_entry_t *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    } else {
+        cache->lru_tail = entry;
+    }
+    cache->lru_head = entry;
+}
+
+/**
+ * 从哈希桶中摘除条目
+ */
+static void hash_unlink(block_cache_t *cache, block_cache_entry_t *entry) {
+    block_cache_entry_t **link = &cache->buckets[cache_bucket(cache, entry->block_num)];
+    while (*link) {
+        if (*link == entry) {
+            *link = entry->hash_next;
+            break;
+        }
+        link = &(*link)->hash_next;
+    }
+    entry->hash_next = NULL;
+}
+
+/**
+ * 释放条目回空闲链表
+ */
+static void cache_release(block_cache_t *cache, block_cache_entry_t *entry) {
+    hash_unlink(cache, entry);
+    lru_unlink(cache, entry);
+    if (entry->dirty) {
+        cache->dirty_count--;
+    }
+    if (entry->prefetched) {
+        cache->prefetch_wasted++;
+    }
+    entry->valid = 0;
+    entry->dirty = 0;
+    entry->prefetched = 0;
+    entry->hash_next = cache->free_list;
+    cache->free_list = entry;
+    cache->count--;
+}
+
+/**
+ * 获取一个可用条目，必要时淘汰最久未使用的块
+ */
+static int cache_get_free_entry(block_cache_t *cache, block_cache_entry_t **out) {
+    if (!cache->free_list) {
+        block_cache_entry_t *victim = cache->lru_tail;
+        if (victim->dirty) {
+            const char *data = victim->data;
+            int result = cache->writeback(cache->writeback_ctx, victim->block_num, 1, &data);
+            if (result != 0) {
+                return result;
+            }
+        }
+        cache_release(cache, victim);
+    }
+
+    *out = cache->free_list;
+    cache->free_list = (*out)->hash_next;
+    (*out)->hash_next = NULL;
+    return 0;
+}
+
+/**
+ * 按块号排序比较函数
+ */
+static int compare_entries(const void *a, const void *b) {
+    const block_cache_entry_t *ea = *(const block_cache_entry_t *const *)a;
+    const block_cache_entry_t *eb = *(const block_cache_entry_t *const *)b;
+    if (ea->block_num < eb->block_num) return -1;
+    if (ea->block_num > eb->block_num) return 1;
+    return 0;
+}
+
+/*==============================================================================
+ * 块缓存操作实现
+ *============================================================================*/
+
+/**
+ * 创建块缓存
+ */
+block_cache_t* block_cache_create(uint32_t capacity, uint32_t block_size,
+                                  block_cache_writeback_fn writeback, void *ctx) {
+    if (capacity == 0 || block_size == 0 || !writeback) {
+        return NULL;
+    }
+
+    block_cache_t *cache = (block_cache_t *)calloc(1, sizeof(block_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+
+    // 哈希桶数量取不小于容量两倍的2的幂
+    uint32_t bucket_count = 1;
+    while (bucket_count < capacity * 2) {
+        bucket_count <<= 1;
+    }
+
+    cache->entries = (block_cache_entry_t *)calloc(capacity, sizeof(block_cache_entry_t));
+    cache->data = (char *)malloc((size_t)capacity * block_size);
+    cache->buckets = (block_cache_entry_t **)calloc(bucket_count, sizeof(block_cache_entry_t *));
+    if (!cache->entries || !cache->data || !cache->buckets) {
+        block_cache_destroy(cache);
+        return NULL;
+    }
+
+    cache->capacity = capacity;
+    cache->block_size = block_size;
+    cache->bucket_mask = bucket_count - 1;
+    cache->writeback = writeback;
+    cache->writeback_ctx = ctx;
+
+    // 所有条目初始都在空闲链表中
+    for (uint32_t i = 0; i < capacity; i++) {
+        cache->entries[i].data = cache->data + (size_t)i * block_size;
+        cache->entries[i].hash_next = (i + 1 < capacity) ? &cache->entries[i + 1] : NULL;
+    }
+    cache->free_list = &cache->entries[0];
+
+    return cache;
+}
+
+/**
+ * 销毁块缓存
+ */
+void block_cache_destroy(block_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+    free(cache->entries);
+    free(cache->data);
+    free(cache->buckets);
+    free(cache);
+}
+
+/**
+ * 查找块
+ */
+int block_cache_lookup(block_cache_t *cache, uint64_t block_num, char *buffer) {
+    block_cache_entry_t *entry = cache_find(cache, block_num);
+    if (!entry) {
+        return 0;
+    }
+
+    memcpy(buffer, entry->data, cache->block_size);
+    if (entry->prefetched) {
+        entry->prefetched = 0;
+        cache->prefetch_hits++;
+    }
+    lru_unlink(cache, entry);
+    lru_push_front(cache, entry);
+    return 1;
+}
+
+/**
+ * 插入或更新块
+ */
+int block_cache_insert(block_cache_t *cache, uint64_t block_num,
+                       const char *data, int dirty) {
+    block_cache_entry_t *entry = cache_find(cache, block_num);
+
+    if (entry) {
+        lru_unlink(cache, entry);
+        if (entry->prefetched) {
+            entry->prefetched = 0;
+            cache->prefetch_wasted++;
+        }
+    } else {
+        int result = cache_get_free_entry(cache, &entry);
+        if (result != 0) {
+            return result;
+        }
+        entry->block_num = block_num;
+        entry->valid = 1;
+        entry->dirty = 0;
+
+        uint32_t bucket = cache_bucket(cache, block_num);
+        entry->hash_next = cache->buckets[bucket];
+        cache->buckets[bucket] = entry;
+        cache->count++;
+    }
+
+    memcpy(entry->data, data, cache->block_size);
+    if (dirty && !entry->dirty) {
+        entry->dirty = 1;
+        cache->dirty_count++;
+    }
+    lru_push_front(cache, entry);
+
+    return 0;
+}
+
+/**
+ * 读未命中后填充块
+ */
+int block_cache_fill(block_cache_t *cache, uint64_t block_num, const char *data) {
+    if (cache_find(cache, block_num)) {
+        return 0;
+    }
+    return block_cache_insert(cache, block_num, data, 0);
+}
+
+/**
+ * 预读填充块
+ */
+int block_cache_prefetch(block_cache_t *cache, uint64_t block_num, const char *data) {
+    if (cache_find(cache, block_num)) {
+        return 0;
+    }
+
+    int result = block_cache_insert(cache, block_num, data, 0);
+    if (result == 0) {
+        cache_find(cache, block_num)->prefetched = 1;
+    }
+    return result;
+}
+
+/**
+ * 检查块是否在缓存中
+ */
+int block_cache_contains(const block_cache_t *cache, uint64_t block_num) {
+    return cache_find(cache, block_num) != NULL;
+}
+
+/**
+ * 检查范围内是否有脏块
+ */
+int block_cache_range_dirty(const block_cache_t *cache, uint64_t start_block, uint32_t count) {
+    if (cache->dirty_count == 0) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        block_cache_entry_t *entry = cache_find(cache, start_block + i);
+        if (entry && entry->dirty) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 使块失效
+ */
+void block_cache_invalidate(block_cache_t *cache, uint64_t block_num) {
+    block_cache_entry_t *entry = cache_find(cache, block_num);
+    if (entry) {
+        cache_release(cache, entry);
+    }
+}
+
+/**
+ * 使一段块失效
+ */
+void block_cache_invalidate_range(block_cache_t *cache, uint64_t start_block, uint64_t count) {
+    if (count <= cache->capacity) {
+        for (uint64_t i = 0; i < count; i++) {
+            block_cache_invalidate(cache, start_block + i);
+        }
+        return;
+    }
+
+    // 范围大于缓存时改为扫描所有条目
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        block_cache_entry_t *entry = &cache->entries[i];
+        if (entry->valid && entry->block_num - start_block < count) {
+            cache_release(cache, entry);
+        }
+    }
+}
+
+/**
+ * 回写所有脏块
+ */
+int block_cache_flush(block_cache_t *cache) {
+    return block_cache_flush_range(cache, 0, UINT64_MAX);
+}
+
+/**
+ * 回写一段块中的脏块
+ */
+int block_cache_flush_range(block_cache_t *cache, uint64_t start_block, uint64_t count) {
+    if (cache->dirty_count == 0) {
+        return 0;
+    }
+
+    block_cache_entry_t **dirty = (block_cache_entry_t **)malloc(
+        cache->dirty_count * sizeof(block_cache_entry_t *));
+    if (!dirty) {
+        return -1;
+    }
+
+    uint32_t n = 0;
+    for (block_cache_entry_t *e = cache->lru_head; e; e = e->lru_next) {
+        if (e->dirty && e->block_num - start_block < count) {
+            dirty[n++] = e;
+        }
+    }
+    qsort(dirty, n, sizeof(block_cache_entry_t *), compare_entries);
+
+    // 连续块合并为一次回写
+    const char *run[BLOCK_CACHE_MAX_RUN];
+    int status = 0;
+    uint32_t i = 0;
+    while (i < n) {
+        uint32_t len = 1;
+        run[0] = dirty[i]->data;
+        while (i + len < n && len < BLOCK_CACHE_MAX_RUN &&
+               dirty[i + len]->block_num == dirty[i]->block_num + len) {
+            run[len] = dirty[i + len]->data;
+            len++;
+        }
+
+        int result = cache->writeback(cache->writeback_ctx, dirty[i]->block_num, len, run);
+        if (result != 0) {
+            if (status == 0) {
+                status = result;
+            }
+        } else {
+            for (uint32_t j = 0; j < len; j++) {
+                dirty[i + j]->dirty = 0;
+                cache->dirty_count--;
+            }
+        }
+        i += len;
+    }
+
+    free(dirty);
+    return status;
+}
@@ -0,0 +1,197 @@
+/**
+ * Block Cache Header
+ * block_cache.h
+ *
+ * Write-back block buffer cache used by the disk simulator.
+ * Blocks are located through a hash table and replaced in LRU order.
+ * Dirty blocks are only written to the backing store when they are
+ * evicted or when the cache is explicitly flushed.
+ *
+ * The cache knows nothing about files or descriptors: the owner supplies
+ * a write-back callback that persists runs of consecutive dirty blocks.
+ *
+ * Blocks loaded ahead of use (readahead) are tagged until first read, so
+ * the cache can count prefetches that paid off and those evicted unused.
+ * The cache is not thread-safe; callers serialize access with their own lock.
+ */
+
+#ifndef _BLOCK_CACHE_H_
+#define _BLOCK_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============================================================================
+ * BLOCK CACHE CONSTANTS
+ *============================================================================*/
+
+#define BLOCK_CACHE_MAX_RUN     64          // Maximum blocks handed to one write-back call
+
+/*==============================================================================
+ * DATA STRUCTURES
+ *============================================================================*/
+
+/**
+ * Write-back callback
+ *
+ * Persists `count` consecutive blocks starting at `start_block`.
+ * `blocks[i]` points to the cached data of block `start_block + i`.
+ *
+ * @return 0 on success, negative error code on failure
+ */
+typedef int (*block_cache_writeback_fn)(void *ctx, uint64_t start_block,
+                                        uint32_t count, const char *const *blocks);
+
+/**
+ * Cache Entry Structure
+ *
+ * One cached block. Entries live in a fixed array allocated at creation
+ * time and are chained into a hash bucket and the global LRU list.
+ */
+typedef struct block_cache_entry {
+    uint64_t    block_num;                  // Cached block number
+    uint8_t     valid;                      // Entry holds a block
+    uint8_t     dirty;                      // Entry differs from backing store
+    uint8_t     prefetched;                 // Loaded by readahead, not read yet
+    char        *data;                      // Block data (block_size bytes)
+
+    struct block_cache_entry *hash_next;    // Next entry in hash bucket
+    struct block_cache_entry *lru_prev;     // Towards most recently used
+    struct block_cache_entry *lru_next;     // Towards least recently used
+} block_cache_entry_t;
+
+/**
+ * Block Cache Structure
+ */
+typedef struct {
+    uint32_t    capacity;                   // Maximum number of cached blocks
+    uint32_t    block_size;                 // Size of each block in bytes
+    uint32_t    count;                      // Number of valid entries
+    uint32_t    dirty_count;                // Number of dirty entries
+
+    block_cache_entry_t  *entries;          // Entry array (capacity entries)
+    char                 *data;             // Block data slab
+    block_cache_entry_t **buckets;          // Hash buckets
+    uint32_t    bucket_mask;                // Bucket count - 1 (power of two)
+
+    block_cache_entry_t  *lru_head;         // Most recently used
+    block_cache_entry_t  *lru_tail;         // Least recently used
+    block_cache_entry_t  *free_list;        // Unused entries (chained via hash_next)
+
+    block_cache_writeback_fn writeback;     // Persists dirty blocks
+    void        *writeback_ctx;             // Opaque callback context
+    uint64_t    prefetch_hits;              // Prefetched blocks later read
+    uint64_t    prefetch_wasted;            // Prefetched blocks dropped or overwritten unread
+} block_cache_t;
+
+/*==============================================================================
+ * BLOCK CACHE OPERATIONS
+ *============================================================================*/
+
+/**
+ * Create a block cache
+ *
+ * @param capacity Maximum number of blocks to keep (must be > 0)
+ * @param block_size Size of each block in bytes
+ * @param writeback Callback used to persist dirty blocks
+ * @param ctx Opaque pointer passed to the callback
+ * @return New cache, or NULL on allocation failure
+ */
+block_cache_t* block_cache_create(uint32_t capacity, uint32_t block_size,
+                                  block_cache_writeback_fn writeback, void *ctx);
+
+/**
+ * Destroy a block cache
+ *
+ * Dirty blocks are discarded; call block_cache_flush() first to keep them.
+ */
+void block_cache_destroy(block_cache_t *cache);
+
+/**
+ * Look up a block
+ *
+ * Copies the cached block into `buffer` and marks it most recently used.
+ *
+ * @return 1 on hit, 0 on miss
+ */
+int block_cache_lookup(block_cache_t *cache, uint64_t block_num, char *buffer);
+
+/**
+ * Insert or update a block
+ *
+ * Stores `data` for `block_num`, evicting the least recently used block
+ * if the cache is full. An evicted dirty block is written back first.
+ * A clean insert never clears the dirty flag of an existing entry.
+ *
+ * @param dirty Non-zero if the block must eventually be written back
+ * @return 0 on success, negative error code from the write-back callback
+ */
+int block_cache_insert(block_cache_t *cache, uint64_t block_num,
+                       const char *data, int dirty);
+
+/**
+ * Fill a block after a read miss
+ *
+ * Like a clean block_cache_insert(), but leaves an existing entry untouched
+ * so that data read from the backing store never replaces a newer copy.
+ *
+ * @return 0 on success, negative error code from the write-back callback
+ */
+int block_cache_fill(block_cache_t *cache, uint64_t block_num, const char *data);
+
+/**
+ * Fill a block loaded ahead of use
+ *
+ * Like block_cache_fill(), but tags a newly inserted entry as prefetched.
+ * Its first lookup counts in prefetch_hits; eviction, invalidation or
+ * overwrite before that counts in prefetch_wasted.
+ *
+ * @return 0 on success, negative error code from the write-back callback
+ */
+int block_cache_prefetch(block_cache_t *cache, uint64_t block_num, const char *data);
+
+/**
+ * Check whether a block is cached (without touching the LRU order)
+ *
+ * @return 1 if cached, 0 otherwise
+ */
+int block_cache_contains(const block_cache_t *cache, uint64_t block_num);
+
+/**
+ * Check a block range for dirty blocks
+ *
+ * @return 1 if any block in [start_block, start_block + count) is dirty, 0 otherwise
+ */
+int block_cache_range_dirty(const block_cache_t *cache, uint64_t start_block, uint32_t count);
+
+/**
+ * Drop a block from the cache without writing it back
+ */
+void block_cache_invalidate(block_cache_t *cache, uint64_t block_num);
+
+/**
+ * Drop every block in [start_block, start_block + count) without writing it back
+ */
+void block_cache_invalidate_range(block_cache_t *cache, uint64_t start_block, uint64_t count);
+
+/**
+ * Write back all dirty blocks
+ *
+ * Dirty blocks are written in ascending block order, with consecutive
+ * blocks grouped into a single write-back call.
+ *
+ * @return 0 on success, first negative error code from the callback
+ */
+int block_cache_flush(block_cache_t *cache);
+
+/**
+ * Write back the dirty blocks in [start_block, start_block + count)
+ *
+ * Same as block_cache_flush() but leaves dirty blocks outside the range
+ * in the cache.
+ *
+ * @return 0 on success, first negative error code from the callback
+ */
+int block_cache_flush_range(block_cache_t *cache, uint64_t start_block, uint64_t count);
+
+#endif /* _BLOCK_CACHE_H_ */
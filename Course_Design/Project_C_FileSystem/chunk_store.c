@@ -0,0 +1,1003 @@
+/**
+ * Compressed Chunk Store Implementation
+ * chunk_store.c
+ *
+ * 压缩块存储实现 - 按块组压缩存放逻辑块，通过索引定位每个块组的压缩数据
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // pread()/pwrite()/fdatasync()
+#endif
+
+#include "chunk_store.h"
+#include "crc32c.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* 压缩数据在文件中的分配粒度（字节） */
+#define CHUNK_STORE_ALIGN       64
+
+/* 索引按页跟踪修改，同步时只写回改过的页 */
+#define CHUNK_STORE_INDEX_PAGE  4096
+
+/* 压缩数据占用的空间（按分配粒度向上取整） */
+#define EXTENT_SIZE(length) \
+    (((uint64_t)(length) + CHUNK_STORE_ALIGN - 1) & ~(uint64_t)(CHUNK_STORE_ALIGN - 1))
+
+/* LZ77编码参数：最短匹配4字节，匹配距离不超过64KB */
+#define LZ_MIN_MATCH            4
+#define LZ_MAX_OFFSET           65535
+#define LZ_HASH_BITS            12
+#define LZ_HASH_SIZE            (1 << LZ_HASH_BITS)
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+/**
+ * 索引项（按此布局存放在镜像文件中）
+ */
+typedef struct {
+    uint64_t        offset;         // 压缩数据在文件中的偏移
+    uint32_t        length;         // 压缩数据长度（0表示全零块组）
+    uint32_t        crc;            // 压缩数据的CRC32C
+} chunk_entry_t;
+
+/**
+ * 文件中的一段空间
+ */
+typedef struct {
+    uint64_t        offset;
+    uint64_t        length;
+} chunk_extent_t;
+
+/**
+ * 按偏移排序的空间列表
+ */
+typedef struct {
+    chunk_extent_t  *items;
+    uint32_t        count;
+    uint32_t        capacity;
+} extent_list_t;
+
+/**
+ * 解压后的块组缓存槽
+ */
+typedef struct {
+    uint32_t        chunk;          // 块组号
+    uint8_t         valid;          // 槽中有数据
+    uint8_t         dirty;          // 修改后尚未压缩写回
+    uint64_t        last_use;       // 最近使用时刻（LRU）
+    char            *data;          // 块组数据（chunk_bytes字节）
+} chunk_slot_t;
+
+struct chunk_store {
+    int             fd;             // 镜像文件描述符（不归存储所有）
+    uint32_t        block_size;     // 块大小（字节）
+    uint32_t        chunk_blocks;   // 每个块组的块数
+    uint32_t        chunk_bytes;    // 每个块组的字节数
+    uint32_t        chunk_count;    // 块组数
+    uint64_t        index_offset;   // 索引在文件中的偏移
+    uint64_t        data_start;     // 压缩数据区起始偏移
+    uint64_t        tail;           // 已分配空间的末尾
+    chunk_entry_t   *index;         // 内存中的索引
+    uint8_t         *index_dirty;   // 每个索引页一位，尚未写回
+    uint32_t        index_pages;    // 索引页数
+    extent_list_t   free_space;     // 可重用的空间
+    extent_list_t   pending;        // 被替换的空间，下次同步后才可重用
+    chunk_slot_t    slots[CHUNK_STORE_CACHE_SLOTS];
+    uint64_t        clock;          // LRU时钟
+    uint8_t         *scratch;       // 压缩数据缓冲区
+    uint32_t        *hash;          // LZ77哈希表
+    pthread_mutex_t lock;           // 保护以上全部字段和统计
+    chunk_store_stats_t stats;
+};
+
+/*==============================================================================
+ * LZ77编解码
+ *============================================================================*/
+
+/**
+ * 计算4字节序列的哈希
+ */
+static uint32_t lz_hash(const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return (value * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+ * 写入长度的扩展字节（每个255表示继续）
+ */
+static uint8_t *lz_put_length(uint8_t *op, const uint8_t *oend, size_t length) {
+    while (length >= 255) {
+        if (op >= oend) {
+            return NULL;
+        }
+        *op++ = 255;
+        length -= 255;
+    }
+    if (op >= oend) {
+        return NULL;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/**
+ * 写入一个序列：若干字面字节，接一个匹配（match_length为0时为结尾序列）
+ *
+ * 标记字节高4位为字面长度，低4位为匹配长度减4，值15表示后跟扩展字节。
+ */
+static uint8_t *lz_put_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *literals,
+                                size_t literal_length, size_t offset, size_t match_length) {
+    size_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+
+    if (op >= oend) {
+        return NULL;
+    }
+    uint8_t *token = op++;
+    *token = (uint8_t)(((literal_length < 15 ? literal_length : 15) << 4) |
+                       (match_code < 15 ? match_code : 15));
+
+    if (literal_length >= 15 && !(op = lz_put_length(op, oend, literal_length - 15))) {
+        return NULL;
+    }
+    if (literal_length > (size_t)(oend - op)) {
+        return NULL;
+    }
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+
+    if (match_length == 0) {
+        return op;
+    }
+    if (oend - op < 2) {
+        return NULL;
+    }
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    if (match_code >= 15 && !(op = lz_put_length(op, oend, match_code - 15))) {
+        return NULL;
+    }
+
+    return op;
+}
+
+/**
+ * 压缩一段数据
+ *
+ * 贪心匹配：每个位置按哈希查找上一次出现的相同4字节，找到则尽量延长。
+ * 连续找不到匹配时逐渐加大步长，不可压缩的数据很快放弃。
+ *
+ * @return 压缩后的长度，放不进capacity时为0
+ */
+static size_t lz_compress(const uint8_t *src, size_t length, uint8_t *dst, size_t capacity,
+                          uint32_t *table) {
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *iend = src + length;
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + capacity;
+    uint32_t misses = 0;
+
+    memset(table, 0xFF, LZ_HASH_SIZE * sizeof(uint32_t));
+
+    while (iend - ip >= LZ_MIN_MATCH) {
+        uint32_t h = lz_hash(ip);
+        uint32_t candidate = table[h];
+        uint32_t position = (uint32_t)(ip - src);
+        table[h] = position;
+
+        if (candidate == UINT32_MAX || position - candidate > LZ_MAX_OFFSET ||
+            memcmp(src + candidate, ip, LZ_MIN_MATCH) != 0) {
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+
+        const uint8_t *match = src + candidate;
+        size_t match_length = LZ_MIN_MATCH;
+        while (ip + match_length < iend && match[match_length] == ip[match_length]) {
+            match_length++;
+        }
+
+        op = lz_put_sequence(op, oend, anchor, (size_t)(ip - anchor), (size_t)(ip - match),
+                             match_length);
+        if (!op) {
+            return 0;
+        }
+        ip += match_length;
+        anchor = ip;
+        misses = 0;
+    }
+
+    op = lz_put_sequence(op, oend, anchor, (size_t)(iend - anchor), 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+/**
+ * 读取长度的扩展字节
+ *
+ * @return 0成功，-1数据不完整
+ */
+static int lz_get_length(const uint8_t **ip, const uint8_t *iend, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*ip >= iend) {
+            return -1;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return 0;
+}
+
+/**
+ * 解压一段数据（检查所有长度和距离，损坏的数据不会越界）
+ *
+ * @return 0成功且恰好得到output_length字节，-1数据损坏
+ */
+static int lz_decompress(const uint8_t *src, size_t length, uint8_t *dst, size_t output_length) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + length;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + output_length;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && lz_get_length(&ip, iend, &literal_length) != 0) {
+            return -1;
+        }
+        if (literal_length > (size_t)(iend - ip) || literal_length > (size_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        if (ip == iend) {
+            break;
+        }
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+
+        size_t match_length = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15 && lz_get_length(&ip, iend, &match_length) != 0) {
+            return -1;
+        }
+        if (offset == 0 || offset > (size_t)(op - dst) || match_length > (size_t)(oend - op)) {
+            return -1;
+        }
+
+        // 距离小于长度时匹配与输出重叠，必须逐字节复制
+        const uint8_t *match = op - offset;
+        if (offset == 1) {
+            memset(op, *match, match_length);
+        } else if (offset >= match_length) {
+            memcpy(op, match, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; i++) {
+                op[i] = match[i];
+            }
+        }
+        op += match_length;
+    }
+
+    return op == oend ? 0 : -1;
+}
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 获取本线程消耗的CPU时间（纳秒）
+ */
+static uint64_t cpu_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 检查缓冲区是否全零
+ */
+static int is_zero(const char *data, size_t length) {
+    return data[0] == 0 && memcmp(data, data + 1, length - 1) == 0;
+}
+
+/**
+ * 完整读取，处理部分读取和EINTR
+ */
+static int pread_full(int fd, void *buffer, size_t length, uint64_t offset) {
+    char *p = (char *)buffer;
+
+    while (length > 0) {
+        ssize_t bytes = pread(fd, p, length, (off_t)offset);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (bytes == 0) {
+            return -EIO;
+        }
+        p += bytes;
+        length -= (size_t)bytes;
+        offset += (uint64_t)bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * 完整写入，处理部分写入和EINTR
+ */
+static int pwrite_full(int fd, const void *data, size_t length, uint64_t offset) {
+    const char *p = (const char *)data;
+
+    while (length > 0) {
+        ssize_t bytes = pwrite(fd, p, length, (off_t)offset);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        p += bytes;
+        length -= (size_t)bytes;
+        offset += (uint64_t)bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * 在列表的指定位置插入一段空间
+ */
+static int extent_insert(extent_list_t *list, uint32_t at, uint64_t offset, uint64_t length) {
+    if (list->count == list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 64;
+        chunk_extent_t *items = (chunk_extent_t *)realloc(list->items,
+                                                          capacity * sizeof(chunk_extent_t));
+        if (!items) {
+            return -ENOMEM;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    memmove(&list->items[at + 1], &list->items[at], (list->count - at) * sizeof(chunk_extent_t));
+    list->items[at].offset = offset;
+    list->items[at].length = length;
+    list->count++;
+    return 0;
+}
+
+/**
+ * 从列表中删除一项
+ */
+static void extent_remove(extent_list_t *list, uint32_t at) {
+    list->count--;
+    memmove(&list->items[at], &list->items[at + 1], (list->count - at) * sizeof(chunk_extent_t));
+}
+
+/**
+ * 归还一段空间，与相邻的空闲空间合并；位于末尾时直接缩回tail
+ *
+ * 内存不足时这段空间在重新打开镜像前不再使用。
+ */
+static void free_space_add(chunk_store_t *store, uint64_t offset, uint64_t length) {
+    extent_list_t *list = &store->free_space;
+    uint32_t lo = 0;
+    uint32_t hi = list->count;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (list->items[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo > 0 && list->items[lo - 1].offset + list->items[lo - 1].length == offset) {
+        chunk_extent_t *prev = &list->items[lo - 1];
+        prev->length += length;
+        if (lo < list->count && prev->offset + prev->length == list->items[lo].offset) {
+            prev->length += list->items[lo].length;
+            extent_remove(list, lo);
+        }
+    } else if (lo < list->count && offset + length == list->items[lo].offset) {
+        list->items[lo].offset = offset;
+        list->items[lo].length += length;
+    } else if (extent_insert(list, lo, offset, length) != 0) {
+        return;
+    }
+
+    if (list->count > 0) {
+        chunk_extent_t *last = &list->items[list->count - 1];
+        if (last->offset + last->length == store->tail) {
+            store->tail = last->offset;
+            list->count--;
+        }
+    }
+}
+
+/**
+ * 分配一段空间：首次适配空闲列表，否则从末尾扩展
+ */
+static uint64_t extent_alloc(chunk_store_t *store, uint64_t length) {
+    extent_list_t *list = &store->free_space;
+
+    for (uint32_t i = 0; i < list->count; i++) {
+        chunk_extent_t *extent = &list->items[i];
+        if (extent->length >= length) {
+            uint64_t offset = extent->offset;
+            extent->offset += length;
+            extent->length -= length;
+            if (extent->length == 0) {
+                extent_remove(list, i);
+            }
+            return offset;
+        }
+    }
+
+    uint64_t offset = store->tail;
+    store->tail += length;
+    return offset;
+}
+
+/**
+ * 同步完成后，把被替换的空间放回空闲列表
+ */
+static void release_pending(chunk_store_t *store) {
+    for (uint32_t i = 0; i < store->pending.count; i++) {
+        free_space_add(store, store->pending.items[i].offset, store->pending.items[i].length);
+    }
+    store->pending.count = 0;
+}
+
+/**
+ * 压缩比分类：压缩比在2^i到2^(i+1)之间为第i类
+ */
+static uint32_t ratio_class(const chunk_store_t *store, uint32_t length) {
+    uint32_t cls = 0;
+    while (cls < CHUNK_STORE_RATIO_BUCKETS - 1 &&
+           ((uint64_t)length << (cls + 1)) <= store->chunk_bytes) {
+        cls++;
+    }
+    return cls;
+}
+
+/**
+ * 更新已存储块组的统计（sign为1加入，-1移除）
+ */
+static void account_stored(chunk_store_t *store, uint32_t length, int sign) {
+    store->stats.stored_chunks += (uint64_t)(int64_t)sign;
+    store->stats.stored_bytes += (uint64_t)((int64_t)sign * length);
+    store->stats.ratio_chunks[ratio_class(store, length)] += (uint64_t)(int64_t)sign;
+}
+
+/**
+ * 替换块组的索引项，旧数据的空间等下次同步后再重用
+ */
+static void replace_entry(chunk_store_t *store, uint32_t chunk, const chunk_entry_t *entry) {
+    chunk_entry_t *old = &store->index[chunk];
+
+    if (old->length == 0 && entry->length == 0) {
+        return;
+    }
+    if (old->length > 0) {
+        // 内存不足时记不下，这段空间在重新打开镜像前不再使用
+        (void)extent_insert(&store->pending, store->pending.count, old->offset,
+                            EXTENT_SIZE(old->length));
+        account_stored(store, old->length, -1);
+    }
+    if (entry->length > 0) {
+        account_stored(store, entry->length, 1);
+    }
+
+    *old = *entry;
+    uint32_t page = (uint32_t)((uint64_t)chunk * sizeof(chunk_entry_t) / CHUNK_STORE_INDEX_PAGE);
+    store->index_dirty[page / 8] |= (uint8_t)(1 << (page % 8));
+}
+
+/**
+ * 压缩缓存槽中的块组并写入新分配的空间
+ *
+ * 全零的块组不占空间；压缩后不比原数据小时按原样存放。
+ */
+static int store_chunk(chunk_store_t *store, chunk_slot_t *slot) {
+    chunk_entry_t entry = {0, 0, 0};
+
+    if (!is_zero(slot->data, store->chunk_bytes)) {
+        uint64_t begin = cpu_time_ns();
+        size_t length = lz_compress((const uint8_t *)slot->data, store->chunk_bytes,
+                                    store->scratch, store->chunk_bytes - 1, store->hash);
+        latency_hist_record(&store->stats.compress_latency, cpu_time_ns() - begin);
+
+        const void *payload = store->scratch;
+        if (length == 0) {
+            length = store->chunk_bytes;
+            payload = slot->data;
+        }
+
+        entry.length = (uint32_t)length;
+        entry.crc = crc32c(0, payload, length);
+        entry.offset = extent_alloc(store, EXTENT_SIZE(length));
+
+        int result = pwrite_full(store->fd, payload, length, entry.offset);
+        if (result != 0) {
+            free_space_add(store, entry.offset, EXTENT_SIZE(length));
+            return result;
+        }
+
+        store->stats.chunks_written++;
+        store->stats.bytes_in += store->chunk_bytes;
+        store->stats.bytes_out += length;
+    }
+
+    replace_entry(store, slot->chunk, &entry);
+    slot->dirty = 0;
+    return 0;
+}
+
+/**
+ * 读取并解压一个块组
+ */
+static int load_chunk(chunk_store_t *store, uint32_t chunk, char *data) {
+    const chunk_entry_t *entry = &store->index[chunk];
+
+    if (entry->length == 0) {
+        memset(data, 0, store->chunk_bytes);
+        store->stats.zero_chunks_read++;
+        return 0;
+    }
+
+    int raw = (entry->length == store->chunk_bytes);
+    void *buffer = raw ? (void *)data : (void *)store->scratch;
+    int result = pread_full(store->fd, buffer, entry->length, entry->offset);
+    if (result != 0) {
+        return result;
+    }
+    if (crc32c(0, buffer, entry->length) != entry->crc) {
+        return -EBADMSG;
+    }
+
+    if (!raw) {
+        uint64_t begin = cpu_time_ns();
+        result = lz_decompress(store->scratch, entry->length, (uint8_t *)data, store->chunk_bytes);
+        latency_hist_record(&store->stats.decompress_latency, cpu_time_ns() - begin);
+        if (result != 0) {
+            return -EBADMSG;
+        }
+    }
+
+    store->stats.chunks_read++;
+    return 0;
+}
+
+/**
+ * 取得块组所在的缓存槽，不在缓存中时淘汰最久未用的槽
+ *
+ * @param load 是否读入块组内容（调用方将覆盖整个块组时不需要）
+ */
+static int get_slot(chunk_store_t *store, uint32_t chunk, int load, chunk_slot_t **slot) {
+    chunk_slot_t *victim = NULL;
+
+    for (uint32_t i = 0; i < CHUNK_STORE_CACHE_SLOTS; i++) {
+        chunk_slot_t *s = &store->slots[i];
+        if (s->valid && s->chunk == chunk) {
+            s->last_use = ++store->clock;
+            *slot = s;
+            return 0;
+        }
+        if (!victim || (victim->valid && (!s->valid || s->last_use < victim->last_use))) {
+            victim = s;
+        }
+    }
+
+    if (victim->valid && victim->dirty) {
+        int result = store_chunk(store, victim);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    victim->valid = 0;
+    if (load) {
+        int result = load_chunk(store, chunk, victim->data);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    victim->chunk = chunk;
+    victim->valid = 1;
+    victim->dirty = 0;
+    victim->last_use = ++store->clock;
+    *slot = victim;
+    return 0;
+}
+
+/**
+ * 把索引中修改过的页写回文件（不同步）
+ */
+static int write_index(chunk_store_t *store) {
+    uint64_t index_bytes = (uint64_t)store->chunk_count * sizeof(chunk_entry_t);
+
+    for (uint32_t page = 0; page < store->index_pages; page++) {
+        uint8_t mask = (uint8_t)(1 << (page % 8));
+        if (!(store->index_dirty[page / 8] & mask)) {
+            continue;
+        }
+
+        uint64_t offset = (uint64_t)page * CHUNK_STORE_INDEX_PAGE;
+        uint64_t length = index_bytes - offset;
+        if (length > CHUNK_STORE_INDEX_PAGE) {
+            length = CHUNK_STORE_INDEX_PAGE;
+        }
+
+        int result = pwrite_full(store->fd, (const char *)store->index + offset, (size_t)length,
+                                 store->index_offset + offset);
+        if (result != 0) {
+            return result;
+        }
+        store->index_dirty[page / 8] &= (uint8_t)~mask;
+    }
+
+    return 0;
+}
+
+/**
+ * 比较两段空间的偏移
+ */
+static int compare_extents(const void *a, const void *b) {
+    const chunk_extent_t *x = (const chunk_extent_t *)a;
+    const chunk_extent_t *y = (const chunk_extent_t *)b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+/**
+ * 加载并检查索引，索引未引用的空间成为空闲空间
+ */
+static int load_index(chunk_store_t *store) {
+    struct stat file_stat;
+    if (fstat(store->fd, &file_stat) != 0) {
+        return -errno;
+    }
+    if ((uint64_t)file_stat.st_size < store->data_start) {
+        return -EBADMSG;
+    }
+
+    int result = pread_full(store->fd, store->index,
+                            (size_t)store->chunk_count * sizeof(chunk_entry_t), store->index_offset);
+    if (result != 0) {
+        return result;
+    }
+
+    chunk_extent_t *extents = (chunk_extent_t *)malloc((size_t)store->chunk_count *
+                                                       sizeof(chunk_extent_t));
+    if (!extents) {
+        return -ENOMEM;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < store->chunk_count; c++) {
+        const chunk_entry_t *entry = &store->index[c];
+        if (entry->length == 0) {
+            continue;
+        }
+        if (entry->length > store->chunk_bytes || entry->offset < store->data_start ||
+            entry->offset % CHUNK_STORE_ALIGN != 0 ||
+            entry->offset + entry->length > (uint64_t)file_stat.st_size) {
+            free(extents);
+            return -EBADMSG;
+        }
+        extents[count].offset = entry->offset;
+        extents[count].length = EXTENT_SIZE(entry->length);
+        count++;
+        account_stored(store, entry->length, 1);
+    }
+
+    qsort(extents, count, sizeof(chunk_extent_t), compare_extents);
+
+    // 建立空闲列表期间tail取最大值，避免末尾的空闲空间被并入tail
+    uint64_t position = store->data_start;
+    store->tail = UINT64_MAX;
+    for (uint32_t i = 0; i < count && result == 0; i++) {
+        if (extents[i].offset < position) {
+            result = -EBADMSG;
+        } else {
+            if (extents[i].offset > position) {
+                free_space_add(store, position, extents[i].offset - position);
+            }
+            position = extents[i].offset + extents[i].length;
+        }
+    }
+    store->tail = position;
+
+    free(extents);
+    return result;
+}
+
+/*==============================================================================
+ * 压缩块存储操作
+ *============================================================================*/
+
+/**
+ * 计算压缩数据区的起始偏移
+ */
+uint64_t chunk_store_data_offset(uint64_t index_offset, uint32_t total_blocks,
+                                 uint32_t block_size, uint32_t chunk_blocks) {
+    uint64_t chunks = ((uint64_t)total_blocks + chunk_blocks - 1) / chunk_blocks;
+    uint64_t index_bytes = chunks * sizeof(chunk_entry_t);
+    return index_offset + (index_bytes + block_size - 1) / block_size * block_size;
+}
+
+/**
+ * 打开镜像文件中的压缩块存储
+ */
+int chunk_store_open(int fd, uint64_t index_offset, uint32_t total_blocks, uint32_t block_size,
+                     uint32_t chunk_blocks, int create, chunk_store_t **store) {
+    if (!store || total_blocks == 0 || block_size == 0 || chunk_blocks == 0 ||
+        (uint64_t)chunk_blocks * block_size > CHUNK_STORE_MAX_CHUNK_BYTES) {
+        return -EINVAL;
+    }
+
+    chunk_store_t *cs = (chunk_store_t *)calloc(1, sizeof(chunk_store_t));
+    if (!cs) {
+        return -ENOMEM;
+    }
+    pthread_mutex_init(&cs->lock, NULL);
+
+    cs->fd = fd;
+    cs->block_size = block_size;
+    cs->chunk_blocks = chunk_blocks;
+    cs->chunk_bytes = chunk_blocks * block_size;
+    cs->chunk_count = (uint32_t)(((uint64_t)total_blocks + chunk_blocks - 1) / chunk_blocks);
+    cs->index_offset = index_offset;
+    cs->data_start = chunk_store_data_offset(index_offset, total_blocks, block_size, chunk_blocks);
+    cs->tail = cs->data_start;
+
+    uint64_t index_bytes = (uint64_t)cs->chunk_count * sizeof(chunk_entry_t);
+    cs->index_pages = (uint32_t)((index_bytes + CHUNK_STORE_INDEX_PAGE - 1) / CHUNK_STORE_INDEX_PAGE);
+    cs->index = (chunk_entry_t *)calloc(cs->chunk_count, sizeof(chunk_entry_t));
+    cs->index_dirty = (uint8_t *)calloc((cs->index_pages + 7) / 8, 1);
+    cs->scratch = (uint8_t *)malloc(cs->chunk_bytes);
+    cs->hash = (uint32_t *)malloc(LZ_HASH_SIZE * sizeof(uint32_t));
+
+    int result = (cs->index && cs->index_dirty && cs->scratch && cs->hash) ? 0 : -ENOMEM;
+    for (uint32_t i = 0; i < CHUNK_STORE_CACHE_SLOTS && result == 0; i++) {
+        cs->slots[i].data = (char *)malloc(cs->chunk_bytes);
+        if (!cs->slots[i].data) {
+            result = -ENOMEM;
+        }
+    }
+
+    // 新镜像的索引区读出全零，即所有块组都为空
+    if (result == 0) {
+        if (create) {
+            result = ftruncate(fd, (off_t)cs->data_start) == 0 ? 0 : -errno;
+        } else {
+            result = load_index(cs);
+        }
+    }
+
+    if (result != 0) {
+        chunk_store_close(cs);
+        return result;
+    }
+
+    *store = cs;
+    return 0;
+}
+
+/**
+ * 释放压缩块存储
+ */
+void chunk_store_close(chunk_store_t *store) {
+    if (!store) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < CHUNK_STORE_CACHE_SLOTS; i++) {
+        free(store->slots[i].data);
+    }
+    free(store->free_space.items);
+    free(store->pending.items);
+    free(store->hash);
+    free(store->scratch);
+    free(store->index_dirty);
+    free(store->index);
+    pthread_mutex_destroy(&store->lock);
+    free(store);
+}
+
+/**
+ * 读取一段连续块
+ */
+int chunk_store_read(chunk_store_t *store, uint32_t start_block, uint32_t count,
+                     char *const *blocks) {
+    int result = 0;
+
+    pthread_mutex_lock(&store->lock);
+    for (uint32_t done = 0; done < count && result == 0; ) {
+        uint32_t chunk = (start_block + done) / store->chunk_blocks;
+        uint32_t within = (start_block + done) % store->chunk_blocks;
+        uint32_t n = store->chunk_blocks - within;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        chunk_slot_t *slot;
+        result = get_slot(store, chunk, 1, &slot);
+        for (uint32_t i = 0; i < n && result == 0; i++) {
+            memcpy(blocks[done + i], slot->data + (size_t)(within + i) * store->block_size,
+                   store->block_size);
+        }
+        done += n;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 写入一段连续块
+ */
+int chunk_store_write(chunk_store_t *store, uint32_t start_block, uint32_t count,
+                      const char *const *blocks) {
+    int result = 0;
+
+    pthread_mutex_lock(&store->lock);
+    for (uint32_t done = 0; done < count && result == 0; ) {
+        uint32_t chunk = (start_block + done) / store->chunk_blocks;
+        uint32_t within = (start_block + done) % store->chunk_blocks;
+        uint32_t n = store->chunk_blocks - within;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        chunk_slot_t *slot;
+        result = get_slot(store, chunk, n != store->chunk_blocks, &slot);
+        if (result == 0) {
+            for (uint32_t i = 0; i < n; i++) {
+                memcpy(slot->data + (size_t)(within + i) * store->block_size, blocks[done + i],
+                       store->block_size);
+            }
+            slot->dirty = 1;
+        }
+        done += n;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 清零一段连续块
+ */
+int chunk_store_zero(chunk_store_t *store, uint32_t start_block, uint32_t count) {
+    static const chunk_entry_t empty = {0, 0, 0};
+    int result = 0;
+
+    pthread_mutex_lock(&store->lock);
+    for (uint32_t done = 0; done < count && result == 0; ) {
+        uint32_t chunk = (start_block + done) / store->chunk_blocks;
+        uint32_t within = (start_block + done) % store->chunk_blocks;
+        uint32_t n = store->chunk_blocks - within;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        if (n == store->chunk_blocks) {
+            // 整个块组清零：丢弃缓存副本，索引项置空
+            for (uint32_t i = 0; i < CHUNK_STORE_CACHE_SLOTS; i++) {
+                if (store->slots[i].valid && store->slots[i].chunk == chunk) {
+                    store->slots[i].valid = 0;
+                    store->slots[i].dirty = 0;
+                }
+            }
+            replace_entry(store, chunk, &empty);
+        } else {
+            chunk_slot_t *slot;
+            result = get_slot(store, chunk, 1, &slot);
+            if (result == 0) {
+                memset(slot->data + (size_t)within * store->block_size, 0,
+                       (size_t)n * store->block_size);
+                slot->dirty = 1;
+            }
+        }
+        done += n;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 使所有写入持久化
+ *
+ * 先写回脏块组并同步，再写回索引并同步：索引落盘时它引用的数据已经
+ * 持久，被替换的旧空间直到此时才能重用。
+ */
+int chunk_store_sync(chunk_store_t *store, int data_only) {
+    int result = 0;
+
+    pthread_mutex_lock(&store->lock);
+    for (uint32_t i = 0; i < CHUNK_STORE_CACHE_SLOTS && result == 0; i++) {
+        if (store->slots[i].valid && store->slots[i].dirty) {
+            result = store_chunk(store, &store->slots[i]);
+        }
+    }
+
+    int index_dirty = 0;
+    for (uint32_t i = 0; i < (store->index_pages + 7) / 8; i++) {
+        index_dirty |= store->index_dirty[i];
+    }
+    if (result == 0 && index_dirty) {
+        result = fdatasync(store->fd) == 0 ? 0 : -errno;
+        if (result == 0) {
+            result = write_index(store);
+        }
+    }
+    if (result == 0 && (data_only ? fdatasync(store->fd) : fsync(store->fd)) != 0) {
+        result = -errno;
+    }
+    if (result == 0) {
+        release_pending(store);
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 获取统计
+ */
+void chunk_store_get_stats(chunk_store_t *store, chunk_store_stats_t *stats) {
+    pthread_mutex_lock(&store->lock);
+    *stats = store->stats;
+    latency_hist_snapshot(&stats->compress_latency, &store->stats.compress_latency);
+    latency_hist_snapshot(&stats->decompress_latency, &store->stats.decompress_latency);
+    pthread_mutex_unlock(&store->lock);
+}
+
+/**
+ * 重置统计（保留当前存储量）
+ */
+void chunk_store_reset_stats(chunk_store_t *store) {
+    pthread_mutex_lock(&store->lock);
+    uint64_t stored_chunks = store->stats.stored_chunks;
+    uint64_t stored_bytes = store->stats.stored_bytes;
+    uint64_t ratio_chunks[CHUNK_STORE_RATIO_BUCKETS];
+    memcpy(ratio_chunks, store->stats.ratio_chunks, sizeof(ratio_chunks));
+
+    memset(&store->stats, 0, sizeof(store->stats));
+    store->stats.stored_chunks = stored_chunks;
+    store->stats.stored_bytes = stored_bytes;
+    memcpy(store->stats.ratio_chunks, ratio_chunks, sizeof(ratio_chunks));
+    pthread_mutex_unlock(&store->lock);
+}
+
+/**
+ * 获取每个块组的块数
+ */
+uint32_t chunk_store_chunk_blocks(const chunk_store_t *store) {
+    return store->chunk_blocks;
+}
@@ -0,0 +1,164 @@
+/**
+ * Compressed Chunk Store Header
+ * chunk_store.h
+ *
+ * Block storage for compressed disk images. Logical blocks are grouped
+ * into chunks of `chunk_blocks` blocks; every chunk is compressed on its
+ * own with a built-in LZ77 codec and stored as one variable-length extent
+ * in the image file. A fixed index right after the image header maps each
+ * chunk to its extent:
+ *
+ *   - length 0: the chunk was never written or is all zeros; it reads back
+ *     as zeros without any file I/O
+ *   - length == chunk bytes: the chunk did not compress and is stored raw
+ *   - otherwise: LZ77-compressed data, protected by a CRC32C
+ *
+ * A small cache of decompressed chunks absorbs the read-modify-write of
+ * block-sized updates; dirty chunks are compressed when they are evicted
+ * or at chunk_store_sync(). A rewritten chunk always goes to a fresh
+ * extent, and the extent it replaces is only reused after the next sync
+ * has made the new index durable. The index on disk therefore always
+ * points at the chunk contents of the last sync, even after a crash.
+ *
+ * All operations are serialized by one lock inside the store.
+ */
+
+#ifndef _CHUNK_STORE_H_
+#define _CHUNK_STORE_H_
+
+#include <stdint.h>
+#include "latency_hist.h"
+
+/*==============================================================================
+ * CHUNK STORE CONSTANTS
+ *============================================================================*/
+
+#define CHUNK_STORE_MAX_CHUNK_BYTES (1024 * 1024) // Largest chunk (chunk_blocks * block_size)
+#define CHUNK_STORE_CACHE_SLOTS 8           // Decompressed chunks kept in memory
+#define CHUNK_STORE_RATIO_BUCKETS 6         // Compression-ratio classes in the stats
+
+/* Store internals live in chunk_store.c */
+typedef struct chunk_store chunk_store_t;
+
+/**
+ * Chunk Store Statistics
+ *
+ * ratio_chunks[i] counts the chunks currently stored with a compression
+ * ratio between 2^i and 2^(i+1) (the last class is open-ended); chunks
+ * that read back as zeros take no space and are not counted. The CPU
+ * time of the codec is recorded per chunk.
+ */
+typedef struct {
+    uint64_t    chunks_written;     // Chunks compressed and written to the file
+    uint64_t    chunks_read;        // Chunks read from the file and decompressed
+    uint64_t    zero_chunks_read;   // Loads of empty chunks (no file I/O)
+    uint64_t    bytes_in;           // Uncompressed bytes of the written chunks
+    uint64_t    bytes_out;          // File bytes those chunks took
+    uint64_t    stored_chunks;      // Chunks currently holding data
+    uint64_t    stored_bytes;       // Their compressed size
+    uint64_t    ratio_chunks[CHUNK_STORE_RATIO_BUCKETS]; // Stored chunks by ratio class
+    latency_hist_t compress_latency;   // CPU time to compress each written chunk
+    latency_hist_t decompress_latency; // CPU time to decompress each chunk read
+} chunk_store_stats_t;
+
+/*==============================================================================
+ * CHUNK STORE OPERATIONS
+ *============================================================================*/
+
+/**
+ * File offset at which chunk data starts (the end of the index)
+ *
+ * @param index_offset File offset of the index
+ * @param total_blocks Logical blocks in the image
+ * @param block_size Block size in bytes
+ * @param chunk_blocks Blocks per chunk
+ * @return First byte after the index, rounded up to the block size
+ */
+uint64_t chunk_store_data_offset(uint64_t index_offset, uint32_t total_blocks,
+                                 uint32_t block_size, uint32_t chunk_blocks);
+
+/**
+ * Open the store of an image file
+ *
+ * With `create` the index is initialized empty (every chunk reads as
+ * zeros) by truncating the file to the end of the index. Otherwise the
+ * index is loaded and checked, and the free space between the extents
+ * it references becomes available for new chunks.
+ *
+ * @param fd Image descriptor; the store uses but does not close it
+ * @param index_offset File offset of the index
+ * @param total_blocks Logical blocks in the image
+ * @param block_size Block size in bytes
+ * @param chunk_blocks Blocks per chunk
+ * @param create Nonzero for a new image
+ * @param store Receives the new store
+ * @return 0 on success, -EBADMSG for a damaged index, other -errno on failure
+ */
+int chunk_store_open(int fd, uint64_t index_offset, uint32_t total_blocks, uint32_t block_size,
+                     uint32_t chunk_blocks, int create, chunk_store_t **store);
+
+/**
+ * Free a store without writing anything (call chunk_store_sync() first)
+ */
+void chunk_store_close(chunk_store_t *store);
+
+/**
+ * Read a run of consecutive blocks
+ *
+ * @param blocks blocks[i] receives block start_block + i
+ * @return 0 on success, -EBADMSG if a chunk fails its CRC or does not
+ *         decompress, other -errno on I/O errors
+ */
+int chunk_store_read(chunk_store_t *store, uint32_t start_block, uint32_t count,
+                     char *const *blocks);
+
+/**
+ * Write a run of consecutive blocks
+ *
+ * The data is copied into the chunk cache; chunks the run covers entirely
+ * are not read first.
+ *
+ * @param blocks blocks[i] holds block start_block + i
+ * @return 0 on success, -errno on failure
+ */
+int chunk_store_write(chunk_store_t *store, uint32_t start_block, uint32_t count,
+                      const char *const *blocks);
+
+/**
+ * Clear a run of blocks to zeros
+ *
+ * Chunks covered entirely are dropped from the index and their extents
+ * freed; partially covered ones are rewritten.
+ *
+ * @return 0 on success, -errno on failure
+ */
+int chunk_store_zero(chunk_store_t *store, uint32_t start_block, uint32_t count);
+
+/**
+ * Make all writes durable
+ *
+ * Compresses and writes the dirty chunks, syncs them, then writes the
+ * changed index pages and syncs again. Extents replaced since the last
+ * sync become reusable afterwards.
+ *
+ * @param data_only Nonzero to use fdatasync() for the final sync
+ * @return 0 on success, -errno on failure
+ */
+int chunk_store_sync(chunk_store_t *store, int data_only);
+
+/**
+ * Copy the statistics (histograms as a consistent snapshot)
+ */
+void chunk_store_get_stats(chunk_store_t *store, chunk_store_stats_t *stats);
+
+/**
+ * Clear the counters and histograms (the stored_* gauges are kept)
+ */
+void chunk_store_reset_stats(chunk_store_t *store);
+
+/**
+ * Blocks per chunk
+ */
+uint32_t chunk_store_chunk_blocks(const chunk_store_t *store);
+
+#endif /* _CHUNK_STORE_H_ */
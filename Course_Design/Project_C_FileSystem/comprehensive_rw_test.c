@@ -80,6 +80,10 @@ void test_basic_operations(void) {
         int size = fs_size(fd);
         printf("文件大小: %d 字节\n", size);
         
+        // 只把这个文件写入稳定存储
+        result = fs_fsync(fd);
+        printf("同步文件: %s\n", result == FS_SUCCESS ? "成功" : "失败");
+        
         // 回到开头读取
         fs_seek(fd, 0, SEEK_SET);
         char buffer[100];
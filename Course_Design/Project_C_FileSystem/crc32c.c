@@ -0,0 +1,264 @@
+/**
+ * CRC32C Implementation
+ * crc32c.c
+ *
+ * CRC32C实现 - 支持SSE4.2时使用硬件crc32指令，否则使用slice-by-8查表
+ */
+
+#include "crc32c.h"
+#include <pthread.h>
+#include <string.h>
+
+#define CRC32C_POLY 0x82F63B78U     // 反射形式的Castagnoli多项式
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CRC32C_HAVE_SSE42 1
+#else
+#define CRC32C_HAVE_SSE42 0
+#endif
+
+/* 硬件实现三路并行时每路的长度（字节，8的倍数） */
+#define CRC32C_LONG_LANE    1024
+#define CRC32C_SHORT_LANE   128
+
+/*==============================================================================
+ * 全局变量
+ *============================================================================*/
+
+static uint32_t g_crc_table[8][256];
+static uint32_t g_long_shift[4][256];   // CRC后追加CRC32C_LONG_LANE个零字节的算子
+static uint32_t g_short_shift[4][256];  // CRC后追加CRC32C_SHORT_LANE个零字节的算子
+static int g_use_sse42 = 0;
+static pthread_once_t g_crc_once = PTHREAD_ONCE_INIT;
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * GF(2)上的矩阵乘向量（矩阵按列存放）
+ */
+static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+/**
+ * GF(2)上的矩阵平方
+ */
+static void gf2_matrix_square(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+/**
+ * 生成在CRC之后追加len个零字节的算子表
+ *
+ * 从追加一个零位的算子开始反复平方，按len的二进制位累乘；结果拆成4张
+ * 按字节查找的表，合并分段CRC时只需4次查表。
+ */
+static void crc32c_zeros(uint32_t shift[4][256], size_t len) {
+    uint32_t op[32], sq[32], tmp[32];
+
+    // 追加一个零位的算子
+    sq[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; n++) {
+        sq[n] = 1U << (n - 1);
+    }
+    // 平方三次得到追加一个零字节的算子
+    gf2_matrix_square(tmp, sq);
+    gf2_matrix_square(sq, tmp);
+    gf2_matrix_square(tmp, sq);
+    memcpy(sq, tmp, sizeof(sq));
+
+    int have_op = 0;
+    while (len) {
+        if (len & 1) {
+            if (have_op) {
+                for (int n = 0; n < 32; n++) {
+                    tmp[n] = gf2_matrix_times(sq, op[n]);
+                }
+                memcpy(op, tmp, sizeof(op));
+            } else {
+                memcpy(op, sq, sizeof(op));
+                have_op = 1;
+            }
+        }
+        len >>= 1;
+        if (len) {
+            gf2_matrix_square(tmp, sq);
+            memcpy(sq, tmp, sizeof(sq));
+        }
+    }
+
+    for (uint32_t n = 0; n < 256; n++) {
+        shift[0][n] = gf2_matrix_times(op, n);
+        shift[1][n] = gf2_matrix_times(op, n << 8);
+        shift[2][n] = gf2_matrix_times(op, n << 16);
+        shift[3][n] = gf2_matrix_times(op, n << 24);
+    }
+}
+
+/**
+ * 对CRC应用追加零字节的算子
+ */
+static inline uint32_t crc32c_shift(uint32_t shift[4][256], uint32_t crc) {
+    return shift[0][crc & 0xFF] ^ shift[1][(crc >> 8) & 0xFF] ^
+           shift[2][(crc >> 16) & 0xFF] ^ shift[3][crc >> 24];
+}
+
+/**
+ * 生成查找表并选择实现
+ *
+ * g_crc_table[k][b]为字节b后跟k个零字节的CRC，8张表合起来一次处理8字节。
+ */
+static void crc32c_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0U - (crc & 1)));
+        }
+        g_crc_table[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = g_crc_table[k - 1][i];
+            g_crc_table[k][i] = (prev >> 8) ^ g_crc_table[0][prev & 0xFF];
+        }
+    }
+
+#if CRC32C_HAVE_SSE42
+    __builtin_cpu_init();
+    g_use_sse42 = __builtin_cpu_supports("sse4.2");
+    if (g_use_sse42) {
+        crc32c_zeros(g_long_shift, CRC32C_LONG_LANE);
+        crc32c_zeros(g_short_shift, CRC32C_SHORT_LANE);
+    }
+#endif
+}
+
+/**
+ * slice-by-8查表实现（按字节组合，与主机字节序无关）
+ */
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *p, size_t len) {
+    while (len >= 8) {
+        crc ^= (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+               ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        crc = g_crc_table[7][crc & 0xFF] ^
+              g_crc_table[6][(crc >> 8) & 0xFF] ^
+              g_crc_table[5][(crc >> 16) & 0xFF] ^
+              g_crc_table[4][crc >> 24] ^
+              g_crc_table[3][p[4]] ^
+              g_crc_table[2][p[5]] ^
+              g_crc_table[1][p[6]] ^
+              g_crc_table[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+
+    while (len--) {
+        crc = (crc >> 8) ^ g_crc_table[0][(crc ^ *p++) & 0xFF];
+    }
+
+    return crc;
+}
+
+#if CRC32C_HAVE_SSE42
+/**
+ * 三路并行计算3*lane字节
+ *
+ * crc32指令延迟为3个周期、吞吐为每周期1条，三段相邻数据交替计算才能
+ * 填满流水线；最后用追加零字节的算子把三段CRC合并。
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw_lanes(uint32_t crc, const unsigned char *p, size_t lane,
+                                uint32_t shift[4][256]) {
+    uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+    for (size_t i = 0; i < lane; i += 8) {
+        uint64_t w0, w1, w2;
+        memcpy(&w0, p + i, 8);
+        memcpy(&w1, p + lane + i, 8);
+        memcpy(&w2, p + 2 * lane + i, 8);
+        crc0 = __builtin_ia32_crc32di(crc0, w0);
+        crc1 = __builtin_ia32_crc32di(crc1, w1);
+        crc2 = __builtin_ia32_crc32di(crc2, w2);
+    }
+
+    crc = crc32c_shift(shift, (uint32_t)crc0) ^ (uint32_t)crc1;
+    return crc32c_shift(shift, crc) ^ (uint32_t)crc2;
+}
+
+/**
+ * SSE4.2硬件实现，对齐后每条指令处理8字节，长数据三路并行
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const unsigned char *p, size_t len) {
+    while (len > 0 && ((uintptr_t)p & 7) != 0) {
+        crc = __builtin_ia32_crc32qi(crc, *p++);
+        len--;
+    }
+
+    while (len >= 3 * CRC32C_LONG_LANE) {
+        crc = crc32c_hw_lanes(crc, p, CRC32C_LONG_LANE, g_long_shift);
+        p += 3 * CRC32C_LONG_LANE;
+        len -= 3 * CRC32C_LONG_LANE;
+    }
+    while (len >= 3 * CRC32C_SHORT_LANE) {
+        crc = crc32c_hw_lanes(crc, p, CRC32C_SHORT_LANE, g_short_shift);
+        p += 3 * CRC32C_SHORT_LANE;
+        len -= 3 * CRC32C_SHORT_LANE;
+    }
+
+    uint64_t crc64 = crc;
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+
+    while (len--) {
+        crc = __builtin_ia32_crc32qi(crc, *p++);
+    }
+
+    return crc;
+}
+#endif
+
+/*==============================================================================
+ * CRC32C操作
+ *============================================================================*/
+
+/**
+ * 计算或续算CRC32C
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+    pthread_once(&g_crc_once, crc32c_init);
+
+    crc = ~crc;
+#if CRC32C_HAVE_SSE42
+    if (g_use_sse42) {
+        return ~crc32c_hw(crc, (const unsigned char *)data, len);
+    }
+#endif
+    return ~crc32c_sw(crc, (const unsigned char *)data, len);
+}
+
+/**
+ * 获取当前使用的实现名称
+ */
+const char* crc32c_implementation(void) {
+    pthread_once(&g_crc_once, crc32c_init);
+    return g_use_sse42 ? "sse4.2" : "slice-by-8";
+}
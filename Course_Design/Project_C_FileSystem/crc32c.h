@@ -0,0 +1,43 @@
+/**
+ * CRC32C Header
+ * crc32c.h
+ *
+ * CRC-32C (Castagnoli, reflected polynomial 0x82F63B78) used for disk image
+ * headers, per-block checksums and the file system superblock. On x86-64
+ * CPUs with SSE4.2 the hardware `crc32` instruction is used; everywhere
+ * else a slice-by-8 table implementation processes eight bytes per step.
+ * Both produce identical results, so images are portable between hosts.
+ */
+
+#ifndef _CRC32C_H_
+#define _CRC32C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*==============================================================================
+ * CRC32C OPERATIONS
+ *============================================================================*/
+
+/**
+ * Compute or extend a CRC32C
+ *
+ * Pass 0 as `crc` to start a new checksum. Passing the result of a previous
+ * call continues it, so crc32c(crc32c(0, a, n), b, m) equals the checksum
+ * of a followed by b.
+ *
+ * @param crc Checksum of the preceding data, or 0
+ * @param data Data to checksum
+ * @param len Length of data in bytes
+ * @return Updated checksum
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+/**
+ * Name of the implementation selected for this CPU
+ *
+ * @return "sse4.2" or "slice-by-8"
+ */
+const char* crc32c_implementation(void);
+
+#endif /* _CRC32C_H_ */
@@ -0,0 +1,729 @@
+/**
+ * Deduplicating Block Store Implementation
+ * dedup_store.c
+ *
+ * 去重块存储实现 - 按内容指纹共享相同的块，逻辑块经块映射表指向引用计数的槽
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // pread()/preadv()/pthread_rwlock_t
+#endif
+
+#include "dedup_store.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/* 映射表和指纹表按页跟踪修改，同步时只写回改过的页 */
+#define DEDUP_STORE_TABLE_PAGE  4096
+
+/* 每次preadv最多读取的槽数 */
+#define DEDUP_STORE_MAX_IOV     256
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+/**
+ * 块内容的128位指纹（按此布局存放在指纹表中）
+ */
+typedef struct {
+    uint64_t        lo;             // 指纹缓存以此为键
+    uint64_t        hi;
+} dedup_fp_t;
+
+/**
+ * 指纹缓存项（开放寻址，线性探测）
+ */
+typedef struct {
+    uint64_t        key;            // 指纹低64位
+    uint32_t        slot;           // 槽号加1（0表示空位）
+    uint32_t        reserved;
+} dedup_entry_t;
+
+struct dedup_store {
+    int             fd;             // 镜像文件描述符（不归存储所有）
+    uint32_t        block_size;     // 块大小（字节）
+    uint32_t        total_blocks;   // 逻辑块数
+    uint32_t        max_slots;      // 槽数上限
+    uint64_t        map_offset;     // 块映射表在文件中的偏移
+    uint64_t        fp_offset;      // 指纹表在文件中的偏移
+    uint64_t        data_start;     // 槽数据区起始偏移
+    uint32_t        *map;           // 每个逻辑块的槽号加1（0表示全零块）
+    dedup_fp_t      *fps;           // 每个槽的指纹
+    uint32_t        *refs;          // 每个槽的引用计数
+    uint8_t         *map_dirty;     // 每个映射表页一位，尚未写回
+    uint8_t         *fp_dirty;      // 每个指纹表页一位，尚未写回
+    uint32_t        map_pages;      // 映射表页数
+    uint32_t        fp_pages;       // 指纹表页数
+    uint32_t        *free_slots;    // 可用的槽（栈顶为编号最小的槽）
+    uint32_t        free_count;
+    uint32_t        *pending;       // 引用归零的槽，下次同步后才可重用
+    uint32_t        pending_count;
+    dedup_entry_t   *cache;         // 指纹缓存
+    uint32_t        cache_mask;     // 指纹缓存大小减1（大小为2的幂）
+    char            *scratch;       // 验证匹配时读回的槽数据
+    pthread_rwlock_t lock;          // 读取共享，写入、清零和同步独占
+    dedup_store_stats_t stats;
+};
+
+/*==============================================================================
+ * 内容指纹（MurmurHash3 x64 128位）
+ *============================================================================*/
+
+/**
+ * 64位循环左移
+ */
+static uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * 最终混合，使每个输入位影响所有输出位
+ */
+static uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+/**
+ * 计算块的128位指纹
+ *
+ * 块大小总是16字节的倍数，不需要处理尾部字节。
+ */
+static void fingerprint(const char *data, size_t length, dedup_fp_t *fp) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+
+    for (size_t i = 0; i + 16 <= length; i += 16) {
+        uint64_t k1, k2;
+        memcpy(&k1, data + i, sizeof(k1));
+        memcpy(&k2, data + i + 8, sizeof(k2));
+
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    h1 ^= (uint64_t)length;
+    h2 ^= (uint64_t)length;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    fp->lo = h1;
+    fp->hi = h2;
+}
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 获取单调时钟时间（纳秒）
+ */
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 检查缓冲区是否全零
+ */
+static int is_zero(const char *data, size_t length) {
+    return data[0] == 0 && memcmp(data, data + 1, length - 1) == 0;
+}
+
+/**
+ * 完整读取，处理部分读取和EINTR
+ */
+static int pread_full(int fd, void *buffer, size_t length, uint64_t offset) {
+    char *p = (char *)buffer;
+
+    while (length > 0) {
+        ssize_t bytes = pread(fd, p, length, (off_t)offset);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (bytes == 0) {
+            return -EIO;
+        }
+        p += bytes;
+        length -= (size_t)bytes;
+        offset += (uint64_t)bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * 完整写入，处理部分写入和EINTR
+ */
+static int pwrite_full(int fd, const void *data, size_t length, uint64_t offset) {
+    const char *p = (const char *)data;
+
+    while (length > 0) {
+        ssize_t bytes = pwrite(fd, p, length, (off_t)offset);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        p += bytes;
+        length -= (size_t)bytes;
+        offset += (uint64_t)bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * 槽在文件中的偏移
+ */
+static uint64_t slot_offset(const dedup_store_t *store, uint32_t slot) {
+    return store->data_start + (uint64_t)slot * store->block_size;
+}
+
+/**
+ * 标记表中一项所在的页待回写
+ */
+static void mark_page(uint8_t *dirty, uint64_t byte_offset) {
+    uint64_t page = byte_offset / DEDUP_STORE_TABLE_PAGE;
+    dirty[page / 8] |= (uint8_t)(1 << (page % 8));
+}
+
+/**
+ * 把指纹加入缓存
+ */
+static void cache_insert(dedup_store_t *store, uint32_t slot) {
+    uint32_t i = (uint32_t)store->fps[slot].lo & store->cache_mask;
+    while (store->cache[i].slot != 0) {
+        i = (i + 1) & store->cache_mask;
+    }
+    store->cache[i].key = store->fps[slot].lo;
+    store->cache[i].slot = slot + 1;
+}
+
+/**
+ * 从缓存中删除槽的指纹
+ *
+ * 线性探测下删除后把同一探测链上后面的项前移，不留删除标记。
+ */
+static void cache_remove(dedup_store_t *store, uint32_t slot) {
+    uint32_t mask = store->cache_mask;
+    uint32_t i = (uint32_t)store->fps[slot].lo & mask;
+    while (store->cache[i].slot != slot + 1) {
+        if (store->cache[i].slot == 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    uint32_t j = i;
+    for (;;) {
+        store->cache[i].slot = 0;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (store->cache[j].slot == 0) {
+                return;
+            }
+            // j处的项可以前移到i，当且仅当它的初始位置不在(i, j]之间
+            uint32_t home = (uint32_t)store->cache[j].key & mask;
+            if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+                break;
+            }
+        }
+        store->cache[i] = store->cache[j];
+        i = j;
+    }
+}
+
+/**
+ * 按指纹查找内容相同的槽
+ *
+ * 指纹匹配后读回槽数据逐字节比较，哈希碰撞或崩溃后过期的指纹不会
+ * 把不同的数据合并在一起。
+ *
+ * @return 1找到（slot为槽号），0未找到，负数为读取错误
+ */
+static int cache_lookup(dedup_store_t *store, const dedup_fp_t *fp, const char *data,
+                        uint32_t *slot) {
+    uint32_t i = (uint32_t)fp->lo & store->cache_mask;
+
+    store->stats.lookups++;
+    for (;;) {
+        const dedup_entry_t *entry = &store->cache[i];
+        store->stats.lookup_probes++;
+        if (entry->slot == 0) {
+            return 0;
+        }
+
+        uint32_t candidate = entry->slot - 1;
+        if (entry->key == fp->lo && store->fps[candidate].hi == fp->hi) {
+            store->stats.verify_reads++;
+            int result = pread_full(store->fd, store->scratch, store->block_size,
+                                    slot_offset(store, candidate));
+            if (result != 0) {
+                return result;
+            }
+            if (memcmp(store->scratch, data, store->block_size) == 0) {
+                *slot = candidate;
+                return 1;
+            }
+            store->stats.hash_collisions++;
+        }
+        i = (i + 1) & store->cache_mask;
+    }
+}
+
+/**
+ * 修改逻辑块的映射，并维护新旧槽的引用计数
+ *
+ * 引用归零的槽从指纹缓存中删除，等下次同步后再重用。
+ */
+static void set_mapping(dedup_store_t *store, uint32_t block, uint32_t entry) {
+    uint32_t old = store->map[block];
+    if (old == entry) {
+        return;
+    }
+
+    if (entry != 0) {
+        store->refs[entry - 1]++;
+    }
+    if (old != 0 && --store->refs[old - 1] == 0) {
+        cache_remove(store, old - 1);
+        store->pending[store->pending_count++] = old - 1;
+        store->stats.stored_slots--;
+    }
+    if (old == 0) {
+        store->stats.referenced_blocks++;
+    } else if (entry == 0) {
+        store->stats.referenced_blocks--;
+    }
+
+    store->map[block] = entry;
+    mark_page(store->map_dirty, (uint64_t)block * sizeof(uint32_t));
+}
+
+/**
+ * 把表中修改过的页写回文件（不同步）
+ */
+static int write_table(dedup_store_t *store, const void *table, uint64_t table_bytes,
+                       uint64_t file_offset, uint8_t *dirty, uint32_t pages) {
+    for (uint32_t page = 0; page < pages; page++) {
+        uint8_t mask = (uint8_t)(1 << (page % 8));
+        if (!(dirty[page / 8] & mask)) {
+            continue;
+        }
+
+        uint64_t offset = (uint64_t)page * DEDUP_STORE_TABLE_PAGE;
+        uint64_t length = table_bytes - offset;
+        if (length > DEDUP_STORE_TABLE_PAGE) {
+            length = DEDUP_STORE_TABLE_PAGE;
+        }
+
+        int result = pwrite_full(store->fd, (const char *)table + offset, (size_t)length,
+                                 file_offset + offset);
+        if (result != 0) {
+            return result;
+        }
+        dirty[page / 8] &= (uint8_t)~mask;
+    }
+
+    return 0;
+}
+
+/**
+ * 使所有写入持久化（调用方持有写锁）
+ */
+static int sync_locked(dedup_store_t *store, int data_only) {
+    int dirty = 0;
+    for (uint32_t i = 0; i < (store->map_pages + 7) / 8; i++) {
+        dirty |= store->map_dirty[i];
+    }
+    for (uint32_t i = 0; i < (store->fp_pages + 7) / 8; i++) {
+        dirty |= store->fp_dirty[i];
+    }
+
+    int result = 0;
+    if (dirty) {
+        result = fdatasync(store->fd) == 0 ? 0 : -errno;
+        if (result == 0) {
+            result = write_table(store, store->fps, (uint64_t)store->max_slots * sizeof(dedup_fp_t),
+                                 store->fp_offset, store->fp_dirty, store->fp_pages);
+        }
+        if (result == 0) {
+            result = write_table(store, store->map,
+                                 (uint64_t)store->total_blocks * sizeof(uint32_t),
+                                 store->map_offset, store->map_dirty, store->map_pages);
+        }
+    }
+    if (result == 0 && (data_only ? fdatasync(store->fd) : fsync(store->fd)) != 0) {
+        result = -errno;
+    }
+
+    // 映射表已不再引用这些槽，可以重用（编号小的先用，文件保持紧凑）
+    if (result == 0) {
+        while (store->pending_count > 0) {
+            store->free_slots[store->free_count++] = store->pending[--store->pending_count];
+        }
+    }
+    return result;
+}
+
+/**
+ * 分配一个空闲槽
+ *
+ * 存活的槽不超过逻辑块数，空闲槽用完时同步一次即可回收等待中的槽。
+ */
+static int alloc_slot(dedup_store_t *store, uint32_t *slot) {
+    if (store->free_count == 0) {
+        int result = sync_locked(store, 1);
+        if (result != 0) {
+            return result;
+        }
+        if (store->free_count == 0) {
+            return -ENOSPC;
+        }
+    }
+
+    *slot = store->free_slots[--store->free_count];
+    return 0;
+}
+
+/**
+ * 写入一个块（调用方持有写锁）
+ */
+static int write_block(dedup_store_t *store, uint32_t block, const char *data) {
+    store->stats.blocks_written++;
+    if (is_zero(data, store->block_size)) {
+        store->stats.zero_blocks++;
+        set_mapping(store, block, 0);
+        return 0;
+    }
+
+    uint64_t begin = monotonic_ns();
+    dedup_fp_t fp;
+    fingerprint(data, store->block_size, &fp);
+    uint32_t slot = 0;
+    int found = cache_lookup(store, &fp, data, &slot);
+    latency_hist_record(&store->stats.lookup_latency, monotonic_ns() - begin);
+    if (found < 0) {
+        return found;
+    }
+
+    if (found) {
+        store->stats.duplicate_blocks++;
+        set_mapping(store, block, slot + 1);
+        return 0;
+    }
+
+    int result = alloc_slot(store, &slot);
+    if (result == 0) {
+        result = pwrite_full(store->fd, data, store->block_size, slot_offset(store, slot));
+        if (result != 0) {
+            store->free_slots[store->free_count++] = slot;
+        }
+    }
+    if (result != 0) {
+        return result;
+    }
+
+    store->fps[slot] = fp;
+    mark_page(store->fp_dirty, (uint64_t)slot * sizeof(dedup_fp_t));
+    cache_insert(store, slot);
+    store->refs[slot] = 0;
+    store->stats.unique_blocks++;
+    store->stats.stored_slots++;
+    set_mapping(store, block, slot + 1);
+    return 0;
+}
+
+/**
+ * 加载并检查映射表和指纹表，重建引用计数、空闲槽和指纹缓存
+ */
+static int load_tables(dedup_store_t *store) {
+    struct stat file_stat;
+    if (fstat(store->fd, &file_stat) != 0) {
+        return -errno;
+    }
+    if ((uint64_t)file_stat.st_size < store->data_start) {
+        return -EBADMSG;
+    }
+
+    int result = pread_full(store->fd, store->map,
+                            (size_t)store->total_blocks * sizeof(uint32_t), store->map_offset);
+    if (result == 0) {
+        result = pread_full(store->fd, store->fps, (size_t)store->max_slots * sizeof(dedup_fp_t),
+                            store->fp_offset);
+    }
+    if (result != 0) {
+        return result;
+    }
+
+    for (uint32_t b = 0; b < store->total_blocks; b++) {
+        uint32_t entry = store->map[b];
+        if (entry == 0) {
+            continue;
+        }
+        if (entry > store->max_slots ||
+            slot_offset(store, entry - 1) + store->block_size > (uint64_t)file_stat.st_size) {
+            return -EBADMSG;
+        }
+        store->refs[entry - 1]++;
+        store->stats.referenced_blocks++;
+    }
+
+    for (uint32_t slot = store->max_slots; slot-- > 0; ) {
+        if (store->refs[slot] == 0) {
+            store->free_slots[store->free_count++] = slot;
+        } else {
+            cache_insert(store, slot);
+            store->stats.stored_slots++;
+        }
+    }
+
+    return 0;
+}
+
+/*==============================================================================
+ * 去重块存储操作
+ *============================================================================*/
+
+/**
+ * 计算槽数据区的起始偏移
+ */
+uint64_t dedup_store_data_offset(uint64_t index_offset, uint32_t total_blocks,
+                                 uint32_t block_size) {
+    uint64_t map_bytes = (uint64_t)total_blocks * sizeof(uint32_t);
+    uint64_t fp_bytes = ((uint64_t)total_blocks + DEDUP_STORE_SPARE_SLOTS) * sizeof(dedup_fp_t);
+    return index_offset + (map_bytes + block_size - 1) / block_size * block_size +
+           (fp_bytes + block_size - 1) / block_size * block_size;
+}
+
+/**
+ * 打开镜像文件中的去重块存储
+ */
+int dedup_store_open(int fd, uint64_t index_offset, uint32_t total_blocks, uint32_t block_size,
+                     int create, dedup_store_t **store) {
+    if (!store || total_blocks == 0 || block_size == 0 || block_size % 16 != 0 ||
+        total_blocks > UINT32_MAX / 4) {
+        return -EINVAL;
+    }
+
+    dedup_store_t *ds = (dedup_store_t *)calloc(1, sizeof(dedup_store_t));
+    if (!ds) {
+        return -ENOMEM;
+    }
+    pthread_rwlock_init(&ds->lock, NULL);
+
+    ds->fd = fd;
+    ds->block_size = block_size;
+    ds->total_blocks = total_blocks;
+    ds->max_slots = total_blocks + DEDUP_STORE_SPARE_SLOTS;
+    ds->map_offset = index_offset;
+    uint64_t map_bytes = (uint64_t)total_blocks * sizeof(uint32_t);
+    ds->fp_offset = index_offset + (map_bytes + block_size - 1) / block_size * block_size;
+    ds->data_start = dedup_store_data_offset(index_offset, total_blocks, block_size);
+    ds->map_pages = (uint32_t)((map_bytes + DEDUP_STORE_TABLE_PAGE - 1) / DEDUP_STORE_TABLE_PAGE);
+    ds->fp_pages = (uint32_t)(((uint64_t)ds->max_slots * sizeof(dedup_fp_t) +
+                               DEDUP_STORE_TABLE_PAGE - 1) / DEDUP_STORE_TABLE_PAGE);
+
+    // 指纹缓存至少是槽数的两倍，探测链保持很短
+    uint32_t cache_size = 1;
+    while (cache_size < ds->max_slots * 2) {
+        cache_size <<= 1;
+    }
+    ds->cache_mask = cache_size - 1;
+
+    ds->map = (uint32_t *)calloc(total_blocks, sizeof(uint32_t));
+    ds->fps = (dedup_fp_t *)calloc(ds->max_slots, sizeof(dedup_fp_t));
+    ds->refs = (uint32_t *)calloc(ds->max_slots, sizeof(uint32_t));
+    ds->map_dirty = (uint8_t *)calloc((ds->map_pages + 7) / 8, 1);
+    ds->fp_dirty = (uint8_t *)calloc((ds->fp_pages + 7) / 8, 1);
+    ds->free_slots = (uint32_t *)malloc((size_t)ds->max_slots * sizeof(uint32_t));
+    ds->pending = (uint32_t *)malloc((size_t)ds->max_slots * sizeof(uint32_t));
+    ds->cache = (dedup_entry_t *)calloc(cache_size, sizeof(dedup_entry_t));
+    ds->scratch = (char *)malloc(block_size);
+
+    int result = (ds->map && ds->fps && ds->refs && ds->map_dirty && ds->fp_dirty &&
+                  ds->free_slots && ds->pending && ds->cache && ds->scratch) ? 0 : -ENOMEM;
+
+    // 新镜像的表读出全零，即所有块都为空
+    if (result == 0) {
+        if (create) {
+            result = ftruncate(fd, (off_t)ds->data_start) == 0 ? 0 : -errno;
+            for (uint32_t slot = ds->max_slots; slot-- > 0; ) {
+                ds->free_slots[ds->free_count++] = slot;
+            }
+        } else {
+            result = load_tables(ds);
+        }
+    }
+
+    if (result != 0) {
+        dedup_store_close(ds);
+        return result;
+    }
+
+    *store = ds;
+    return 0;
+}
+
+/**
+ * 释放去重块存储
+ */
+void dedup_store_close(dedup_store_t *store) {
+    if (!store) {
+        return;
+    }
+
+    free(store->scratch);
+    free(store->cache);
+    free(store->pending);
+    free(store->free_slots);
+    free(store->fp_dirty);
+    free(store->map_dirty);
+    free(store->refs);
+    free(store->fps);
+    free(store->map);
+    pthread_rwlock_destroy(&store->lock);
+    free(store);
+}
+
+/**
+ * 读取一段连续块
+ */
+int dedup_store_read(dedup_store_t *store, uint32_t start_block, uint32_t count,
+                     char *const *blocks) {
+    struct iovec iov[DEDUP_STORE_MAX_IOV];
+    int result = 0;
+
+    pthread_rwlock_rdlock(&store->lock);
+    for (uint32_t i = 0; i < count && result == 0; ) {
+        uint32_t entry = store->map[start_block + i];
+        if (entry == 0) {
+            memset(blocks[i], 0, store->block_size);
+            i++;
+            continue;
+        }
+
+        // 存放在相邻槽中的连续块合并为一次preadv
+        uint32_t n = 0;
+        while (i + n < count && n < DEDUP_STORE_MAX_IOV &&
+               store->map[start_block + i + n] == entry + n) {
+            iov[n].iov_base = blocks[i + n];
+            iov[n].iov_len = store->block_size;
+            n++;
+        }
+
+        ssize_t expected = (ssize_t)n * store->block_size;
+        ssize_t bytes = preadv(store->fd, iov, (int)n, (off_t)slot_offset(store, entry - 1));
+        if (bytes != expected) {
+            result = bytes < 0 ? -errno : -EIO;
+        }
+        i += n;
+    }
+    pthread_rwlock_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 写入一段连续块
+ */
+int dedup_store_write(dedup_store_t *store, uint32_t start_block, uint32_t count,
+                      const char *const *blocks) {
+    int result = 0;
+
+    pthread_rwlock_wrlock(&store->lock);
+    for (uint32_t i = 0; i < count && result == 0; i++) {
+        result = write_block(store, start_block + i, blocks[i]);
+    }
+    pthread_rwlock_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 清零一段连续块
+ */
+int dedup_store_zero(dedup_store_t *store, uint32_t start_block, uint32_t count) {
+    pthread_rwlock_wrlock(&store->lock);
+    for (uint32_t i = 0; i < count; i++) {
+        set_mapping(store, start_block + i, 0);
+    }
+    pthread_rwlock_unlock(&store->lock);
+
+    return 0;
+}
+
+/**
+ * 使所有写入持久化
+ *
+ * 先同步槽数据，再写回指纹表和映射表并同步：映射表落盘时它引用的数据
+ * 已经持久，引用归零的槽直到此时才能重用。
+ */
+int dedup_store_sync(dedup_store_t *store, int data_only) {
+    pthread_rwlock_wrlock(&store->lock);
+    int result = sync_locked(store, data_only);
+    pthread_rwlock_unlock(&store->lock);
+
+    return result;
+}
+
+/**
+ * 获取统计
+ */
+void dedup_store_get_stats(dedup_store_t *store, dedup_store_stats_t *stats) {
+    pthread_rwlock_rdlock(&store->lock);
+    *stats = store->stats;
+    latency_hist_snapshot(&stats->lookup_latency, &store->stats.lookup_latency);
+    pthread_rwlock_unlock(&store->lock);
+}
+
+/**
+ * 重置统计（保留当前的引用量和存储量）
+ */
+void dedup_store_reset_stats(dedup_store_t *store) {
+    pthread_rwlock_wrlock(&store->lock);
+    uint64_t referenced_blocks = store->stats.referenced_blocks;
+    uint64_t stored_slots = store->stats.stored_slots;
+
+    memset(&store->stats, 0, sizeof(store->stats));
+    store->stats.referenced_blocks = referenced_blocks;
+    store->stats.stored_slots = stored_slots;
+    pthread_rwlock_unlock(&store->lock);
+}
@@ -0,0 +1,158 @@
+/**
+ * Deduplicating Block Store Header
+ * dedup_store.h
+ *
+ * Block storage for deduplicated disk images. Every written block is
+ * fingerprinted with a 128-bit hash (MurmurHash3 x64); blocks with the
+ * same contents share one slot in the image file. Two tables after the
+ * image header describe the store:
+ *
+ *   - the block map: slot + 1 for each logical block, 0 for a block that
+ *     was never written or is all zeros (it reads back as zeros without
+ *     any file I/O)
+ *   - the fingerprint table: the hash of the data in each slot
+ *
+ * Slots are reference counted; a slot whose last reference goes away is
+ * reused only after the next dedup_store_sync() has made the map that no
+ * longer references it durable. A rewritten block therefore always goes
+ * to a fresh slot (or an existing duplicate), and the map on disk always
+ * describes the contents of the last sync, even after a crash.
+ *
+ * At open the fingerprints of all referenced slots are loaded into an
+ * in-memory hash table (the fingerprint cache), so a lookup costs no file
+ * I/O until a fingerprint matches; the matching slot is then read back
+ * and compared byte for byte before it is shared, so hash collisions and
+ * fingerprints left stale by a crash never merge different data.
+ *
+ * Reads run in parallel; writes, zeroing and sync are serialized by the
+ * store's lock.
+ */
+
+#ifndef _DEDUP_STORE_H_
+#define _DEDUP_STORE_H_
+
+#include <stdint.h>
+#include "latency_hist.h"
+
+/*==============================================================================
+ * DEDUP STORE CONSTANTS
+ *============================================================================*/
+
+#define DEDUP_STORE_SPARE_SLOTS 64          // Slots beyond the block count (rewrites between syncs)
+
+/* Store internals live in dedup_store.c */
+typedef struct dedup_store dedup_store_t;
+
+/**
+ * Dedup Store Statistics
+ *
+ * The dedup ratio is referenced_blocks / stored_slots. lookup_latency
+ * records, for every non-zero block written, the time to hash it, probe
+ * the fingerprint cache and verify a match.
+ */
+typedef struct {
+    uint64_t    blocks_written;     // Block writes handled by the store
+    uint64_t    unique_blocks;      // Writes stored in a new slot
+    uint64_t    duplicate_blocks;   // Writes that referenced an existing slot instead
+    uint64_t    zero_blocks;        // Writes of all-zero blocks (no slot at all)
+    uint64_t    lookups;            // Fingerprint cache lookups
+    uint64_t    lookup_probes;      // Cache entries examined by those lookups
+    uint64_t    verify_reads;       // Slots read back to confirm a fingerprint match
+    uint64_t    hash_collisions;    // Fingerprint matches whose data differed
+    latency_hist_t lookup_latency;  // Hash + lookup + verify time of each written block
+    uint64_t    referenced_blocks;  // Logical blocks currently mapped to a slot
+    uint64_t    stored_slots;       // Slots currently holding data
+} dedup_store_stats_t;
+
+/*==============================================================================
+ * DEDUP STORE OPERATIONS
+ *============================================================================*/
+
+/**
+ * File offset at which slot data starts (the end of the tables)
+ *
+ * @param index_offset File offset of the block map
+ * @param total_blocks Logical blocks in the image
+ * @param block_size Block size in bytes
+ * @return First byte after the fingerprint table, rounded up to the block size
+ */
+uint64_t dedup_store_data_offset(uint64_t index_offset, uint32_t total_blocks,
+                                 uint32_t block_size);
+
+/**
+ * Open the store of an image file
+ *
+ * With `create` the tables are initialized empty (every block reads as
+ * zeros) by truncating the file to the end of the fingerprint table.
+ * Otherwise the tables are loaded and checked, reference counts are
+ * rebuilt from the block map and the fingerprint cache is filled.
+ *
+ * @param fd Image descriptor; the store uses but does not close it
+ * @param index_offset File offset of the block map
+ * @param total_blocks Logical blocks in the image
+ * @param block_size Block size in bytes
+ * @param create Nonzero for a new image
+ * @param store Receives the new store
+ * @return 0 on success, -EBADMSG for damaged tables, other -errno on failure
+ */
+int dedup_store_open(int fd, uint64_t index_offset, uint32_t total_blocks, uint32_t block_size,
+                     int create, dedup_store_t **store);
+
+/**
+ * Free a store without writing anything (call dedup_store_sync() first)
+ */
+void dedup_store_close(dedup_store_t *store);
+
+/**
+ * Read a run of consecutive blocks
+ *
+ * Blocks stored in consecutive slots are read with one preadv().
+ *
+ * @param blocks blocks[i] receives block start_block + i
+ * @return 0 on success, -errno on I/O errors
+ */
+int dedup_store_read(dedup_store_t *store, uint32_t start_block, uint32_t count,
+                     char *const *blocks);
+
+/**
+ * Write a run of consecutive blocks
+ *
+ * Each block is looked up by fingerprint; only blocks not already stored
+ * are written to the file.
+ *
+ * @param blocks blocks[i] holds block start_block + i
+ * @return 0 on success, -errno on failure
+ */
+int dedup_store_write(dedup_store_t *store, uint32_t start_block, uint32_t count,
+                      const char *const *blocks);
+
+/**
+ * Clear a run of blocks to zeros (drops their slot references)
+ *
+ * @return 0 on success, -errno on failure
+ */
+int dedup_store_zero(dedup_store_t *store, uint32_t start_block, uint32_t count);
+
+/**
+ * Make all writes durable
+ *
+ * Syncs the slot data, then writes the changed pages of the fingerprint
+ * table and the block map and syncs again. Slots released since the last
+ * sync become reusable afterwards.
+ *
+ * @param data_only Nonzero to use fdatasync() for the final sync
+ * @return 0 on success, -errno on failure
+ */
+int dedup_store_sync(dedup_store_t *store, int data_only);
+
+/**
+ * Copy the statistics (histogram as a consistent snapshot)
+ */
+void dedup_store_get_stats(dedup_store_t *store, dedup_store_stats_t *stats);
+
+/**
+ * Clear the counters and histogram (the referenced/stored gauges are kept)
+ */
+void dedup_store_reset_stats(dedup_store_t *store);
+
+#endif /* _DEDUP_STORE_H_ */
@@ -0,0 +1,255 @@
+/**
+ * 磁盘模拟器多线程基准测试
+ * disk_bench.c
+ *
+ * 多个线程同时对同一个磁盘镜像做随机块读取，测量吞吐量随线程数的变化。
+ * 每次读取都会校验块内容，确保并发I/O下数据正确。fsync/group模式改为
+ * 测量持久写入（每次写入返回时已落盘）的吞吐量。校验和参数为1时磁盘镜像
+ * 带每块CRC32C校验和，用于比较端到端校验的开销。最后一个参数选择模拟的
+ * 设备（按设备时序模型实际延迟），用于在真实设备速度下比较缓存和调度策略。
+ *
+ * 用法: ./disk_bench [最大线程数] [每线程操作次数] [缓存块数] [pread|mmap|fsync|group] [块大小] [校验和]
+ *                    [none|hdd|ssd|nvme]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "disk_simulator.h"
+
+#define BENCH_DISK_FILE "bench_disk.img"
+#define BENCH_DISK_SIZE (64 * 1024 * 1024)  // 64MB磁盘
+
+/* 基准磁盘的块数（取决于块大小） */
+static uint32_t g_block_count;
+
+/**
+ * 线程参数
+ */
+typedef struct {
+    int         thread_id;
+    int         ops;
+    int         errors;
+} bench_thread_t;
+
+/**
+ * 获取当前时间（秒）
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/**
+ * 生成块内容：块号写在块开头，其余为可校验的模式
+ */
+static void fill_block(char *buffer, uint32_t block_num, uint32_t block_size) {
+    memcpy(buffer, &block_num, sizeof(block_num));
+    for (uint32_t i = sizeof(block_num); i < block_size; i++) {
+        buffer[i] = (char)(block_num + i);
+    }
+}
+
+/**
+ * 读线程：随机读取块并校验
+ */
+static void *reader_thread(void *arg) {
+    bench_thread_t *t = (bench_thread_t *)arg;
+    uint32_t seed = 2463534242u + t->thread_id * 7919u;
+    uint32_t block_size = disk_get_block_size();
+    char buffer[block_size];
+
+    for (int i = 0; i < t->ops; i++) {
+        // xorshift随机数
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        uint32_t block_num = seed % g_block_count;
+
+        if (disk_read_block(block_num, buffer) != DISK_SUCCESS) {
+            t->errors++;
+            continue;
+        }
+
+        uint32_t stored;
+        memcpy(&stored, buffer, sizeof(stored));
+        if (stored != block_num || buffer[block_size - 1] != (char)(block_num + block_size - 1)) {
+            t->errors++;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * 写线程：随机写入块，每次写入返回时已持久化
+ */
+static void *writer_thread(void *arg) {
+    bench_thread_t *t = (bench_thread_t *)arg;
+    uint32_t seed = 2463534242u + t->thread_id * 7919u;
+    uint32_t block_size = disk_get_block_size();
+    char buffer[block_size];
+
+    for (int i = 0; i < t->ops; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        uint32_t block_num = seed % g_block_count;
+
+        fill_block(buffer, block_num, block_size);
+        if (disk_write_block(block_num, buffer) != DISK_SUCCESS) {
+            t->errors++;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * 准备基准测试磁盘
+ */
+static int prepare_disk(void) {
+    unlink(BENCH_DISK_FILE);
+
+    int result = disk_init(BENCH_DISK_FILE, BENCH_DISK_SIZE);
+    if (result != DISK_SUCCESS) {
+        printf("磁盘初始化失败: %s\n", disk_error_to_string(result));
+        return result;
+    }
+
+    uint32_t block_size = disk_get_block_size();
+    g_block_count = BENCH_DISK_SIZE / block_size;
+    printf("写入 %u 个测试块...\n", g_block_count);
+    char buffer[block_size];
+    for (uint32_t i = 0; i < g_block_count; i++) {
+        fill_block(buffer, i, block_size);
+        result = disk_write_block(i, buffer);
+        if (result != DISK_SUCCESS) {
+            printf("写入块 %u 失败: %s\n", i, disk_error_to_string(result));
+            return result;
+        }
+    }
+
+    return disk_sync();
+}
+
+/**
+ * 运行一轮基准测试
+ */
+static int run_round(void *(*worker)(void *), int threads, int ops_per_thread,
+                     double *throughput) {
+    pthread_t tids[threads];
+    bench_thread_t args[threads];
+
+    double start = now_seconds();
+    for (int i = 0; i < threads; i++) {
+        args[i].thread_id = i;
+        args[i].ops = ops_per_thread;
+        args[i].errors = 0;
+        pthread_create(&tids[i], NULL, worker, &args[i]);
+    }
+
+    int errors = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        errors += args[i].errors;
+    }
+    double elapsed = now_seconds() - start;
+
+    *throughput = (threads * (double)ops_per_thread) / elapsed;
+    return errors;
+}
+
+int main(int argc, char *argv[]) {
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int ops_per_thread = (argc > 2) ? atoi(argv[2]) : 20000;
+    uint32_t cache_blocks = (argc > 3) ? (uint32_t)atoi(argv[3]) : 0;
+    const char *mode = (argc > 4) ? argv[4] : "pread";
+    uint32_t block_size = (argc > 5) ? (uint32_t)atoi(argv[5]) : DISK_BLOCK_SIZE;
+    int use_checksums = (argc > 6) ? atoi(argv[6]) : 0;
+    const char *device = (argc > 7) ? argv[7] : "none";
+    timing_profile_t profile = strcmp(device, "hdd") == 0  ? TIMING_PROFILE_HDD
+                             : strcmp(device, "ssd") == 0  ? TIMING_PROFILE_SATA_SSD
+                             : strcmp(device, "nvme") == 0 ? TIMING_PROFILE_NVME
+                                                           : TIMING_PROFILE_NONE;
+    int use_mmap = strcmp(mode, "mmap") == 0;
+    int use_fsync = strcmp(mode, "fsync") == 0;
+    int use_group = strcmp(mode, "group") == 0;
+
+    if (max_threads <= 0 || ops_per_thread <= 0 ||
+        (!use_mmap && !use_fsync && !use_group && strcmp(mode, "pread") != 0) ||
+        (profile == TIMING_PROFILE_NONE && strcmp(device, "none") != 0) ||
+        disk_set_block_size(block_size) != DISK_SUCCESS) {
+        printf("用法: %s [最大线程数] [每线程操作次数] [缓存块数] [pread|mmap|fsync|group] [块大小] [校验和] [none|hdd|ssd|nvme]\n", argv[0]);
+        return 1;
+    }
+    disk_set_checksums(use_checksums);
+
+    printf("磁盘模拟器多线程基准测试\n");
+    printf("========================\n");
+    printf("磁盘大小: %d MB, 块大小: %u 字节, 每线程操作: %d 次, 缓存: %u 块, 模式: %s\n",
+           BENCH_DISK_SIZE / (1024 * 1024), block_size, ops_per_thread, cache_blocks, mode);
+    printf("块校验和: %s, 模拟设备: %s\n\n", use_checksums ? crc32c_implementation() : "禁用",
+           timing_profile_name(profile));
+
+    if (prepare_disk() != DISK_SUCCESS) {
+        return 1;
+    }
+    disk_set_cache_capacity(cache_blocks);
+    if (disk_set_timing_model(profile, 0, 1) != DISK_SUCCESS) {
+        printf("设置设备模型失败\n");
+        return 1;
+    }
+    if (use_mmap && disk_set_mmap_mode(1) != DISK_SUCCESS) {
+        printf("启用mmap模式失败\n");
+        return 1;
+    }
+    // 持久写模式：每次写入后fsync，或由组提交批量fdatasync
+    if (use_fsync) {
+        g_disk_state.auto_sync = 1;
+    }
+    if (use_group && disk_set_group_commit(1000, 0) != DISK_SUCCESS) {
+        printf("启用组提交失败\n");
+        return 1;
+    }
+    void *(*worker)(void *) = (use_fsync || use_group) ? writer_thread : reader_thread;
+
+    printf("\n线程数\t吞吐量(次/秒)\t加速比\t错误\n");
+    printf("------\t-------------\t------\t----\n");
+
+    double baseline = 0.0;
+    int total_errors = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double throughput;
+        int errors = run_round(worker, threads, ops_per_thread, &throughput);
+        if (threads == 1) {
+            baseline = throughput;
+        }
+        printf("%d\t%.0f\t\t%.2fx\t%d\n", threads, throughput, throughput / baseline, errors);
+        total_errors += errors;
+    }
+
+    if (use_group) {
+        disk_stats_t stats;
+        disk_get_stats(&stats);
+        printf("\n组提交: %lu 次刷新, 平均每批 %.1f 次写入\n", stats.group_commits,
+               stats.group_commits ? (double)stats.group_commit_writes / stats.group_commits : 0.0);
+    }
+    if (profile != TIMING_PROFILE_NONE) {
+        disk_stats_t stats;
+        disk_get_stats(&stats);
+        printf("\n设备 %s: %lu 次I/O (寻道 %lu 次)\n", timing_profile_name(profile),
+               stats.device_ios, stats.device_seeks);
+        latency_hist_print(&stats.device_latency, "设备");
+    }
+
+    disk_close();
+    disk_set_group_commit(0, 0);
+    disk_set_timing_model(TIMING_PROFILE_NONE, 0, 0);
+    unlink(BENCH_DISK_FILE);
+
+    printf("\n%s\n", total_errors == 0 ? "数据校验全部通过" : "存在数据校验错误！");
+    return total_errors == 0 ? 0 : 1;
+}
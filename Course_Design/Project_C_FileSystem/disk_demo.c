@@ -29,11 +29,11 @@ void demo_basic_operations(void) {
     printf("   ✓ 磁盘初始化成功\n");
     
     // 获取磁盘信息
-    uint32_t total_blocks, block_size;
-    uint64_t disk_size;
+    uint64_t total_blocks, disk_size;
+    uint32_t block_size;
     disk_get_info(&total_blocks, &block_size, &disk_size);
     printf("2. 磁盘信息:\n");
-    printf("   - 总块数: %u\n", total_blocks);
+    printf("   - 总块数: %lu\n", total_blocks);
     printf("   - 块大小: %u 字节\n", block_size);
     printf("   - 磁盘大小: %lu 字节 (%.2f MB)\n", 
            disk_size, disk_size / (1024.0 * 1024.0));
@@ -170,12 +170,12 @@ void demo_utility_functions(void) {
     
     // 块验证
     printf("3. 块号验证...\n");
-    uint32_t block_count = disk_get_block_count();
-    printf("   - 有效块范围: 0 - %u\n", block_count - 1);
+    uint64_t block_count = disk_get_block_count();
+    printf("   - 有效块范围: 0 - %lu\n", block_count - 1);
     printf("   - 块0有效性: %s\n", disk_is_valid_block(0) ? "有效" : "无效");
-    printf("   - 块%u有效性: %s\n", block_count - 1, 
+    printf("   - 块%lu有效性: %s\n", block_count - 1, 
            disk_is_valid_block(block_count - 1) ? "有效" : "无效");
-    printf("   - 块%u有效性: %s\n", block_count, 
+    printf("   - 块%lu有效性: %s\n", block_count, 
            disk_is_valid_block(block_count) ? "有效" : "无效");
 }
 
@@ -212,8 +212,12 @@ void demo_statistics(void) {
     printf("   - 写入字节数: %lu\n", stats.bytes_written);
     printf("   - 读取错误: %lu\n", stats.read_errors);
     printf("   - 写入错误: %lu\n", stats.write_errors);
-    printf("   - 平均读取时间: %.6f 秒\n", stats.avg_read_time);
-    printf("   - 平均写入时间: %.6f 秒\n", stats.avg_write_time);
+    printf("   - 读取延迟: 平均 %.1f us, p99 %.1f us\n",
+           latency_hist_mean(&stats.read_latency) / 1000.0,
+           latency_hist_percentile(&stats.read_latency, 99) / 1000.0);
+    printf("   - 写入延迟: 平均 %.1f us, p99 %.1f us\n",
+           latency_hist_mean(&stats.write_latency) / 1000.0,
+           latency_hist_percentile(&stats.write_latency, 99) / 1000.0);
 }
 
 /**
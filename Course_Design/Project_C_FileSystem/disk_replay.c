@@ -0,0 +1,269 @@
+/**
+ * 磁盘模拟器I/O跟踪回放
+ * disk_replay.c
+ *
+ * 读入disk_trace_start()记录的跟踪文件，按原顺序对新建的磁盘镜像重新发出
+ * 每次读、写和同步调用。fast模式一个接一个尽快发出，timed模式按记录中的
+ * 原始发出时刻发出（前一次调用超时则立即发出，并统计落后的时间）。后端
+ * 参数选择镜像的存放方式，设备参数选择设备时序模型，用于在同一负载下比较
+ * 不同的配置。最后输出吞吐量，以及回放和原始记录的各类调用延迟分布。
+ *
+ * 用法: ./disk_replay 跟踪文件 [fast|timed] [plain|mmap|mem|csum|compress|dedup|stripe] [缓存块数]
+ *                     [none|hdd|ssd|nvme] [镜像文件]
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // clock_nanosleep()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "disk_simulator.h"
+
+#define REPLAY_DISK_FILE "replay_disk.img"
+#define REPLAY_STRIPE_MEMBERS 4         // stripe后端的成员数
+
+/**
+ * 一类调用的回放结果
+ */
+typedef struct {
+    uint64_t        calls;
+    uint64_t        blocks;
+    uint64_t        errors;
+    latency_hist_t  replayed;       // 回放时的调用延迟
+    latency_hist_t  original;       // 跟踪中记录的调用延迟
+} replay_op_stats_t;
+
+/**
+ * 获取单调时钟时间（纳秒）
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 睡眠到指定的单调时钟时刻
+ */
+static void sleep_until(uint64_t deadline_ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+    ts.tv_nsec = (long)(deadline_ns % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+/**
+ * 生成块内容：块号写在块开头，其余为可校验的模式
+ */
+static void fill_block(char *buffer, uint64_t block_num, uint32_t block_size) {
+    memcpy(buffer, &block_num, sizeof(block_num));
+    for (uint32_t i = sizeof(block_num); i < block_size; i++) {
+        buffer[i] = (char)(block_num + i);
+    }
+}
+
+/**
+ * 删除默认镜像文件（包括条带集的成员文件）
+ */
+static void remove_default_image(void) {
+    char member[64];
+    unlink(REPLAY_DISK_FILE);
+    for (int i = 1; i < REPLAY_STRIPE_MEMBERS; i++) {
+        snprintf(member, sizeof(member), "%s.%d", REPLAY_DISK_FILE, i);
+        unlink(member);
+    }
+}
+
+/**
+ * 按后端名称配置之后新建的镜像
+ *
+ * @return 0成功，-1未知的后端
+ */
+static int configure_backend(const char *backend) {
+    if (strcmp(backend, "csum") == 0) {
+        disk_set_checksums(1);
+    } else if (strcmp(backend, "compress") == 0) {
+        disk_set_compression(DISK_COMPRESS_DEFAULT_CHUNK_BLOCKS);
+    } else if (strcmp(backend, "dedup") == 0) {
+        disk_set_dedup(1);
+    } else if (strcmp(backend, "stripe") == 0) {
+        disk_set_striping(REPLAY_STRIPE_MEMBERS, 16);
+    } else if (strcmp(backend, "mem") == 0) {
+        disk_set_ram_disk(1, 0);
+    } else if (strcmp(backend, "plain") != 0 && strcmp(backend, "mmap") != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 打印一类调用的统计
+ */
+static void print_op_stats(const char *name, const replay_op_stats_t *op) {
+    if (op->calls == 0) {
+        return;
+    }
+
+    char label[64];
+    printf("%s: %lu 次调用, %lu 块, 错误 %lu\n", name, op->calls, op->blocks, op->errors);
+    snprintf(label, sizeof(label), "  回放%s", name);
+    latency_hist_print(&op->replayed, label);
+    snprintf(label, sizeof(label), "  原始%s", name);
+    latency_hist_print(&op->original, label);
+}
+
+int main(int argc, char *argv[]) {
+    const char *trace_file = (argc > 1) ? argv[1] : NULL;
+    const char *mode = (argc > 2) ? argv[2] : "fast";
+    const char *backend = (argc > 3) ? argv[3] : "plain";
+    uint32_t cache_blocks = (argc > 4) ? (uint32_t)atoi(argv[4]) : DISK_CACHE_DEFAULT_BLOCKS;
+    const char *device = (argc > 5) ? argv[5] : "none";
+    const char *image = (argc > 6) ? argv[6] : REPLAY_DISK_FILE;
+    timing_profile_t profile = strcmp(device, "hdd") == 0  ? TIMING_PROFILE_HDD
+                             : strcmp(device, "ssd") == 0  ? TIMING_PROFILE_SATA_SSD
+                             : strcmp(device, "nvme") == 0 ? TIMING_PROFILE_NVME
+                                                           : TIMING_PROFILE_NONE;
+    int timed = strcmp(mode, "timed") == 0;
+
+    if (!trace_file || (!timed && strcmp(mode, "fast") != 0) || configure_backend(backend) != 0 ||
+        (profile == TIMING_PROFILE_NONE && strcmp(device, "none") != 0)) {
+        printf("用法: %s 跟踪文件 [fast|timed] [plain|mmap|mem|csum|compress|dedup|stripe] [缓存块数] [none|hdd|ssd|nvme] [镜像文件]\n",
+               argv[0]);
+        return 1;
+    }
+
+    trace_file_header_t header;
+    trace_record_t *records = NULL;
+    size_t count = 0;
+    int result = trace_log_load(trace_file, &header, &records, &count);
+    if (result != 0) {
+        printf("读取跟踪文件失败: %s\n", result == -EBADMSG ? "不是跟踪文件" : strerror(-result));
+        return 1;
+    }
+
+    uint32_t block_size = header.block_size;
+    uint32_t max_blocks = 1;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].count > max_blocks) {
+            max_blocks = records[i].count;
+        }
+    }
+    char *buffer = (char *)malloc((size_t)max_blocks * block_size);
+    if (!buffer) {
+        free(records);
+        return 1;
+    }
+
+    printf("磁盘模拟器I/O跟踪回放\n");
+    printf("====================\n");
+    printf("跟踪: %s, %zu 条记录, 时长 %.3f 秒, 块大小 %u 字节, %lu 块\n", trace_file, count,
+           count ? records[count - 1].timestamp_ns / 1000000000.0 : 0.0, block_size,
+           header.total_blocks);
+    printf("模式: %s, 后端: %s, 缓存: %u 块, 模拟设备: %s\n\n", mode, backend, cache_blocks,
+           timing_profile_name(profile));
+
+    // 镜像按跟踪中的块大小和块数新建（指定的已有镜像原样打开）
+    int own_image = strcmp(image, REPLAY_DISK_FILE) == 0;
+    if (own_image) {
+        remove_default_image();
+    }
+    disk_set_block_size(block_size);
+    disk_set_cache_capacity(cache_blocks);
+    result = disk_init(image, header.total_blocks * block_size);
+    if (result == DISK_SUCCESS && strcmp(backend, "mmap") == 0) {
+        result = disk_set_mmap_mode(1);
+    }
+    if (result == DISK_SUCCESS) {
+        result = disk_set_timing_model(profile, 0, 1);
+    }
+    if (result != DISK_SUCCESS) {
+        printf("初始化磁盘失败: %s\n", disk_error_to_string((disk_error_t)result));
+        free(buffer);
+        free(records);
+        return 1;
+    }
+
+    replay_op_stats_t ops[TRACE_OP_SYNC + 1];
+    latency_hist_t lag;
+    memset(ops, 0, sizeof(ops));
+    memset(&lag, 0, sizeof(lag));
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < count; i++) {
+        const trace_record_t *rec = &records[i];
+        if (rec->op < TRACE_OP_READ || rec->op > TRACE_OP_SYNC) {
+            continue;
+        }
+
+        // 按原始时刻发出：提前到达时等待，落后时立即发出并记下落后的时间
+        if (timed) {
+            uint64_t due = start + rec->timestamp_ns;
+            uint64_t now = now_ns();
+            if (now < due) {
+                sleep_until(due);
+            } else {
+                latency_hist_record(&lag, now - due);
+            }
+        }
+
+        if (rec->op == TRACE_OP_WRITE) {
+            for (uint32_t b = 0; b < rec->count; b++) {
+                fill_block(buffer + (size_t)b * block_size, rec->block + b, block_size);
+            }
+        }
+
+        uint64_t issue = now_ns();
+        if (rec->op == TRACE_OP_READ) {
+            result = rec->count == 1 ? disk_read_block(rec->block, buffer)
+                                     : disk_read_blocks(rec->block, (int)rec->count, buffer);
+        } else if (rec->op == TRACE_OP_WRITE) {
+            result = rec->count == 1 ? disk_write_block(rec->block, buffer)
+                                     : disk_write_blocks(rec->block, (int)rec->count, buffer);
+        } else if (rec->count > 0) {
+            result = disk_sync_range(rec->block, rec->count);
+        } else {
+            result = disk_sync();
+        }
+        uint64_t latency = now_ns() - issue;
+
+        replay_op_stats_t *op = &ops[rec->op];
+        op->calls++;
+        op->blocks += rec->count;
+        latency_hist_record(&op->replayed, latency);
+        latency_hist_record(&op->original, rec->latency_ns);
+        // 原始调用就失败的（如越界）回放时同样失败，不算错误
+        if (result != DISK_SUCCESS && rec->result == DISK_SUCCESS) {
+            op->errors++;
+            errors++;
+        } else if (result == DISK_SUCCESS && rec->op != TRACE_OP_SYNC) {
+            bytes += (uint64_t)rec->count * block_size;
+        }
+    }
+    double elapsed = (now_ns() - start) / 1000000000.0;
+
+    printf("回放耗时: %.3f 秒, %.0f 次/秒, %.2f MB/秒, 错误 %lu\n", elapsed,
+           elapsed > 0 ? count / elapsed : 0.0,
+           elapsed > 0 ? bytes / elapsed / (1024 * 1024) : 0.0, errors);
+    if (timed) {
+        printf("落后于原始时刻发出: %lu 次\n", lag.count);
+        latency_hist_print(&lag, "落后");
+    }
+    printf("\n");
+    print_op_stats("读取", &ops[TRACE_OP_READ]);
+    print_op_stats("写入", &ops[TRACE_OP_WRITE]);
+    print_op_stats("同步", &ops[TRACE_OP_SYNC]);
+
+    disk_close();
+    disk_set_timing_model(TIMING_PROFILE_NONE, 0, 0);
+    if (own_image) {
+        remove_default_image();
+    }
+    free(buffer);
+    free(records);
+    return errors == 0 ? 0 : 1;
+}
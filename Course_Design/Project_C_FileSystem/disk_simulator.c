@@ -5,17 +5,118 @@
  * 磁盘模拟器实现 - 使用单个主机OS文件模拟基于块的磁盘存储
  */
 
+#define _GNU_SOURCE                         // fallocate()
 #include "disk_simulator.h"
+#include <sys/ioctl.h>
+#include <linux/fs.h>                       // FICLONE
 
 /* 全局磁盘状态 */
 disk_state_t g_disk_state = {0};
 
+/* 块缓存容量配置（块数，0表示禁用） */
+static uint32_t g_cache_capacity = DISK_CACHE_DEFAULT_BLOCKS;
+
+/* 是否以内存映射方式访问磁盘镜像 */
+static int g_use_mmap = 0;
+
+/* 新建磁盘使用的块大小（打开已有磁盘时以头部记录为准） */
+static uint32_t g_new_block_size = DISK_BLOCK_SIZE;
+
+/* 新建磁盘是否带每块校验和（打开已有磁盘时以头部记录为准） */
+static int g_new_checksums = 0;
+
+/* 新建磁盘的条带布局（成员数为1表示不分条带；打开已有磁盘时以头部记录为准） */
+static uint32_t g_new_stripe_members = 1;
+static uint32_t g_new_stripe_blocks = 0;
+
+/* 新建磁盘的压缩块组大小（0表示不压缩；打开已有磁盘时以头部记录为准） */
+static uint32_t g_new_chunk_blocks = 0;
+
+/* 新建磁盘是否按内容去重（打开已有磁盘时以头部记录为准） */
+static int g_new_dedup = 0;
+
+/* 之后打开的磁盘是否为内存盘，以及内存盘选项（DISK_RAM_*） */
+static int g_new_ram = 0;
+static int g_new_ram_flags = 0;
+
+/* 组提交配置（时间窗口为0表示禁用） */
+static uint32_t g_group_window_us = 0;
+static uint64_t g_group_max_bytes = DISK_GROUP_COMMIT_BYTES;
+
+/* I/O调度队列配置（深度为0表示禁用） */
+static uint32_t g_ioq_depth = 0;
+static uint32_t g_ioq_deadline_us = DISK_IOQ_DEFAULT_DEADLINE_US;
+
+/* 设备时序模型配置（TIMING_PROFILE_NONE表示按主机文件速度运行） */
+static timing_profile_t g_timing_profile = TIMING_PROFILE_NONE;
+static uint64_t g_timing_bandwidth = 0;
+static int g_timing_real_delay = 0;
+
+/* 本线程累计的虚拟设备时间（纳秒），计入get_current_time()，从而计入请求延迟 */
+static __thread uint64_t t_virtual_ns = 0;
+
+/* 全零块（块大小可达64KB，不在栈上分配） */
+static const char g_zero_block[DISK_MAX_BLOCK_SIZE];
+
+/* mmap模式下块在映射中的地址 */
+#define MAP_BLOCK_PTR(block_num) \
+    (disk->map_base + DISK_BLOCK_OFFSET(disk, block_num))
+
+/* 内存盘载入和导出镜像时每次复制的字节数 */
+#define RAM_COPY_BYTES (1024 * 1024)
+
+/* 快照叠加层映射表中表示"已清零"的项（其余非零项为槽号加1） */
+#define REMAP_ZERO UINT32_MAX
+
+/* 叠加层中槽在文件中的偏移 */
+#define OVERLAY_SLOT_OFFSET(disk, slot) \
+    ((disk)->overlay_offset + (uint64_t)(slot) * (disk)->block_size)
+
+/**
+ * 存储后端操作表
+ * 
+ * 后端决定镜像存放在哪里（镜像文件或内存文件），以及普通布局的数据区
+ * 经什么方式读写（preadv/pwritev或共享映射）。块缓存、校验和、压缩、去重、
+ * 条带和快照叠加层都在后端之上实现。头部和各种表经disk->fd读写，所以
+ * 后端的init必须留下一个可以pread/pwrite的描述符。
+ */
+struct disk_backend {
+    const char* name;               // URI前缀（不含冒号）
+    int         mapped;             // 可映射的镜像是否经共享映射访问
+    
+    /* 打开（create为0）或新建（create为1）镜像存储，设置disk->fd */
+    int  (*init)(disk_t* disk, const char* path, int create);
+    
+    /* 读写数据区中的一段连续块，blocks[i]为第start_block+i块的缓冲区 */
+    int  (*read_blocks)(disk_t* disk, uint64_t start_block, uint32_t count, char* const* blocks);
+    int  (*write_blocks)(disk_t* disk, uint64_t start_block, uint32_t count,
+                         const char* const* blocks);
+    
+    /* 把镜像存储刷到稳定存储，0成功，-1失败 */
+    int  (*sync)(disk_t* disk, int data_only);
+    
+    /* 只把数据区中的一段块刷到稳定存储，0成功，-1失败 */
+    int  (*sync_range)(disk_t* disk, uint64_t start_block, uint64_t count);
+    
+    /* 把数据区中的一段块清零（punch为1时打洞释放空间），不支持时返回DISK_ERROR_IO */
+    int  (*discard)(disk_t* disk, uint64_t start_block, uint64_t count, int punch);
+    
+    /* 关闭镜像存储（remove为1时同时删除新建失败的镜像） */
+    void (*close)(disk_t* disk, int remove);
+    
+    /* 打印后端的存储状态 */
+    void (*stats)(disk_t* disk);
+};
+
 /*==============================================================================
  * 内部辅助函数
  *============================================================================*/
 
+/* 校验失败后的重读次数（并发写入期间数据与校验和可能短暂不一致） */
+#define CSUM_READ_RETRIES 3
+
 /**
- * 计算简单校验和
+ * 计算简单校验和（版本1、2的头部）
  */
 static uint32_t calculate_checksum(const void* data, size_t size) {
     const uint8_t* bytes = (const uint8_t*)data;
@@ -29,601 +130,5658 @@ static uint32_t calculate_checksum(const void* data, size_t size) {
     return checksum;
 }
 
+/* 统计计数器原子更新（多线程并发I/O时使用） */
+#define STATS_ADD(field, n) \
+    __atomic_fetch_add(&disk->stats.field, (n), __ATOMIC_RELAXED)
+
 /**
- * 更新读操作统计
+ * 更新读操作统计（按块计数，延迟按请求记录）
  */
-static void update_stats_read(uint64_t bytes, double elapsed_time) {
-    g_disk_state.stats.total_reads++;
-    g_disk_state.stats.bytes_read += bytes;
-    g_disk_state.stats.last_operation_time = time(NULL);
+static void update_stats_read(disk_t* disk, uint64_t blocks, double elapsed_time) {
+    STATS_ADD(total_reads, blocks);
+    STATS_ADD(bytes_read, blocks * disk->block_size);
+    __atomic_store_n(&disk->stats.last_operation_time, time(NULL), __ATOMIC_RELAXED);
     
-    if (g_disk_state.stats.total_reads == 1) {
-        g_disk_state.stats.avg_read_time = elapsed_time;
-    } else {
-        g_disk_state.stats.avg_read_time = 
-            (g_disk_state.stats.avg_read_time * 0.9) + (elapsed_time * 0.1);
-    }
+    latency_hist_record_seconds(&disk->stats.read_latency, elapsed_time);
 }
 
 /**
- * 更新写操作统计
+ * 更新写操作统计（按块计数，延迟按请求记录）
  */
-static void update_stats_write(uint64_t bytes, double elapsed_time) {
-    g_disk_state.stats.total_writes++;
-    g_disk_state.stats.bytes_written += bytes;
-    g_disk_state.stats.last_operation_time = time(NULL);
-    g_disk_state.is_dirty = 1;
+static void update_stats_write(disk_t* disk, uint64_t blocks, double elapsed_time) {
+    STATS_ADD(total_writes, blocks);
+    STATS_ADD(bytes_written, blocks * disk->block_size);
+    __atomic_store_n(&disk->stats.last_operation_time, time(NULL), __ATOMIC_RELAXED);
+    __atomic_store_n(&disk->is_dirty, 1, __ATOMIC_RELAXED);
     
-    if (g_disk_state.stats.total_writes == 1) {
-        g_disk_state.stats.avg_write_time = elapsed_time;
-    } else {
-        g_disk_state.stats.avg_write_time = 
-            (g_disk_state.stats.avg_write_time * 0.9) + (elapsed_time * 0.1);
-    }
+    latency_hist_record_seconds(&disk->stats.write_latency, elapsed_time);
 }
 
 /**
- * 获取当前时间（高精度）
+ * 获取当前时间（高精度，包含本线程的虚拟设备时间）
  */
 static double get_current_time(void) {
+    double virtual_time = t_virtual_ns / 1000000000.0;
     struct timespec ts;
     if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
-        return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+        return ts.tv_sec + ts.tv_nsec / 1000000000.0 + virtual_time;
     }
-    return (double)time(NULL);
+    return (double)time(NULL) + virtual_time;
 }
 
 /**
- * 创建磁盘头部
+ * 记录一次由设备时序模型计时的I/O
+ * 
+ * 实际延迟模式下模型已睡眠到完成时刻；虚拟时间模式下把时间累加到本线程
+ * 的虚拟时钟。
  */
-static int create_disk_header(disk_header_t* header, uint32_t total_blocks) {
-    if (!header) {
-        return DISK_ERROR_INVALID_PARAM;
+static void account_device_time(disk_t* disk, uint64_t latency_ns, int seeked) {
+    if (!timing_model_real_delay(disk->timing)) {
+        t_virtual_ns += latency_ns;
     }
-    
-    memset(header, 0, sizeof(disk_header_t));
-    
-    header->magic_number = DISK_MAGIC_HEADER;
-    header->version = DISK_VERSION;
-    header->block_size = DISK_BLOCK_SIZE;
-    header->total_blocks = total_blocks;
-    header->disk_size = (uint64_t)total_blocks * DISK_BLOCK_SIZE;
-    header->created_time = time(NULL);
-    header->last_access_time = header->created_time;
-    
-    // 只对稳定的字段计算校验和（排除时间戳和校验和字段）
-    uint32_t stable_size = offsetof(disk_header_t, created_time);
-    header->checksum = calculate_checksum(header, stable_size);
-    
-    return DISK_SUCCESS;
+    STATS_ADD(device_ios, 1);
+    STATS_ADD(device_seeks, seeked);
+    STATS_ADD(device_time_ns, latency_ns);
+    latency_hist_record(&disk->stats.device_latency, latency_ns);
 }
 
 /**
- * 验证磁盘头部
+ * 按设备时序模型为一段连续块的读写计时
  */
-static int validate_disk_header(const disk_header_t* header) {
-    if (!header) {
-        return DISK_ERROR_INVALID_PARAM;
+static void model_device_io(disk_t* disk, int is_write, uint64_t start_block, uint32_t count) {
+    if (disk->timing) {
+        int seeked = 0;
+        uint64_t latency_ns = timing_model_io(disk->timing, is_write, start_block, count, &seeked);
+        account_device_time(disk, latency_ns, seeked);
     }
+}
+
+/**
+ * 计算一个块的校验和
+ */
+static uint32_t block_checksum(disk_t* disk, const char* data) {
+    return crc32c(0, data, disk->block_size);
+}
+
+/**
+ * 计算整块填充同一字节时的校验和（按小段续算，不需要整块缓冲区）
+ */
+static uint32_t pattern_checksum(disk_t* disk, uint8_t pattern) {
+    char chunk[DISK_MIN_BLOCK_SIZE];
+    memset(chunk, pattern, sizeof(chunk));
     
-    if (header->magic_number != DISK_MAGIC_HEADER) {
-        return DISK_ERROR_CORRUPTED;
+    uint32_t csum = 0;
+    for (uint32_t done = 0; done < disk->block_size; done += sizeof(chunk)) {
+        csum = crc32c(csum, chunk, sizeof(chunk));
     }
+    return csum;
+}
+
+/**
+ * 记录块在镜像中的新校验和，并标记所在的校验和表块待回写
+ */
+static void csum_store(disk_t* disk, uint64_t block_num, uint32_t csum) {
+    uint32_t table_block = block_num / (disk->block_size / sizeof(uint32_t));
     
-    if (header->version != DISK_VERSION) {
-        return DISK_ERROR_CORRUPTED;
+    __atomic_store_n(&disk->csums[block_num], csum, __ATOMIC_RELEASE);
+    __atomic_fetch_or(&disk->csum_dirty[table_block / 8],
+                      (uint8_t)(1 << (table_block % 8)), __ATOMIC_RELEASE);
+}
+
+/**
+ * 块内容写入镜像（或映射）后更新校验和
+ */
+static void csum_update(disk_t* disk, uint64_t block_num, const char* data) {
+    if (disk->csums) {
+        csum_store(disk, block_num, block_checksum(disk, data));
     }
-    
-    if (header->block_size != DISK_BLOCK_SIZE) {
-        return DISK_ERROR_CORRUPTED;
+}
+
+/**
+ * 一段块被填充为同一字节后更新校验和
+ */
+static void csum_update_range(disk_t* disk, uint64_t start_block, uint64_t count, uint8_t pattern) {
+    if (!disk->csums) {
+        return;
     }
     
-    // 只验证稳定字段的校验和
-    uint32_t stable_size = offsetof(disk_header_t, created_time);
-    uint32_t calculated_checksum = calculate_checksum(header, stable_size);
-    if (calculated_checksum != header->checksum) {
-        return DISK_ERROR_CORRUPTED;
+    uint32_t csum = pattern_checksum(disk, pattern);
+    for (uint64_t i = 0; i < count; i++) {
+        csum_store(disk, start_block + i, csum);
     }
-    
-    return DISK_SUCCESS;
 }
 
-/*==============================================================================
- * 核心磁盘操作实现
- *============================================================================*/
+/**
+ * 检查从镜像读到的块是否与记录的校验和一致
+ */
+static int csum_matches(disk_t* disk, uint64_t block_num, const char* data) {
+    return !disk->csums ||
+           block_checksum(disk, data) == __atomic_load_n(&disk->csums[block_num], __ATOMIC_ACQUIRE);
+}
 
 /**
- * 初始化磁盘模拟器
+ * 记录一次校验失败
  */
-int disk_init(const char* filename, int disk_size) {
-    // 参数验证
-    if (!filename || disk_size <= 0) {
-        return DISK_ERROR_INVALID_PARAM;
-    }
-    
-    if (g_disk_state.is_initialized) {
-        return DISK_ERROR_ALREADY_INIT;
+static int csum_failure(disk_t* disk) {
+    STATS_ADD(checksum_errors, 1);
+    STATS_ADD(read_errors, 1);
+    return DISK_ERROR_CHECKSUM;
+}
+
+/**
+ * 将修改过的校验和表块写回镜像文件（不同步）
+ */
+static int csum_flush(disk_t* disk) {
+    if (!disk->csums) {
+        return DISK_SUCCESS;
     }
     
-    // 检查磁盘大小是否块对齐
-    if (!DISK_IS_BLOCK_ALIGNED(disk_size)) {
-        return DISK_ERROR_INVALID_PARAM;
+    uint32_t block_size = disk->block_size;
+    for (uint32_t t = 0; t < disk->csum_table_blocks; t++) {
+        uint8_t mask = (uint8_t)(1 << (t % 8));
+        if (!(__atomic_load_n(&disk->csum_dirty[t / 8], __ATOMIC_ACQUIRE) & mask)) {
+            continue;
+        }
+        
+        // 先清除脏位再写入，期间的新更新会重新置位
+        __atomic_fetch_and(&disk->csum_dirty[t / 8], (uint8_t)~mask, __ATOMIC_ACQ_REL);
+        const char* table = (const char*)disk->csums + (size_t)t * block_size;
+        off_t offset = (off_t)(disk->csum_offset + (uint64_t)t * block_size);
+        if (pwrite(disk->fd, table, block_size, offset) != (ssize_t)block_size) {
+            __atomic_fetch_or(&disk->csum_dirty[t / 8], mask, __ATOMIC_RELAXED);
+            STATS_ADD(write_errors, 1);
+            return DISK_ERROR_FILE_WRITE;
+        }
     }
     
-    // 计算块数
-    uint32_t total_blocks = disk_size / DISK_BLOCK_SIZE;
-    if (total_blocks == 0) {
-        return DISK_ERROR_INVALID_PARAM;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 定位块在镜像中的位置（条带集时为所在的成员文件）
+ * 
+ * @return 文件描述符，offset为块在该文件中的偏移
+ */
+static int block_fd(disk_t* disk, uint64_t block_num, off_t* offset) {
+    if (disk->stripe) {
+        int fd;
+        uint64_t member_offset;
+        stripe_set_locate(disk->stripe, block_num, &fd, &member_offset, NULL);
+        *offset = (off_t)member_offset;
+        return fd;
     }
     
-    // 初始化磁盘状态
-    memset(&g_disk_state, 0, sizeof(g_disk_state));
-    strncpy(g_disk_state.filename, filename, DISK_MAX_FILENAME_LEN - 1);
-    g_disk_state.filename[DISK_MAX_FILENAME_LEN - 1] = '\0';
-    
-    // 检查文件是否存在
-    struct stat file_stat;
-    int file_exists = (stat(filename, &file_stat) == 0);
+    *offset = (off_t)DISK_BLOCK_OFFSET(disk, block_num);
+    return disk->fd;
+}
+
+/**
+ * 记录块在叠加层中的新映射，并标记所在的映射表块待回写
+ */
+static void remap_store(disk_t* disk, uint64_t block_num, uint32_t entry) {
+    uint32_t table_block = block_num / (disk->block_size / sizeof(uint32_t));
     
-    if (file_exists) {
-        // 打开现有文件
-        g_disk_state.fd = open(filename, O_RDWR);
-        if (g_disk_state.fd == -1) {
-            return DISK_ERROR_FILE_OPEN;
-        }
-        
-        // 读取并验证头部
-        disk_header_t header;
-        ssize_t bytes_read = read(g_disk_state.fd, &header, sizeof(header));
-        if (bytes_read != sizeof(header)) {
-            close(g_disk_state.fd);
-            return DISK_ERROR_FILE_READ;
-        }
-        
-        int validation_result = validate_disk_header(&header);
-        if (validation_result != DISK_SUCCESS) {
-            close(g_disk_state.fd);
-            return validation_result;
-        }
-        
+    __atomic_store_n(&disk->remap[block_num], entry, __ATOMIC_RELEASE);
+    __atomic_fetch_or(&disk->remap_dirty[table_block / 8],
+                      (uint8_t)(1 << (table_block % 8)), __ATOMIC_RELEASE);
+}
 
-        
-        // 从头部更新状态
-        g_disk_state.total_blocks = header.total_blocks;
-        g_disk_state.disk_size = header.disk_size;
-        
-        // 验证文件大小
-        uint64_t expected_size = DISK_TOTAL_FILE_SIZE(header.total_blocks);
-        if ((uint64_t)file_stat.st_size < expected_size) {
-            close(g_disk_state.fd);
-            return DISK_ERROR_CORRUPTED;
-        }
-        
-    } else {
-        // 创建新文件
-        g_disk_state.fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
-        if (g_disk_state.fd == -1) {
-            return DISK_ERROR_FILE_CREATE;
-        }
-        
-        // 创建并写入头部
-        disk_header_t header;
-        int result = create_disk_header(&header, total_blocks);
-        if (result != DISK_SUCCESS) {
-            close(g_disk_state.fd);
-            unlink(filename);
-            return result;
-        }
-        
-        ssize_t bytes_written = write(g_disk_state.fd, &header, sizeof(header));
-        if (bytes_written != sizeof(header)) {
-            close(g_disk_state.fd);
-            unlink(filename);
-            return DISK_ERROR_FILE_WRITE;
+/**
+ * 把快照叠加层刷到稳定存储
+ * 
+ * 映射表改动时先同步槽中的数据，再写入映射表并同步，崩溃后映射表
+ * 不会指向未落盘的槽。
+ */
+static int sync_overlay(disk_t* disk, int data_only) {
+    int changed = 0;
+    for (uint32_t t = 0; t < disk->remap_table_blocks; t++) {
+        uint8_t mask = (uint8_t)(1 << (t % 8));
+        if (!(__atomic_load_n(&disk->remap_dirty[t / 8], __ATOMIC_ACQUIRE) & mask)) {
+            continue;
         }
-        
-        // 扩展文件到完整大小
-        uint64_t file_size = DISK_TOTAL_FILE_SIZE(total_blocks);
-        if (lseek(g_disk_state.fd, file_size - 1, SEEK_SET) == -1) {
-            close(g_disk_state.fd);
-            unlink(filename);
-            return DISK_ERROR_FILE_SEEK;
+        if (!changed && fdatasync(disk->fd) != 0) {
+            return -1;
         }
+        changed = 1;
         
-        char zero = 0;
-        if (write(g_disk_state.fd, &zero, 1) != 1) {
-            close(g_disk_state.fd);
-            unlink(filename);
-            return DISK_ERROR_FILE_WRITE;
+        // 先清除脏位再写入，期间的新映射会重新置位
+        __atomic_fetch_and(&disk->remap_dirty[t / 8], (uint8_t)~mask, __ATOMIC_ACQ_REL);
+        const char* table = (const char*)disk->remap + (size_t)t * disk->block_size;
+        off_t offset = (off_t)(disk->data_offset + (uint64_t)t * disk->block_size);
+        if (pwrite(disk->fd, table, disk->block_size, offset) != (ssize_t)disk->block_size) {
+            __atomic_fetch_or(&disk->remap_dirty[t / 8], mask, __ATOMIC_RELAXED);
+            STATS_ADD(write_errors, 1);
+            return -1;
         }
-        
-        g_disk_state.total_blocks = total_blocks;
-        g_disk_state.disk_size = disk_size;
     }
     
-    // 完成初始化
-    g_disk_state.block_size = DISK_BLOCK_SIZE;
-    g_disk_state.is_initialized = 1;
-    g_disk_state.is_read_only = 0;
-    g_disk_state.is_dirty = 0;
-    g_disk_state.auto_sync = 0;
-    g_disk_state.last_sync_time = time(NULL);
-    
-    return DISK_SUCCESS;
+    return data_only ? fdatasync(disk->fd) : fsync(disk->fd);
 }
 
 /**
- * 写入一个数据块
+ * 把镜像文件（条带集的所有成员）刷到稳定存储
+ * 
+ * @return 0成功，-1失败
  */
-int disk_write_block(int block_num, const char* data) {
-    // 参数验证
-    if (!data) {
-        return DISK_ERROR_INVALID_PARAM;
-    }
-    
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
-    }
-    
-    if (g_disk_state.is_read_only) {
-        return DISK_ERROR_IO;
+static int sync_image(disk_t* disk, int data_only) {
+    if (disk->timing) {
+        account_device_time(disk, timing_model_flush(disk->timing), 0);
     }
-    
-    if (!disk_check_block_bounds(block_num)) {
-        return DISK_ERROR_BLOCK_RANGE;
+    if (disk->stripe) {
+        return stripe_set_sync(disk->stripe, data_only) == 0 ? 0 : -1;
     }
-    
-    double start_time = get_current_time();
-    
-    // 计算文件偏移
-    uint64_t offset = DISK_BLOCK_TO_OFFSET(block_num);
-    
-    // 定位到块位置
-    if (lseek(g_disk_state.fd, offset, SEEK_SET) == -1) {
-        g_disk_state.stats.write_errors++;
-        return DISK_ERROR_FILE_SEEK;
+    if (disk->chunks) {
+        return chunk_store_sync(disk->chunks, data_only) == 0 ? 0 : -1;
     }
-    
-    // 写入块数据
-    ssize_t bytes_written = write(g_disk_state.fd, data, DISK_BLOCK_SIZE);
-    if (bytes_written != DISK_BLOCK_SIZE) {
-        g_disk_state.stats.write_errors++;
-        return DISK_ERROR_FILE_WRITE;
+    if (disk->dedup) {
+        return dedup_store_sync(disk->dedup, data_only) == 0 ? 0 : -1;
     }
-    
-    // 更新统计
-    double elapsed_time = get_current_time() - start_time;
-    update_stats_write(DISK_BLOCK_SIZE, elapsed_time);
-    
-    // 自动同步（如果启用）
-    if (g_disk_state.auto_sync) {
-        fsync(g_disk_state.fd);
+    if (disk->remap) {
+        return sync_overlay(disk, data_only);
     }
-    
-    return DISK_SUCCESS;
+    return disk->backend->sync(disk, data_only);
 }
 
 /**
- * 读取一个数据块
+ * 只把镜像中的一段块刷到稳定存储（不同步元数据）
+ * 
+ * 校验和表、条带成员和压缩、去重、叠加层的索引与数据分开存放，一段
+ * 块的持久性依赖这些元数据，只能对整个镜像做一次只同步数据的刷新。
+ * 
+ * @return 0成功，-1失败
  */
-int disk_read_block(int block_num, char* buffer) {
-    // 参数验证
-    if (!buffer) {
-        return DISK_ERROR_INVALID_PARAM;
+static int sync_image_range(disk_t* disk, uint64_t start_block, uint64_t count) {
+    if (disk->csums || disk->stripe || disk->chunks || disk->dedup || disk->remap) {
+        return sync_image(disk, 1);
     }
-    
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
+    if (disk->timing) {
+        account_device_time(disk, timing_model_flush(disk->timing), 0);
     }
+    return disk->backend->sync_range(disk, start_block, count);
+}
+
+/**
+ * 在压缩镜像上读写一段连续块（经块组缓存，按需解压和压缩）
+ */
+static int compressed_io(disk_t* disk, int is_write, uint64_t start_block, uint32_t count,
+                         char* const* blocks) {
+    model_device_io(disk, is_write, start_block, count);
     
-    if (!disk_check_block_bounds(block_num)) {
-        return DISK_ERROR_BLOCK_RANGE;
+    int result = is_write
+        ? chunk_store_write(disk->chunks, start_block, count, (const char* const*)blocks)
+        : chunk_store_read(disk->chunks, start_block, count, blocks);
+    if (result == 0) {
+        return DISK_SUCCESS;
     }
-    
-    double start_time = get_current_time();
-    
-    // 计算文件偏移
-    uint64_t offset = DISK_BLOCK_TO_OFFSET(block_num);
-    
-    // 定位到块位置
-    if (lseek(g_disk_state.fd, offset, SEEK_SET) == -1) {
-        g_disk_state.stats.read_errors++;
-        return DISK_ERROR_FILE_SEEK;
+    if (result == -EBADMSG) {
+        return csum_failure(disk);
     }
-    
-    // 读取块数据
-    ssize_t bytes_read = read(g_disk_state.fd, buffer, DISK_BLOCK_SIZE);
-    if (bytes_read != DISK_BLOCK_SIZE) {
-        g_disk_state.stats.read_errors++;
-        return DISK_ERROR_FILE_READ;
+    if (is_write) {
+        STATS_ADD(write_errors, 1);
+        return DISK_ERROR_FILE_WRITE;
     }
-    
-    // 更新统计
-    double elapsed_time = get_current_time() - start_time;
-    update_stats_read(DISK_BLOCK_SIZE, elapsed_time);
-    
-    return DISK_SUCCESS;
+    STATS_ADD(read_errors, 1);
+    return DISK_ERROR_FILE_READ;
 }
 
-/*==============================================================================
- * 扩展磁盘操作
- *============================================================================*/
-
 /**
- * 关闭和清理磁盘模拟器
+ * 在去重镜像上读写一段连续块（写入时按指纹查找相同的块）
  */
-int disk_close(void) {
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
-    }
+static int dedup_io(disk_t* disk, int is_write, uint64_t start_block, uint32_t count,
+                    char* const* blocks) {
+    model_device_io(disk, is_write, start_block, count);
     
-    // 同步待写入数据
-    if (g_disk_state.is_dirty) {
-        disk_sync();
+    int result = is_write
+        ? dedup_store_write(disk->dedup, start_block, count, (const char* const*)blocks)
+        : dedup_store_read(disk->dedup, start_block, count, blocks);
+    if (result == 0) {
+        return DISK_SUCCESS;
     }
-    
-    // 关闭文件描述符
-    if (g_disk_state.fd != -1) {
-        close(g_disk_state.fd);
+    if (is_write) {
+        STATS_ADD(write_errors, 1);
+        return result == -ENOSPC ? DISK_ERROR_DISK_FULL : DISK_ERROR_FILE_WRITE;
     }
-    
-    // 重置状态
-    memset(&g_disk_state, 0, sizeof(g_disk_state));
-    g_disk_state.fd = -1;
-    
-    return DISK_SUCCESS;
+    STATS_ADD(read_errors, 1);
+    return DISK_ERROR_FILE_READ;
 }
 
 /**
- * 同步磁盘写入
+ * 在快照叠加层上写入一个块
+ * 
+ * 块在快照后第一次写入时分配叠加层末尾的一个新槽（被冻结的镜像保持
+ * 不变），之后原地改写这个槽。
  */
-int disk_sync(void) {
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
+static int overlay_write_block(disk_t* disk, uint64_t block_num, const char* data) {
+    uint32_t entry = __atomic_load_n(&disk->remap[block_num], __ATOMIC_ACQUIRE);
+    if (entry == 0 || entry == REMAP_ZERO) {
+        uint32_t slot = __atomic_fetch_add(&disk->overlay_slots, 1, __ATOMIC_RELAXED);
+        uint32_t expected = entry;
+        if (__atomic_compare_exchange_n(&disk->remap[block_num], &expected, slot + 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            remap_store(disk, block_num, slot + 1);
+            STATS_ADD(overlay_redirects, 1);
+            entry = slot + 1;
+        } else {
+            // 并发的首次写入已为本块分配了槽，本次分配的槽留空
+            entry = expected;
+        }
     }
     
-    if (g_disk_state.fd == -1) {
-        return DISK_ERROR_IO;
+    ssize_t bytes_written = pwrite(disk->fd, data, disk->block_size,
+                                   (off_t)OVERLAY_SLOT_OFFSET(disk, entry - 1));
+    if (bytes_written != (ssize_t)disk->block_size) {
+        STATS_ADD(write_errors, 1);
+        return DISK_ERROR_FILE_WRITE;
     }
+    return DISK_SUCCESS;
+}
+
+/**
+ * 在快照叠加层上读写一段连续块
+ * 
+ * 写过的块读写叠加层中的槽，清零过的块直接填零；快照后未写过的连续块
+ * 合并为一次向量读交给被冻结的镜像。
+ */
+static int overlay_io(disk_t* disk, int is_write, uint64_t start_block, uint32_t count,
+                      char* const* blocks) {
+    model_device_io(disk, is_write, start_block, count);
     
-    // 强制同步
-    if (fsync(g_disk_state.fd) == -1) {
-        return DISK_ERROR_IO;
+    for (uint32_t i = 0; i < count; ) {
+        uint64_t block_num = start_block + i;
+        if (is_write) {
+            int result = overlay_write_block(disk, block_num, blocks[i]);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+            i++;
+            continue;
+        }
+        
+        uint32_t entry = __atomic_load_n(&disk->remap[block_num], __ATOMIC_ACQUIRE);
+        if (entry == REMAP_ZERO) {
+            memset(blocks[i], 0, disk->block_size);
+            i++;
+        } else if (entry != 0) {
+            ssize_t bytes_read = pread(disk->fd, blocks[i], disk->block_size,
+                                       (off_t)OVERLAY_SLOT_OFFSET(disk, entry - 1));
+            if (bytes_read != (ssize_t)disk->block_size) {
+                STATS_ADD(read_errors, 1);
+                return DISK_ERROR_FILE_READ;
+            }
+            i++;
+        } else {
+            disk_block_vec_t vec[DISK_MAX_IOV_BLOCKS];
+            int n = 0;
+            while (i < count && n < DISK_MAX_IOV_BLOCKS &&
+                   __atomic_load_n(&disk->remap[start_block + i], __ATOMIC_ACQUIRE) == 0) {
+                vec[n].block_num = start_block + i;
+                vec[n].buffer = blocks[i];
+                n++;
+                i++;
+            }
+            
+            int result = disk_handle_readv_blocks(disk->backing, vec, n);
+            if (result != DISK_SUCCESS) {
+                STATS_ADD(read_errors, 1);
+                return result;
+            }
+            STATS_ADD(backing_reads, n);
+        }
     }
     
-    g_disk_state.is_dirty = 0;
-    g_disk_state.last_sync_time = time(NULL);
-    
     return DISK_SUCCESS;
 }
 
 /**
- * 获取磁盘信息
+ * 从磁盘文件读取一个块（绕过缓存）
+ * 
+ * 使用pread定位读取，不修改共享的文件偏移，可被多个线程并发调用。
+ * 启用校验和时验证读到的数据，不一致时重读几次再报告错误。
  */
-int disk_get_info(uint32_t* total_blocks, uint32_t* block_size, uint64_t* disk_size) {
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
+static int raw_read_block(disk_t* disk, uint64_t block_num, char* buffer) {
+    if (disk->chunks) {
+        return compressed_io(disk, 0, block_num, 1, &buffer);
     }
-    
-    if (total_blocks) {
-        *total_blocks = g_disk_state.total_blocks;
+    if (disk->dedup) {
+        return dedup_io(disk, 0, block_num, 1, &buffer);
     }
-    
-    if (block_size) {
-        *block_size = g_disk_state.block_size;
+    if (disk->remap) {
+        return overlay_io(disk, 0, block_num, 1, &buffer);
+    }
+    if (disk->discarded && extent_set_count(disk->discarded) > 0 &&
+        extent_set_lookup(disk->discarded, block_num, NULL)) {
+        memset(buffer, 0, disk->block_size);
+        STATS_ADD(discard_zero_reads, 1);
+        return DISK_SUCCESS;
     }
     
-    if (disk_size) {
-        *disk_size = g_disk_state.disk_size;
+    off_t offset;
+    int fd = block_fd(disk, block_num, &offset);
+    model_device_io(disk, 0, block_num, 1);
+    
+    for (int attempt = 0; ; attempt++) {
+        ssize_t bytes_read = pread(fd, buffer, disk->block_size, offset);
+        if (bytes_read != (ssize_t)disk->block_size) {
+            STATS_ADD(read_errors, 1);
+            return DISK_ERROR_FILE_READ;
+        }
+        
+        if (csum_matches(disk, block_num, buffer)) {
+            return DISK_SUCCESS;
+        }
+        if (attempt == CSUM_READ_RETRIES) {
+            return csum_failure(disk);
+        }
+        sched_yield();
+    }
+}
+
+/**
+ * 把一段全零块变为洞（不写入数据）
+ * 
+ * 整段已是洞（记录在已丢弃集合中）时直接跳过；否则打洞后记入集合，
+ * 之后的读取和重复的全零写入都不再访问镜像。主机文件系统不支持打洞
+ * 时照常写入。
+ */
+static int write_zero_run(disk_t* disk, uint64_t start_block, uint32_t count,
+                          const char* const* blocks) {
+    uint64_t run;
+    if (extent_set_lookup(disk->discarded, start_block, &run) && run >= count) {
+        STATS_ADD(zero_writes_skipped, count);
+        STATS_ADD(bytes_write_avoided, (uint64_t)count * disk->block_size);
+        return DISK_SUCCESS;
+    }
+    
+    if (disk->backend->discard(disk, start_block, count, 1) != DISK_SUCCESS) {
+        extent_set_remove(disk->discarded, start_block, count);
+        return disk->backend->write_blocks(disk, start_block, count, blocks);
     }
+    csum_update_range(disk, start_block, count, 0);
     
+    // 集合已满时不记录，这些块照常从镜像中读出零
+    extent_set_add(disk->discarded, start_block, count);
+    STATS_ADD(zero_writes_punched, count);
+    STATS_ADD(bytes_write_avoided, (uint64_t)count * disk->block_size);
     return DISK_SUCCESS;
 }
 
 /**
- * 获取磁盘统计
+ * 写入一段连续块，其中的全零块不写入数据
+ * 
+ * 按是否全零把这段块分成若干连续段：全零段交给write_zero_run()，其余
+ * 的段照常写入存储后端，并且不再是已丢弃的块。
  */
-int disk_get_stats(disk_stats_t* stats) {
-    if (!stats) {
-        return DISK_ERROR_INVALID_PARAM;
+static int sparse_write_run(disk_t* disk, uint64_t start_block, uint32_t count,
+                            const char* const* blocks) {
+    for (uint32_t done = 0; done < count; ) {
+        int zero = buffer_is_zero(blocks[done], disk->block_size);
+        uint32_t n = 1;
+        while (done + n < count) {
+            // 填充时所有iovec指向同一缓冲区，不必重复检查
+            const char* block = blocks[done + n];
+            int next = block == blocks[done + n - 1] ? zero
+                                                     : buffer_is_zero(block, disk->block_size);
+            if (next != zero) {
+                break;
+            }
+            n++;
+        }
+        
+        int result;
+        if (zero) {
+            result = write_zero_run(disk, start_block + done, n, blocks + done);
+        } else {
+            if (extent_set_count(disk->discarded) > 0) {
+                extent_set_remove(disk->discarded, start_block + done, n);
+            }
+            result = disk->backend->write_blocks(disk, start_block + done, n, blocks + done);
+        }
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        done += n;
     }
     
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 向磁盘文件写入一个块（绕过缓存）
+ */
+static int raw_write_block(disk_t* disk, uint64_t block_num, const char* data) {
+    if (disk->chunks) {
+        char* blocks[1] = { (char*)data };
+        return compressed_io(disk, 1, block_num, 1, blocks);
+    }
+    if (disk->dedup) {
+        char* blocks[1] = { (char*)data };
+        return dedup_io(disk, 1, block_num, 1, blocks);
+    }
+    if (disk->remap) {
+        char* blocks[1] = { (char*)data };
+        return overlay_io(disk, 1, block_num, 1, blocks);
+    }
+    if (disk->discarded && !disk->map_base && buffer_is_zero(data, disk->block_size)) {
+        return sparse_write_run(disk, block_num, 1, &data);
+    }
+    if (disk->discarded && extent_set_count(disk->discarded) > 0) {
+        extent_set_remove(disk->discarded, block_num, 1);
+    }
+    
+    off_t offset;
+    int fd = block_fd(disk, block_num, &offset);
+    model_device_io(disk, 1, block_num, 1);
+    
+    ssize_t bytes_written = pwrite(fd, data, disk->block_size, offset);
+    if (bytes_written != (ssize_t)disk->block_size) {
+        STATS_ADD(write_errors, 1);
+        return DISK_ERROR_FILE_WRITE;
     }
+    csum_update(disk, block_num, data);
     
-    *stats = g_disk_state.stats;
     return DISK_SUCCESS;
 }
 
 /**
- * 重置磁盘统计
+ * 一段块读写完成后更新或验证校验和，验证失败的块单独重读
  */
-int disk_reset_stats(void) {
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
+static int run_checksums(disk_t* disk, int is_write, uint64_t start_block, uint32_t count,
+                         char* const* blocks) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t block_num = start_block + i;
+        if (is_write) {
+            // 填充时所有iovec指向同一缓冲区，复用上一块的校验和
+            if (i > 0 && blocks[i] == blocks[i - 1]) {
+                csum_store(disk, block_num, disk->csums[block_num - 1]);
+            } else {
+                csum_update(disk, block_num, blocks[i]);
+            }
+        } else if (!csum_matches(disk, block_num, blocks[i])) {
+            int result = raw_read_block(disk, block_num, blocks[i]);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+        }
     }
     
-    memset(&g_disk_state.stats, 0, sizeof(g_disk_state.stats));
     return DISK_SUCCESS;
 }
 
-/*==============================================================================
- * 工具函数
- *============================================================================*/
+/**
+ * 对镜像文件中的一段连续块执行向量化读写
+ * 
+ * blocks[i]为第start_block+i块的缓冲区，每DISK_MAX_IOV_BLOCKS块发起一次
+ * preadv/pwritev，代替逐块的pread/pwrite。条带集上整段交给各成员并行
+ * 读写。启用校验和时写入后更新、读取后验证，验证失败的块单独重读。
+ */
+static int file_io_run(disk_t* disk, int is_write, uint64_t start_block, uint32_t count,
+                       char* const* blocks) {
+    struct iovec iov[DISK_MAX_IOV_BLOCKS];
+    
+    model_device_io(disk, is_write, start_block, count);
+    
+    if (disk->stripe) {
+        int members = stripe_set_io(disk->stripe, is_write, start_block, count, blocks);
+        if (members < 0) {
+            if (is_write) {
+                STATS_ADD(write_errors, 1);
+                return DISK_ERROR_FILE_WRITE;
+            }
+            STATS_ADD(read_errors, 1);
+            return DISK_ERROR_FILE_READ;
+        }
+        if (members > 1) {
+            STATS_ADD(striped_ios, 1);
+        }
+        return disk->csums ? run_checksums(disk, is_write, start_block, count, blocks)
+                                  : DISK_SUCCESS;
+    }
+    
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t n = count - done;
+        if (n > DISK_MAX_IOV_BLOCKS) {
+            n = DISK_MAX_IOV_BLOCKS;
+        }
+        
+        for (uint32_t i = 0; i < n; i++) {
+            iov[i].iov_base = blocks[done + i];
+            iov[i].iov_len = disk->block_size;
+        }
+        
+        off_t offset = (off_t)DISK_BLOCK_OFFSET(disk, start_block + done);
+        ssize_t expected = (ssize_t)n * disk->block_size;
+        ssize_t bytes = is_write ? pwritev(disk->fd, iov, n, offset)
+                                 : preadv(disk->fd, iov, n, offset);
+        if (bytes != expected) {
+            if (is_write) {
+                STATS_ADD(write_errors, 1);
+                return DISK_ERROR_FILE_WRITE;
+            }
+            STATS_ADD(read_errors, 1);
+            return DISK_ERROR_FILE_READ;
+        }
+        
+        if (n > 1) {
+            STATS_ADD(vectored_ios, 1);
+        }
+        
+        if (disk->csums) {
+            int result = run_checksums(disk, is_write, start_block + done, n, blocks + done);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+        }
+        done += n;
+    }
+    
+    return DISK_SUCCESS;
+}
 
 /**
- * 错误码转字符串
+ * 读取一段可能包含已丢弃块的连续块
+ * 
+ * 丢弃后未再写入的块直接填零，不读镜像也不计入设备时间；其余的连续块
+ * 照常读取。
  */
-const char* disk_error_to_string(disk_error_t error) {
-    switch (error) {
-        case DISK_SUCCESS:              return "操作成功";
-        case DISK_ERROR_INVALID_PARAM:  return "无效参数";
-        case DISK_ERROR_FILE_OPEN:      return "文件打开失败";
-        case DISK_ERROR_FILE_CREATE:    return "文件创建失败";
-        case DISK_ERROR_FILE_READ:      return "文件读取失败";
-        case DISK_ERROR_FILE_WRITE:     return "文件写入失败";
-        case DISK_ERROR_FILE_SEEK:      return "文件定位失败";
-        case DISK_ERROR_BLOCK_RANGE:    return "块号超出范围";
-        case DISK_ERROR_NOT_INIT:       return "磁盘未初始化";
-        case DISK_ERROR_ALREADY_INIT:   return "磁盘已初始化";
-        case DISK_ERROR_DISK_FULL:      return "磁盘已满";
-        case DISK_ERROR_IO:             return "I/O错误";
-        case DISK_ERROR_CORRUPTED:      return "磁盘数据损坏";
-        default:                        return "未知错误";
+static int discarded_read_run(disk_t* disk, uint64_t start_block, uint32_t count,
+                              char* const* blocks) {
+    for (uint32_t done = 0; done < count; ) {
+        uint64_t run;
+        int discarded = extent_set_lookup(disk->discarded, start_block + done, &run);
+        uint32_t n = run < count - done ? (uint32_t)run : count - done;
+        
+        if (discarded) {
+            for (uint32_t i = 0; i < n; i++) {
+                memset(blocks[done + i], 0, disk->block_size);
+            }
+            STATS_ADD(discard_zero_reads, n);
+        } else {
+            int result = disk->backend->read_blocks(disk, start_block + done, n, blocks + done);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+        }
+        done += n;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 对一段连续块执行读写
+ * 
+ * 压缩、去重镜像和快照叠加层交给各自的存储；普通和条带镜像交给存储
+ * 后端，未映射时其中的全零块变为洞。写入的块不再是已丢弃的块。
+ */
+static int raw_io_run(disk_t* disk, int is_write, uint64_t start_block, uint32_t count,
+                      char* const* blocks) {
+    if (disk->chunks) {
+        return compressed_io(disk, is_write, start_block, count, blocks);
+    }
+    if (disk->dedup) {
+        return dedup_io(disk, is_write, start_block, count, blocks);
     }
+    if (disk->remap) {
+        return overlay_io(disk, is_write, start_block, count, blocks);
+    }
+    
+    if (is_write && disk->discarded && !disk->map_base) {
+        return sparse_write_run(disk, start_block, count, (const char* const*)blocks);
+    }
+    if (disk->discarded && extent_set_count(disk->discarded) > 0) {
+        if (!is_write) {
+            return discarded_read_run(disk, start_block, count, blocks);
+        }
+        extent_set_remove(disk->discarded, start_block, count);
+    }
+    
+    if (is_write) {
+        return disk->backend->write_blocks(disk, start_block, count, (const char* const*)blocks);
+    }
+    return disk->backend->read_blocks(disk, start_block, count, blocks);
 }
 
 /**
- * 检查磁盘是否已初始化
+ * 读取一段连续块（绕过缓存）
  */
-int disk_is_initialized(void) {
-    return g_disk_state.is_initialized;
+static int raw_read_run(disk_t* disk, uint64_t start_block, uint32_t count, char* const* blocks) {
+    return raw_io_run(disk, 0, start_block, count, blocks);
 }
 
 /**
- * 获取当前磁盘块数
+ * 写入一段连续块（绕过缓存）
  */
-uint32_t disk_get_block_count(void) {
-    return g_disk_state.is_initialized ? g_disk_state.total_blocks : 0;
+static int raw_write_run(disk_t* disk, uint64_t start_block, uint32_t count,
+                         const char* const* blocks) {
+    return raw_io_run(disk, 1, start_block, count, (char* const*)blocks);
 }
 
 /**
- * 验证块号
+ * 块缓存回写回调 - 将连续的脏块一次写入磁盘文件
  */
-int disk_is_valid_block(int block_num) {
-    return disk_check_block_bounds(block_num);
+static int cache_writeback(void* ctx, uint64_t start_block, uint32_t count,
+                           const char* const* blocks) {
+    disk_t* disk = (disk_t*)ctx;
+    
+    int result = raw_write_run(disk, start_block, count, blocks);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    STATS_ADD(cache_writebacks, count);
+    
+    return DISK_SUCCESS;
 }
 
 /**
- * 使用模式格式化磁盘
+ * 按当前配置创建块缓存（调用方持有cache_lock）
  */
-int disk_format(uint8_t pattern) {
-    if (!g_disk_state.is_initialized) {
-        return DISK_ERROR_NOT_INIT;
+static int create_block_cache(disk_t* disk) {
+    disk->cache = NULL;
+    if (disk->cache_capacity == 0) {
+        return DISK_SUCCESS;
     }
     
-    if (g_disk_state.is_read_only) {
-        return DISK_ERROR_IO;
+    disk->cache = block_cache_create(disk->cache_capacity, disk->block_size,
+                                            cache_writeback, disk);
+    return disk->cache ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/**
+ * 释放块缓存（调用方持有cache_lock），预读计数并入磁盘统计
+ */
+static void release_block_cache(disk_t* disk) {
+    if (disk->cache) {
+        STATS_ADD(readahead_hits, disk->cache->prefetch_hits);
+        STATS_ADD(readahead_wasted, disk->cache->prefetch_wasted);
+        block_cache_destroy(disk->cache);
+        disk->cache = NULL;
     }
+}
+
+/**
+ * 标记映射中的块为脏（等待msync）
+ */
+static void map_mark_dirty(disk_t* disk, uint64_t block_num) {
+    __atomic_fetch_or(&disk->map_dirty[block_num / 8],
+                      (uint8_t)(1 << (block_num % 8)), __ATOMIC_RELAXED);
+    __atomic_store_n(&disk->is_dirty, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * 检查映射中的块是否为脏
+ */
+static int map_is_dirty(disk_t* disk, uint64_t block_num) {
+    return (__atomic_load_n(&disk->map_dirty[block_num / 8], __ATOMIC_RELAXED)
+            >> (block_num % 8)) & 1;
+}
+
+/**
+ * 从映射中复制一个块并验证校验和（buffer为NULL时只验证）
+ */
+static int map_read_block(disk_t* disk, uint64_t block_num, char* buffer) {
+    const char* src = MAP_BLOCK_PTR(block_num);
     
-    // 创建模式块
-    char block_data[DISK_BLOCK_SIZE];
-    memset(block_data, pattern, DISK_BLOCK_SIZE);
+    for (int attempt = 0; ; attempt++) {
+        if (buffer) {
+            memcpy(buffer, src, disk->block_size);
+        }
+        if (csum_matches(disk, block_num, buffer ? buffer : src)) {
+            return DISK_SUCCESS;
+        }
+        if (attempt == CSUM_READ_RETRIES) {
+            return csum_failure(disk);
+        }
+        sched_yield();
+    }
+}
+
+/**
+ * 向映射写入一个块并标记为脏
+ */
+static void map_write_block(disk_t* disk, uint64_t block_num, const char* data) {
+    memcpy(MAP_BLOCK_PTR(block_num), data, disk->block_size);
+    map_mark_dirty(disk, block_num);
+    csum_update(disk, block_num, data);
+}
+
+/**
+ * 对一段块中写过的块所在的页范围调用msync
+ * 
+ * 连续的脏块合并为一次msync，起始地址向下对齐到页边界。
+ */
+static int map_sync_range(disk_t* disk, uint64_t start_block, uint64_t end_block) {
+    uint64_t page_mask = (uint64_t)sysconf(_SC_PAGESIZE) - 1;
+    uint64_t total = end_block;
     
-    // 写入模式到所有块
-    for (uint32_t i = 0; i < g_disk_state.total_blocks; i++) {
-        int result = disk_write_block(i, block_data);
-        if (result != DISK_SUCCESS) {
-            return result;
+    for (uint64_t i = start_block; i < total; ) {
+        // 整字节无脏块时快速跳过
+        if ((i % 8) == 0 &&
+            __atomic_load_n(&disk->map_dirty[i / 8], __ATOMIC_RELAXED) == 0) {
+            i += 8;
+            continue;
+        }
+        if (!map_is_dirty(disk, i)) {
+            i++;
+            continue;
+        }
+        
+        // 先清除脏位再同步，期间的新写入会重新置位
+        uint64_t end = i;
+        while (end < total && map_is_dirty(disk, end)) {
+            __atomic_fetch_and(&disk->map_dirty[end / 8],
+                               (uint8_t)~(1 << (end % 8)), __ATOMIC_RELAXED);
+            end++;
         }
+        
+        uint64_t start_offset = DISK_BLOCK_OFFSET(disk, i) & ~page_mask;
+        uint64_t end_offset = DISK_BLOCK_OFFSET(disk, end);
+        if (msync(disk->map_base + start_offset, end_offset - start_offset, MS_SYNC) == -1) {
+            return DISK_ERROR_IO;
+        }
+        i = end;
     }
     
-    // 强制同步
-    return disk_sync();
+    return DISK_SUCCESS;
 }
 
 /**
- * 打印磁盘状态
+ * 对所有写过的块所在的页范围调用msync
  */
-void disk_print_status(void) {
-    printf("\n=== 磁盘模拟器状态 ===\n");
-    
-    if (!g_disk_state.is_initialized) {
-        printf("状态: 未初始化\n");
-        printf("====================\n\n");
-        return;
+static int map_sync_dirty(disk_t* disk) {
+    return map_sync_range(disk, 0, disk->total_blocks);
+}
+
+/**
+ * 将整个磁盘镜像映射到内存
+ */
+static int map_disk_image(disk_t* disk) {
+    // 条带集的块分散在多个文件中，压缩、去重镜像和快照叠加层的块不按位置存放，都无法映射为一段连续内存
+    if (disk->stripe || disk->chunks || disk->dedup || disk->remap) {
+        return DISK_ERROR_INVALID_PARAM;
     }
     
-    printf("文件名: %s\n", g_disk_state.filename);
-    printf("状态: %s\n", g_disk_state.is_initialized ? "已初始化" : "未初始化");
-    printf("模式: %s\n", g_disk_state.is_read_only ? "只读" : "读写");
-    printf("块大小: %u 字节\n", g_disk_state.block_size);
-    printf("总块数: %u\n", g_disk_state.total_blocks);
-    printf("磁盘大小: %lu 字节 (%.2f MB)\n", 
-           g_disk_state.disk_size, g_disk_state.disk_size / (1024.0 * 1024.0));
-    printf("脏标志: %s\n", g_disk_state.is_dirty ? "是" : "否");
-    printf("自动同步: %s\n", g_disk_state.auto_sync ? "启用" : "禁用");
+    size_t size = DISK_FILE_SIZE(disk, disk->total_blocks);
+    int prot = PROT_READ | (disk->is_read_only ? 0 : PROT_WRITE);
     
-    printf("\n--- 统计信息 ---\n");
-    printf("总读取次数: %lu\n", g_disk_state.stats.total_reads);
-    printf("总写入次数: %lu\n", g_disk_state.stats.total_writes);
-    printf("读取字节数: %lu\n", g_disk_state.stats.bytes_read);
-    printf("写入字节数: %lu\n", g_disk_state.stats.bytes_written);
-    printf("读取错误: %lu\n", g_disk_state.stats.read_errors);
-    printf("写入错误: %lu\n", g_disk_state.stats.write_errors);
-    printf("平均读取时间: %.6f 秒\n", g_disk_state.stats.avg_read_time);
-    printf("平均写入时间: %.6f 秒\n", g_disk_state.stats.avg_write_time);
+    void* base = mmap(NULL, size, prot, MAP_SHARED, disk->fd, 0);
+    if (base == MAP_FAILED) {
+        return DISK_ERROR_IO;
+    }
     
-    if (g_disk_state.stats.last_operation_time > 0) {
-        printf("最后操作时间: %s", ctime(&g_disk_state.stats.last_operation_time));
+    // 内核不支持或未开启共享内存大页时照常使用普通页
+    if (disk->ram_flags & DISK_RAM_HUGE_PAGES) {
+        madvise(base, size, MADV_HUGEPAGE);
     }
     
-    printf("最后同步时间: %s", ctime(&g_disk_state.last_sync_time));
-    printf("====================\n\n");
+    uint8_t* dirty = (uint8_t*)calloc((disk->total_blocks + 7) / 8, 1);
+    if (!dirty) {
+        munmap(base, size);
+        return DISK_ERROR_IO;
+    }
+    
+    disk->map_base = (char*)base;
+    disk->map_size = size;
+    disk->map_dirty = dirty;
+    
+    // 映射期间的写入不经过丢弃记录，解除映射后记录已经过时
+    if (disk->discarded) {
+        extent_set_clear(disk->discarded);
+    }
+    return DISK_SUCCESS;
 }
 
-/*==============================================================================
- * 块I/O便利函数
- *============================================================================*/
+/**
+ * 同步并解除磁盘镜像映射
+ */
+static int unmap_disk_image(disk_t* disk) {
+    int result = map_sync_dirty(disk);
+    
+    munmap(disk->map_base, disk->map_size);
+    free(disk->map_dirty);
+    disk->map_base = NULL;
+    disk->map_size = 0;
+    disk->map_dirty = NULL;
+    
+    return result;
+}
 
 /**
- * 写入多个连续块
+ * 使已完成的写入持久化
+ * 
+ * 先把缓存中的脏块整批回写，再用一次fdatasync覆盖所有写入；mmap模式下
+ * 对脏页msync。校验和表在数据之后写回，由同一次fdatasync覆盖。
  */
-int disk_write_blocks(int start_block, int block_count, const char* data) {
-    if (!data || block_count <= 0) {
-        return DISK_ERROR_INVALID_PARAM;
+static int flush_for_durability(disk_t* disk) {
+    double start_time = get_current_time();
+    int result;
+    
+    if (disk->map_base) {
+        result = map_sync_dirty(disk);
+        if (result == DISK_SUCCESS && disk->csums &&
+            (csum_flush(disk) != DISK_SUCCESS || sync_image(disk, 1) != 0)) {
+            result = DISK_ERROR_IO;
+        }
+    } else {
+        result = DISK_SUCCESS;
+        if (disk->cache) {
+            pthread_mutex_lock(&disk->cache_lock);
+            if (block_cache_flush(disk->cache) != 0) {
+                result = DISK_ERROR_IO;
+            }
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+        if (result == DISK_SUCCESS && csum_flush(disk) != DISK_SUCCESS) {
+            result = DISK_ERROR_IO;
+        }
+        if (result == DISK_SUCCESS && sync_image(disk, 1) != 0) {
+            result = DISK_ERROR_IO;
+        }
     }
     
-    for (int i = 0; i < block_count; i++) {
-        int result = disk_write_block(start_block + i, 
-                                    data + (i * DISK_BLOCK_SIZE));
-        if (result != DISK_SUCCESS) {
-            return result;
+    latency_hist_record_seconds(&disk->stats.sync_latency, get_current_time() - start_time);
+    return result;
+}
+
+/**
+ * 组提交刷新线程
+ * 
+ * 有写入登记后等待时间窗口结束（或待刷新字节数达到阈值），然后一次刷新
+ * 覆盖期间登记的所有写入，并唤醒它们的写入者。停止时立即刷新剩余写入。
+ */
+static void* group_commit_thread(void* arg) {
+    disk_t* disk = (disk_t*)arg;
+    disk_group_commit_t* gc = &disk->group_commit;
+    
+    pthread_mutex_lock(&gc->lock);
+    for (;;) {
+        if (gc->write_seq == gc->flushed_seq) {
+            if (!gc->running) {
+                break;
+            }
+            pthread_cond_wait(&gc->wake, &gc->lock);
+            continue;
+        }
+        
+        // 等待时间窗口结束，让更多写入加入本批
+        struct timespec deadline = gc->first_pending;
+        deadline.tv_sec += gc->window_us / 1000000;
+        deadline.tv_nsec += (long)(gc->window_us % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (gc->running && gc->pending_bytes < gc->max_bytes) {
+            if (pthread_cond_timedwait(&gc->wake, &gc->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        
+        uint64_t target = gc->write_seq;
+        uint64_t writes = gc->pending_writes;
+        gc->pending_bytes = 0;
+        gc->pending_writes = 0;
+        pthread_mutex_unlock(&gc->lock);
+        
+        // 刷新期间新的写入可以继续登记，进入下一批
+        int result = flush_for_durability(disk);
+        STATS_ADD(group_commits, 1);
+        
+        pthread_mutex_lock(&gc->lock);
+        gc->flushed_seq = target;
+        if (result == DISK_SUCCESS) {
+            gc->durable_seq = target;
+            STATS_ADD(group_commit_writes, writes);
+        } else {
+            STATS_ADD(write_errors, 1);
         }
+        pthread_cond_broadcast(&gc->done);
     }
+    pthread_mutex_unlock(&gc->lock);
     
-    return DISK_SUCCESS;
+    return NULL;
 }
 
 /**
- * 读取多个连续块
+ * 登记一次写入并等待组提交使其持久化
  */
-int disk_read_blocks(int start_block, int block_count, char* buffer) {
-    if (!buffer || block_count <= 0) {
-        return DISK_ERROR_INVALID_PARAM;
+static int group_commit_wait(disk_t* disk, uint64_t bytes) {
+    disk_group_commit_t* gc = &disk->group_commit;
+    
+    pthread_mutex_lock(&gc->lock);
+    uint64_t seq = ++gc->write_seq;
+    if (gc->pending_writes++ == 0) {
+        // 本批的第一个写入开始计时
+        clock_gettime(CLOCK_MONOTONIC, &gc->first_pending);
+        pthread_cond_signal(&gc->wake);
+    }
+    gc->pending_bytes += bytes;
+    if (gc->pending_bytes >= gc->max_bytes) {
+        pthread_cond_signal(&gc->wake);
     }
     
-    for (int i = 0; i < block_count; i++) {
-        int result = disk_read_block(start_block + i, 
-                                   buffer + (i * DISK_BLOCK_SIZE));
-        if (result != DISK_SUCCESS) {
-            return result;
-        }
+    while (gc->flushed_seq < seq) {
+        pthread_cond_wait(&gc->done, &gc->lock);
+    }
+    int result = (gc->durable_seq >= seq) ? DISK_SUCCESS : DISK_ERROR_IO;
+    pthread_mutex_unlock(&gc->lock);
+    
+    return result;
+}
+
+/**
+ * 按给定的时间窗口和脏数据上限启动组提交刷新线程
+ */
+static int start_group_commit(disk_t* disk, uint32_t window_us, uint64_t max_bytes) {
+    disk_group_commit_t* gc = &disk->group_commit;
+    
+    memset(gc, 0, sizeof(*gc));
+    gc->window_us = window_us;
+    gc->max_bytes = max_bytes;
+    
+    // 时间窗口按单调时钟计算
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&gc->lock, NULL);
+    pthread_cond_init(&gc->wake, &attr);
+    pthread_cond_init(&gc->done, NULL);
+    pthread_condattr_destroy(&attr);
+    
+    gc->running = 1;
+    if (pthread_create(&gc->thread, NULL, group_commit_thread, disk) != 0) {
+        gc->running = 0;
+        pthread_cond_destroy(&gc->done);
+        pthread_cond_destroy(&gc->wake);
+        pthread_mutex_destroy(&gc->lock);
+        return DISK_ERROR_IO;
     }
     
     return DISK_SUCCESS;
 }
 
 /**
- * 清零一个块
+ * 停止组提交刷新线程（先刷新已登记的写入）
  */
-int disk_zero_block(int block_num) {
-    char zero_block[DISK_BLOCK_SIZE];
-    memset(zero_block, 0, DISK_BLOCK_SIZE);
-    return disk_write_block(block_num, zero_block);
+static void stop_group_commit(disk_t* disk) {
+    disk_group_commit_t* gc = &disk->group_commit;
+    if (!gc->running) {
+        return;
+    }
+    
+    pthread_mutex_lock(&gc->lock);
+    gc->running = 0;
+    pthread_cond_signal(&gc->wake);
+    pthread_mutex_unlock(&gc->lock);
+    pthread_join(gc->thread, NULL);
+    
+    pthread_cond_destroy(&gc->done);
+    pthread_cond_destroy(&gc->wake);
+    pthread_mutex_destroy(&gc->lock);
 }
 
+/* 派发排队写入（定义在I/O调度一节，需要批量写入函数） */
+static int ioq_dispatch_locked(disk_t* disk);
+
 /**
- * 复制块数据
+ * 访问[start_block, start_block + count)之前派发与之重叠的排队写入
  */
-int disk_copy_block(int src_block, int dst_block) {
-    char buffer[DISK_BLOCK_SIZE];
+static int ioq_barrier(disk_t* disk, uint64_t start_block, uint64_t count) {
+    disk_ioq_t* ioq = &disk->ioq;
+    if (__atomic_load_n(&ioq->count, __ATOMIC_ACQUIRE) == 0) {
+        return DISK_SUCCESS;
+    }
     
-    int result = disk_read_block(src_block, buffer);
-    if (result != DISK_SUCCESS) {
-        return result;
+    uint64_t end = start_block + count;
+    int result = DISK_SUCCESS;
+    
+    pthread_mutex_lock(&ioq->lock);
+    if (ioq->count > 0 && start_block <= ioq->high && end > ioq->low) {
+        for (uint32_t i = 0; i < ioq->count; i++) {
+            if (ioq->reqs[i].block_num >= start_block && ioq->reqs[i].block_num < end) {
+                result = ioq_dispatch_locked(disk);
+                break;
+            }
+        }
     }
+    pthread_mutex_unlock(&ioq->lock);
     
-    return disk_write_block(dst_block, buffer);
-} 
\ No newline at end of file
+    return result;
+}
+
+/**
+ * 派发全部排队写入，并报告之前后台派发的错误
+ */
+static int ioq_drain(disk_t* disk) {
+    disk_ioq_t* ioq = &disk->ioq;
+    if (!ioq->running) {
+        return DISK_SUCCESS;
+    }
+    
+    pthread_mutex_lock(&ioq->lock);
+    int result = ioq_dispatch_locked(disk);
+    if (result == DISK_SUCCESS) {
+        result = ioq->error;
+    }
+    ioq->error = DISK_SUCCESS;
+    pthread_mutex_unlock(&ioq->lock);
+    
+    return result;
+}
+
+/**
+ * I/O调度截止时间线程
+ * 
+ * 队列非空时等待最早的排队写入到期后派发整个队列，保证排队写入最多等待
+ * deadline_us；期间队列被其他线程派发或填满时重新计算。停止时派发剩余写入。
+ */
+static void* ioq_thread(void* arg) {
+    disk_t* disk = (disk_t*)arg;
+    disk_ioq_t* ioq = &disk->ioq;
+    
+    pthread_mutex_lock(&ioq->lock);
+    for (;;) {
+        if (ioq->count == 0) {
+            if (!ioq->running) {
+                break;
+            }
+            pthread_cond_wait(&ioq->wake, &ioq->lock);
+            continue;
+        }
+        
+        if (ioq->running) {
+            struct timespec deadline = ioq->oldest;
+            deadline.tv_sec += ioq->deadline_us / 1000000;
+            deadline.tv_nsec += (long)(ioq->deadline_us % 1000000) * 1000;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            if (pthread_cond_timedwait(&ioq->wake, &ioq->lock, &deadline) != ETIMEDOUT) {
+                continue;
+            }
+        }
+        
+        int result = ioq_dispatch_locked(disk);
+        if (result != DISK_SUCCESS && ioq->error == DISK_SUCCESS) {
+            ioq->error = result;
+        }
+    }
+    pthread_mutex_unlock(&ioq->lock);
+    
+    return NULL;
+}
+
+/**
+ * 按给定的深度和截止时间创建I/O调度队列并启动截止时间线程
+ */
+static int start_ioq(disk_t* disk, uint32_t depth, uint32_t deadline_us) {
+    disk_ioq_t* ioq = &disk->ioq;
+    
+    memset(ioq, 0, sizeof(*ioq));
+    ioq->depth = depth;
+    ioq->deadline_us = deadline_us;
+    ioq->reqs = (disk_block_vec_t*)malloc((size_t)ioq->depth * sizeof(disk_block_vec_t));
+    ioq->data = (char*)malloc((size_t)ioq->depth * disk->block_size);
+    if (!ioq->reqs || !ioq->data) {
+        free(ioq->reqs);
+        free(ioq->data);
+        memset(ioq, 0, sizeof(*ioq));
+        return DISK_ERROR_IO;
+    }
+    
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&ioq->lock, NULL);
+    pthread_cond_init(&ioq->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    
+    ioq->running = 1;
+    if (pthread_create(&ioq->thread, NULL, ioq_thread, disk) != 0) {
+        pthread_cond_destroy(&ioq->wake);
+        pthread_mutex_destroy(&ioq->lock);
+        free(ioq->reqs);
+        free(ioq->data);
+        memset(ioq, 0, sizeof(*ioq));
+        return DISK_ERROR_IO;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 停止I/O调度队列（线程退出前派发剩余写入）
+ */
+static void stop_ioq(disk_t* disk) {
+    disk_ioq_t* ioq = &disk->ioq;
+    if (!ioq->running) {
+        return;
+    }
+    
+    pthread_mutex_lock(&ioq->lock);
+    ioq->running = 0;
+    pthread_cond_signal(&ioq->wake);
+    pthread_mutex_unlock(&ioq->lock);
+    pthread_join(ioq->thread, NULL);
+    
+    pthread_cond_destroy(&ioq->wake);
+    pthread_mutex_destroy(&ioq->lock);
+    free(ioq->reqs);
+    free(ioq->data);
+    memset(ioq, 0, sizeof(*ioq));
+}
+
+/**
+ * 写入完成后按同步模式保证持久化
+ * 
+ * 组提交模式下等待下一次批量刷新；auto_sync模式下每次写入后fsync。
+ */
+static int sync_after_write(disk_t* disk, uint32_t blocks) {
+    if (disk->group_commit.running) {
+        return group_commit_wait(disk, (uint64_t)blocks * disk->block_size);
+    }
+    
+    if (disk->auto_sync) {
+        double start_time = get_current_time();
+        int result = csum_flush(disk);
+        if (result == DISK_SUCCESS && sync_image(disk, 0) == -1) {
+            result = DISK_ERROR_IO;
+        }
+        latency_hist_record_seconds(&disk->stats.sync_latency, get_current_time() - start_time);
+        return result;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 用同一字节填充一段连续块（绕过缓存）
+ * 
+ * 所有iovec指向同一个模式块，每DISK_MAX_IOV_BLOCKS块一次pwritev；mmap模式
+ * 下直接memset映射。
+ */
+static int fill_block_range(disk_t* disk, uint64_t start_block, uint64_t count, uint8_t pattern) {
+    if (disk->map_base) {
+        memset(MAP_BLOCK_PTR(start_block), pattern, (size_t)count * disk->block_size);
+        for (uint64_t i = 0; i < count; i++) {
+            map_mark_dirty(disk, start_block + i);
+        }
+        csum_update_range(disk, start_block, count, pattern);
+        return DISK_SUCCESS;
+    }
+    
+    char* block = (char*)malloc(disk->block_size);
+    if (!block) {
+        return DISK_ERROR_IO;
+    }
+    memset(block, pattern, disk->block_size);
+    
+    const char* blocks[DISK_MAX_IOV_BLOCKS];
+    for (uint32_t i = 0; i < DISK_MAX_IOV_BLOCKS; i++) {
+        blocks[i] = block;
+    }
+    
+    int result = DISK_SUCCESS;
+    for (uint64_t done = 0; done < count && result == DISK_SUCCESS; ) {
+        uint32_t n = DISK_MAX_IOV_BLOCKS;
+        if (count - done < n) {
+            n = (uint32_t)(count - done);
+        }
+        result = raw_write_run(disk, start_block + done, n, blocks);
+        done += n;
+    }
+    
+    free(block);
+    return result;
+}
+
+/**
+ * 由主机文件系统把文件中的一段变为全零，不写入数据
+ * 
+ * 清零时优先FALLOC_FL_ZERO_RANGE（保留已分配空间），其次打洞；punch为1
+ * 时只打洞，把空间还给主机文件系统。
+ * 
+ * @return DISK_SUCCESS，或DISK_ERROR_IO表示文件系统不支持
+ */
+static int deallocate_extent(int fd, off_t offset, off_t length, int punch) {
+    (void)fd;
+    (void)offset;
+    (void)length;
+    (void)punch;
+    
+#ifdef FALLOC_FL_ZERO_RANGE
+    if (!punch && fallocate(fd, FALLOC_FL_ZERO_RANGE, offset, length) == 0) {
+        return DISK_SUCCESS;
+    }
+#endif
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) == 0) {
+        return DISK_SUCCESS;
+    }
+#endif
+    
+    return DISK_ERROR_IO;
+}
+
+/**
+ * 把一段块交给存储清零或打洞
+ */
+static int deallocate_block_range(disk_t* disk, uint64_t start_block, uint64_t count, int punch) {
+    // 压缩镜像中整个块组清零即从索引中删除
+    if (disk->chunks) {
+        return chunk_store_zero(disk->chunks, start_block, (uint32_t)count) == 0
+            ? DISK_SUCCESS : DISK_ERROR_IO;
+    }
+    // 去重镜像中清零即释放块对槽的引用
+    if (disk->dedup) {
+        return dedup_store_zero(disk->dedup, start_block, (uint32_t)count) == 0
+            ? DISK_SUCCESS : DISK_ERROR_IO;
+    }
+    // 叠加层中的块标记为清零，已分配的槽由主机文件系统释放空间（槽保留给以后的写入）
+    if (disk->remap) {
+        for (uint64_t i = start_block; i < start_block + count; i++) {
+            uint32_t entry = __atomic_load_n(&disk->remap[i], __ATOMIC_ACQUIRE);
+            if (entry != 0 && entry != REMAP_ZERO) {
+                if (deallocate_extent(disk->fd, (off_t)OVERLAY_SLOT_OFFSET(disk, entry - 1),
+                                      (off_t)disk->block_size, punch) != DISK_SUCCESS &&
+                    overlay_write_block(disk, i, g_zero_block) != DISK_SUCCESS) {
+                    return DISK_ERROR_IO;
+                }
+            } else if (entry == 0) {
+                remap_store(disk, i, REMAP_ZERO);
+            }
+        }
+        return DISK_SUCCESS;
+    }
+    
+    return disk->backend->discard(disk, start_block, count, punch);
+}
+
+/**
+ * 把一段连续块变为全零（调用方已检查参数）
+ * 
+ * 缓存中的旧副本直接丢弃。清零在持有缓存锁时完成，避免并发读把清零前
+ * 的数据重新放入缓存。punch为1时打洞释放空间，并记下丢弃的范围，之后
+ * 的读取直接填零（mmap模式下读取本来就不经过镜像文件的读路径）。
+ */
+static int clear_block_range(disk_t* disk, uint64_t start_block, uint64_t count, int punch) {
+    if (disk->cache) {
+        pthread_mutex_lock(&disk->cache_lock);
+        block_cache_invalidate_range(disk->cache, start_block, count);
+        disk->write_seq++;
+    }
+    
+    // 整段已是洞时无需再交给主机文件系统（清零范围反而会为洞分配空间）
+    uint64_t run;
+    if (disk->discarded && !disk->map_base &&
+        extent_set_lookup(disk->discarded, start_block, &run) && run >= count) {
+        STATS_ADD(zero_writes_skipped, count);
+        STATS_ADD(bytes_write_avoided, count * disk->block_size);
+        if (disk->cache) {
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+        return DISK_SUCCESS;
+    }
+    
+    int result = deallocate_block_range(disk, start_block, count, punch);
+    if (result == DISK_SUCCESS) {
+        csum_update_range(disk, start_block, count, 0);
+    }
+    if (result == DISK_SUCCESS && disk->map_base) {
+        // 映射中的页已被丢弃，无需再msync
+        for (uint64_t i = start_block; i < start_block + count; i++) {
+            __atomic_fetch_and(&disk->map_dirty[i / 8],
+                               (uint8_t)~(1 << (i % 8)), __ATOMIC_RELAXED);
+        }
+    } else if (result != DISK_SUCCESS) {
+        result = fill_block_range(disk, start_block, count, 0);
+    }
+    
+    // 集合已满时不记录，这些块照常从镜像中读出零
+    if (result == DISK_SUCCESS && punch && disk->discarded && !disk->map_base) {
+        extent_set_add(disk->discarded, start_block, count);
+    }
+    
+    if (disk->cache) {
+        pthread_mutex_unlock(&disk->cache_lock);
+    }
+    
+    if (result == DISK_SUCCESS) {
+        __atomic_store_n(&disk->stats.last_operation_time, time(NULL), __ATOMIC_RELAXED);
+        __atomic_store_n(&disk->is_dirty, 1, __ATOMIC_RELAXED);
+    }
+    
+    return result;
+}
+
+/**
+ * 清零一段连续块（调用方已检查参数）
+ */
+static int zero_block_range(disk_t* disk, uint64_t start_block, uint64_t count) {
+    int result = clear_block_range(disk, start_block, count, 0);
+    if (result == DISK_SUCCESS) {
+        STATS_ADD(blocks_zeroed, count);
+    }
+    return result;
+}
+
+/**
+ * 后台清零线程
+ * 
+ * 每次清零DISK_ZERO_CHUNK_BLOCKS块，段与段之间释放锁，让认领请求插入。
+ */
+static void* zeroer_thread(void* arg) {
+    disk_t* disk = (disk_t*)arg;
+    disk_zeroer_t* z = &disk->zeroer;
+    
+    pthread_mutex_lock(&z->lock);
+    while (!z->stop && z->next < z->end) {
+        uint32_t n = DISK_ZERO_CHUNK_BLOCKS;
+        if (z->end - z->next < n) {
+            n = (uint32_t)(z->end - z->next);
+        }
+        
+        // 失败时停在原处，剩余块由认领请求同步清零
+        if (zero_block_range(disk, z->next, n) != DISK_SUCCESS) {
+            break;
+        }
+        z->next += n;
+        
+        pthread_mutex_unlock(&z->lock);
+        sched_yield();
+        pthread_mutex_lock(&z->lock);
+    }
+    pthread_mutex_unlock(&z->lock);
+    
+    return NULL;
+}
+
+/**
+ * 停止后台清零线程并清除任务范围
+ */
+static void stop_zeroer(disk_t* disk) {
+    disk_zeroer_t* z = &disk->zeroer;
+    
+    pthread_mutex_lock(&z->lock);
+    z->stop = 1;
+    pthread_mutex_unlock(&z->lock);
+    
+    if (z->active) {
+        pthread_join(z->thread, NULL);
+        z->active = 0;
+    }
+    
+    z->stop = 0;
+    z->start = 0;
+    z->next = 0;
+    z->end = 0;
+}
+
+/**
+ * 等待后台清零任务做完并清除任务范围
+ * 
+ * 线程中途失败时剩余的块在这里同步清零。
+ */
+static int finish_zeroer(disk_t* disk) {
+    disk_zeroer_t* z = &disk->zeroer;
+    
+    if (z->active) {
+        pthread_join(z->thread, NULL);
+        z->active = 0;
+    }
+    
+    int result = DISK_SUCCESS;
+    if (z->next < z->end) {
+        result = zero_block_range(disk, z->next, z->end - z->next);
+    }
+    stop_zeroer(disk);
+    return result;
+}
+
+/**
+ * 计算头部校验和
+ * 
+ * 版本3起对时间戳和校验和以外的所有字段计算CRC32C；更早的版本只覆盖
+ * created_time之前的字段，使用简单校验和。
+ */
+static uint32_t header_checksum(const disk_header_t* header) {
+    uint32_t stable_size = offsetof(disk_header_t, created_time);
+    if (header->version < 3) {
+        return calculate_checksum(header, stable_size);
+    }
+    
+    uint32_t crc = crc32c(0, header, stable_size);
+    return crc32c(crc, &header->flags, sizeof(disk_header_t) - offsetof(disk_header_t, flags));
+}
+
+/**
+ * 创建磁盘头部
+ */
+static int create_disk_header(disk_t* disk, disk_header_t* header, uint64_t total_blocks) {
+    if (!header) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    memset(header, 0, sizeof(disk_header_t));
+    
+    header->magic_number = DISK_MAGIC_HEADER;
+    header->version = DISK_VERSION;
+    header->block_size = disk->block_size;
+    header->total_blocks = (uint32_t)total_blocks;
+    header->total_blocks_hi = (uint32_t)(total_blocks >> 32);
+    header->disk_size = total_blocks * disk->block_size > UINT32_MAX
+                      ? UINT32_MAX : (uint32_t)(total_blocks * disk->block_size);
+    header->created_time = time(NULL);
+    header->last_access_time = header->created_time;
+    header->flags = g_new_checksums ? DISK_FLAG_BLOCK_CHECKSUMS | DISK_FLAG_CHECKSUMS_STALE : 0;
+    if (g_new_stripe_members > 1) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        header->flags |= DISK_FLAG_STRIPED;
+        header->stripe_blocks = g_new_stripe_blocks;
+        header->stripe_count = (uint16_t)g_new_stripe_members;
+        header->stripe_index = 0;
+        header->stripe_set_id = ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec ^
+                                ((uint64_t)getpid() << 16);
+    }
+    if (g_new_chunk_blocks > 0) {
+        header->flags |= DISK_FLAG_COMPRESSED;
+        header->chunk_blocks = g_new_chunk_blocks;
+    }
+    if (g_new_dedup) {
+        header->flags |= DISK_FLAG_DEDUP;
+    }
+    
+    // 只对稳定的字段计算校验和（排除时间戳和校验和字段）
+    header->checksum = header_checksum(header);
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 修改镜像文件头部的标志位并立即落盘
+ */
+static int write_header_flags(int fd, uint32_t set, uint32_t clear) {
+    disk_header_t header;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        return DISK_ERROR_FILE_READ;
+    }
+    
+    header.flags = (header.flags | set) & ~clear;
+    header.checksum = header_checksum(&header);
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        return DISK_ERROR_FILE_WRITE;
+    }
+    
+    return fdatasync(fd) == 0 ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/**
+ * 修改当前磁盘头部的标志位并立即落盘
+ */
+static int update_header_flags(disk_t* disk, uint32_t set, uint32_t clear) {
+    return write_header_flags(disk->fd, set, clear);
+}
+
+/**
+ * 计算块数据在镜像文件中的起始偏移
+ * 
+ * 版本1的块紧跟在头部之后；版本2起头部单独占满一个块，使每个块都按
+ * 块大小对齐（块大小不小于页大小时即按页对齐）。
+ */
+static uint64_t header_data_offset(const disk_header_t* header) {
+    return header->version == 1 ? sizeof(disk_header_t) : header->block_size;
+}
+
+/**
+ * 取头部记录的块数
+ * 
+ * 版本4起块数为64位，高32位存放在原保留字段中；更早的版本只有低32位。
+ */
+static uint64_t header_total_blocks(const disk_header_t* header) {
+    uint64_t high = header->version >= 4 ? header->total_blocks_hi : 0;
+    return (high << 32) | header->total_blocks;
+}
+
+/**
+ * 验证磁盘头部
+ */
+static int validate_disk_header(const disk_header_t* header) {
+    if (!header) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (header->magic_number != DISK_MAGIC_HEADER) {
+        return DISK_ERROR_CORRUPTED;
+    }
+    
+    // 版本1的镜像只有1KB块；版本2起块大小可配置
+    if (header->version == 1) {
+        if (header->block_size != DISK_MIN_BLOCK_SIZE) {
+            return DISK_ERROR_CORRUPTED;
+        }
+    } else if (header->version > DISK_VERSION ||
+               !DISK_IS_VALID_BLOCK_SIZE(header->block_size)) {
+        return DISK_ERROR_CORRUPTED;
+    }
+    
+    // 只验证稳定字段的校验和
+    uint32_t calculated_checksum = header_checksum(header);
+    if (calculated_checksum != header->checksum) {
+        return DISK_ERROR_CORRUPTED;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 计算校验和表占用的块数
+ */
+static uint32_t checksum_table_blocks(uint64_t total_blocks, uint32_t block_size) {
+    uint32_t per_block = block_size / sizeof(uint32_t);
+    return (uint32_t)((total_blocks + per_block - 1) / per_block);
+}
+
+/**
+ * 释放内存中的校验和表
+ */
+static void free_checksums(disk_t* disk) {
+    free(disk->csums);
+    free(disk->csum_dirty);
+    disk->csums = NULL;
+    disk->csum_dirty = NULL;
+}
+
+/**
+ * 建立内存中的校验和表（位于数据区之后，条带集时在成员0中）
+ * 
+ * 新建镜像时数据区读出全零，所有项填为零块的校验和并写入文件；打开
+ * 已有镜像时从文件加载。
+ */
+static int setup_checksums(disk_t* disk, int create) {
+    uint32_t table_blocks = checksum_table_blocks(disk->total_blocks,
+                                                  disk->block_size);
+    size_t table_size = (size_t)table_blocks * disk->block_size;
+    
+    disk->csum_table_blocks = table_blocks;
+    disk->csum_offset = DISK_FILE_SIZE(disk, disk->member_blocks);
+    disk->csums = (uint32_t*)calloc(table_size, 1);
+    disk->csum_dirty = (uint8_t*)calloc((table_blocks + 7) / 8, 1);
+    if (!disk->csums || !disk->csum_dirty) {
+        free_checksums(disk);
+        return DISK_ERROR_IO;
+    }
+    
+    int result = DISK_SUCCESS;
+    if (create) {
+        csum_update_range(disk, 0, disk->total_blocks, 0);
+        result = csum_flush(disk);
+    } else if (pread(disk->fd, disk->csums, table_size,
+                     (off_t)disk->csum_offset) != (ssize_t)table_size) {
+        result = DISK_ERROR_FILE_READ;
+    }
+    
+    if (result != DISK_SUCCESS) {
+        free_checksums(disk);
+    }
+    return result;
+}
+
+/**
+ * 不验证校验和地读取一段连续块到连续缓冲区
+ */
+static int read_run_unverified(disk_t* disk, uint64_t start_block, uint32_t count, char* buffer) {
+    if (disk->stripe) {
+        char* blocks[DISK_MAX_IOV_BLOCKS];
+        for (uint32_t i = 0; i < count; i++) {
+            blocks[i] = buffer + (size_t)i * disk->block_size;
+        }
+        return stripe_set_io(disk->stripe, 0, start_block, count, blocks) > 0
+            ? DISK_SUCCESS : DISK_ERROR_FILE_READ;
+    }
+    
+    size_t length = (size_t)count * disk->block_size;
+    return pread(disk->fd, buffer, length, (off_t)DISK_BLOCK_OFFSET(disk, start_block)) ==
+           (ssize_t)length ? DISK_SUCCESS : DISK_ERROR_FILE_READ;
+}
+
+/**
+ * 按数据区的当前内容重建校验和表
+ * 
+ * 校验和表只在同步时回写，镜像未正常关闭时表中的项可能落后于数据。
+ * 这些块已无法验证，只能以现有内容为准重新计算，避免误报校验失败。
+ */
+static int rebuild_checksums(disk_t* disk) {
+    uint32_t block_size = disk->block_size;
+    char* buffer = (char*)malloc((size_t)DISK_MAX_IOV_BLOCKS * block_size);
+    if (!buffer) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = DISK_SUCCESS;
+    for (uint64_t block = 0; block < disk->total_blocks; block += DISK_MAX_IOV_BLOCKS) {
+        uint32_t n = DISK_MAX_IOV_BLOCKS;
+        if (disk->total_blocks - block < n) {
+            n = (uint32_t)(disk->total_blocks - block);
+        }
+        
+        if (read_run_unverified(disk, block, n, buffer) != DISK_SUCCESS) {
+            result = DISK_ERROR_FILE_READ;
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            csum_update(disk, block + i, buffer + (size_t)i * block_size);
+        }
+    }
+    
+    free(buffer);
+    return (result == DISK_SUCCESS) ? csum_flush(disk) : result;
+}
+
+/**
+ * 生成条带集成员文件名（成员0即镜像文件本身）
+ */
+static void member_filename(disk_t* disk, char* name, size_t size, uint32_t index) {
+    snprintf(name, size, "%s.%u", disk->filename, index);
+}
+
+/**
+ * 启动条带集（成员0使用镜像文件的描述符）
+ */
+static int start_stripe_set(disk_t* disk, uint32_t stripe_blocks) {
+    disk->member_fds[0] = disk->fd;
+    disk->stripe = stripe_set_create(disk->member_fds, disk->member_count,
+                                            stripe_blocks, disk->block_size,
+                                            disk->data_offset);
+    return disk->stripe ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/**
+ * 停止条带集并关闭成员1及以后的文件
+ * 
+ * @param remove 是否同时删除成员文件（新建失败时）
+ */
+static void close_stripe_members(disk_t* disk, int remove) {
+    stripe_set_destroy(disk->stripe);
+    disk->stripe = NULL;
+    
+    for (uint32_t i = 1; i < disk->member_count; i++) {
+        if (disk->member_fds[i] > 0) {
+            close(disk->member_fds[i]);
+            disk->member_fds[i] = 0;
+            if (remove) {
+                char name[DISK_MAX_FILENAME_LEN + 8];
+                member_filename(disk, name, sizeof(name), i);
+                unlink(name);
+            }
+        }
+    }
+}
+
+/**
+ * 打开已有条带集的其余成员并逐一核对头部
+ * 
+ * 每个成员的头部必须有效，且与成员0属于同一条带集、位于预期的位置，
+ * 文件大小足以容纳本成员的块。
+ */
+static int open_stripe_members(disk_t* disk, const disk_header_t* header) {
+    for (uint32_t i = 1; i < disk->member_count; i++) {
+        char name[DISK_MAX_FILENAME_LEN + 8];
+        member_filename(disk, name, sizeof(name), i);
+        
+        int fd = open(name, O_RDWR);
+        if (fd == -1) {
+            close_stripe_members(disk, 0);
+            return DISK_ERROR_FILE_OPEN;
+        }
+        disk->member_fds[i] = fd;
+        
+        disk_header_t member;
+        struct stat member_stat;
+        if (pread(fd, &member, sizeof(member), 0) != sizeof(member) ||
+            validate_disk_header(&member) != DISK_SUCCESS ||
+            !(member.flags & DISK_FLAG_STRIPED) ||
+            member.stripe_set_id != header->stripe_set_id ||
+            member.stripe_index != i ||
+            member.stripe_count != header->stripe_count ||
+            member.stripe_blocks != header->stripe_blocks ||
+            member.block_size != header->block_size ||
+            header_total_blocks(&member) != header_total_blocks(header) ||
+            fstat(fd, &member_stat) != 0 ||
+            (uint64_t)member_stat.st_size < DISK_FILE_SIZE(disk, disk->member_blocks)) {
+            close_stripe_members(disk, 0);
+            return DISK_ERROR_CORRUPTED;
+        }
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 新建条带集的其余成员：写入各自位置的头部并扩展到成员大小
+ */
+static int create_stripe_members(disk_t* disk, const disk_header_t* header) {
+    for (uint32_t i = 1; i < disk->member_count; i++) {
+        char name[DISK_MAX_FILENAME_LEN + 8];
+        member_filename(disk, name, sizeof(name), i);
+        
+        int fd = open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd == -1) {
+            close_stripe_members(disk, 1);
+            return DISK_ERROR_FILE_CREATE;
+        }
+        disk->member_fds[i] = fd;
+        
+        disk_header_t member = *header;
+        member.stripe_index = (uint16_t)i;
+        member.flags &= ~(uint32_t)(DISK_FLAG_BLOCK_CHECKSUMS | DISK_FLAG_CHECKSUMS_STALE);
+        member.checksum = header_checksum(&member);
+        if (pwrite(fd, &member, sizeof(member), 0) != sizeof(member) ||
+            ftruncate(fd, (off_t)DISK_FILE_SIZE(disk, disk->member_blocks)) == -1) {
+            close_stripe_members(disk, 1);
+            return DISK_ERROR_FILE_WRITE;
+        }
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 打开镜像中的压缩块存储（索引位于头部之后的数据区起始处）
+ */
+static int open_chunk_store(disk_t* disk, uint32_t chunk_blocks, int create) {
+    int result = chunk_store_open(disk->fd, disk->data_offset, (uint32_t)disk->total_blocks,
+                                  disk->block_size, chunk_blocks, create, &disk->chunks);
+    if (result == -EINVAL) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    if (result == -EBADMSG) {
+        return DISK_ERROR_CORRUPTED;
+    }
+    return result == 0 ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/**
+ * 打开镜像中的去重块存储（块映射表和指纹表位于头部之后的数据区起始处）
+ */
+static int open_dedup_store(disk_t* disk, int create) {
+    int result = dedup_store_open(disk->fd, disk->data_offset, (uint32_t)disk->total_blocks,
+                                  disk->block_size, create, &disk->dedup);
+    if (result == -EINVAL) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    if (result == -EBADMSG) {
+        return DISK_ERROR_CORRUPTED;
+    }
+    return result == 0 ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/* 打开和关闭磁盘（定义在核心磁盘操作一节，叠加层以同样的方式打开下面的冻结镜像） */
+static int open_disk(disk_t* disk, const char* filename, uint64_t disk_size, int as_backing);
+static int close_disk(disk_t* disk);
+
+/**
+ * 关闭叠加层下面的冻结镜像并释放映射表
+ */
+static void close_overlay(disk_t* disk) {
+    if (disk->backing) {
+        close_disk(disk->backing);
+        free(disk->backing);
+        disk->backing = NULL;
+    }
+    free(disk->remap);
+    free(disk->remap_dirty);
+    disk->remap = NULL;
+    disk->remap_dirty = NULL;
+}
+
+/**
+ * 打开快照叠加层：载入映射表，再以只读方式打开下面的冻结镜像
+ * 
+ * 冻结镜像的文件名保存在头部块中紧随头部之后，由头部的backing_crc保护；
+ * 两者的块大小和块数必须一致。
+ */
+static int open_overlay(disk_t* disk, const disk_header_t* header) {
+    char name[DISK_MAX_FILENAME_LEN];
+    if (pread(disk->fd, name, sizeof(name), sizeof(disk_header_t)) != sizeof(name)) {
+        return DISK_ERROR_FILE_READ;
+    }
+    name[sizeof(name) - 1] = '\0';
+    if (name[0] == '\0' || crc32c(0, name, strlen(name)) != header->backing_crc) {
+        return DISK_ERROR_CORRUPTED;
+    }
+    
+    uint32_t table_blocks = checksum_table_blocks(disk->total_blocks, disk->block_size);
+    size_t table_size = (size_t)table_blocks * disk->block_size;
+    disk->remap = (uint32_t*)malloc(table_size);
+    disk->remap_dirty = (uint8_t*)calloc((table_blocks + 7) / 8, 1);
+    disk->backing = (disk_t*)calloc(1, sizeof(disk_t));
+    if (!disk->remap || !disk->remap_dirty || !disk->backing) {
+        close_overlay(disk);
+        return DISK_ERROR_IO;
+    }
+    disk->remap_table_blocks = table_blocks;
+    disk->overlay_offset = disk->data_offset + table_size;
+    if (pread(disk->fd, disk->remap, table_size, (off_t)disk->data_offset) != (ssize_t)table_size) {
+        close_overlay(disk);
+        return DISK_ERROR_FILE_READ;
+    }
+    
+    // 新槽从已登记的最大槽之后分配（崩溃前分配但未登记的槽直接跳过）
+    for (uint64_t i = 0; i < disk->total_blocks; i++) {
+        uint32_t entry = disk->remap[i];
+        if (entry != REMAP_ZERO && entry > disk->overlay_slots) {
+            disk->overlay_slots = entry;
+        }
+    }
+    
+    int result = open_disk(disk->backing, name, 1, 1);
+    if (result == DISK_SUCCESS && (disk->backing->block_size != disk->block_size ||
+                                   disk->backing->total_blocks != disk->total_blocks)) {
+        result = DISK_ERROR_CORRUPTED;
+    }
+    if (result != DISK_SUCCESS) {
+        close_overlay(disk);
+    }
+    return result;
+}
+
+/**
+ * 在冻结镜像之上新建快照叠加层
+ * 
+ * 映射表全零，即所有块都还在冻结镜像中；文件只有头部块和映射表。
+ */
+static int create_overlay(const char* filename, const char* backing_name,
+                          const disk_header_t* base) {
+    disk_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic_number = DISK_MAGIC_HEADER;
+    header.version = DISK_VERSION;
+    header.block_size = base->block_size;
+    header.total_blocks = base->total_blocks;
+    header.total_blocks_hi = base->version >= 4 ? base->total_blocks_hi : 0;
+    header.disk_size = base->disk_size;
+    header.created_time = time(NULL);
+    header.last_access_time = header.created_time;
+    header.flags = DISK_FLAG_OVERLAY;
+    header.backing_crc = crc32c(0, backing_name, strlen(backing_name));
+    header.checksum = header_checksum(&header);
+    
+    char name[DISK_MAX_FILENAME_LEN] = {0};
+    strncpy(name, backing_name, sizeof(name) - 1);
+    uint64_t file_size = (uint64_t)header.block_size *
+                         (1 + checksum_table_blocks(header_total_blocks(&header), header.block_size));
+    
+    int fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        return DISK_ERROR_FILE_CREATE;
+    }
+    
+    int result = DISK_SUCCESS;
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        pwrite(fd, name, sizeof(name), sizeof(header)) != sizeof(name) ||
+        ftruncate(fd, (off_t)file_size) == -1) {
+        result = DISK_ERROR_FILE_WRITE;
+    } else if (fsync(fd) != 0) {
+        result = DISK_ERROR_IO;
+    }
+    
+    close(fd);
+    if (result != DISK_SUCCESS) {
+        unlink(filename);
+    }
+    return result;
+}
+
+/*==============================================================================
+ * 内存盘
+ *============================================================================*/
+
+/**
+ * 把镜像内容复制到另一个文件（空洞保持为空洞）
+ * 
+ * 目标先截断为size，再用SEEK_DATA/SEEK_HOLE只复制有数据的段；不支持
+ * SEEK_DATA的文件整体复制。
+ */
+static int copy_image_data(int src_fd, int dst_fd, uint64_t size) {
+    if (ftruncate(dst_fd, (off_t)size) == -1) {
+        return DISK_ERROR_FILE_WRITE;
+    }
+    
+    char* buffer = (char*)malloc(RAM_COPY_BYTES);
+    if (!buffer) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = DISK_SUCCESS;
+    off_t pos = 0;
+    while (result == DISK_SUCCESS && (uint64_t)pos < size) {
+        off_t data = lseek(src_fd, pos, SEEK_DATA);
+        if (data == -1 && errno == ENXIO) {
+            break;
+        }
+        if (data == -1) {
+            data = pos;
+        }
+        off_t hole = lseek(src_fd, data, SEEK_HOLE);
+        if (hole == -1 || (uint64_t)hole > size) {
+            hole = (off_t)size;
+        }
+        
+        for (off_t offset = data; offset < hole; ) {
+            size_t length = (uint64_t)(hole - offset) < RAM_COPY_BYTES
+                ? (size_t)(hole - offset) : RAM_COPY_BYTES;
+            ssize_t got = pread(src_fd, buffer, length, offset);
+            if (got <= 0) {
+                result = DISK_ERROR_FILE_READ;
+                break;
+            }
+            if (pwrite(dst_fd, buffer, (size_t)got, offset) != got) {
+                result = DISK_ERROR_FILE_WRITE;
+                break;
+            }
+            offset += got;
+        }
+        pos = hole;
+    }
+    
+    free(buffer);
+    return result;
+}
+
+/**
+ * 创建存放内存盘镜像的匿名内存文件
+ */
+static int create_ram_image(void) {
+    return memfd_create("disk_simulator", MFD_CLOEXEC);
+}
+
+/**
+ * 把镜像文件载入新的内存文件
+ * 
+ * @return 内存文件的描述符（文件偏移为0），-1表示失败
+ */
+static int load_ram_image(const char* filename) {
+    int src = open(filename, O_RDONLY);
+    if (src == -1) {
+        return -1;
+    }
+    
+    struct stat file_stat;
+    int fd = fstat(src, &file_stat) == 0 ? create_ram_image() : -1;
+    if (fd != -1 && (copy_image_data(src, fd, (uint64_t)file_stat.st_size) != DISK_SUCCESS ||
+                     lseek(fd, 0, SEEK_SET) == -1)) {
+        close(fd);
+        fd = -1;
+    }
+    
+    close(src);
+    return fd;
+}
+
+/*==============================================================================
+ * 存储后端
+ *============================================================================*/
+
+/**
+ * 打开或新建镜像文件
+ */
+static int file_backend_init(disk_t* disk, const char* path, int create) {
+    disk->fd = create ? open(path, O_RDWR | O_CREAT | O_EXCL, 0644) : open(path, O_RDWR);
+    if (disk->fd == -1) {
+        return create ? DISK_ERROR_FILE_CREATE : DISK_ERROR_FILE_OPEN;
+    }
+    return DISK_SUCCESS;
+}
+
+/**
+ * 用preadv读取镜像文件中的一段连续块
+ */
+static int file_backend_read(disk_t* disk, uint64_t start_block, uint32_t count,
+                             char* const* blocks) {
+    return file_io_run(disk, 0, start_block, count, blocks);
+}
+
+/**
+ * 用pwritev写入镜像文件中的一段连续块
+ */
+static int file_backend_write(disk_t* disk, uint64_t start_block, uint32_t count,
+                              const char* const* blocks) {
+    return file_io_run(disk, 1, start_block, count, (char* const*)blocks);
+}
+
+/**
+ * 同步镜像文件
+ */
+static int file_backend_sync(disk_t* disk, int data_only) {
+    return data_only ? fdatasync(disk->fd) : fsync(disk->fd);
+}
+
+/**
+ * 把镜像文件中的一段块刷到稳定存储
+ * 
+ * sync_file_range()先写出这段块的脏页并等待完成，但它不提交新分配的
+ * 空间也不刷新设备缓存，所以随后还要fdatasync。fdatasync作用于整个
+ * 文件，会一并写出镜像中其他的主机脏页（只是不同步时间戳等元数据）。
+ */
+static int file_backend_sync_range(disk_t* disk, uint64_t start_block, uint64_t count) {
+    if (sync_file_range(disk->fd, (off64_t)DISK_BLOCK_OFFSET(disk, start_block),
+                        (off64_t)(count * disk->block_size),
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                        SYNC_FILE_RANGE_WAIT_AFTER) != 0) {
+        return -1;
+    }
+    return fdatasync(disk->fd);
+}
+
+/**
+ * 由主机文件系统清零或打洞（条带集上按条带单元拆到各成员）
+ */
+static int file_backend_discard(disk_t* disk, uint64_t start_block, uint64_t count, int punch) {
+    if (!disk->stripe) {
+        return deallocate_extent(disk->fd, (off_t)DISK_BLOCK_OFFSET(disk, start_block),
+                                 (off_t)count * disk->block_size, punch);
+    }
+    
+    for (uint64_t done = 0; done < count; ) {
+        int fd;
+        uint64_t offset;
+        uint32_t n;
+        stripe_set_locate(disk->stripe, start_block + done, &fd, &offset, &n);
+        if (n > count - done) {
+            n = (uint32_t)(count - done);
+        }
+        
+        int result = deallocate_extent(fd, (off_t)offset, (off_t)n * disk->block_size, punch);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        done += n;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 关闭镜像文件（条带集先停止成员工作线程）
+ */
+static void file_backend_close(disk_t* disk, int remove) {
+    close_stripe_members(disk, remove);
+    if (disk->fd != -1) {
+        close(disk->fd);
+        disk->fd = -1;
+    }
+    if (remove) {
+        unlink(disk->filename);
+    }
+}
+
+/**
+ * 打印镜像文件在主机上占用的空间
+ */
+static void file_backend_stats(disk_t* disk) {
+    struct stat st;
+    if (fstat(disk->fd, &st) == 0) {
+        printf("存储: 镜像文件 (主机占用 %.2f MB)\n",
+               (double)st.st_blocks * 512 / (1024.0 * 1024.0));
+    }
+}
+
+/**
+ * 从映射中读取一段连续块（镜像未映射时按镜像文件读取）
+ */
+static int map_backend_read(disk_t* disk, uint64_t start_block, uint32_t count,
+                            char* const* blocks) {
+    if (!disk->map_base) {
+        return file_io_run(disk, 0, start_block, count, blocks);
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        int result = map_read_block(disk, start_block + i, blocks[i]);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+    }
+    return DISK_SUCCESS;
+}
+
+/**
+ * 向映射写入一段连续块（镜像未映射时按镜像文件写入）
+ */
+static int map_backend_write(disk_t* disk, uint64_t start_block, uint32_t count,
+                             const char* const* blocks) {
+    if (!disk->map_base) {
+        return file_io_run(disk, 1, start_block, count, (char* const*)blocks);
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        map_write_block(disk, start_block + i, blocks[i]);
+    }
+    return DISK_SUCCESS;
+}
+
+/**
+ * 载入或新建内存盘镜像
+ */
+static int mem_backend_init(disk_t* disk, const char* path, int create) {
+    disk->fd = create ? create_ram_image() : load_ram_image(path);
+    if (disk->fd == -1) {
+        return create ? DISK_ERROR_FILE_CREATE : DISK_ERROR_FILE_OPEN;
+    }
+    disk->is_ram = 1;
+    disk->ram_flags = (uint8_t)g_new_ram_flags;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 内存文件没有可落盘的地方，同步只需使写入可见（映射和pwrite本来就立即可见）
+ */
+static int mem_backend_sync(disk_t* disk, int data_only) {
+    (void)disk;
+    (void)data_only;
+    return 0;
+}
+
+/**
+ * 同上，内存文件的一段块同样无需落盘
+ */
+static int mem_backend_sync_range(disk_t* disk, uint64_t start_block, uint64_t count) {
+    (void)disk;
+    (void)start_block;
+    (void)count;
+    return 0;
+}
+
+/**
+ * 关闭内存文件，镜像随之释放
+ */
+static void mem_backend_close(disk_t* disk, int remove) {
+    (void)remove;
+    if (disk->fd != -1) {
+        close(disk->fd);
+        disk->fd = -1;
+    }
+}
+
+/**
+ * 打印内存盘占用的内存
+ */
+static void mem_backend_stats(disk_t* disk) {
+    struct stat st;
+    if (fstat(disk->fd, &st) == 0) {
+        printf("存储: 内存盘 (memfd%s，占用 %.2f MB)\n",
+               (disk->ram_flags & DISK_RAM_HUGE_PAGES) ? "，透明大页" : "",
+               (double)st.st_blocks * 512 / (1024.0 * 1024.0));
+    }
+}
+
+/* file: - 镜像文件，经块缓存用preadv/pwritev读写 */
+static const disk_backend_t g_file_backend = {
+    "file", 0, file_backend_init, file_backend_read, file_backend_write,
+    file_backend_sync, file_backend_sync_range, file_backend_discard, file_backend_close,
+    file_backend_stats
+};
+
+/* mmap: - 镜像文件，经共享映射读写，同步时msync写过的页 */
+static const disk_backend_t g_mmap_backend = {
+    "mmap", 1, file_backend_init, map_backend_read, map_backend_write,
+    file_backend_sync, file_backend_sync_range, file_backend_discard, file_backend_close,
+    file_backend_stats
+};
+
+/* mem: - 内存文件，经共享映射读写，关闭后释放（disk_ram_dump()可保存） */
+static const disk_backend_t g_mem_backend = {
+    "mem", 1, mem_backend_init, map_backend_read, map_backend_write,
+    mem_backend_sync, mem_backend_sync_range, file_backend_discard, mem_backend_close,
+    mem_backend_stats
+};
+
+static const disk_backend_t* const g_backends[] = {
+    &g_file_backend, &g_mmap_backend, &g_mem_backend
+};
+
+/**
+ * 按文件名的前缀（"file:"、"mmap:"、"mem:"）选择存储后端
+ * 
+ * 没有已知前缀时按disk_set_ram_disk()和disk_set_mmap_mode()的设置选择，
+ * 文件名原样作为路径。
+ * 
+ * @param path 返回去掉前缀后的路径
+ */
+static const disk_backend_t* select_backend(const char* filename, const char** path) {
+    for (size_t i = 0; i < sizeof(g_backends) / sizeof(g_backends[0]); i++) {
+        size_t length = strlen(g_backends[i]->name);
+        if (strncmp(filename, g_backends[i]->name, length) == 0 && filename[length] == ':') {
+            *path = filename + length + 1;
+            return g_backends[i];
+        }
+    }
+    
+    *path = filename;
+    if (g_new_ram) {
+        return &g_mem_backend;
+    }
+    return g_use_mmap ? &g_mmap_backend : &g_file_backend;
+}
+
+/*==============================================================================
+ * 核心磁盘操作实现
+ *============================================================================*/
+
+/**
+ * 初始化磁盘模拟器
+ * 
+ * @param as_backing 以只读方式打开叠加层下面的冻结镜像（不建映射、时序模型和后台线程）
+ */
+static int open_disk(disk_t* disk, const char* filename, uint64_t disk_size, int as_backing) {
+    // 参数验证
+    if (!filename || disk_size == 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (disk->is_initialized) {
+        return DISK_ERROR_ALREADY_INIT;
+    }
+    
+    // 按前缀选择存储后端（冻结镜像总是按普通文件访问）
+    const char* path = filename;
+    const disk_backend_t* backend = as_backing ? &g_file_backend : select_backend(filename, &path);
+    
+    // 初始化磁盘状态
+    memset(disk, 0, sizeof(*disk));
+    strncpy(disk->filename, path, DISK_MAX_FILENAME_LEN - 1);
+    disk->filename[DISK_MAX_FILENAME_LEN - 1] = '\0';
+    disk->backend = backend;
+    disk->cache_capacity = g_cache_capacity;
+    
+    // 检查文件是否存在
+    struct stat file_stat;
+    int file_exists = (stat(path, &file_stat) == 0);
+    int read_only = as_backing;
+    
+    if (file_exists) {
+        // 打开现有镜像（内存盘载入整个文件）
+        int open_result = backend->init(disk, path, 0);
+        if (open_result != DISK_SUCCESS) {
+            return open_result;
+        }
+        
+        // 读取并验证头部
+        disk_header_t header;
+        ssize_t bytes_read = read(disk->fd, &header, sizeof(header));
+        if (bytes_read != sizeof(header)) {
+            backend->close(disk, 0);
+            return DISK_ERROR_FILE_READ;
+        }
+        
+        int validation_result = validate_disk_header(&header);
+        if (validation_result != DISK_SUCCESS) {
+            backend->close(disk, 0);
+            return validation_result;
+        }
+        
+        // 从头部更新状态（头部的disk_size只有32位，大小按块数计算）
+        disk->total_blocks = header_total_blocks(&header);
+        disk->block_size = header.block_size;
+        disk->data_offset = header_data_offset(&header);
+        disk->disk_size = disk->total_blocks * disk->block_size;
+        int has_checksums = header.version >= 3 && (header.flags & DISK_FLAG_BLOCK_CHECKSUMS);
+        int striped = header.version >= 3 && (header.flags & DISK_FLAG_STRIPED);
+        int compressed = header.version >= 3 && (header.flags & DISK_FLAG_COMPRESSED);
+        int overlay = header.version >= 3 && (header.flags & DISK_FLAG_OVERLAY);
+        int dedup = header.version >= 3 && (header.flags & DISK_FLAG_DEDUP);
+        
+        // 被冻结的快照镜像只读打开
+        if (header.version >= 3 && (header.flags & DISK_FLAG_SNAPSHOT)) {
+            read_only = 1;
+        }
+        
+        // 条带集由成员0打开，成员文件中只存放本成员的块
+        disk->member_count = 1;
+        disk->member_blocks = disk->total_blocks;
+        if (striped && backend == &g_mem_backend) {
+            backend->close(disk, 0);
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        if (striped) {
+            if (header.stripe_index != 0 || header.stripe_count < 2 ||
+                header.stripe_count > STRIPE_SET_MAX_MEMBERS || header.stripe_blocks == 0) {
+                backend->close(disk, 0);
+                return DISK_ERROR_CORRUPTED;
+            }
+            disk->member_count = header.stripe_count;
+            disk->member_blocks = stripe_set_member_blocks(
+                header.stripe_count, header.stripe_blocks, disk->total_blocks);
+        }
+        
+        // 校验和表、压缩索引、去重映射表和叠加层映射表按32位块号存放
+        if ((has_checksums || compressed || overlay || dedup) &&
+            disk->total_blocks > DISK_MAX_TABLE_BLOCKS) {
+            backend->close(disk, 0);
+            return DISK_ERROR_CORRUPTED;
+        }
+        
+        // 验证文件大小（包括数据区之后的校验和表）
+        uint64_t expected_size = DISK_FILE_SIZE(disk, disk->member_blocks);
+        if (has_checksums) {
+            expected_size += (uint64_t)checksum_table_blocks(disk->total_blocks,
+                                                             header.block_size) * header.block_size;
+        }
+        if (!compressed && !overlay && !dedup && (uint64_t)file_stat.st_size < expected_size) {
+            backend->close(disk, 0);
+            return DISK_ERROR_CORRUPTED;
+        }
+        
+        // 压缩镜像的大小随数据变化，由压缩块存储检查索引
+        if (compressed) {
+            int result = (striped || has_checksums || header.chunk_blocks == 0)
+                ? DISK_ERROR_CORRUPTED : open_chunk_store(disk, header.chunk_blocks, 0);
+            if (result != DISK_SUCCESS) {
+                backend->close(disk, 0);
+                return result;
+            }
+        }
+        
+        // 去重镜像的大小随存放的槽数变化，由去重块存储检查映射表
+        if (dedup) {
+            int result = (striped || has_checksums || compressed)
+                ? DISK_ERROR_CORRUPTED : open_dedup_store(disk, 0);
+            if (result != DISK_SUCCESS) {
+                backend->close(disk, 0);
+                return result;
+            }
+        }
+        
+        // 叠加层本身是普通布局，快照后未写过的块读自下面的冻结镜像
+        if (overlay) {
+            int result = (striped || has_checksums || compressed || dedup)
+                ? DISK_ERROR_CORRUPTED : open_overlay(disk, &header);
+            if (result != DISK_SUCCESS) {
+                chunk_store_close(disk->chunks);
+                dedup_store_close(disk->dedup);
+                backend->close(disk, 0);
+                return result;
+            }
+        }
+        
+        if (striped) {
+            int result = open_stripe_members(disk, &header);
+            if (result == DISK_SUCCESS) {
+                result = start_stripe_set(disk, header.stripe_blocks);
+            }
+            if (result != DISK_SUCCESS) {
+                backend->close(disk, 0);
+                return result;
+            }
+        }
+        
+        if (has_checksums) {
+            // 上次未正常关闭时重建校验和表；打开期间头部一直带过期标志
+            int result = setup_checksums(disk, 0);
+            if (result == DISK_SUCCESS && (header.flags & DISK_FLAG_CHECKSUMS_STALE)) {
+                result = rebuild_checksums(disk);
+            } else if (result == DISK_SUCCESS && !read_only) {
+                result = update_header_flags(disk, DISK_FLAG_CHECKSUMS_STALE, 0);
+            }
+            if (result != DISK_SUCCESS) {
+                free_checksums(disk);
+                backend->close(disk, 0);
+                return result;
+            }
+        }
+        
+    } else {
+        // 叠加层下面的冻结镜像必须存在
+        if (as_backing) {
+            return DISK_ERROR_FILE_OPEN;
+        }
+        
+        // 新磁盘按当前配置的块大小划分，现有镜像的块大小以头部为准
+        if (disk_size % g_new_block_size != 0) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        
+        uint64_t total_blocks = disk_size / g_new_block_size;
+        if (total_blocks == 0) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        
+        // 校验和表、压缩索引和去重映射表按32位块号存放
+        if ((g_new_checksums || g_new_chunk_blocks > 0 || g_new_dedup) &&
+            total_blocks > DISK_MAX_TABLE_BLOCKS) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        
+        // 压缩镜像每个块组自带CRC32C，不与每块校验和、条带集组合
+        if (g_new_chunk_blocks > 0 &&
+            (g_new_checksums || g_new_stripe_members > 1 ||
+             (uint64_t)g_new_chunk_blocks * g_new_block_size > CHUNK_STORE_MAX_CHUNK_BYTES)) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        
+        // 去重镜像中的块经映射表间接存放，同样不与每块校验和、条带集和压缩组合
+        if (g_new_dedup && (g_new_checksums || g_new_stripe_members > 1 || g_new_chunk_blocks > 0)) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        
+        // 条带集的成员是各自的镜像文件，内存盘只有一个内存文件
+        if (backend == &g_mem_backend && g_new_stripe_members > 1) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        
+        // 创建新镜像（内存盘创建内存文件，不碰文件系统）
+        int result = backend->init(disk, path, 1);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        
+        // 创建并写入头部
+        disk->block_size = g_new_block_size;
+        disk->data_offset = g_new_block_size;
+        disk_header_t header;
+        result = create_disk_header(disk, &header, total_blocks);
+        if (result != DISK_SUCCESS) {
+            backend->close(disk, 1);
+            return result;
+        }
+        
+        ssize_t bytes_written = write(disk->fd, &header, sizeof(header));
+        if (bytes_written != sizeof(header)) {
+            backend->close(disk, 1);
+            return DISK_ERROR_FILE_WRITE;
+        }
+        
+        // 条带集的其余成员各自带一份头部
+        disk->member_count = g_new_stripe_members;
+        disk->member_blocks = total_blocks;
+        if (g_new_stripe_members > 1) {
+            disk->member_blocks = stripe_set_member_blocks(
+                g_new_stripe_members, g_new_stripe_blocks, total_blocks);
+            result = create_stripe_members(disk, &header);
+            if (result == DISK_SUCCESS) {
+                result = start_stripe_set(disk, g_new_stripe_blocks);
+            }
+            if (result != DISK_SUCCESS) {
+                backend->close(disk, 1);
+                return result;
+            }
+        }
+        
+        // 扩展文件到完整大小（稀疏文件，数据区读出全零）；压缩和去重镜像只有头部和空索引
+        uint64_t file_size = DISK_FILE_SIZE(disk, disk->member_blocks);
+        if (g_new_checksums) {
+            file_size += (uint64_t)checksum_table_blocks(total_blocks, g_new_block_size) *
+                         g_new_block_size;
+        }
+        disk->total_blocks = total_blocks;
+        disk->disk_size = disk_size;
+        if (g_new_chunk_blocks > 0) {
+            result = open_chunk_store(disk, g_new_chunk_blocks, 1);
+        } else if (g_new_dedup) {
+            result = open_dedup_store(disk, 1);
+        } else if (ftruncate(disk->fd, (off_t)file_size) == -1) {
+            result = DISK_ERROR_FILE_WRITE;
+        }
+        if (result != DISK_SUCCESS) {
+            backend->close(disk, 1);
+            return result;
+        }
+        
+        if (g_new_checksums) {
+            result = setup_checksums(disk, 1);
+            if (result != DISK_SUCCESS) {
+                backend->close(disk, 1);
+                return result;
+            }
+        }
+    }
+    
+    // 创建块缓存（mmap和mem后端由映射代替缓存；不能映射的镜像在mmap后端下按普通文件访问）
+    disk->is_read_only = read_only;
+    pthread_mutex_init(&disk->cache_lock, NULL);
+    pthread_mutex_lock(&disk->cache_lock);
+    int mappable = backend->mapped && !disk->stripe && !disk->chunks && !disk->dedup && !disk->remap;
+    if (!mappable && backend == &g_mmap_backend) {
+        disk->backend = &g_file_backend;
+    }
+    int setup_result = mappable ? map_disk_image(disk) : create_block_cache(disk);
+    pthread_mutex_unlock(&disk->cache_lock);
+    if (setup_result != DISK_SUCCESS) {
+        pthread_mutex_destroy(&disk->cache_lock);
+        close_overlay(disk);
+        chunk_store_close(disk->chunks);
+        dedup_store_close(disk->dedup);
+        free_checksums(disk);
+        backend->close(disk, 0);
+        return setup_result;
+    }
+    
+    // 创建设备时序模型，启动组提交刷新线程和I/O调度队列（如果已配置；冻结镜像只经叠加层访问）
+    int thread_result = DISK_SUCCESS;
+    if (g_timing_profile != TIMING_PROFILE_NONE && !as_backing) {
+        disk->timing = timing_model_create(g_timing_profile, g_timing_bandwidth,
+                                           g_timing_real_delay, disk->total_blocks,
+                                           disk->block_size);
+        if (!disk->timing) {
+            thread_result = DISK_ERROR_IO;
+        }
+    }
+    if (thread_result == DISK_SUCCESS && g_group_window_us > 0 && !as_backing) {
+        thread_result = start_group_commit(disk, g_group_window_us, g_group_max_bytes);
+    }
+    if (thread_result == DISK_SUCCESS && g_ioq_depth > 0 && !as_backing) {
+        thread_result = start_ioq(disk, g_ioq_depth, g_ioq_deadline_us);
+        if (thread_result != DISK_SUCCESS) {
+            stop_group_commit(disk);
+        }
+    }
+    if (thread_result != DISK_SUCCESS) {
+        timing_model_destroy(disk->timing);
+        disk->timing = NULL;
+        pthread_mutex_lock(&disk->cache_lock);
+        if (disk->map_base) {
+            unmap_disk_image(disk);
+        }
+        release_block_cache(disk);
+        pthread_mutex_unlock(&disk->cache_lock);
+        pthread_mutex_destroy(&disk->cache_lock);
+        close_overlay(disk);
+        chunk_store_close(disk->chunks);
+        dedup_store_close(disk->dedup);
+        free_checksums(disk);
+        backend->close(disk, 0);
+        return DISK_ERROR_IO;
+    }
+    
+    pthread_mutex_init(&disk->zeroer.lock, NULL);
+    
+    // 记录丢弃的范围（压缩、去重镜像和叠加层在各自的映射中记录清零的块；创建失败时丢弃的块照常读出零）
+    if (!read_only && !disk->chunks && !disk->dedup && !disk->remap) {
+        disk->discarded = extent_set_create(DISK_DISCARD_MAX_EXTENTS);
+    }
+    
+    // 完成初始化
+    disk->is_initialized = 1;
+    disk->is_dirty = 0;
+    disk->auto_sync = 0;
+    disk->last_sync_time = time(NULL);
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * I/O跟踪中一次调用的开始时刻
+ */
+typedef struct {
+    uint64_t    issue_ns;           // 发出时的单调时钟时间
+    double      start_time;         // 计算延迟的起点（包含虚拟设备时间）
+} trace_start_t;
+
+/**
+ * 记下调用的开始时刻
+ */
+static void trace_begin(trace_start_t* start) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    start->issue_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    start->start_time = get_current_time();
+}
+
+/**
+ * 把完成的调用写入I/O跟踪
+ * 
+ * @return 调用的结果（原样返回）
+ */
+static int trace_end(disk_t* disk, const trace_start_t* start, int op, uint64_t block,
+                     uint32_t count, int result) {
+    double elapsed_time = get_current_time() - start->start_time;
+    trace_log_record(disk->trace, op, block, count, start->issue_ns,
+                     (uint64_t)(elapsed_time * 1000000000.0), result);
+    STATS_ADD(trace_records, 1);
+    return result;
+}
+
+/**
+ * 写入一个数据块
+ */
+static int write_block(disk_t* disk, uint64_t block_num, const char* data) {
+    // 参数验证
+    if (!data) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (!disk_block_in_range(disk, block_num)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    // 先派发与本块重叠的排队写入
+    if (ioq_barrier(disk, block_num, 1) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    double start_time = get_current_time();
+    
+    if (disk->map_base) {
+        // mmap模式：由后端直接写入映射，disk_handle_sync(disk)时msync
+        int result = disk->backend->write_blocks(disk, block_num, 1, &data);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+    } else if (disk->cache && !disk->auto_sync) {
+        // 写回模式：只写入缓存，淘汰或同步时再落盘
+        pthread_mutex_lock(&disk->cache_lock);
+        disk->write_seq++;
+        int result = block_cache_insert(disk->cache, block_num, data, 1);
+        pthread_mutex_unlock(&disk->cache_lock);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+    } else {
+        // 直写模式
+        int result = raw_write_block(disk, block_num, data);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        
+        // 保持缓存副本一致
+        if (disk->cache) {
+            pthread_mutex_lock(&disk->cache_lock);
+            disk->write_seq++;
+            block_cache_insert(disk->cache, block_num, data, 0);
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+    }
+    
+    // 更新统计
+    double elapsed_time = get_current_time() - start_time;
+    update_stats_write(disk, 1, elapsed_time);
+    
+    // 自动同步或组提交（如果启用）
+    return sync_after_write(disk, 1);
+}
+
+/**
+ * 写入一个数据块（启用I/O跟踪时记录本次调用）
+ */
+int disk_handle_write_block(disk_t* disk, uint64_t block_num, const char* data) {
+    if (!disk->trace) {
+        return write_block(disk, block_num, data);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = write_block(disk, block_num, data);
+    return trace_end(disk, &start, TRACE_OP_WRITE, block_num, 1, result);
+}
+
+/**
+ * 读取一个数据块
+ */
+static int read_block(disk_t* disk, uint64_t block_num, char* buffer) {
+    // 参数验证
+    if (!buffer) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk_block_in_range(disk, block_num)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    // 先派发与本块重叠的排队写入
+    if (ioq_barrier(disk, block_num, 1) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    double start_time = get_current_time();
+    
+    if (disk->map_base) {
+        // mmap模式：由后端直接从映射复制
+        int result = disk->backend->read_blocks(disk, block_num, 1, &buffer);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        update_stats_read(disk, 1, get_current_time() - start_time);
+        return DISK_SUCCESS;
+    }
+    
+    int hit = 0;
+    uint64_t seq = 0;
+    if (disk->cache) {
+        pthread_mutex_lock(&disk->cache_lock);
+        hit = block_cache_lookup(disk->cache, block_num, buffer);
+        seq = disk->write_seq;
+        pthread_mutex_unlock(&disk->cache_lock);
+    }
+    
+    if (hit) {
+        STATS_ADD(cache_hits, 1);
+    } else {
+        // 未命中时在锁外读取，允许多个线程并行访问磁盘文件
+        int result = raw_read_block(disk, block_num, buffer);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        
+        // 放入缓存（期间若有写入发生，读到的数据可能已过期，放弃缓存；
+        // 淘汰脏块失败时同样仅放弃缓存，不影响本次读取）
+        if (disk->cache) {
+            STATS_ADD(cache_misses, 1);
+            pthread_mutex_lock(&disk->cache_lock);
+            if (seq == disk->write_seq) {
+                block_cache_fill(disk->cache, block_num, buffer);
+            }
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+    }
+    
+    // 更新统计
+    double elapsed_time = get_current_time() - start_time;
+    update_stats_read(disk, 1, elapsed_time);
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 读取一个数据块（启用I/O跟踪时记录本次调用）
+ */
+int disk_handle_read_block(disk_t* disk, uint64_t block_num, char* buffer) {
+    if (!disk->trace) {
+        return read_block(disk, block_num, buffer);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = read_block(disk, block_num, buffer);
+    return trace_end(disk, &start, TRACE_OP_READ, block_num, 1, result);
+}
+
+/*==============================================================================
+ * 扩展磁盘操作
+ *============================================================================*/
+
+/**
+ * 回收所有未回收的异步请求（丢弃完成事件）
+ * 
+ * 写入的校验和在回收时记录，关闭前必须先回收。
+ */
+static void drain_aio(disk_t* disk) {
+    disk_aio_completion_t done[DISK_AIO_DEFAULT_DEPTH];
+    while (aio_engine_outstanding(disk->aio) > 0 &&
+           disk_handle_aio_reap(disk, done, DISK_AIO_DEFAULT_DEPTH, 1) > 0) {
+    }
+}
+
+/**
+ * 关闭和清理磁盘模拟器
+ */
+static int close_disk(disk_t* disk) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    // 结束I/O跟踪（关闭时的同步不再记入跟踪）
+    if (disk->trace) {
+        trace_log_close(disk->trace);
+        disk->trace = NULL;
+    }
+    
+    // 停止I/O调度队列（派发排队的写入）
+    stop_ioq(disk);
+    
+    // 停止后台清零（未完成的块保持原样）
+    stop_zeroer(disk);
+    pthread_mutex_destroy(&disk->zeroer.lock);
+    
+    // 停止组提交（刷新已登记的写入）
+    stop_group_commit(disk);
+    
+    // 等待异步请求完成
+    if (disk->aio) {
+        drain_aio(disk);
+        aio_engine_destroy(disk->aio);
+        disk->aio = NULL;
+    }
+    
+    // 同步待写入数据；校验和表与数据一起落盘后清除过期标志，压缩镜像写回块组缓存和索引，
+    // 去重镜像和叠加层写回映射表
+    if (disk->is_dirty || disk->csums || disk->chunks || disk->dedup || disk->remap) {
+        if (disk_handle_sync(disk) == DISK_SUCCESS && disk->csums && !disk->is_read_only) {
+            update_header_flags(disk, 0, DISK_FLAG_CHECKSUMS_STALE);
+        }
+    }
+    
+    // 解除映射，释放块缓存
+    pthread_mutex_lock(&disk->cache_lock);
+    if (disk->map_base) {
+        unmap_disk_image(disk);
+    }
+    release_block_cache(disk);
+    pthread_mutex_unlock(&disk->cache_lock);
+    pthread_mutex_destroy(&disk->cache_lock);
+    free_checksums(disk);
+    chunk_store_close(disk->chunks);
+    dedup_store_close(disk->dedup);
+    close_overlay(disk);
+    timing_model_destroy(disk->timing);
+    extent_set_destroy(disk->discarded);
+    
+    // 关闭镜像存储
+    disk->backend->close(disk, 0);
+    
+    // 重置状态
+    memset(disk, 0, sizeof(*disk));
+    disk->fd = -1;
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 同步磁盘写入（data_only为1时镜像文件只同步数据，不同步时间戳等元数据）
+ */
+static int sync_disk(disk_t* disk, int data_only) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->fd == -1) {
+        return DISK_ERROR_IO;
+    }
+    
+    // 先派发排队的写入
+    int queued = ioq_drain(disk);
+    if (queued != DISK_SUCCESS) {
+        return queued;
+    }
+    
+    double start_time = get_current_time();
+    
+    if (disk->map_base) {
+        // mmap模式：只同步写过的页
+        if (map_sync_dirty(disk) != DISK_SUCCESS) {
+            return DISK_ERROR_IO;
+        }
+    } else if (disk->cache) {
+        // 回写缓存中的脏块
+        pthread_mutex_lock(&disk->cache_lock);
+        int result = block_cache_flush(disk->cache);
+        pthread_mutex_unlock(&disk->cache_lock);
+        if (result != 0) {
+            return DISK_ERROR_IO;
+        }
+    }
+    
+    // 回写校验和表后强制同步（mmap模式下只有校验和表需要fsync）
+    if (csum_flush(disk) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    if ((!disk->map_base || disk->csums) && sync_image(disk, data_only) != 0) {
+        return DISK_ERROR_IO;
+    }
+    
+    disk->is_dirty = 0;
+    disk->last_sync_time = time(NULL);
+    latency_hist_record_seconds(&disk->stats.sync_latency, get_current_time() - start_time);
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 同步磁盘（启用I/O跟踪时记录本次调用）
+ */
+int disk_handle_sync(disk_t* disk) {
+    if (!disk->trace) {
+        return sync_disk(disk, 0);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = sync_disk(disk, 0);
+    return trace_end(disk, &start, TRACE_OP_SYNC, 0, 0, result);
+}
+
+/**
+ * 只同步数据（跟踪中与disk_sync()记为同一种操作）
+ */
+int disk_handle_sync_data(disk_t* disk) {
+    if (!disk->trace) {
+        return sync_disk(disk, 1);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = sync_disk(disk, 1);
+    return trace_end(disk, &start, TRACE_OP_SYNC, 0, 0, result);
+}
+
+/**
+ * 同步一段块
+ * 
+ * 排队的写入照常先派发；之后只回写缓存中这段块的脏块（mmap模式下只
+ * msync这段块中写过的页），其余的脏块留在缓存中，镜像文件只刷新这段
+ * 块。磁盘因此仍可能有未同步的写入，is_dirty保持不变。
+ */
+static int sync_block_range(disk_t* disk, uint64_t start_block, uint64_t count) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    if (count == 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    if (start_block >= disk->total_blocks || count > disk->total_blocks - start_block) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    if (disk->fd == -1) {
+        return DISK_ERROR_IO;
+    }
+    
+    int queued = ioq_drain(disk);
+    if (queued != DISK_SUCCESS) {
+        return queued;
+    }
+    
+    double start_time = get_current_time();
+    
+    if (disk->map_base) {
+        if (map_sync_range(disk, start_block, start_block + count) != DISK_SUCCESS) {
+            return DISK_ERROR_IO;
+        }
+    } else if (disk->cache) {
+        pthread_mutex_lock(&disk->cache_lock);
+        int result = block_cache_flush_range(disk->cache, start_block, count);
+        pthread_mutex_unlock(&disk->cache_lock);
+        if (result != 0) {
+            return DISK_ERROR_IO;
+        }
+    }
+    
+    if (csum_flush(disk) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    if ((!disk->map_base || disk->csums) && sync_image_range(disk, start_block, count) != 0) {
+        return DISK_ERROR_IO;
+    }
+    
+    STATS_ADD(range_syncs, 1);
+    latency_hist_record_seconds(&disk->stats.sync_latency, get_current_time() - start_time);
+    return DISK_SUCCESS;
+}
+
+/**
+ * 同步一段块（启用I/O跟踪时记为带范围的同步）
+ */
+int disk_handle_sync_range(disk_t* disk, uint64_t start_block, uint64_t block_count) {
+    if (!disk->trace) {
+        return sync_block_range(disk, start_block, block_count);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = sync_block_range(disk, start_block, block_count);
+    return trace_end(disk, &start, TRACE_OP_SYNC, start_block,
+                     block_count > UINT32_MAX ? UINT32_MAX : (uint32_t)block_count, result);
+}
+
+/**
+ * 获取磁盘信息
+ */
+int disk_handle_get_info(disk_t* disk, uint64_t* total_blocks, uint32_t* block_size,
+                         uint64_t* disk_size) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (total_blocks) {
+        *total_blocks = disk->total_blocks;
+    }
+    
+    if (block_size) {
+        *block_size = disk->block_size;
+    }
+    
+    if (disk_size) {
+        *disk_size = disk->disk_size;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 设置新建磁盘的块大小
+ */
+int disk_set_block_size(uint32_t block_size) {
+    if (!DISK_IS_VALID_BLOCK_SIZE(block_size)) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    g_new_block_size = block_size;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 设置新建磁盘是否带每块校验和
+ */
+int disk_set_checksums(int enabled) {
+    g_new_checksums = enabled ? 1 : 0;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 检查当前磁盘是否带每块校验和
+ */
+int disk_handle_has_checksums(disk_t* disk) {
+    return disk->csums != NULL;
+}
+
+/**
+ * 设置新建磁盘的条带布局
+ */
+int disk_set_striping(uint32_t members, uint32_t stripe_blocks) {
+    if (members == 0 || members > STRIPE_SET_MAX_MEMBERS || (members > 1 && stripe_blocks == 0)) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    g_new_stripe_members = members;
+    g_new_stripe_blocks = (members > 1) ? stripe_blocks : 0;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 获取当前磁盘的条带布局
+ */
+int disk_handle_get_striping(disk_t* disk, uint32_t* members, uint32_t* stripe_blocks) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (members) {
+        *members = disk->stripe ? stripe_set_count(disk->stripe) : 1;
+    }
+    if (stripe_blocks) {
+        *stripe_blocks = disk->stripe ? stripe_set_stripe_blocks(disk->stripe) : 0;
+    }
+    return DISK_SUCCESS;
+}
+
+/**
+ * 设置新建磁盘的压缩块组大小
+ */
+int disk_set_compression(uint32_t chunk_blocks) {
+    if ((uint64_t)chunk_blocks * DISK_MIN_BLOCK_SIZE > CHUNK_STORE_MAX_CHUNK_BYTES) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    g_new_chunk_blocks = chunk_blocks;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 获取当前磁盘的压缩块组大小
+ */
+uint32_t disk_handle_get_compression(disk_t* disk) {
+    return disk->chunks ? chunk_store_chunk_blocks(disk->chunks) : 0;
+}
+
+/**
+ * 设置新建磁盘是否按内容去重
+ */
+int disk_set_dedup(int enabled) {
+    g_new_dedup = enabled ? 1 : 0;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 检查当前磁盘是否按内容去重
+ */
+int disk_handle_has_dedup(disk_t* disk) {
+    return disk->dedup != NULL;
+}
+
+/**
+ * 设置之后打开的磁盘是否为内存盘
+ */
+int disk_set_ram_disk(int enabled, int flags) {
+    if (flags & ~DISK_RAM_HUGE_PAGES) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    g_new_ram = enabled ? 1 : 0;
+    g_new_ram_flags = flags;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 检查当前磁盘是否为内存盘
+ */
+int disk_handle_is_ram_disk(disk_t* disk) {
+    return disk->is_ram;
+}
+
+/**
+ * 获取当前磁盘的存储后端名
+ */
+const char* disk_handle_backend_name(disk_t* disk) {
+    return disk->is_initialized ? disk->backend->name : "none";
+}
+
+/**
+ * 获取块大小
+ */
+uint32_t disk_handle_get_block_size(disk_t* disk) {
+    return disk->is_initialized ? disk->block_size : g_new_block_size;
+}
+
+/**
+ * 获取磁盘统计
+ */
+int disk_handle_get_stats(disk_t* disk, disk_stats_t* stats) {
+    if (!stats) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    *stats = disk->stats;
+    
+    // 当前缓存中的预读计数尚未并入统计
+    pthread_mutex_lock(&disk->cache_lock);
+    if (disk->cache) {
+        stats->readahead_hits += disk->cache->prefetch_hits;
+        stats->readahead_wasted += disk->cache->prefetch_wasted;
+    }
+    pthread_mutex_unlock(&disk->cache_lock);
+    
+    // 直方图可能正在被并发更新，取一致的快照
+    latency_hist_snapshot(&stats->read_latency, &disk->stats.read_latency);
+    latency_hist_snapshot(&stats->write_latency, &disk->stats.write_latency);
+    latency_hist_snapshot(&stats->sync_latency, &disk->stats.sync_latency);
+    latency_hist_snapshot(&stats->device_latency, &disk->stats.device_latency);
+    if (disk->chunks) {
+        chunk_store_get_stats(disk->chunks, &stats->compression);
+    }
+    if (disk->dedup) {
+        dedup_store_get_stats(disk->dedup, &stats->dedup);
+    }
+    return DISK_SUCCESS;
+}
+
+/**
+ * 重置磁盘统计
+ */
+int disk_handle_reset_stats(disk_t* disk) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    memset(&disk->stats, 0, sizeof(disk->stats));
+    if (disk->chunks) {
+        chunk_store_reset_stats(disk->chunks);
+    }
+    if (disk->dedup) {
+        dedup_store_reset_stats(disk->dedup);
+    }
+    
+    pthread_mutex_lock(&disk->cache_lock);
+    if (disk->cache) {
+        disk->cache->prefetch_hits = 0;
+        disk->cache->prefetch_wasted = 0;
+    }
+    pthread_mutex_unlock(&disk->cache_lock);
+    return DISK_SUCCESS;
+}
+
+/**
+ * 配置组提交
+ */
+int disk_handle_set_group_commit(disk_t* disk, uint32_t window_us, uint64_t max_dirty_bytes) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    stop_group_commit(disk);
+    if (window_us == 0) {
+        return DISK_SUCCESS;
+    }
+    return start_group_commit(disk, window_us,
+                              max_dirty_bytes ? max_dirty_bytes : DISK_GROUP_COMMIT_BYTES);
+}
+
+/**
+ * 配置设备时序模型
+ */
+int disk_handle_set_timing_model(disk_t* disk, timing_profile_t profile, uint64_t bandwidth_limit,
+                                 int real_delay) {
+    timing_params_t params;
+    if (profile != TIMING_PROFILE_NONE && timing_profile_params(profile, &params) != 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    // 新模型的磁头从块0开始
+    timing_model_destroy(disk->timing);
+    disk->timing = NULL;
+    if (profile != TIMING_PROFILE_NONE) {
+        disk->timing = timing_model_create(profile, bandwidth_limit, real_delay,
+                                           disk->total_blocks, disk->block_size);
+        if (!disk->timing) {
+            return DISK_ERROR_IO;
+        }
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 配置块缓存容量
+ */
+int disk_handle_set_cache_capacity(disk_t* disk, uint32_t capacity_blocks) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    // mmap模式下不使用缓存，容量在退出mmap模式时生效
+    if (disk->map_base) {
+        disk->cache_capacity = capacity_blocks;
+        return DISK_SUCCESS;
+    }
+    
+    pthread_mutex_lock(&disk->cache_lock);
+    
+    if (disk->cache) {
+        if (block_cache_flush(disk->cache) != 0) {
+            pthread_mutex_unlock(&disk->cache_lock);
+            return DISK_ERROR_IO;
+        }
+        release_block_cache(disk);
+    }
+    
+    disk->cache_capacity = capacity_blocks;
+    int result = create_block_cache(disk);
+    
+    pthread_mutex_unlock(&disk->cache_lock);
+    return result;
+}
+
+/**
+ * 启用或禁用内存映射模式
+ */
+int disk_handle_set_mmap_mode(disk_t* disk, int enabled) {
+    enabled = enabled ? 1 : 0;
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (enabled == (disk->map_base != NULL)) {
+        return DISK_SUCCESS;
+    }
+    
+    pthread_mutex_lock(&disk->cache_lock);
+    
+    int result;
+    if (enabled) {
+        // 回写并释放块缓存，由映射接管
+        if (disk->cache) {
+            if (block_cache_flush(disk->cache) != 0) {
+                pthread_mutex_unlock(&disk->cache_lock);
+                return DISK_ERROR_IO;
+            }
+            release_block_cache(disk);
+        }
+        
+        result = map_disk_image(disk);
+        if (result != DISK_SUCCESS) {
+            create_block_cache(disk);
+        }
+    } else {
+        result = unmap_disk_image(disk);
+        int cache_result = create_block_cache(disk);
+        if (result == DISK_SUCCESS) {
+            result = cache_result;
+        }
+    }
+    
+    pthread_mutex_unlock(&disk->cache_lock);
+    
+    // 镜像文件在file和mmap后端之间切换；内存盘仍是mem后端，只改变访问方式
+    if (result == DISK_SUCCESS) {
+        if (disk->backend != &g_mem_backend) {
+            disk->backend = enabled ? &g_mmap_backend : &g_file_backend;
+        }
+    }
+    return result;
+}
+
+/**
+ * 检查磁盘是否以内存映射方式访问
+ */
+int disk_handle_is_mapped(disk_t* disk) {
+    return disk->map_base != NULL;
+}
+
+/*==============================================================================
+ * 工具函数
+ *============================================================================*/
+
+/**
+ * 错误码转字符串
+ */
+const char* disk_error_to_string(disk_error_t error) {
+    switch (error) {
+        case DISK_SUCCESS:              return "操作成功";
+        case DISK_ERROR_INVALID_PARAM:  return "无效参数";
+        case DISK_ERROR_FILE_OPEN:      return "文件打开失败";
+        case DISK_ERROR_FILE_CREATE:    return "文件创建失败";
+        case DISK_ERROR_FILE_READ:      return "文件读取失败";
+        case DISK_ERROR_FILE_WRITE:     return "文件写入失败";
+        case DISK_ERROR_FILE_SEEK:      return "文件定位失败";
+        case DISK_ERROR_BLOCK_RANGE:    return "块号超出范围";
+        case DISK_ERROR_NOT_INIT:       return "磁盘未初始化";
+        case DISK_ERROR_ALREADY_INIT:   return "磁盘已初始化";
+        case DISK_ERROR_DISK_FULL:      return "磁盘已满";
+        case DISK_ERROR_IO:             return "I/O错误";
+        case DISK_ERROR_CORRUPTED:      return "磁盘数据损坏";
+        case DISK_ERROR_BUSY:           return "异步队列已满";
+        case DISK_ERROR_CHECKSUM:       return "块校验和不匹配";
+        default:                        return "未知错误";
+    }
+}
+
+/**
+ * 检查磁盘是否已初始化
+ */
+int disk_handle_is_initialized(disk_t* disk) {
+    return disk->is_initialized;
+}
+
+/**
+ * 获取当前磁盘块数
+ */
+uint64_t disk_handle_get_block_count(disk_t* disk) {
+    return disk->is_initialized ? disk->total_blocks : 0;
+}
+
+/**
+ * 验证块号
+ */
+int disk_handle_is_valid_block(disk_t* disk, uint64_t block_num) {
+    return disk_block_in_range(disk, block_num);
+}
+
+/**
+ * 使用模式格式化磁盘
+ */
+int disk_handle_format(disk_t* disk, uint8_t pattern) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    // 整盘格式化覆盖排队的写入和后台清零任务
+    int queued = ioq_drain(disk);
+    if (queued != DISK_SUCCESS) {
+        return queued;
+    }
+    stop_zeroer(disk);
+    
+    uint64_t total = disk->total_blocks;
+    int result;
+    if (pattern == 0) {
+        // 全零：整盘打洞代替逐块写入，之后的全零写入都可跳过
+        result = clear_block_range(disk, 0, total, 1);
+        if (result == DISK_SUCCESS) {
+            STATS_ADD(blocks_zeroed, total);
+        }
+    } else {
+        // 丢弃缓存中的旧副本后整段写入模式
+        if (disk->cache) {
+            pthread_mutex_lock(&disk->cache_lock);
+            block_cache_invalidate_range(disk->cache, 0, total);
+            disk->write_seq++;
+        }
+        
+        double start_time = get_current_time();
+        result = fill_block_range(disk, 0, total, pattern);
+        
+        if (disk->cache) {
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+        if (result == DISK_SUCCESS) {
+            update_stats_write(disk, total, get_current_time() - start_time);
+        }
+    }
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    // 强制同步
+    return disk_handle_sync(disk);
+}
+
+/**
+ * 打印磁盘状态
+ */
+void disk_handle_print_status(disk_t* disk) {
+    printf("\n=== 磁盘模拟器状态 ===\n");
+    
+    if (!disk->is_initialized) {
+        printf("状态: 未初始化\n");
+        printf("====================\n\n");
+        return;
+    }
+    
+    printf("文件名: %s\n", disk->filename[0] ? disk->filename : "(无)");
+    printf("状态: %s\n", disk->is_initialized ? "已初始化" : "未初始化");
+    printf("模式: %s\n", disk->is_read_only ? "只读" : "读写");
+    printf("后端: %s\n", disk->backend->name);
+    printf("访问方式: %s\n", disk->map_base ? "内存映射 (mmap)" : "pread/pwrite");
+    disk->backend->stats(disk);
+    printf("块大小: %u 字节\n", disk->block_size);
+    printf("总块数: %lu\n", disk->total_blocks);
+    printf("磁盘大小: %lu 字节 (%.2f MB)\n", 
+           disk->disk_size, disk->disk_size / (1024.0 * 1024.0));
+    printf("脏标志: %s\n", disk->is_dirty ? "是" : "否");
+    printf("自动同步: %s\n", disk->auto_sync ? "启用" : "禁用");
+    if (disk->csums) {
+        printf("块校验和: 启用 (CRC32C, %s)\n", crc32c_implementation());
+    } else {
+        printf("块校验和: 禁用\n");
+    }
+    if (disk->stripe) {
+        printf("条带集: %u 个成员, 条带单元 %u 块\n", stripe_set_count(disk->stripe),
+               stripe_set_stripe_blocks(disk->stripe));
+    }
+    if (disk->backing) {
+        printf("快照叠加层: 基于 %s, 已分配 %u 个槽\n", disk->backing->filename,
+               __atomic_load_n(&disk->overlay_slots, __ATOMIC_RELAXED));
+    }
+    
+    // 计数器和直方图可能正在被并发更新，打印一致的快照
+    disk_stats_t stats;
+    disk_handle_get_stats(disk, &stats);
+    
+    printf("\n--- 统计信息 ---\n");
+    printf("总读取次数: %lu\n", stats.total_reads);
+    printf("总写入次数: %lu\n", stats.total_writes);
+    printf("读取字节数: %lu\n", stats.bytes_read);
+    printf("写入字节数: %lu\n", stats.bytes_written);
+    printf("读取错误: %lu\n", stats.read_errors);
+    printf("写入错误: %lu\n", stats.write_errors);
+    printf("校验失败: %lu\n", stats.checksum_errors);
+    
+    printf("\n--- 延迟分布 ---\n");
+    latency_hist_print(&stats.read_latency, "读取");
+    latency_hist_print(&stats.write_latency, "写入");
+    latency_hist_print(&stats.sync_latency, "同步");
+    
+    if (disk->timing) {
+        printf("\n--- 设备模型 ---\n");
+        printf("设备类型: %s (%s)\n", timing_profile_name(timing_model_profile(disk->timing)),
+               timing_model_real_delay(disk->timing) ? "实际延迟" : "虚拟时间");
+        printf("设备I/O: %lu 次 (寻道: %lu), 设备时间: %.3f 秒\n", stats.device_ios,
+               stats.device_seeks, stats.device_time_ns / 1000000000.0);
+        latency_hist_print(&stats.device_latency, "设备");
+    }
+    
+    if (disk->chunks) {
+        const chunk_store_stats_t* cs = &stats.compression;
+        uint32_t chunk_blocks = chunk_store_chunk_blocks(disk->chunks);
+        uint64_t chunks = ((uint64_t)disk->total_blocks + chunk_blocks - 1) / chunk_blocks;
+        printf("\n--- 压缩 ---\n");
+        printf("块组: 每组 %u 块, 共 %lu 个 (有数据: %lu, 占用 %lu 字节)\n",
+               chunk_blocks, chunks, cs->stored_chunks, cs->stored_bytes);
+        printf("压缩比分布:");
+        for (int i = 0; i < CHUNK_STORE_RATIO_BUCKETS; i++) {
+            printf(" %dx%s %lu", 1 << i, i == CHUNK_STORE_RATIO_BUCKETS - 1 ? "+:" : "~:",
+                   cs->ratio_chunks[i]);
+        }
+        printf("\n写入块组: %lu (%lu -> %lu 字节), 读取块组: %lu (空块组: %lu)\n",
+               cs->chunks_written, cs->bytes_in, cs->bytes_out, cs->chunks_read,
+               cs->zero_chunks_read);
+        latency_hist_print(&cs->compress_latency, "压缩CPU");
+        latency_hist_print(&cs->decompress_latency, "解压CPU");
+    }
+    
+    if (disk->dedup) {
+        const dedup_store_stats_t* ds = &stats.dedup;
+        printf("\n--- 去重 ---\n");
+        printf("引用块数: %lu, 存放槽数: %lu, 去重比: %.2f\n", ds->referenced_blocks,
+               ds->stored_slots,
+               ds->stored_slots ? (double)ds->referenced_blocks / ds->stored_slots : 1.0);
+        printf("写入块: %lu (新块: %lu, 重复: %lu, 全零: %lu)\n", ds->blocks_written,
+               ds->unique_blocks, ds->duplicate_blocks, ds->zero_blocks);
+        printf("指纹查找: %lu 次 (平均探测 %.2f, 验证读取: %lu, 哈希碰撞: %lu)\n", ds->lookups,
+               ds->lookups ? (double)ds->lookup_probes / ds->lookups : 0.0, ds->verify_reads,
+               ds->hash_collisions);
+        latency_hist_print(&ds->lookup_latency, "指纹查找");
+    }
+    
+    if (disk->cache) {
+        uint64_t lookups = stats.cache_hits + stats.cache_misses;
+        printf("\n--- 块缓存 ---\n");
+        printf("缓存容量: %u 块 (已用: %u, 脏块: %u)\n", disk->cache->capacity,
+               disk->cache->count, disk->cache->dirty_count);
+        printf("缓存命中: %lu\n", stats.cache_hits);
+        printf("缓存未命中: %lu\n", stats.cache_misses);
+        printf("命中率: %.1f%%\n", lookups ? 100.0 * stats.cache_hits / lookups : 0.0);
+        printf("回写块数: %lu\n", stats.cache_writebacks);
+        if (stats.readahead_blocks > 0) {
+            printf("预读块数: %lu (命中: %lu, 浪费: %lu)\n", stats.readahead_blocks,
+                   stats.readahead_hits, stats.readahead_wasted);
+        }
+    }
+    printf("向量化I/O次数: %lu\n", stats.vectored_ios);
+    if (stats.ioq_queued > 0) {
+        printf("调度队列: 排队写入 %lu (覆盖 %lu), 派发 %lu 批, 合并为 %lu 次I/O\n",
+               stats.ioq_queued, stats.ioq_absorbed, stats.ioq_dispatches, stats.ioq_runs);
+    }
+    printf("零拷贝访问次数: %lu\n", stats.zero_copy_gets);
+    printf("清零块数: %lu\n", stats.blocks_zeroed);
+    if (stats.zero_writes_skipped + stats.zero_writes_punched > 0) {
+        printf("全零写入: 跳过 %lu 块, 打洞 %lu 块 (避免写入: %lu 字节)\n",
+               stats.zero_writes_skipped, stats.zero_writes_punched, stats.bytes_write_avoided);
+    }
+    if (stats.discard_requests > 0) {
+        printf("丢弃: %lu 次, %lu 块 (直接填零的读取: %lu 块)\n", stats.discard_requests,
+               stats.blocks_discarded, stats.discard_zero_reads);
+    }
+    if (disk->stripe) {
+        printf("条带并行I/O次数: %lu\n", stats.striped_ios);
+    }
+    if (stats.snapshots_reflinked + stats.snapshots_overlaid > 0 || disk->backing) {
+        printf("快照: 克隆 %lu 次, 叠加层 %lu 次 (重定向写入: %lu, 读自快照: %lu)\n",
+               stats.snapshots_reflinked, stats.snapshots_overlaid,
+               stats.overlay_redirects, stats.backing_reads);
+    }
+    
+    if (disk->aio) {
+        printf("\n--- 异步I/O ---\n");
+        printf("后端: %s\n", aio_engine_backend_name(disk->aio));
+        printf("已提交: %lu\n", stats.aio_submitted);
+        printf("已完成: %lu\n", stats.aio_completed);
+        printf("进行中: %u\n", aio_engine_outstanding(disk->aio));
+    }
+    
+    if (disk->group_commit.running) {
+        uint64_t commits = stats.group_commits;
+        printf("\n--- 组提交 ---\n");
+        printf("时间窗口: %u 微秒, 提前刷新阈值: %lu 字节\n",
+               disk->group_commit.window_us, disk->group_commit.max_bytes);
+        printf("刷新次数: %lu\n", commits);
+        printf("持久化写入: %lu (平均每批 %.1f)\n", stats.group_commit_writes,
+               commits ? (double)stats.group_commit_writes / commits : 0.0);
+    }
+    
+    if (stats.last_operation_time > 0) {
+        printf("最后操作时间: %s", ctime(&stats.last_operation_time));
+    }
+    
+    printf("最后同步时间: %s", ctime(&disk->last_sync_time));
+    if (stats.range_syncs > 0) {
+        printf("范围同步次数: %lu\n", stats.range_syncs);
+    }
+    printf("====================\n\n");
+}
+
+/*==============================================================================
+ * 块I/O便利函数
+ *============================================================================*/
+
+/**
+ * 批量I/O条目（按块号排序后处理）
+ */
+typedef struct {
+    uint64_t    block_num;          // 块号
+    uint32_t    order;              // 调用方数组中的原始位置
+    char        *buffer;            // 块数据
+    uint8_t     cached;             // 读取时已由缓存命中
+} sg_entry_t;
+
+/**
+ * 按块号（相同块按原始位置）排序比较函数
+ */
+static int compare_sg_entries(const void* a, const void* b) {
+    const sg_entry_t* ea = (const sg_entry_t*)a;
+    const sg_entry_t* eb = (const sg_entry_t*)b;
+    if (ea->block_num != eb->block_num) {
+        return (ea->block_num < eb->block_num) ? -1 : 1;
+    }
+    return (ea->order < eb->order) ? -1 : (ea->order > eb->order);
+}
+
+/**
+ * 读取已按块号排序的一组块
+ * 
+ * 先在缓存中查找，未命中的块按连续段合并为一次preadv。
+ */
+static int read_sorted_blocks(disk_t* disk, sg_entry_t* entries, uint32_t count) {
+    double start_time = get_current_time();
+    
+    if (disk->map_base) {
+        for (uint32_t i = 0; i < count; i++) {
+            int result = disk->backend->read_blocks(disk, entries[i].block_num, 1, &entries[i].buffer);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+        }
+        update_stats_read(disk, count, get_current_time() - start_time);
+        return DISK_SUCCESS;
+    }
+    
+    uint64_t seq = 0;
+    uint32_t hits = 0;
+    if (disk->cache) {
+        pthread_mutex_lock(&disk->cache_lock);
+        for (uint32_t i = 0; i < count; i++) {
+            entries[i].cached = (uint8_t)block_cache_lookup(disk->cache,
+                                                            entries[i].block_num,
+                                                            entries[i].buffer);
+            hits += entries[i].cached;
+        }
+        seq = disk->write_seq;
+        pthread_mutex_unlock(&disk->cache_lock);
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            entries[i].cached = 0;
+        }
+    }
+    
+    // 未命中的连续块合并读取
+    char* run[DISK_MAX_IOV_BLOCKS];
+    for (uint32_t i = 0; i < count; ) {
+        if (entries[i].cached) {
+            i++;
+            continue;
+        }
+        
+        uint32_t len = 1;
+        run[0] = entries[i].buffer;
+        while (i + len < count && len < DISK_MAX_IOV_BLOCKS &&
+               !entries[i + len].cached &&
+               entries[i + len].block_num == entries[i].block_num + len) {
+            run[len] = entries[i + len].buffer;
+            len++;
+        }
+        
+        int result = raw_read_run(disk, entries[i].block_num, len, run);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        i += len;
+    }
+    
+    if (disk->cache) {
+        STATS_ADD(cache_hits, hits);
+        STATS_ADD(cache_misses, count - hits);
+        if (hits < count) {
+            pthread_mutex_lock(&disk->cache_lock);
+            if (seq == disk->write_seq) {
+                for (uint32_t i = 0; i < count; i++) {
+                    if (!entries[i].cached) {
+                        block_cache_fill(disk->cache, entries[i].block_num,
+                                         entries[i].buffer);
+                    }
+                }
+            }
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+    }
+    
+    double elapsed_time = get_current_time() - start_time;
+    update_stats_read(disk, count, elapsed_time);
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 写入已按块号排序且无重复的一组块
+ * 
+ * 写回模式下只进入缓存；直写模式下连续块合并为一次pwritev。
+ */
+static int write_sorted_blocks(disk_t* disk, const sg_entry_t* entries, uint32_t count) {
+    double start_time = get_current_time();
+    
+    if (disk->map_base) {
+        for (uint32_t i = 0; i < count; i++) {
+            int result = disk->backend->write_blocks(disk, entries[i].block_num, 1,
+                                                     (const char* const*)&entries[i].buffer);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+        }
+    } else if (disk->cache && !disk->auto_sync) {
+        pthread_mutex_lock(&disk->cache_lock);
+        disk->write_seq++;
+        for (uint32_t i = 0; i < count; i++) {
+            int result = block_cache_insert(disk->cache, entries[i].block_num,
+                                            entries[i].buffer, 1);
+            if (result != DISK_SUCCESS) {
+                pthread_mutex_unlock(&disk->cache_lock);
+                return result;
+            }
+        }
+        pthread_mutex_unlock(&disk->cache_lock);
+    } else {
+        const char* run[DISK_MAX_IOV_BLOCKS];
+        for (uint32_t i = 0; i < count; ) {
+            uint32_t len = 1;
+            run[0] = entries[i].buffer;
+            while (i + len < count && len < DISK_MAX_IOV_BLOCKS &&
+                   entries[i + len].block_num == entries[i].block_num + len) {
+                run[len] = entries[i + len].buffer;
+                len++;
+            }
+            
+            int result = raw_write_run(disk, entries[i].block_num, len, run);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+            i += len;
+        }
+        
+        // 保持缓存副本一致
+        if (disk->cache) {
+            pthread_mutex_lock(&disk->cache_lock);
+            disk->write_seq++;
+            for (uint32_t i = 0; i < count; i++) {
+                block_cache_insert(disk->cache, entries[i].block_num,
+                                   entries[i].buffer, 0);
+            }
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+    }
+    
+    double elapsed_time = get_current_time() - start_time;
+    update_stats_write(disk, count, elapsed_time);
+    
+    return sync_after_write(disk, count);
+}
+
+/**
+ * 检查连续块范围参数
+ */
+static int check_block_range(disk_t* disk, uint64_t start_block, int block_count) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk_block_in_range(disk, start_block) ||
+        start_block + (uint64_t)block_count > disk->total_blocks) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 写入多个连续块
+ */
+static int write_blocks(disk_t* disk, uint64_t start_block, int block_count, const char* data) {
+    if (!data || block_count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    int result = check_block_range(disk, start_block, block_count);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (ioq_barrier(disk, start_block, (uint64_t)block_count) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    sg_entry_t entries[DISK_MAX_IOV_BLOCKS];
+    for (int done = 0; done < block_count; ) {
+        uint32_t n = (uint32_t)(block_count - done);
+        if (n > DISK_MAX_IOV_BLOCKS) {
+            n = DISK_MAX_IOV_BLOCKS;
+        }
+        
+        for (uint32_t i = 0; i < n; i++) {
+            entries[i].block_num = start_block + done + i;
+            entries[i].order = i;
+            entries[i].buffer = (char*)data + (size_t)(done + i) * disk->block_size;
+        }
+        
+        result = write_sorted_blocks(disk, entries, n);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        done += n;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 写入多个连续块（启用I/O跟踪时记录本次调用）
+ */
+int disk_handle_write_blocks(disk_t* disk, uint64_t start_block, int block_count, const char* data) {
+    if (!disk->trace) {
+        return write_blocks(disk, start_block, block_count, data);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = write_blocks(disk, start_block, block_count, data);
+    return trace_end(disk, &start, TRACE_OP_WRITE, start_block, (uint32_t)block_count,
+                     result);
+}
+
+/**
+ * 读取多个连续块
+ */
+static int read_blocks(disk_t* disk, uint64_t start_block, int block_count, char* buffer) {
+    if (!buffer || block_count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    int result = check_block_range(disk, start_block, block_count);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (ioq_barrier(disk, start_block, (uint64_t)block_count) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    sg_entry_t entries[DISK_MAX_IOV_BLOCKS];
+    for (int done = 0; done < block_count; ) {
+        uint32_t n = (uint32_t)(block_count - done);
+        if (n > DISK_MAX_IOV_BLOCKS) {
+            n = DISK_MAX_IOV_BLOCKS;
+        }
+        
+        for (uint32_t i = 0; i < n; i++) {
+            entries[i].block_num = start_block + done + i;
+            entries[i].order = i;
+            entries[i].buffer = buffer + (size_t)(done + i) * disk->block_size;
+        }
+        
+        result = read_sorted_blocks(disk, entries, n);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        done += n;
+    }
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 读取多个连续块（启用I/O跟踪时记录本次调用）
+ */
+int disk_handle_read_blocks(disk_t* disk, uint64_t start_block, int block_count, char* buffer) {
+    if (!disk->trace) {
+        return read_blocks(disk, start_block, block_count, buffer);
+    }
+    
+    trace_start_t start;
+    trace_begin(&start);
+    int result = read_blocks(disk, start_block, block_count, buffer);
+    return trace_end(disk, &start, TRACE_OP_READ, start_block, (uint32_t)block_count,
+                     result);
+}
+
+/**
+ * 复制并排序分散读写请求
+ */
+static int prepare_sg_entries(disk_t* disk, const disk_block_vec_t* vec, int count,
+                              sg_entry_t** out) {
+    if (!vec || count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    sg_entry_t* entries = (sg_entry_t*)malloc((size_t)count * sizeof(sg_entry_t));
+    if (!entries) {
+        return DISK_ERROR_IO;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        if (!vec[i].buffer) {
+            free(entries);
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        if (vec[i].block_num >= disk->total_blocks) {
+            free(entries);
+            return DISK_ERROR_BLOCK_RANGE;
+        }
+        entries[i].block_num = vec[i].block_num;
+        entries[i].order = (uint32_t)i;
+        entries[i].buffer = vec[i].buffer;
+    }
+    
+    qsort(entries, count, sizeof(sg_entry_t), compare_sg_entries);
+    
+    // 先派发与请求范围重叠的排队写入
+    uint64_t first = entries[0].block_num;
+    if (ioq_barrier(disk, first, entries[count - 1].block_num - first + 1) != DISK_SUCCESS) {
+        free(entries);
+        return DISK_ERROR_IO;
+    }
+    
+    *out = entries;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 分散读取
+ */
+int disk_handle_readv_blocks(disk_t* disk, const disk_block_vec_t* vec, int count) {
+    sg_entry_t* entries;
+    int result = prepare_sg_entries(disk, vec, count, &entries);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    result = read_sorted_blocks(disk, entries, (uint32_t)count);
+    free(entries);
+    return result;
+}
+
+/**
+ * 聚集写入
+ */
+int disk_handle_writev_blocks(disk_t* disk, const disk_block_vec_t* vec, int count) {
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    sg_entry_t* entries;
+    int result = prepare_sg_entries(disk, vec, count, &entries);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    // 同一块出现多次时只保留最后一次写入
+    uint32_t unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (i + 1 < count && entries[i + 1].block_num == entries[i].block_num) {
+            continue;
+        }
+        entries[unique++] = entries[i];
+    }
+    
+    result = write_sorted_blocks(disk, entries, unique);
+    free(entries);
+    return result;
+}
+
+/**
+ * 块号比较函数
+ */
+static int compare_block_nums(const void* a, const void* b) {
+    uint64_t ba = *(const uint64_t*)a;
+    uint64_t bb = *(const uint64_t*)b;
+    return (ba > bb) - (ba < bb);
+}
+
+/**
+ * mmap模式下提示内核预读块所在的映射页
+ */
+static void advise_mapped_blocks(disk_t* disk, const uint64_t* block_nums, int count) {
+    uintptr_t page_mask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+    
+    for (int i = 0; i < count; i++) {
+        if (block_nums[i] >= disk->total_blocks) {
+            continue;
+        }
+        uintptr_t start = (uintptr_t)MAP_BLOCK_PTR(block_nums[i]);
+        uintptr_t end = start + disk->block_size;
+        start &= ~page_mask;
+        madvise((void*)start, end - start, MADV_WILLNEED);
+    }
+}
+
+/**
+ * 预读一组块到块缓存
+ * 
+ * 跳过已缓存和越界的块，其余按块号排序后连续段合并读取，以预读标记
+ * 放入缓存；读取期间有写入发生时放弃填充，避免缓存旧数据。
+ */
+int disk_handle_prefetch_blocks(disk_t* disk, const uint64_t* block_nums, int count) {
+    if (!block_nums || count < 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->map_base) {
+        advise_mapped_blocks(disk, block_nums, count);
+        return 0;
+    }
+    if (!disk->cache || count == 0) {
+        return 0;
+    }
+    
+    uint64_t* missing = (uint64_t*)malloc((size_t)count * sizeof(uint64_t));
+    if (!missing) {
+        return DISK_ERROR_IO;
+    }
+    
+    uint32_t n = 0;
+    pthread_mutex_lock(&disk->cache_lock);
+    for (int i = 0; i < count; i++) {
+        if (block_nums[i] < disk->total_blocks &&
+            !block_cache_contains(disk->cache, block_nums[i])) {
+            missing[n++] = block_nums[i];
+        }
+    }
+    uint64_t seq = disk->write_seq;
+    pthread_mutex_unlock(&disk->cache_lock);
+    
+    // 排序并去重
+    qsort(missing, n, sizeof(uint64_t), compare_block_nums);
+    uint32_t unique = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (unique == 0 || missing[unique - 1] != missing[i]) {
+            missing[unique++] = missing[i];
+        }
+    }
+    
+    if (unique == 0) {
+        free(missing);
+        return 0;
+    }
+    
+    char* data = (char*)malloc((size_t)unique * disk->block_size);
+    if (!data) {
+        free(missing);
+        return DISK_ERROR_IO;
+    }
+    
+    char* run[DISK_MAX_IOV_BLOCKS];
+    int result = DISK_SUCCESS;
+    for (uint32_t i = 0; i < unique && result == DISK_SUCCESS; ) {
+        uint32_t len = 0;
+        while (i + len < unique && len < DISK_MAX_IOV_BLOCKS &&
+               missing[i + len] == missing[i] + len) {
+            run[len] = data + (size_t)(i + len) * disk->block_size;
+            len++;
+        }
+        result = raw_read_run(disk, missing[i], len, run);
+        i += len;
+    }
+    
+    if (result == DISK_SUCCESS) {
+        pthread_mutex_lock(&disk->cache_lock);
+        if (seq == disk->write_seq) {
+            for (uint32_t i = 0; i < unique; i++) {
+                block_cache_prefetch(disk->cache, missing[i], data + (size_t)i * disk->block_size);
+            }
+        } else {
+            unique = 0;
+        }
+        pthread_mutex_unlock(&disk->cache_lock);
+        STATS_ADD(readahead_blocks, unique);
+    }
+    
+    free(data);
+    free(missing);
+    return (result == DISK_SUCCESS) ? (int)unique : result;
+}
+
+/*==============================================================================
+ * I/O调度
+ *============================================================================*/
+
+/**
+ * 按块号排序比较函数（分散读写描述符）
+ */
+static int compare_block_vecs(const void* a, const void* b) {
+    uint64_t ba = ((const disk_block_vec_t*)a)->block_num;
+    uint64_t bb = ((const disk_block_vec_t*)b)->block_num;
+    return (ba > bb) - (ba < bb);
+}
+
+/**
+ * 派发队列中的全部写入（调用方持有ioq.lock）
+ * 
+ * 队列中的块号互不相同；按块号排序后一次升序扫描，连续的块由
+ * write_sorted_blocks合并为一次pwritev。失败时本批写入同样出队。
+ */
+static int ioq_dispatch_locked(disk_t* disk) {
+    disk_ioq_t* ioq = &disk->ioq;
+    if (ioq->count == 0) {
+        return DISK_SUCCESS;
+    }
+    
+    qsort(ioq->reqs, ioq->count, sizeof(disk_block_vec_t), compare_block_vecs);
+    
+    sg_entry_t entries[DISK_MAX_IOV_BLOCKS];
+    uint32_t runs = 0;
+    int result = DISK_SUCCESS;
+    for (uint32_t done = 0; done < ioq->count && result == DISK_SUCCESS; ) {
+        uint32_t n = ioq->count - done;
+        if (n > DISK_MAX_IOV_BLOCKS) {
+            n = DISK_MAX_IOV_BLOCKS;
+        }
+        
+        for (uint32_t i = 0; i < n; i++) {
+            const disk_block_vec_t* req = &ioq->reqs[done + i];
+            if (done + i == 0 || req->block_num != req[-1].block_num + 1) {
+                runs++;
+            }
+            entries[i].block_num = req->block_num;
+            entries[i].order = i;
+            entries[i].buffer = req->buffer;
+        }
+        
+        result = write_sorted_blocks(disk, entries, n);
+        done += n;
+    }
+    
+    __atomic_store_n(&ioq->count, 0, __ATOMIC_RELEASE);
+    STATS_ADD(ioq_dispatches, 1);
+    STATS_ADD(ioq_runs, runs);
+    if (result != DISK_SUCCESS) {
+        STATS_ADD(write_errors, 1);
+    }
+    
+    return result;
+}
+
+/**
+ * 把一个块加入队列（调用方持有ioq.lock）
+ * 
+ * 已在队列中的块直接覆盖其副本，保持原来的到达时间。
+ */
+static void ioq_add_locked(disk_t* disk, uint64_t block_num, const char* data) {
+    disk_ioq_t* ioq = &disk->ioq;
+    
+    if (ioq->count > 0 && block_num >= ioq->low && block_num <= ioq->high) {
+        for (uint32_t i = 0; i < ioq->count; i++) {
+            if (ioq->reqs[i].block_num == block_num) {
+                memcpy(ioq->reqs[i].buffer, data, disk->block_size);
+                STATS_ADD(ioq_absorbed, 1);
+                return;
+            }
+        }
+    }
+    
+    disk_block_vec_t* req = &ioq->reqs[ioq->count];
+    req->block_num = block_num;
+    req->buffer = ioq->data + (size_t)ioq->count * disk->block_size;
+    memcpy(req->buffer, data, disk->block_size);
+    
+    if (ioq->count == 0) {
+        // 第一个排队写入开始计时
+        ioq->low = block_num;
+        ioq->high = block_num;
+        clock_gettime(CLOCK_MONOTONIC, &ioq->oldest);
+        pthread_cond_signal(&ioq->wake);
+    } else if (block_num < ioq->low) {
+        ioq->low = block_num;
+    } else if (block_num > ioq->high) {
+        ioq->high = block_num;
+    }
+    __atomic_store_n(&ioq->count, ioq->count + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * 配置I/O调度队列
+ */
+int disk_handle_set_io_queue(disk_t* disk, uint32_t depth, uint32_t deadline_us) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    int result = ioq_drain(disk);
+    stop_ioq(disk);
+    if (depth > 0) {
+        int started = start_ioq(disk, depth,
+                                deadline_us ? deadline_us : DISK_IOQ_DEFAULT_DEADLINE_US);
+        if (result == DISK_SUCCESS) {
+            result = started;
+        }
+    }
+    
+    return result;
+}
+
+/**
+ * 排队写入一个块
+ */
+int disk_handle_queue_write(disk_t* disk, uint64_t block_num, const char* data) {
+    disk_ioq_t* ioq = &disk->ioq;
+    if (!ioq->running) {
+        return disk_handle_write_block(disk, block_num, data);
+    }
+    
+    if (!data) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (!disk_block_in_range(disk, block_num)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    pthread_mutex_lock(&ioq->lock);
+    int result = ioq->error;
+    ioq->error = DISK_SUCCESS;
+    if (result == DISK_SUCCESS) {
+        ioq_add_locked(disk, block_num, data);
+        STATS_ADD(ioq_queued, 1);
+        if (ioq->count >= ioq->depth) {
+            result = ioq_dispatch_locked(disk);
+        }
+    }
+    pthread_mutex_unlock(&ioq->lock);
+    
+    return result;
+}
+
+/**
+ * 排队写入一组块
+ */
+int disk_handle_queue_writev(disk_t* disk, const disk_block_vec_t* vec, int count) {
+    disk_ioq_t* ioq = &disk->ioq;
+    if (!ioq->running) {
+        return disk_handle_writev_blocks(disk, vec, count);
+    }
+    
+    if (!vec || count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        if (!vec[i].buffer) {
+            return DISK_ERROR_INVALID_PARAM;
+        }
+        if (vec[i].block_num >= disk->total_blocks) {
+            return DISK_ERROR_BLOCK_RANGE;
+        }
+    }
+    
+    pthread_mutex_lock(&ioq->lock);
+    int result = ioq->error;
+    ioq->error = DISK_SUCCESS;
+    for (int i = 0; i < count && result == DISK_SUCCESS; i++) {
+        ioq_add_locked(disk, vec[i].block_num, vec[i].buffer);
+        if (ioq->count >= ioq->depth) {
+            result = ioq_dispatch_locked(disk);
+        }
+    }
+    pthread_mutex_unlock(&ioq->lock);
+    STATS_ADD(ioq_queued, count);
+    
+    return result;
+}
+
+/**
+ * 立即派发全部排队写入
+ */
+int disk_handle_dispatch(disk_t* disk) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    return ioq_drain(disk);
+}
+
+/*==============================================================================
+ * 零拷贝块访问
+ *============================================================================*/
+
+/**
+ * 获取块指针（mmap模式下直接指向映射，否则返回私有副本）
+ */
+static int get_block_pointer(disk_t* disk, uint64_t block_num, int writable, char** ptr) {
+    if (!ptr) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    *ptr = NULL;
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (writable && disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (!disk_block_in_range(disk, block_num)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    if (ioq_barrier(disk, block_num, 1) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (disk->map_base) {
+        int result = map_read_block(disk, block_num, NULL);
+        if (result != DISK_SUCCESS) {
+            return result;
+        }
+        *ptr = MAP_BLOCK_PTR(block_num);
+        STATS_ADD(zero_copy_gets, 1);
+        return DISK_SUCCESS;
+    }
+    
+    char* copy = (char*)malloc(disk->block_size);
+    if (!copy) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = disk_handle_read_block(disk, block_num, copy);
+    if (result != DISK_SUCCESS) {
+        free(copy);
+        return result;
+    }
+    
+    *ptr = copy;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 获取只读块指针
+ */
+int disk_handle_get_block(disk_t* disk, uint64_t block_num, const char** ptr) {
+    char* block;
+    int result = get_block_pointer(disk, block_num, 0, &block);
+    if (ptr) {
+        *ptr = block;
+    }
+    return result;
+}
+
+/**
+ * 获取可写块指针
+ */
+int disk_handle_get_block_mut(disk_t* disk, uint64_t block_num, char** ptr) {
+    return get_block_pointer(disk, block_num, 1, ptr);
+}
+
+/**
+ * 释放块指针
+ */
+int disk_handle_put_block(disk_t* disk, uint64_t block_num, const char* ptr, int dirty) {
+    if (!ptr) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk_block_in_range(disk, block_num)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    // 映射中的块已就地修改，只需记录脏块并计入写入统计
+    if (disk->map_base && ptr == MAP_BLOCK_PTR(block_num)) {
+        if (dirty) {
+            map_mark_dirty(disk, block_num);
+            csum_update(disk, block_num, ptr);
+            STATS_ADD(total_writes, 1);
+            STATS_ADD(bytes_written, disk->block_size);
+            __atomic_store_n(&disk->stats.last_operation_time, time(NULL), __ATOMIC_RELAXED);
+            return sync_after_write(disk, 1);
+        }
+        return DISK_SUCCESS;
+    }
+    
+    // 私有副本：修改过则写回，然后释放
+    int result = DISK_SUCCESS;
+    if (dirty) {
+        result = disk_handle_write_block(disk, block_num, ptr);
+    }
+    free((void*)ptr);
+    return result;
+}
+
+/*==============================================================================
+ * 异步块I/O
+ *============================================================================*/
+
+/**
+ * 引擎错误码转换为磁盘错误码
+ */
+static int aio_error_to_disk(int error) {
+    return (error == -EAGAIN) ? DISK_ERROR_BUSY : DISK_ERROR_IO;
+}
+
+/**
+ * 检查异步请求参数
+ */
+static int check_aio_request(disk_t* disk, uint64_t start_block, int block_count, const void* buffer) {
+    if (!buffer || block_count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    int result = check_block_range(disk, start_block, block_count);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (!disk->aio) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    // 异步请求绕过调度队列，先派发与之重叠的排队写入
+    return ioq_barrier(disk, start_block, (uint64_t)block_count) == DISK_SUCCESS
+           ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/**
+ * 初始化异步I/O
+ */
+int disk_handle_aio_init(disk_t* disk, uint32_t queue_depth, int flags) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->aio) {
+        return DISK_ERROR_ALREADY_INIT;
+    }
+    
+    if (queue_depth == 0) {
+        queue_depth = DISK_AIO_DEFAULT_DEPTH;
+    }
+    
+    // 引擎只针对单个文件描述符按位置读写，条带集由成员工作线程并行读写，压缩镜像需要编解码，
+    // 去重镜像需要查指纹，快照叠加层需要查映射表
+    if (disk->stripe || disk->chunks || disk->dedup || disk->remap) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    aio_backend_t backend = (flags & DISK_AIO_THREADS) ? AIO_BACKEND_THREADS : AIO_BACKEND_AUTO;
+    disk->aio = aio_engine_create(disk->fd, queue_depth, backend);
+    return disk->aio ? DISK_SUCCESS : DISK_ERROR_IO;
+}
+
+/**
+ * 关闭异步I/O
+ */
+int disk_handle_aio_shutdown(disk_t* disk) {
+    if (!disk->aio) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    drain_aio(disk);
+    aio_engine_destroy(disk->aio);
+    disk->aio = NULL;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 提交异步读
+ */
+int disk_handle_aio_submit_read(disk_t* disk, uint64_t start_block, int block_count, char* buffer,
+                                uint64_t user_data) {
+    int result = check_aio_request(disk, start_block, block_count, buffer);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    size_t length = (size_t)block_count * disk->block_size;
+    int immediate = 0;
+    
+    if (disk->map_base) {
+        // mmap模式：直接从映射复制，立即完成
+        for (int i = 0; i < block_count; i++) {
+            result = map_read_block(disk, start_block + i, buffer + (size_t)i * disk->block_size);
+            if (result != DISK_SUCCESS) {
+                return result;
+            }
+        }
+        immediate = 1;
+    } else if (disk->cache) {
+        // 全部命中缓存时立即完成；否则先回写范围内的脏块，保证磁盘上的数据最新
+        pthread_mutex_lock(&disk->cache_lock);
+        int hits = 0;
+        for (int i = 0; i < block_count; i++) {
+            hits += block_cache_lookup(disk->cache, start_block + i,
+                                       buffer + (size_t)i * disk->block_size);
+        }
+        if (hits == block_count) {
+            immediate = 1;
+        } else if (block_cache_range_dirty(disk->cache, start_block, block_count)) {
+            result = block_cache_flush(disk->cache);
+        }
+        pthread_mutex_unlock(&disk->cache_lock);
+        
+        STATS_ADD(cache_hits, hits);
+        STATS_ADD(cache_misses, block_count - hits);
+        if (result != 0) {
+            return DISK_ERROR_IO;
+        }
+    }
+    
+    int error = immediate
+        ? aio_engine_complete(disk->aio, 0, (int64_t)length, user_data)
+        : aio_engine_submit(disk->aio, 0, buffer, length,
+                            DISK_BLOCK_OFFSET(disk, start_block), user_data);
+    if (error != 0) {
+        return aio_error_to_disk(error);
+    }
+    
+    STATS_ADD(aio_submitted, 1);
+    return DISK_SUCCESS;
+}
+
+/**
+ * 提交异步写
+ */
+int disk_handle_aio_submit_write(disk_t* disk, uint64_t start_block, int block_count, const char* data,
+                                 uint64_t user_data) {
+    int result = check_aio_request(disk, start_block, block_count, data);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    size_t length = (size_t)block_count * disk->block_size;
+    int error;
+    
+    if (disk->map_base) {
+        // mmap模式：直接写入映射，立即完成
+        for (int i = 0; i < block_count; i++) {
+            map_write_block(disk, start_block + i, data + (size_t)i * disk->block_size);
+        }
+        error = aio_engine_complete(disk->aio, 1, (int64_t)length, user_data);
+    } else {
+        // 丢弃缓存中的旧副本（包括脏块），避免之后被回写覆盖
+        if (disk->cache) {
+            pthread_mutex_lock(&disk->cache_lock);
+            disk->write_seq++;
+            for (int i = 0; i < block_count; i++) {
+                block_cache_invalidate(disk->cache, start_block + i);
+            }
+            pthread_mutex_unlock(&disk->cache_lock);
+        }
+        
+        if (disk->discarded && extent_set_count(disk->discarded) > 0) {
+            extent_set_remove(disk->discarded, start_block, (uint64_t)block_count);
+        }
+        
+        // 校验和在回收到成功完成时才记录
+        error = aio_engine_submit(disk->aio, 1, (void*)data, length,
+                                  DISK_BLOCK_OFFSET(disk, start_block), user_data);
+    }
+    
+    if (error != 0) {
+        return aio_error_to_disk(error);
+    }
+    
+    STATS_ADD(aio_submitted, 1);
+    return DISK_SUCCESS;
+}
+
+/**
+ * 回收异步完成事件
+ */
+int disk_handle_aio_reap(disk_t* disk, disk_aio_completion_t* completions, int max_completions,
+                         int min_completions) {
+    if (!completions || max_completions <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->aio) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    aio_engine_event_t events[DISK_AIO_DEFAULT_DEPTH];
+    int total = 0;
+    
+    while (total < max_completions) {
+        int want = max_completions - total;
+        if (want > DISK_AIO_DEFAULT_DEPTH) {
+            want = DISK_AIO_DEFAULT_DEPTH;
+        }
+        int wait = (min_completions > total) ? min_completions - total : 0;
+        
+        int count = aio_engine_reap(disk->aio, events, want, wait);
+        if (count < 0) {
+            return total > 0 ? total : DISK_ERROR_IO;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            aio_engine_event_t* ev = &events[i];
+            disk_aio_completion_t* out = &completions[total + i];
+            out->user_data = ev->user_data;
+            
+            if (ev->is_write && ev->buf && disk->cache) {
+                // 写入期间并发读可能把旧数据放回缓存，完成后再丢弃一次
+                uint64_t start_block = DISK_OFFSET_TO_BLOCK(ev->offset);
+                pthread_mutex_lock(&disk->cache_lock);
+                disk->write_seq++;
+                block_cache_invalidate_range(disk->cache, start_block,
+                                             ev->length / disk->block_size);
+                pthread_mutex_unlock(&disk->cache_lock);
+            }
+            
+            if (ev->result < 0 || (size_t)ev->result != ev->length) {
+                out->result = ev->is_write ? DISK_ERROR_FILE_WRITE : DISK_ERROR_FILE_READ;
+                if (ev->is_write) {
+                    STATS_ADD(write_errors, 1);
+                } else {
+                    STATS_ADD(read_errors, 1);
+                }
+                continue;
+            }
+            
+            out->result = DISK_SUCCESS;
+            uint64_t blocks = ev->length / disk->block_size;
+            if (!ev->is_write && ev->buf && disk->csums) {
+                // 验证读到的每个块，不一致的块单独重读
+                uint64_t start_block = DISK_OFFSET_TO_BLOCK(ev->offset);
+                for (uint64_t b = 0; b < blocks; b++) {
+                    char* block = (char*)ev->buf + b * disk->block_size;
+                    if (!csum_matches(disk, start_block + b, block)) {
+                        out->result = raw_read_block(disk, start_block + b, block);
+                        if (out->result != DISK_SUCCESS) {
+                            break;
+                        }
+                    }
+                }
+                if (out->result != DISK_SUCCESS) {
+                    continue;
+                }
+            }
+            if (ev->is_write && ev->buf && disk->csums) {
+                // 数据已到达镜像，记录新的校验和
+                uint64_t start_block = DISK_OFFSET_TO_BLOCK(ev->offset);
+                for (uint64_t b = 0; b < blocks; b++) {
+                    csum_update(disk, start_block + b, (const char*)ev->buf + b * disk->block_size);
+                }
+            }
+            if (ev->is_write) {
+                STATS_ADD(total_writes, blocks);
+                STATS_ADD(bytes_written, ev->length);
+                __atomic_store_n(&disk->is_dirty, 1, __ATOMIC_RELAXED);
+            } else {
+                STATS_ADD(total_reads, blocks);
+                STATS_ADD(bytes_read, ev->length);
+            }
+        }
+        
+        STATS_ADD(aio_completed, count);
+        total += count;
+        if (count < want) {
+            break;
+        }
+    }
+    
+    return total;
+}
+
+/**
+ * 获取异步I/O后端名称
+ */
+const char* disk_handle_aio_backend(disk_t* disk) {
+    return disk->aio ? aio_engine_backend_name(disk->aio) : "none";
+}
+
+/**
+ * 清零一个块
+ */
+int disk_handle_zero_block(disk_t* disk, uint64_t block_num) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    return disk_handle_write_block(disk, block_num, g_zero_block);
+}
+
+/**
+ * 清零一段块
+ */
+int disk_handle_zero_blocks(disk_t* disk, uint64_t start_block, int block_count) {
+    if (block_count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = check_block_range(disk, start_block, block_count);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (ioq_barrier(disk, start_block, (uint64_t)block_count) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    return zero_block_range(disk, start_block, (uint64_t)block_count);
+}
+
+/**
+ * 在后台清零一段块
+ */
+int disk_handle_zero_blocks_background(disk_t* disk, uint64_t start_block, int block_count) {
+    if (block_count <= 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = check_block_range(disk, start_block, block_count);
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (ioq_barrier(disk, start_block, (uint64_t)block_count) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    stop_zeroer(disk);
+    
+    disk_zeroer_t* z = &disk->zeroer;
+    pthread_mutex_lock(&z->lock);
+    z->start = start_block;
+    z->next = start_block;
+    z->end = start_block + (uint64_t)block_count;
+    pthread_mutex_unlock(&z->lock);
+    
+    if (pthread_create(&z->thread, NULL, zeroer_thread, disk) != 0) {
+        stop_zeroer(disk);
+        return DISK_ERROR_IO;
+    }
+    z->active = 1;
+    
+    return DISK_SUCCESS;
+}
+
+/**
+ * 认领后台清零任务中的块
+ */
+int disk_handle_zero_blocks_claim(disk_t* disk, uint64_t block_num) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk_block_in_range(disk, block_num)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    disk_zeroer_t* z = &disk->zeroer;
+    uint64_t block = block_num;
+    int result = DISK_SUCCESS;
+    
+    pthread_mutex_lock(&z->lock);
+    int covered = (block >= z->start && block < z->end);
+    if (covered && block >= z->next) {
+        // 尚未清零：连同之前待清零的块一起同步清零
+        result = zero_block_range(disk, z->next, block + 1 - z->next);
+        if (result == DISK_SUCCESS) {
+            z->next = block + 1;
+        }
+    }
+    pthread_mutex_unlock(&z->lock);
+    
+    return (result == DISK_SUCCESS) ? covered : result;
+}
+
+/**
+ * 查询后台清零任务已完成的块数
+ */
+int disk_handle_zero_blocks_done(disk_t* disk, uint64_t start_block) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk_block_in_range(disk, start_block)) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    disk_zeroer_t* z = &disk->zeroer;
+    uint64_t block = start_block;
+    int done = 0;
+    
+    pthread_mutex_lock(&z->lock);
+    if (block >= z->start && block < z->next) {
+        done = (int)(z->next - block);
+    }
+    pthread_mutex_unlock(&z->lock);
+    
+    return done;
+}
+
+/**
+ * 丢弃一段块
+ */
+int disk_handle_discard_blocks(disk_t* disk, uint64_t start_block, uint64_t block_count) {
+    if (block_count == 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (start_block >= disk->total_blocks || block_count > disk->total_blocks - start_block) {
+        return DISK_ERROR_BLOCK_RANGE;
+    }
+    
+    // 排队的写入先落到镜像，否则派发时会覆盖打出的洞
+    if (ioq_barrier(disk, start_block, block_count) != DISK_SUCCESS) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = clear_block_range(disk, start_block, block_count, 1);
+    if (result == DISK_SUCCESS) {
+        STATS_ADD(discard_requests, 1);
+        STATS_ADD(blocks_discarded, block_count);
+    }
+    return result;
+}
+
+/**
+ * 复制块数据
+ */
+int disk_handle_copy_block(disk_t* disk, uint64_t src_block, uint64_t dst_block) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    char* buffer = (char*)malloc(disk->block_size);
+    if (!buffer) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = disk_handle_read_block(disk, src_block, buffer);
+    if (result == DISK_SUCCESS) {
+        result = disk_handle_write_block(disk, dst_block, buffer);
+    }
+    
+    free(buffer);
+    return result;
+} 
+
+/*==============================================================================
+ * 快照
+ *============================================================================*/
+
+/**
+ * 用FICLONE克隆镜像文件作为快照（与原文件共享数据区段，不复制数据）
+ * 
+ * 克隆的头部加上快照标志；克隆前校验和表已与数据一起落盘，清除过期标志。
+ * 
+ * @return DISK_SUCCESS，DISK_ERROR_IO表示主机不支持，其他为错误码
+ */
+static int reflink_snapshot(disk_t* disk, const char* snapshot_name) {
+#ifdef FICLONE
+    // 条带集的数据分散在多个文件中，由叠加层冻结整个条带集
+    if (disk->stripe) {
+        return DISK_ERROR_IO;
+    }
+    
+    int fd = open(snapshot_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        return DISK_ERROR_FILE_CREATE;
+    }
+    
+    int result = DISK_ERROR_IO;
+    if (ioctl(fd, FICLONE, disk->fd) == 0) {
+        result = write_header_flags(fd, DISK_FLAG_SNAPSHOT, DISK_FLAG_CHECKSUMS_STALE);
+    }
+    
+    close(fd);
+    if (result != DISK_SUCCESS) {
+        unlink(snapshot_name);
+    }
+    return result;
+#else
+    (void)disk;
+    (void)snapshot_name;
+    return DISK_ERROR_IO;
+#endif
+}
+
+/**
+ * 重命名镜像文件（条带集连同各成员文件）
+ * 
+ * @return 0成功，-1失败（已改名的文件恢复原名）
+ */
+static int rename_image(const char* from, const char* to, uint32_t members) {
+    char from_member[DISK_MAX_FILENAME_LEN + 8];
+    char to_member[DISK_MAX_FILENAME_LEN + 8];
+    
+    uint32_t renamed = 1;
+    for (; renamed < members; renamed++) {
+        snprintf(from_member, sizeof(from_member), "%s.%u", from, renamed);
+        snprintf(to_member, sizeof(to_member), "%s.%u", to, renamed);
+        if (rename(from_member, to_member) != 0) {
+            break;
+        }
+    }
+    if (renamed == members && rename(from, to) == 0) {
+        return 0;
+    }
+    
+    while (renamed-- > 1) {
+        snprintf(from_member, sizeof(from_member), "%s.%u", from, renamed);
+        snprintf(to_member, sizeof(to_member), "%s.%u", to, renamed);
+        rename(to_member, from_member);
+    }
+    return -1;
+}
+
+/**
+ * 冻结当前镜像作为快照，在原文件名下新建叠加层并重新打开
+ * 
+ * 镜像文件先加上快照标志再改名为快照名，数据一个块也不复制；失败时
+ * 恢复原镜像。重新打开后保留统计、自动同步设置、进行中的I/O跟踪，以及
+ * 本磁盘自己的缓存、映射、组提交、调度队列和时序模型配置。
+ */
+static int overlay_snapshot(disk_t* disk, const char* snapshot_name) {
+    char filename[DISK_MAX_FILENAME_LEN];
+    memcpy(filename, disk->filename, sizeof(filename));
+    uint32_t members = disk->member_count;
+    uint8_t auto_sync = disk->auto_sync;
+    disk_stats_t stats;
+    disk_handle_get_stats(disk, &stats);
+    trace_log_t* trace = disk->trace;
+    disk->trace = NULL;
+    timing_model_t* timing = disk->timing;
+    disk->timing = NULL;
+    uint32_t cache_capacity = disk->cache_capacity;
+    int mapped = disk->map_base != NULL;
+    uint32_t group_window_us = disk->group_commit.running ? disk->group_commit.window_us : 0;
+    uint64_t group_max_bytes = disk->group_commit.max_bytes;
+    uint32_t ioq_depth = disk->ioq.running ? disk->ioq.depth : 0;
+    uint32_t ioq_deadline_us = disk->ioq.deadline_us;
+    close_disk(disk);
+    
+    disk_header_t header;
+    int result = DISK_SUCCESS;
+    int fd = open(filename, O_RDWR);
+    if (fd == -1) {
+        result = DISK_ERROR_FILE_OPEN;
+    } else {
+        if (pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+            result = DISK_ERROR_FILE_READ;
+        } else {
+            result = write_header_flags(fd, DISK_FLAG_SNAPSHOT, 0);
+        }
+        close(fd);
+    }
+    
+    if (result == DISK_SUCCESS && rename_image(filename, snapshot_name, members) != 0) {
+        result = DISK_ERROR_FILE_CREATE;
+    }
+    if (result == DISK_SUCCESS) {
+        result = create_overlay(filename, snapshot_name, &header);
+        if (result != DISK_SUCCESS) {
+            rename_image(snapshot_name, filename, members);
+        }
+    }
+    if (result != DISK_SUCCESS && fd != -1) {
+        // 快照没有建成，原镜像恢复为可写
+        int restore = open(filename, O_RDWR);
+        if (restore != -1) {
+            write_header_flags(restore, 0, DISK_FLAG_SNAPSHOT);
+            close(restore);
+        }
+    }
+    
+    int reopen = open_disk(disk, filename, 1, 0);
+    if (reopen == DISK_SUCCESS) {
+        timing_model_destroy(disk->timing);
+        disk->timing = timing;
+        // 叠加层不能映射时沿用块缓存，与打开时的退回方式一致
+        disk_handle_set_cache_capacity(disk, cache_capacity);
+        disk_handle_set_mmap_mode(disk, mapped);
+        reopen = disk_handle_set_group_commit(disk, group_window_us, group_max_bytes);
+        if (reopen == DISK_SUCCESS) {
+            reopen = disk_handle_set_io_queue(disk, ioq_depth, ioq_deadline_us);
+        }
+        disk->stats = stats;
+        disk->auto_sync = auto_sync;
+        disk->trace = trace;
+    } else {
+        timing_model_destroy(timing);
+        trace_log_close(trace);
+    }
+    return result != DISK_SUCCESS ? result : reopen;
+}
+
+/**
+ * 为磁盘建立快照
+ */
+int disk_handle_snapshot(disk_t* disk, const char* snapshot_name, int flags) {
+    if (!snapshot_name || snapshot_name[0] == '\0' ||
+        strlen(snapshot_name) >= DISK_MAX_FILENAME_LEN) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->is_read_only) {
+        return DISK_ERROR_IO;
+    }
+    
+    if (disk->aio && aio_engine_outstanding(disk->aio) > 0) {
+        return DISK_ERROR_BUSY;
+    }
+    
+    if (strcmp(snapshot_name, disk->filename) == 0 || access(snapshot_name, F_OK) == 0) {
+        return DISK_ERROR_FILE_CREATE;
+    }
+    
+    // 内存盘没有可冻结的镜像文件（先用disk_ram_dump()保存）
+    if (disk->is_ram) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    // 快照包含调用前完成的所有写入：做完后台清零，派发排队的写入并回写缓存
+    int result = finish_zeroer(disk);
+    if (result == DISK_SUCCESS) {
+        result = disk_handle_sync(disk);
+    }
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    if (!(flags & DISK_SNAPSHOT_NO_REFLINK)) {
+        result = reflink_snapshot(disk, snapshot_name);
+        if (result == DISK_SUCCESS) {
+            STATS_ADD(snapshots_reflinked, 1);
+            return DISK_SUCCESS;
+        }
+        if (result != DISK_ERROR_IO) {
+            return result;
+        }
+    }
+    
+    // 叠加层的映射表按32位块号索引
+    if (disk->total_blocks > DISK_MAX_TABLE_BLOCKS) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    result = overlay_snapshot(disk, snapshot_name);
+    if (result == DISK_SUCCESS) {
+        STATS_ADD(snapshots_overlaid, 1);
+    }
+    return result;
+}
+
+/*==============================================================================
+ * 内存盘导出
+ *============================================================================*/
+
+/**
+ * 把内存盘保存为镜像文件
+ * 
+ * 先写到同目录的临时文件并同步，再改名覆盖目标，目标文件要么是旧镜像
+ * 要么是完整的新镜像。
+ */
+int disk_handle_ram_dump(disk_t* disk, const char* image_file) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk->is_ram) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!image_file) {
+        image_file = disk->filename;
+    }
+    if (image_file[0] == '\0' || strlen(image_file) >= DISK_MAX_FILENAME_LEN) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (disk->aio && aio_engine_outstanding(disk->aio) > 0) {
+        return DISK_ERROR_BUSY;
+    }
+    
+    // 导出调用前完成的所有写入：做完后台清零，派发排队的写入并回写缓存、校验和表和映射表
+    int result = finish_zeroer(disk);
+    if (result == DISK_SUCCESS) {
+        result = disk_handle_sync(disk);
+    }
+    if (result != DISK_SUCCESS) {
+        return result;
+    }
+    
+    struct stat ram_stat;
+    if (fstat(disk->fd, &ram_stat) == -1) {
+        return DISK_ERROR_IO;
+    }
+    
+    char temp_name[DISK_MAX_FILENAME_LEN + 8];
+    snprintf(temp_name, sizeof(temp_name), "%s.tmp", image_file);
+    int fd = open(temp_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return DISK_ERROR_FILE_CREATE;
+    }
+    
+    result = copy_image_data(disk->fd, fd, (uint64_t)ram_stat.st_size);
+    
+    // 校验和表刚与数据一起写回，导出的镜像不带过期标志
+    if (result == DISK_SUCCESS && disk->csums) {
+        result = write_header_flags(fd, 0, DISK_FLAG_CHECKSUMS_STALE);
+    }
+    if (result == DISK_SUCCESS && fsync(fd) == -1) {
+        result = DISK_ERROR_FILE_WRITE;
+    }
+    close(fd);
+    
+    if (result == DISK_SUCCESS && rename(temp_name, image_file) != 0) {
+        result = DISK_ERROR_FILE_CREATE;
+    }
+    if (result != DISK_SUCCESS) {
+        unlink(temp_name);
+    }
+    return result;
+}
+
+/*==============================================================================
+ * I/O跟踪
+ *============================================================================*/
+
+/**
+ * 开始把块读写和同步调用记录到跟踪文件
+ */
+int disk_handle_trace_start(disk_t* disk, const char* trace_file) {
+    if (!trace_file || trace_file[0] == '\0') {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (disk->trace) {
+        return DISK_ERROR_BUSY;
+    }
+    
+    trace_log_t* trace = NULL;
+    if (trace_log_open(trace_file, disk->block_size, disk->total_blocks, &trace) != 0) {
+        return DISK_ERROR_FILE_CREATE;
+    }
+    
+    disk->trace = trace;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 停止I/O跟踪，写出缓冲的记录并关闭跟踪文件
+ */
+int disk_handle_trace_stop(disk_t* disk) {
+    if (!disk->is_initialized) {
+        return DISK_ERROR_NOT_INIT;
+    }
+    
+    if (!disk->trace) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    trace_log_t* trace = disk->trace;
+    disk->trace = NULL;
+    return trace_log_close(trace) == 0 ? DISK_SUCCESS : DISK_ERROR_FILE_WRITE;
+}
+
+/*==============================================================================
+ * 磁盘句柄
+ *============================================================================*/
+
+/**
+ * 打开或创建磁盘镜像，返回独立的磁盘句柄
+ */
+int disk_open(const char* filename, uint64_t disk_size, disk_t** out) {
+    if (!out) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    disk_t* disk = (disk_t*)calloc(1, sizeof(disk_t));
+    if (!disk) {
+        return DISK_ERROR_IO;
+    }
+    
+    int result = open_disk(disk, filename, disk_size, 0);
+    if (result != DISK_SUCCESS) {
+        free(disk);
+        return result;
+    }
+    
+    *out = disk;
+    return DISK_SUCCESS;
+}
+
+/**
+ * 关闭磁盘句柄并释放
+ */
+int disk_handle_close(disk_t* disk) {
+    if (!disk || disk == &g_disk_state) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    int result = close_disk(disk);
+    free(disk);
+    return result;
+}
+
+/**
+ * 获取默认磁盘的句柄
+ */
+disk_t* disk_default(void) {
+    return &g_disk_state;
+}
+
+/*==============================================================================
+ * 默认磁盘接口（原有接口，作用于全局磁盘g_disk_state）
+ *============================================================================*/
+
+int disk_init(const char* filename, uint64_t disk_size) {
+    return open_disk(&g_disk_state, filename, disk_size, 0);
+}
+
+int disk_write_block(uint64_t block_num, const char* data) {
+    return disk_handle_write_block(&g_disk_state, block_num, data);
+}
+
+int disk_read_block(uint64_t block_num, char* buffer) {
+    return disk_handle_read_block(&g_disk_state, block_num, buffer);
+}
+
+int disk_close(void) {
+    return close_disk(&g_disk_state);
+}
+
+int disk_sync(void) {
+    return disk_handle_sync(&g_disk_state);
+}
+
+int disk_sync_data(void) {
+    return disk_handle_sync_data(&g_disk_state);
+}
+
+int disk_sync_range(uint64_t start_block, uint64_t block_count) {
+    return disk_handle_sync_range(&g_disk_state, start_block, block_count);
+}
+
+int disk_get_info(uint64_t* total_blocks, uint32_t* block_size, uint64_t* disk_size) {
+    return disk_handle_get_info(&g_disk_state, total_blocks, block_size, disk_size);
+}
+
+int disk_has_checksums(void) {
+    return disk_handle_has_checksums(&g_disk_state);
+}
+
+int disk_get_striping(uint32_t* members, uint32_t* stripe_blocks) {
+    return disk_handle_get_striping(&g_disk_state, members, stripe_blocks);
+}
+
+uint32_t disk_get_compression(void) {
+    return disk_handle_get_compression(&g_disk_state);
+}
+
+int disk_has_dedup(void) {
+    return disk_handle_has_dedup(&g_disk_state);
+}
+
+uint32_t disk_get_block_size(void) {
+    return disk_handle_get_block_size(&g_disk_state);
+}
+
+int disk_get_stats(disk_stats_t* stats) {
+    return disk_handle_get_stats(&g_disk_state, stats);
+}
+
+int disk_reset_stats(void) {
+    return disk_handle_reset_stats(&g_disk_state);
+}
+
+/*
+ * 以下配置函数除了作用于默认磁盘，还记住设置供之后打开的磁盘使用；
+ * 默认磁盘未打开时只记住设置
+ */
+
+int disk_set_group_commit(uint32_t window_us, uint64_t max_dirty_bytes) {
+    g_group_window_us = window_us;
+    g_group_max_bytes = max_dirty_bytes ? max_dirty_bytes : DISK_GROUP_COMMIT_BYTES;
+    if (!g_disk_state.is_initialized) {
+        return DISK_SUCCESS;
+    }
+    return disk_handle_set_group_commit(&g_disk_state, window_us, max_dirty_bytes);
+}
+
+int disk_set_timing_model(timing_profile_t profile, uint64_t bandwidth_limit, int real_delay) {
+    timing_params_t params;
+    if (profile != TIMING_PROFILE_NONE && timing_profile_params(profile, &params) != 0) {
+        return DISK_ERROR_INVALID_PARAM;
+    }
+    
+    g_timing_profile = profile;
+    g_timing_bandwidth = bandwidth_limit;
+    g_timing_real_delay = real_delay ? 1 : 0;
+    if (!g_disk_state.is_initialized) {
+        return DISK_SUCCESS;
+    }
+    return disk_handle_set_timing_model(&g_disk_state, profile, bandwidth_limit, real_delay);
+}
+
+int disk_set_cache_capacity(uint32_t capacity_blocks) {
+    g_cache_capacity = capacity_blocks;
+    if (!g_disk_state.is_initialized) {
+        return DISK_SUCCESS;
+    }
+    return disk_handle_set_cache_capacity(&g_disk_state, capacity_blocks);
+}
+
+int disk_set_mmap_mode(int enabled) {
+    if (!g_disk_state.is_initialized) {
+        g_use_mmap = enabled ? 1 : 0;
+        return DISK_SUCCESS;
+    }
+    
+    int result = disk_handle_set_mmap_mode(&g_disk_state, enabled);
+    if (result == DISK_SUCCESS) {
+        g_use_mmap = enabled ? 1 : 0;
+    }
+    return result;
+}
+
+int disk_is_mapped(void) {
+    return disk_handle_is_mapped(&g_disk_state);
+}
+
+int disk_is_initialized(void) {
+    return disk_handle_is_initialized(&g_disk_state);
+}
+
+uint64_t disk_get_block_count(void) {
+    return disk_handle_get_block_count(&g_disk_state);
+}
+
+int disk_is_valid_block(uint64_t block_num) {
+    return disk_handle_is_valid_block(&g_disk_state, block_num);
+}
+
+int disk_format(uint8_t pattern) {
+    return disk_handle_format(&g_disk_state, pattern);
+}
+
+void disk_print_status(void) {
+    disk_handle_print_status(&g_disk_state);
+}
+
+int disk_write_blocks(uint64_t start_block, int block_count, const char* data) {
+    return disk_handle_write_blocks(&g_disk_state, start_block, block_count, data);
+}
+
+int disk_read_blocks(uint64_t start_block, int block_count, char* buffer) {
+    return disk_handle_read_blocks(&g_disk_state, start_block, block_count, buffer);
+}
+
+int disk_readv_blocks(const disk_block_vec_t* vec, int count) {
+    return disk_handle_readv_blocks(&g_disk_state, vec, count);
+}
+
+int disk_writev_blocks(const disk_block_vec_t* vec, int count) {
+    return disk_handle_writev_blocks(&g_disk_state, vec, count);
+}
+
+int disk_prefetch_blocks(const uint64_t* block_nums, int count) {
+    return disk_handle_prefetch_blocks(&g_disk_state, block_nums, count);
+}
+
+int disk_set_io_queue(uint32_t depth, uint32_t deadline_us) {
+    g_ioq_depth = depth;
+    g_ioq_deadline_us = deadline_us ? deadline_us : DISK_IOQ_DEFAULT_DEADLINE_US;
+    if (!g_disk_state.is_initialized) {
+        return DISK_SUCCESS;
+    }
+    return disk_handle_set_io_queue(&g_disk_state, depth, deadline_us);
+}
+
+int disk_queue_write(uint64_t block_num, const char* data) {
+    return disk_handle_queue_write(&g_disk_state, block_num, data);
+}
+
+int disk_queue_writev(const disk_block_vec_t* vec, int count) {
+    return disk_handle_queue_writev(&g_disk_state, vec, count);
+}
+
+int disk_dispatch(void) {
+    return disk_handle_dispatch(&g_disk_state);
+}
+
+int disk_get_block(uint64_t block_num, const char** ptr) {
+    return disk_handle_get_block(&g_disk_state, block_num, ptr);
+}
+
+int disk_get_block_mut(uint64_t block_num, char** ptr) {
+    return disk_handle_get_block_mut(&g_disk_state, block_num, ptr);
+}
+
+int disk_put_block(uint64_t block_num, const char* ptr, int dirty) {
+    return disk_handle_put_block(&g_disk_state, block_num, ptr, dirty);
+}
+
+int disk_aio_init(uint32_t queue_depth, int flags) {
+    return disk_handle_aio_init(&g_disk_state, queue_depth, flags);
+}
+
+int disk_aio_shutdown(void) {
+    return disk_handle_aio_shutdown(&g_disk_state);
+}
+
+int disk_aio_submit_read(uint64_t start_block, int block_count, char* buffer, uint64_t user_data) {
+    return disk_handle_aio_submit_read(&g_disk_state, start_block, block_count, buffer, user_data);
+}
+
+int disk_aio_submit_write(uint64_t start_block, int block_count, const char* data, uint64_t user_data) {
+    return disk_handle_aio_submit_write(&g_disk_state, start_block, block_count, data, user_data);
+}
+
+int disk_aio_reap(disk_aio_completion_t* completions, int max_completions, int min_completions) {
+    return disk_handle_aio_reap(&g_disk_state, completions, max_completions, min_completions);
+}
+
+const char* disk_aio_backend(void) {
+    return disk_handle_aio_backend(&g_disk_state);
+}
+
+int disk_zero_block(uint64_t block_num) {
+    return disk_handle_zero_block(&g_disk_state, block_num);
+}
+
+int disk_zero_blocks(uint64_t start_block, int block_count) {
+    return disk_handle_zero_blocks(&g_disk_state, start_block, block_count);
+}
+
+int disk_zero_blocks_background(uint64_t start_block, int block_count) {
+    return disk_handle_zero_blocks_background(&g_disk_state, start_block, block_count);
+}
+
+int disk_zero_blocks_claim(uint64_t block_num) {
+    return disk_handle_zero_blocks_claim(&g_disk_state, block_num);
+}
+
+int disk_zero_blocks_done(uint64_t start_block) {
+    return disk_handle_zero_blocks_done(&g_disk_state, start_block);
+}
+
+int disk_discard_blocks(uint64_t start_block, uint64_t block_count) {
+    return disk_handle_discard_blocks(&g_disk_state, start_block, block_count);
+}
+
+int disk_copy_block(uint64_t src_block, uint64_t dst_block) {
+    return disk_handle_copy_block(&g_disk_state, src_block, dst_block);
+}
+
+int disk_snapshot(const char* snapshot_name, int flags) {
+    return disk_handle_snapshot(&g_disk_state, snapshot_name, flags);
+}
+
+int disk_is_ram_disk(void) {
+    return disk_handle_is_ram_disk(&g_disk_state);
+}
+
+int disk_ram_dump(const char* image_file) {
+    return disk_handle_ram_dump(&g_disk_state, image_file);
+}
+
+const char* disk_backend_name(void) {
+    return disk_handle_backend_name(&g_disk_state);
+}
+
+int disk_trace_start(const char* trace_file) {
+    return disk_handle_trace_start(&g_disk_state, trace_file);
+}
+
+int disk_trace_stop(void) {
+    return disk_handle_trace_stop(&g_disk_state);
+}
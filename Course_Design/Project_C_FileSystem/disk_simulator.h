@@ -2,17 +2,35 @@
  * Disk Simulator Header
  * disk_simulator.h
  * 
- * Simulates a block-based disk using a single host OS file.
+ * Simulates a block-based disk using a single host OS file, a striped
+ * set of member files (see disk_set_striping()) or an in-memory image
+ * (see disk_set_ram_disk()).
  * Provides basic disk operations like read/write blocks with proper error handling.
  * 
  * This module abstracts the underlying file system and provides a clean
  * block-device interface for the file system implementation.
+ * 
+ * Block reads and writes may be issued from several threads at once: the
+ * disk file is accessed with positional I/O (pread/pwrite), statistics are
+ * updated atomically and the block cache is protected by its own lock.
+ * disk_init()/disk_close() must not race with I/O.
+ * 
+ * All state of an open disk lives in a disk_t. disk_open() returns an
+ * independent handle, so several images can be open in one process; the
+ * disk_handle_*() functions take the handle explicitly. The original
+ * disk_*() functions are thin wrappers that operate on the default disk
+ * (g_disk_state, see disk_default()).
  */
 
 #ifndef _DISK_SIMULATOR_H_
 #define _DISK_SIMULATOR_H_
 
-#define _POSIX_C_SOURCE 199309L
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // preadv/pwritev
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,15 +41,59 @@
 #include <stddef.h>
 #include <time.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include "block_cache.h"
+#include "aio_engine.h"
+#include "latency_hist.h"
+#include "crc32c.h"
+#include "stripe_set.h"
+#include "timing_model.h"
+#include "chunk_store.h"
+#include "dedup_store.h"
+#include "trace_log.h"
+#include "extent_set.h"
+#include "zero_detect.h"
 
 /*==============================================================================
  * DISK SIMULATOR CONSTANTS
  *============================================================================*/
 
-#define DISK_BLOCK_SIZE         1024        // Size of each disk block in bytes
+#define DISK_BLOCK_SIZE         1024        // Default block size for new disks (bytes)
+#define DISK_MIN_BLOCK_SIZE     1024        // Smallest supported block size
+#define DISK_MAX_BLOCK_SIZE     65536       // Largest supported block size
 #define DISK_MAX_FILENAME_LEN   256         // Maximum length of disk filename
 #define DISK_MAGIC_HEADER       0x44534B21  // "DSK!" - Disk magic number
-#define DISK_VERSION            1           // Disk format version
+#define DISK_VERSION            4           // Disk format version (1 = fixed 1KB blocks, 2 = legacy header checksum, 3 = 32-bit block count)
+#define DISK_CACHE_DEFAULT_BLOCKS 256       // Default block cache capacity (blocks)
+#define DISK_MAX_IOV_BLOCKS     256         // Maximum blocks per preadv/pwritev call
+#define DISK_AIO_DEFAULT_DEPTH  64          // Default async queue depth (requests)
+#define DISK_GROUP_COMMIT_BYTES (1024 * 1024) // Default pending bytes that force a group commit
+#define DISK_ZERO_CHUNK_BLOCKS  64          // Blocks cleared per step by the background zeroer
+#define DISK_IOQ_DEFAULT_DEPTH  128         // Default queued blocks that force a dispatch
+#define DISK_IOQ_DEFAULT_DEADLINE_US 10000  // Default longest wait of a queued write
+#define DISK_COMPRESS_DEFAULT_CHUNK_BLOCKS 16 // Suggested blocks per compressed chunk
+#define DISK_MAX_TABLE_BLOCKS   UINT32_MAX  // Largest block count of images with per-block tables
+#define DISK_DISCARD_MAX_EXTENTS 65536      // Discarded ranges remembered for zero-fill reads
+
+/* disk_header_t flags */
+#define DISK_FLAG_BLOCK_CHECKSUMS 0x01      // Image carries a CRC32C per block after the data area
+#define DISK_FLAG_CHECKSUMS_STALE 0x02      // Checksum table may lag the data (not closed cleanly)
+#define DISK_FLAG_STRIPED       0x04        // Image is one member of a striped set
+#define DISK_FLAG_COMPRESSED    0x08        // Blocks are stored as compressed chunks
+#define DISK_FLAG_OVERLAY       0x10        // Copy-on-write overlay on top of a snapshot image
+#define DISK_FLAG_SNAPSHOT      0x20        // Frozen snapshot image (opened read-only)
+#define DISK_FLAG_DEDUP         0x40        // Blocks are stored once per distinct contents
+
+/* disk_aio_init() flags */
+#define DISK_AIO_THREADS        0x01        // Use the worker-thread backend even if io_uring works
+
+/* disk_snapshot() flags */
+#define DISK_SNAPSHOT_NO_REFLINK 0x01       // Always use the internal overlay, never FICLONE
+
+/* disk_set_ram_disk() flags */
+#define DISK_RAM_HUGE_PAGES     0x01        // Ask for transparent huge pages for the mapped image
 
 /*==============================================================================
  * ERROR CODES
@@ -54,7 +116,9 @@ typedef enum {
     DISK_ERROR_ALREADY_INIT = -9,   // Disk already initialized
     DISK_ERROR_DISK_FULL    = -10,  // Disk is full
     DISK_ERROR_IO           = -11,  // General I/O error
-    DISK_ERROR_CORRUPTED    = -12   // Disk data corrupted
+    DISK_ERROR_CORRUPTED    = -12,  // Disk data corrupted
+    DISK_ERROR_BUSY         = -13,  // Async queue full, reap completions first
+    DISK_ERROR_CHECKSUM     = -14   // Block data does not match its stored checksum
 } disk_error_t;
 
 /*==============================================================================
@@ -66,24 +130,40 @@ typedef enum {
  * 
  * Stored at the beginning of the disk file to identify and validate
  * the disk format. Contains metadata about the disk layout.
+ * 
+ * Version 3 headers are protected by a CRC32C over every field except the
+ * timestamps and the checksum itself; older versions use a simple rotating
+ * sum over the fields before `created_time` and have `flags` set to zero.
+ * Version 4 adds the high half of the block count, so an image may hold up
+ * to 2^64 - 1 blocks; `disk_size` is then informational only (it saturates
+ * at UINT32_MAX) and the size is total_blocks * block_size.
  */
 typedef struct {
     uint32_t    magic_number;       // Magic number for identification
     uint32_t    version;            // Disk format version
     uint32_t    block_size;         // Size of each block
-    uint32_t    total_blocks;       // Total number of blocks on disk
-    uint32_t    disk_size;          // Total disk size in bytes
+    uint32_t    total_blocks;       // Total number of blocks on disk (low 32 bits)
+    uint32_t    disk_size;          // Total disk size in bytes (saturates at UINT32_MAX)
     time_t      created_time;       // Disk creation timestamp
     time_t      last_access_time;   // Last access timestamp
     uint32_t    checksum;           // Header checksum for integrity
-    uint8_t     reserved[32];       // Reserved space for future use
+    uint32_t    flags;              // DISK_FLAG_* feature bits (version 3+)
+    uint32_t    stripe_blocks;      // Stripe unit in blocks (DISK_FLAG_STRIPED only)
+    uint16_t    stripe_count;       // Number of member files in the set
+    uint16_t    stripe_index;       // Position of this file in the set
+    uint64_t    stripe_set_id;      // Random id shared by all members of a set
+    uint32_t    chunk_blocks;       // Blocks per compressed chunk (DISK_FLAG_COMPRESSED only)
+    uint32_t    backing_crc;        // CRC32C of the backing image name (DISK_FLAG_OVERLAY only)
+    uint32_t    total_blocks_hi;    // High 32 bits of the block count (version 4+)
 } __attribute__((packed)) disk_header_t;
 
 /**
  * Disk Statistics Structure
  * 
  * Maintains runtime statistics about disk operations
- * for performance monitoring and debugging.
+ * for performance monitoring and debugging. Latencies are kept as
+ * histograms (one sample per request, however many blocks it covers) so
+ * that tail percentiles can be queried with latency_hist_percentile().
  */
 typedef struct {
     uint64_t    total_reads;        // Total number of read operations
@@ -93,30 +173,158 @@ typedef struct {
     uint64_t    read_errors;        // Number of read errors
     uint64_t    write_errors;       // Number of write errors
     time_t      last_operation_time;// Time of last operation
-    double      avg_read_time;      // Average read time (seconds)
-    double      avg_write_time;     // Average write time (seconds)
+    latency_hist_t read_latency;    // Latency of each read request
+    latency_hist_t write_latency;   // Latency of each write request (until accepted)
+    latency_hist_t sync_latency;    // Latency of each fsync/fdatasync/msync pass
+    uint64_t    cache_hits;         // Block reads served from the cache
+    uint64_t    cache_misses;       // Block reads that went to the disk file
+    uint64_t    cache_writebacks;   // Dirty blocks written back to the disk file
+    uint64_t    vectored_ios;       // preadv/pwritev calls covering more than one block
+    uint64_t    zero_copy_gets;     // Blocks handed out in place by disk_get_block*()
+    uint64_t    aio_submitted;      // Async requests accepted
+    uint64_t    aio_completed;      // Async completions reaped
+    uint64_t    group_commits;      // Flushes issued by the group-commit thread
+    uint64_t    group_commit_writes;// Writes made durable by those flushes
+    uint64_t    blocks_zeroed;      // Blocks cleared by disk_zero_blocks() or in the background
+    uint64_t    checksum_errors;    // Blocks read from the image that failed verification
+    uint64_t    striped_ios;        // Block runs spread over several stripe members in parallel
+    uint64_t    readahead_blocks;   // Blocks loaded into the cache by disk_prefetch_blocks()
+    uint64_t    readahead_hits;     // Prefetched blocks later read from the cache
+    uint64_t    readahead_wasted;   // Prefetched blocks evicted or overwritten before any read
+    uint64_t    ioq_queued;         // Block writes accepted by disk_queue_write*()
+    uint64_t    ioq_absorbed;       // Queued writes replaced by a later one to the same block
+    uint64_t    ioq_dispatches;     // Batches the I/O scheduler sent to the backend
+    uint64_t    ioq_runs;           // Runs of consecutive blocks in those batches (one I/O each)
+    latency_hist_t device_latency;  // Modeled latency of each backend I/O and flush (timing model)
+    uint64_t    device_ios;         // Backend I/Os and flushes charged by the timing model
+    uint64_t    device_seeks;       // Those that needed a head seek (HDD profile)
+    uint64_t    device_time_ns;     // Total modeled device time
+    chunk_store_stats_t compression; // Chunk codec and space usage (compressed images only)
+    uint64_t    snapshots_reflinked;// Snapshots taken by cloning the image file (FICLONE)
+    uint64_t    snapshots_overlaid; // Snapshots taken by freezing the image under an overlay
+    uint64_t    overlay_redirects;  // First writes of a block redirected into the overlay
+    uint64_t    backing_reads;      // Block reads served by the frozen snapshot below the overlay
+    dedup_store_stats_t dedup;      // Fingerprint lookups and space sharing (dedup images only)
+    uint64_t    trace_records;      // Calls recorded by the I/O trace (disk_trace_start())
+    uint64_t    discard_requests;   // disk_discard_blocks() calls that succeeded
+    uint64_t    blocks_discarded;   // Blocks released by those calls
+    uint64_t    discard_zero_reads; // Block reads answered with zeros (block discarded or written as zeros)
+    uint64_t    zero_writes_skipped;// All-zero block writes dropped because the blocks were already holes
+    uint64_t    zero_writes_punched;// All-zero block writes turned into hole punches
+    uint64_t    bytes_write_avoided;// Bytes not written to the image because of those two
+    uint64_t    range_syncs;        // disk_sync_range() calls that succeeded
 } disk_stats_t;
 
+/**
+ * Scatter-Gather Block Descriptor
+ * 
+ * One (block number, buffer) pair for disk_readv_blocks() and
+ * disk_writev_blocks(). The buffer must hold one block.
+ */
+typedef struct {
+    uint64_t    block_num;          // Block number (0-based)
+    char        *buffer;            // Block data
+} disk_block_vec_t;
+
+/**
+ * Async Completion Structure
+ * 
+ * Returned by disk_aio_reap() for each finished request.
+ */
+typedef struct {
+    uint64_t    user_data;          // Tag given at submission
+    int         result;             // DISK_SUCCESS or negative error code
+} disk_aio_completion_t;
+
+/**
+ * Group Commit State
+ * 
+ * Writers register a sequence number and sleep until the flusher thread has
+ * covered it with one fdatasync() for the whole batch.
+ */
+typedef struct {
+    pthread_t       thread;         // Flusher thread
+    pthread_mutex_t lock;           // Protects the fields below
+    pthread_cond_t  wake;           // Wakes the flusher
+    pthread_cond_t  done;           // Wakes writers after a flush
+    uint8_t         running;        // Flusher thread is active
+    uint32_t        window_us;      // Longest a write waits for its flush
+    uint64_t        max_bytes;      // Pending bytes that trigger an early flush
+    uint64_t        write_seq;      // Last registered write
+    uint64_t        flushed_seq;    // Last write covered by a finished flush
+    uint64_t        durable_seq;    // Last write covered by a successful flush
+    uint64_t        pending_bytes;  // Bytes registered since the last flush began
+    uint64_t        pending_writes; // Writes registered since the last flush began
+    struct timespec first_pending;  // When the oldest pending write registered
+} disk_group_commit_t;
+
+/**
+ * Background Zeroing State
+ * 
+ * Blocks in [next, end) are still waiting to be zeroed. The zeroing thread
+ * and disk_zero_blocks_claim() both advance `next` under the lock.
+ */
+typedef struct {
+    pthread_t       thread;         // Zeroing thread
+    pthread_mutex_t lock;           // Protects the fields below
+    uint8_t         active;         // Thread started and not yet joined
+    uint8_t         stop;           // Asks the thread to exit early
+    uint64_t        start;          // First block of the current job
+    uint64_t        next;           // First block not yet zeroed
+    uint64_t        end;            // One past the last block of the job
+} disk_zeroer_t;
+
+/**
+ * I/O Scheduler Queue
+ * 
+ * Writes queued with disk_queue_write*() are copied here and wait until
+ * the queue is full, the oldest one reaches its deadline, or another
+ * access overlaps them. A dispatch sorts the whole batch by block number
+ * and writes it in one ascending sweep, one vectored I/O per run.
+ */
+typedef struct {
+    pthread_t       thread;         // Deadline thread
+    pthread_mutex_t lock;           // Protects the fields below
+    pthread_cond_t  wake;           // Wakes the deadline thread
+    uint8_t         running;        // Queue is enabled and the thread is active
+    uint32_t        depth;          // Queued blocks that force a dispatch
+    uint32_t        deadline_us;    // Longest a queued write waits
+    uint32_t        count;          // Blocks currently queued
+    uint64_t        low;            // Lowest queued block
+    uint64_t        high;           // Highest queued block
+    disk_block_vec_t *reqs;         // Queued blocks (buffers point into data)
+    char            *data;          // Copies of the queued blocks
+    struct timespec oldest;         // When the oldest queued write arrived
+    int             error;          // First background dispatch error not yet reported
+} disk_ioq_t;
+
+/* Storage backend operations table; the file:, mmap: and mem: backends live in disk_simulator.c */
+typedef struct disk_backend disk_backend_t;
+
 /**
  * Disk State Structure
  * 
  * Maintains the current state of the disk simulator.
  * Contains all information needed for disk operations.
  */
-typedef struct {
+typedef struct disk_state {
     /* File handling */
     int         fd;                 // File descriptor for disk file
-    char        filename[DISK_MAX_FILENAME_LEN]; // Path to disk file
+    char        filename[DISK_MAX_FILENAME_LEN]; // Path to disk file (without the backend prefix)
+    const disk_backend_t *backend;  // Storage backend the image was opened with
     
     /* Disk configuration */
-    uint32_t    total_blocks;       // Total number of blocks
-    uint32_t    block_size;         // Size of each block (should be DISK_BLOCK_SIZE)
+    uint64_t    total_blocks;       // Total number of blocks
+    uint32_t    block_size;         // Size of each block (from the disk header)
     uint64_t    disk_size;          // Total disk size in bytes
+    uint64_t    data_offset;        // File offset of block 0
     
     /* State flags */
     uint8_t     is_initialized;     // Whether disk is initialized
     uint8_t     is_read_only;       // Whether disk is read-only
     uint8_t     is_dirty;           // Whether disk has pending writes
+    uint8_t     is_ram;             // Image lives in a memfd (filename is only where it was loaded from)
+    uint8_t     ram_flags;          // DISK_RAM_* options of a RAM disk
     
     /* Statistics */
     disk_stats_t stats;             // Operation statistics
@@ -124,13 +332,72 @@ typedef struct {
     /* Synchronization and caching */
     uint8_t     auto_sync;          // Auto-sync after each write
     time_t      last_sync_time;     // Last synchronization time
+    block_cache_t *cache;           // Write-back block cache (NULL if disabled)
+    uint32_t    cache_capacity;     // Cache capacity in blocks (0 disables the cache)
+    pthread_mutex_t cache_lock;     // Protects cache and write_seq
+    uint64_t    write_seq;          // Bumped on every cached write (stale-fill guard)
+    
+    /* Memory-mapped mode */
+    char        *map_base;          // Mapping of the whole image file (NULL if not mapped)
+    size_t      map_size;           // Length of the mapping in bytes
+    uint8_t     *map_dirty;         // One bit per block modified since the last msync
+    
+    /* Asynchronous I/O */
+    aio_engine_t *aio;              // Async engine (NULL until disk_aio_init())
+    
+    /* Group commit */
+    disk_group_commit_t group_commit; // Durability batching (thread runs only if enabled)
+    
+    /* Background zeroing */
+    disk_zeroer_t zeroer;           // Lazy zeroing job (thread runs only while pending)
+    
+    /* I/O scheduling */
+    disk_ioq_t  ioq;                // Queued writes (thread runs only if enabled)
+    
+    /* Device timing */
+    timing_model_t *timing;         // Modeled device behind the image (NULL = host speed)
+    
+    /* Striping */
+    stripe_set_t *stripe;           // Member files and their I/O workers (NULL if not striped)
+    int         member_fds[STRIPE_SET_MAX_MEMBERS]; // Member descriptors (member 0 is fd)
+    uint32_t    member_count;       // Number of image files (1 if not striped)
+    uint64_t    member_blocks;      // Data blocks stored in each image file
+    
+    /* Compression */
+    chunk_store_t *chunks;          // Compressed chunk store (NULL if not compressed)
+    
+    /* Deduplication */
+    dedup_store_t *dedup;           // Deduplicating block store (NULL if not deduplicated)
+    
+    /* I/O trace */
+    trace_log_t *trace;             // Recorder of block I/O calls (NULL if not tracing)
+    
+    /* Discard */
+    extent_set_t *discarded;        // Discarded ranges not written since (NULL for images that track holes themselves)
+    
+    /* Snapshot overlay */
+    struct disk_state *backing;     // Frozen image unmodified blocks are read from (NULL if not an overlay)
+    uint32_t    *remap;             // Overlay slot + 1 of each block (0 = still in the backing image)
+    uint8_t     *remap_dirty;       // One bit per remap-table block not yet written back
+    uint32_t    remap_table_blocks; // Blocks occupied by the remap table
+    uint32_t    overlay_slots;      // Block slots allocated in the overlay file
+    uint64_t    overlay_offset;     // File offset of slot 0
+    
+    /* Per-block checksums */
+    uint32_t    *csums;             // CRC32C of each block as stored in the image (NULL if disabled)
+    uint8_t     *csum_dirty;        // One bit per checksum-table block not yet written back
+    uint32_t    csum_table_blocks;  // Blocks occupied by the checksum table
+    uint64_t    csum_offset;        // File offset of the checksum table
 } disk_state_t;
 
+/* Handle of an open disk */
+typedef disk_state_t disk_t;
+
 /*==============================================================================
  * GLOBAL VARIABLES
  *============================================================================*/
 
-/* Global disk state - external declaration */
+/* Global disk state (the default disk) - external declaration */
 extern disk_state_t g_disk_state;
 
 /*==============================================================================
@@ -141,38 +408,57 @@ extern disk_state_t g_disk_state;
  * Initialize the disk simulator
  * 
  * Creates or opens a file representing the disk. If the file doesn't exist,
- * it will be created with the specified size. If it exists, it will be
- * validated and opened for use.
+ * it will be created with the specified size and the block size set by
+ * disk_set_block_size(). If it exists, it will be validated and opened with
+ * the block size recorded in its header.
  * 
- * @param filename Path to the disk file
+ * The filename may start with a backend prefix that chooses where the image
+ * is stored and how its blocks are reached:
+ *   "file:<path>" - image file accessed with pread/pwrite through the block cache
+ *   "mmap:<path>" - image file accessed through a shared mapping (disk_set_mmap_mode())
+ *   "mem:<path>"  - image held in memory (disk_set_ram_disk()); "mem:" alone
+ *                   creates a scratch disk with no file behind it
+ * Without a prefix the backend follows disk_set_ram_disk() and
+ * disk_set_mmap_mode(). Images that cannot be mapped (striped, compressed,
+ * deduplicated or snapshot overlays) fall back from mmap: to file:.
+ * 
+ * @param filename Path to the disk file, optionally with a backend prefix
  * @param disk_size Size of the disk in bytes (must be multiple of block size)
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_init(const char* filename, int disk_size);
+int disk_init(const char* filename, uint64_t disk_size);
 
 /**
  * Write a block of data to the disk
  * 
- * Writes exactly one block (DISK_BLOCK_SIZE bytes) of data to the specified
+ * Writes exactly one block (disk_get_block_size() bytes) of data to the specified
  * block number. The block number is 0-based.
  * 
+ * When the block cache is enabled the write is buffered and reaches the disk
+ * file on eviction, disk_sync() or disk_close(). With auto_sync enabled the
+ * block is written through immediately.
+ * 
+ * All-zero blocks bound for a plain or striped image that is not mapped
+ * are not written: the block becomes a hole instead, or nothing happens if
+ * it already is one (stats.zero_writes_punched / zero_writes_skipped).
+ * 
  * @param block_num Block number to write to (0-based)
- * @param data Pointer to data buffer (must be at least DISK_BLOCK_SIZE bytes)
+ * @param data Pointer to data buffer (must be at least one block)
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_write_block(int block_num, const char* data);
+int disk_write_block(uint64_t block_num, const char* data);
 
 /**
  * Read a block of data from the disk
  * 
- * Reads exactly one block (DISK_BLOCK_SIZE bytes) of data from the specified
+ * Reads exactly one block (disk_get_block_size() bytes) of data from the specified
  * block number into the provided buffer.
  * 
  * @param block_num Block number to read from (0-based)
- * @param buffer Buffer to store read data (must be at least DISK_BLOCK_SIZE bytes)
+ * @param buffer Buffer to store read data (must be at least one block)
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_read_block(int block_num, char* buffer);
+int disk_read_block(uint64_t block_num, char* buffer);
 
 /*==============================================================================
  * EXTENDED DISK OPERATIONS
@@ -198,6 +484,43 @@ int disk_close(void);
  */
 int disk_sync(void);
 
+/**
+ * Synchronize disk writes without file metadata
+ * 
+ * Same as disk_sync() but the image is flushed with fdatasync(), which
+ * skips metadata the data does not depend on (such as timestamps).
+ * Recorded in an I/O trace as a disk_sync() call.
+ * 
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_sync_data(void);
+
+/**
+ * Synchronize a range of blocks
+ * 
+ * Makes every completed write to [start_block, start_block + block_count)
+ * durable. Queued writes are dispatched first. Only the cache's dirty
+ * blocks in the range are written back (in mmap mode only their pages are
+ * msync'ed); cached dirty blocks outside the range stay unflushed. The
+ * image is then flushed with sync_file_range() over the range followed by
+ * fdatasync(), which commits the range's allocation and the device cache
+ * but also writes back every dirty host page of the image file, so the
+ * host-side flush covers the whole image.
+ * 
+ * Images with block checksums, stripe sets, compressed and deduplicated
+ * images and snapshot overlays keep metadata for the range elsewhere in
+ * the image, so their image flush covers the whole image (data only).
+ * Counted in stats.range_syncs; an I/O trace records it as a sync with
+ * the range's first block and block count.
+ * 
+ * @param start_block First block to make durable
+ * @param block_count Number of blocks (at least 1)
+ * @return DISK_SUCCESS on success, DISK_ERROR_INVALID_PARAM for an empty
+ *         range, DISK_ERROR_BLOCK_RANGE if the range is beyond the disk,
+ *         or another negative error code on failure
+ */
+int disk_sync_range(uint64_t start_block, uint64_t block_count);
+
 /**
  * Get disk information
  * 
@@ -208,13 +531,158 @@ int disk_sync(void);
  * @param disk_size Pointer to store total disk size (can be NULL)
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_get_info(uint32_t* total_blocks, uint32_t* block_size, uint64_t* disk_size);
+int disk_get_info(uint64_t* total_blocks, uint32_t* block_size, uint64_t* disk_size);
+
+/**
+ * Set the block size for new disks
+ * 
+ * Applies to disk images created by later disk_init() calls; an existing
+ * image always opens with the block size stored in its header. Larger
+ * blocks (e.g. 4096 to match the host page size) cut per-block overhead
+ * for large transfers.
+ * 
+ * @param block_size Power of two between DISK_MIN_BLOCK_SIZE and DISK_MAX_BLOCK_SIZE
+ * @return DISK_SUCCESS on success, DISK_ERROR_INVALID_PARAM otherwise
+ */
+int disk_set_block_size(uint32_t block_size);
+
+/**
+ * Enable per-block checksums for new disks
+ * 
+ * Applies to disk images created by later disk_init() calls; an existing
+ * image keeps the setting recorded in its header. With checksums enabled
+ * the image stores a CRC32C for every block in a table after the data
+ * area. The checksum is updated whenever a block reaches the image file
+ * (or the mapping) and verified whenever a block is read back from it;
+ * blocks served from the block cache were verified when they were loaded.
+ * A mismatch fails the read with DISK_ERROR_CHECKSUM and is counted in
+ * stats.checksum_errors. The table itself is written back by disk_sync().
+ * 
+ * While the image is open its header carries DISK_FLAG_CHECKSUMS_STALE,
+ * cleared again by disk_close(). If an image is opened with the flag still
+ * set, the table may be older than the data, so it is rebuilt from the
+ * current block contents; blocks changed by the interrupted session are
+ * accepted unverified rather than reported as checksum failures.
+ * 
+ * @param enabled Non-zero to create images with block checksums
+ * @return DISK_SUCCESS
+ */
+int disk_set_checksums(int enabled);
+
+/**
+ * Check whether the open disk has per-block checksums
+ * 
+ * @return 1 if enabled, 0 if not (or no disk is open)
+ */
+int disk_has_checksums(void);
+
+/**
+ * Create new disks as compressed images
+ * 
+ * Applies to disk images created by later disk_init() calls; an existing
+ * image keeps the layout recorded in its header. A compressed image groups
+ * chunk_blocks consecutive blocks into a chunk, compresses each chunk with
+ * a built-in LZ77 codec and stores it as one variable-length extent,
+ * located through an index after the header (see chunk_store.h). Chunks
+ * that are all zeros take no space at all, so a new image is only the
+ * header and the index, and mostly empty or text-heavy images stay a
+ * fraction of their logical size. The block API is unchanged: partial
+ * chunk updates are merged in a small cache of decompressed chunks and
+ * compressed when evicted or at disk_sync().
+ * 
+ * Compressed images cannot be combined with striping or per-block
+ * checksums (disk_init() fails with DISK_ERROR_INVALID_PARAM; every chunk
+ * carries its own CRC32C instead), and use neither mmap mode nor
+ * disk_aio_init(). stats.compression reports the per-chunk compression
+ * ratio distribution and the CPU time of the codec.
+ * 
+ * @param chunk_blocks Blocks per chunk (0 = uncompressed images, the
+ *                     default); chunk_blocks * block size must not exceed
+ *                     CHUNK_STORE_MAX_CHUNK_BYTES
+ * @return DISK_SUCCESS or DISK_ERROR_INVALID_PARAM
+ */
+int disk_set_compression(uint32_t chunk_blocks);
+
+/**
+ * Get the chunk size of the open disk
+ * 
+ * @return Blocks per compressed chunk, 0 if the disk is not compressed
+ *         (or no disk is open)
+ */
+uint32_t disk_get_compression(void);
+
+/**
+ * Create new disks as deduplicated images
+ * 
+ * Applies to disk images created by later disk_init() calls; an existing
+ * image keeps the layout recorded in its header. A deduplicated image
+ * hashes every written block with a 128-bit fingerprint and looks it up in
+ * an in-memory fingerprint cache; a block whose contents are already
+ * stored becomes a reference to that copy instead of a second one, and
+ * all-zero blocks take no space at all (see dedup_store.h). Copies are
+ * reference counted, so overwriting or disk_zero_blocks() releases them.
+ * 
+ * Deduplicated images cannot be combined with striping, compression or
+ * per-block checksums (disk_init() fails with DISK_ERROR_INVALID_PARAM),
+ * and use neither mmap mode nor disk_aio_init(). stats.dedup reports the
+ * dedup ratio (referenced_blocks / stored_slots) and the cost of the
+ * fingerprint lookups.
+ * 
+ * @param enabled Nonzero for deduplicated images (default: disabled)
+ * @return DISK_SUCCESS
+ */
+int disk_set_dedup(int enabled);
+
+/**
+ * Check whether the open disk is deduplicated
+ * 
+ * @return 1 if deduplicated, 0 otherwise (or no disk is open)
+ */
+int disk_has_dedup(void);
+
+/**
+ * Choose the stripe layout for disks created by later disk_init() calls
+ * 
+ * With members > 1 a new image is split into that many files: member 0 is
+ * `filename` itself and member i is "<filename>.<i>". Logical blocks are
+ * dealt out round-robin in units of stripe_blocks blocks, and every member
+ * has its own descriptor and I/O worker, so multi-block reads and writes
+ * run on all members in parallel. The layout is recorded in every member's
+ * header; disk_init() on member 0 reassembles the set and fails if a
+ * member is missing or belongs to another set. Opening an existing image
+ * always uses its recorded layout. Striped sets use pread/pwrite only:
+ * mmap mode and disk_aio_init() are rejected. The checksum table, if
+ * any, lives in member 0.
+ * 
+ * @param members Number of member files (1..STRIPE_SET_MAX_MEMBERS, 1 = no striping)
+ * @param stripe_blocks Stripe unit in blocks (ignored for 1 member)
+ * @return DISK_SUCCESS or DISK_ERROR_INVALID_PARAM
+ */
+int disk_set_striping(uint32_t members, uint32_t stripe_blocks);
+
+/**
+ * Get the stripe layout of the open disk
+ * 
+ * @param members Receives the number of member files (1 when not striped)
+ * @param stripe_blocks Receives the stripe unit in blocks (0 when not striped)
+ * @return DISK_SUCCESS or DISK_ERROR_NOT_INIT
+ */
+int disk_get_striping(uint32_t* members, uint32_t* stripe_blocks);
+
+/**
+ * Get the block size
+ * 
+ * @return Block size of the open disk, or the size new disks will be
+ *         created with if no disk is open
+ */
+uint32_t disk_get_block_size(void);
 
 /**
  * Get disk statistics
  * 
  * Retrieves current disk operation statistics for monitoring
- * and performance analysis.
+ * and performance analysis. The latency histograms are consistent
+ * snapshots and may be combined with latency_hist_merge().
  * 
  * @param stats Pointer to disk_stats_t structure to fill
  * @return DISK_SUCCESS on success, negative error code on failure
@@ -230,6 +698,150 @@ int disk_get_stats(disk_stats_t* stats);
  */
 int disk_reset_stats(void);
 
+/**
+ * Configure the block cache
+ * 
+ * Sets the number of blocks kept in the write-back cache. Dirty blocks are
+ * written back before the cache is resized. A capacity of 0 disables the
+ * cache so every block operation goes straight to the disk file. The
+ * setting is remembered and applied to disks initialized later.
+ * 
+ * @param capacity_blocks Cache capacity in blocks (0 disables caching)
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_set_cache_capacity(uint32_t capacity_blocks);
+
+/**
+ * Configure group commit
+ * 
+ * In group-commit mode a block write is durable when it returns, as with
+ * auto_sync, but instead of one fsync() per write a background thread
+ * issues a single fdatasync() for all writes registered within a time
+ * window (or as soon as max_dirty_bytes are pending) and then wakes all of
+ * their writers at once. Durable write throughput thus grows with the
+ * number of concurrent writers instead of being capped by flush latency.
+ * Dirty blocks in the write-back cache are written back as part of each
+ * flush; in mmap mode the flush is an msync() of the dirty pages. Async
+ * writes are not covered (use disk_sync()). Like the cache capacity, the
+ * setting is remembered for disks initialized later. Must not be called
+ * while writes are in progress.
+ * 
+ * @param window_us Longest time a write waits for its flush, in microseconds
+ *                  (0 disables group commit)
+ * @param max_dirty_bytes Pending bytes that trigger an early flush
+ *                        (0 selects DISK_GROUP_COMMIT_BYTES)
+ * @return DISK_SUCCESS on success, DISK_ERROR_IO if the flusher thread
+ *         could not be started
+ */
+int disk_set_group_commit(uint32_t window_us, uint64_t max_dirty_bytes);
+
+/**
+ * Configure the device timing model
+ * 
+ * Makes every transfer between the simulator and its image file cost what
+ * it would on the chosen device (see timing_model.h): reads and writes
+ * that reach the file, cache write-back, zeroing and fsync/fdatasync.
+ * Cache hits cost nothing, so caching and scheduling policies can be
+ * compared against realistic devices. With real_delay the calling thread
+ * sleeps until the modeled completion; otherwise the time is virtual: it
+ * is added to the calling thread's clock, so it shows up in the read,
+ * write and sync latency histograms without slowing the run down. Either
+ * way each charged I/O is recorded in stats.device_latency and counted in
+ * device_ios/device_seeks/device_time_ns. mmap-mode block access and
+ * async I/O are not modeled. Like the cache capacity, the setting is
+ * remembered for disks initialized later. Must not be called while I/O is
+ * in progress.
+ * 
+ * @param profile Device to model (TIMING_PROFILE_NONE disables the model)
+ * @param bandwidth_limit Transfer rate cap in bytes per second (0 for the
+ *                        profile's own rate)
+ * @param real_delay Nonzero to really delay I/O, 0 for virtual time
+ * @return DISK_SUCCESS on success, DISK_ERROR_INVALID_PARAM for an unknown
+ *         profile, DISK_ERROR_IO if the model could not be created
+ */
+int disk_set_timing_model(timing_profile_t profile, uint64_t bandwidth_limit, int real_delay);
+
+/**
+ * Enable or disable memory-mapped mode
+ * 
+ * In mmap mode the whole image file is mapped with MAP_SHARED and block
+ * reads/writes become memcpy()s to and from the mapping. The block cache is
+ * not used while mapped (the page cache already plays that role), and
+ * disk_sync() calls msync() on the page ranges of blocks written since the
+ * last sync. Like the cache capacity, the setting is remembered for disks
+ * initialized later. Must not be called while block pointers obtained from
+ * disk_get_block()/disk_get_block_mut() are still held.
+ * 
+ * @param enabled Non-zero to map the image, 0 to use pread/pwrite
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_set_mmap_mode(int enabled);
+
+/**
+ * Check whether the open disk is memory-mapped
+ * 
+ * Callers use this to pick disk_get_block() (zero-copy only when mapped)
+ * over reading into their own buffer with disk_read_block().
+ * 
+ * @return 1 if the image is mapped, 0 otherwise
+ */
+int disk_is_mapped(void);
+
+/**
+ * Open later disks as RAM disks
+ * 
+ * Applies to disks opened by later disk_init()/disk_open() calls. A RAM
+ * disk keeps the whole image (header, data area and any tables) in an
+ * anonymous memfd instead of a file: if `filename` exists it is loaded
+ * into memory once, otherwise a new image is created in memory with the
+ * current configuration. Either way the file is never written; the image
+ * lives until disk_close() unless disk_ram_dump() saves it. The block API
+ * and image layout are unchanged. Plain images are opened in mmap mode
+ * whatever disk_set_mmap_mode() says, so block reads and writes are
+ * memory copies and disk_sync() has nothing to write back.
+ * 
+ * RAM disks cannot be striped or snapshotted (DISK_ERROR_INVALID_PARAM).
+ * With DISK_RAM_HUGE_PAGES the mapping is advised for transparent huge
+ * pages (madvise(MADV_HUGEPAGE)); whether the kernel grants them depends
+ * on its shmem huge page policy, and the disk works either way.
+ * 
+ * @param enabled Nonzero for RAM disks, 0 for image files (the default)
+ * @param flags DISK_RAM_* options
+ * @return DISK_SUCCESS or DISK_ERROR_INVALID_PARAM for unknown flags
+ */
+int disk_set_ram_disk(int enabled, int flags);
+
+/**
+ * Check whether the open disk is a RAM disk
+ * 
+ * @return 1 if the image lives in memory, 0 otherwise (or no disk is open)
+ */
+int disk_is_ram_disk(void);
+
+/**
+ * Save a RAM disk to an image file
+ * 
+ * Makes pending writes visible first (as disk_sync() does), then copies
+ * the image to a temporary file next to `image_file` (holes stay holes),
+ * syncs it and renames it into place, so the file is always either the
+ * old or the complete new image. The result is an ordinary image that
+ * disk_init() opens with or without RAM disks enabled. Writes issued
+ * while the dump runs may or may not be included.
+ * 
+ * @param image_file Destination (NULL = the filename the disk was opened with)
+ * @return DISK_SUCCESS, DISK_ERROR_INVALID_PARAM if the disk is not a RAM
+ *         disk, DISK_ERROR_BUSY while asynchronous requests are in flight,
+ *         DISK_ERROR_FILE_CREATE/DISK_ERROR_FILE_WRITE on failure
+ */
+int disk_ram_dump(const char* image_file);
+
+/**
+ * Get the storage backend of the open disk
+ * 
+ * @return "file", "mmap" or "mem", or "none" if no disk is open
+ */
+const char* disk_backend_name(void);
+
 /*==============================================================================
  * UTILITY FUNCTIONS
  *============================================================================*/
@@ -256,7 +868,7 @@ int disk_is_initialized(void);
  * 
  * @return Number of blocks on disk, or 0 if not initialized
  */
-uint32_t disk_get_block_count(void);
+uint64_t disk_get_block_count(void);
 
 /**
  * Validate block number
@@ -266,13 +878,16 @@ uint32_t disk_get_block_count(void);
  * @param block_num Block number to validate
  * @return 1 if valid, 0 if invalid
  */
-int disk_is_valid_block(int block_num);
+int disk_is_valid_block(uint64_t block_num);
 
 /**
  * Format disk with pattern
  * 
  * Fills the entire disk with a specified byte pattern.
- * Useful for initialization and testing.
+ * Useful for initialization and testing. A zero pattern punches a hole over
+ * the whole disk, so it usually costs a single fallocate() instead of
+ * writing every block, and later all-zero writes are skipped; other patterns are written with one pwritev() per
+ * DISK_MAX_IOV_BLOCKS blocks. Any background zeroing job is cancelled.
  * 
  * @param pattern Byte pattern to fill disk with
  * @return DISK_SUCCESS on success, negative error code on failure
@@ -295,25 +910,129 @@ void disk_print_status(void);
  * Write multiple consecutive blocks
  * 
  * Writes multiple blocks starting from the specified block number.
+ * Without the cache (or with auto_sync) the range is written with one
+ * pwritev() per DISK_MAX_IOV_BLOCKS blocks.
  * 
  * @param start_block Starting block number
  * @param block_count Number of blocks to write
- * @param data Data buffer (must be at least block_count * DISK_BLOCK_SIZE bytes)
+ * @param data Data buffer (must be at least block_count blocks)
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_write_blocks(int start_block, int block_count, const char* data);
+int disk_write_blocks(uint64_t start_block, int block_count, const char* data);
 
 /**
  * Read multiple consecutive blocks
  * 
  * Reads multiple blocks starting from the specified block number.
+ * Blocks not found in the cache are read with one preadv() per run
+ * of consecutive misses.
  * 
  * @param start_block Starting block number
  * @param block_count Number of blocks to read
- * @param buffer Buffer to store data (must be at least block_count * DISK_BLOCK_SIZE bytes)
+ * @param buffer Buffer to store data (must be at least block_count blocks)
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_read_blocks(int start_block, int block_count, char* buffer);
+int disk_read_blocks(uint64_t start_block, int block_count, char* buffer);
+
+/**
+ * Scatter-gather block read
+ * 
+ * Reads an arbitrary set of blocks, each into its own buffer. Requests are
+ * sorted by block number and adjacent blocks are merged into a single
+ * preadv() call. The caller's array is not modified.
+ * 
+ * @param vec Array of (block number, buffer) pairs
+ * @param count Number of entries in vec
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_readv_blocks(const disk_block_vec_t* vec, int count);
+
+/**
+ * Scatter-gather block write
+ * 
+ * Writes an arbitrary set of blocks, each from its own buffer. Requests are
+ * sorted by block number and adjacent blocks are merged into a single
+ * pwritev() call. If a block appears more than once the last entry wins.
+ * 
+ * @param vec Array of (block number, buffer) pairs
+ * @param count Number of entries in vec
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_writev_blocks(const disk_block_vec_t* vec, int count);
+
+/**
+ * Load blocks into the block cache ahead of use (readahead)
+ * 
+ * Blocks already cached or out of range are skipped; the rest are sorted
+ * and read with one preadv() per run of consecutive blocks, then cached
+ * tagged as prefetched. A later read of such a block counts in
+ * stats.readahead_hits; eviction or overwrite before any read counts in
+ * stats.readahead_wasted. Prefetching is not counted as a read request.
+ * In mmap mode the kernel is asked to read the mapped pages ahead
+ * (MADV_WILLNEED); without a block cache the call does nothing.
+ * 
+ * @param block_nums Blocks expected to be read soon (any order)
+ * @param count Number of entries in block_nums
+ * @return Number of blocks read into the cache, or negative error code
+ */
+int disk_prefetch_blocks(const uint64_t* block_nums, int count);
+
+/**
+ * Configure the I/O scheduler queue
+ * 
+ * With the queue enabled, disk_queue_write() and disk_queue_writev() copy
+ * blocks into the queue and return at once; a later write to a queued
+ * block replaces it. The queue is dispatched when depth blocks are
+ * waiting, when the oldest has waited deadline_us (a background thread
+ * enforces this so nothing starves), or by disk_dispatch(), disk_sync()
+ * and disk_close(). A dispatch sorts the batch by block number and writes
+ * each run of consecutive blocks with one pwritev(), through the cache or
+ * mapping as an ordinary write would. Any other access to a queued block
+ * dispatches the queue first, so reads always see queued data. Like group
+ * commit, the setting is remembered for disks initialized later. Must not
+ * be called while I/O is in progress.
+ * 
+ * @param depth Queued blocks that force a dispatch (0 disables the queue;
+ *              queued writes are dispatched first)
+ * @param deadline_us Longest time a queued write waits, in microseconds
+ *                    (0 selects DISK_IOQ_DEFAULT_DEADLINE_US)
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_set_io_queue(uint32_t depth, uint32_t deadline_us);
+
+/**
+ * Queue a block write for the I/O scheduler
+ * 
+ * Without a queue this is disk_write_block(). A queued write counts in
+ * total_writes when it is dispatched; it is durable only after a
+ * successful disk_sync().
+ * 
+ * @param block_num Block number to write
+ * @param data Block data (copied)
+ * @return DISK_SUCCESS on success, negative error code on failure
+ *         (including an earlier background dispatch that failed)
+ */
+int disk_queue_write(uint64_t block_num, const char* data);
+
+/**
+ * Queue a set of block writes for the I/O scheduler
+ * 
+ * Without a queue this is disk_writev_blocks(). If a block appears more
+ * than once the last entry wins.
+ * 
+ * @param vec Array of (block number, buffer) pairs (buffers are copied)
+ * @param count Number of entries in vec
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_queue_writev(const disk_block_vec_t* vec, int count);
+
+/**
+ * Dispatch all queued writes now
+ * 
+ * @return DISK_SUCCESS on success, negative error code if this or an
+ *         earlier background dispatch failed
+ */
+int disk_dispatch(void);
 
 /**
  * Zero out a block
@@ -323,7 +1042,87 @@ int disk_read_blocks(int start_block, int block_count, char* buffer);
  * @param block_num Block number to zero out
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_zero_block(int block_num);
+int disk_zero_block(uint64_t block_num);
+
+/**
+ * Zero a range of blocks
+ * 
+ * Clears the blocks without transferring data where the host file system
+ * allows it: the range becomes unwritten extents through
+ * fallocate(FALLOC_FL_ZERO_RANGE), or is deallocated with
+ * FALLOC_FL_PUNCH_HOLE if that is not supported. Otherwise zeros are
+ * written with one pwritev() per DISK_MAX_IOV_BLOCKS blocks. Cached copies
+ * of the blocks are dropped. The blocks are counted in stats.blocks_zeroed
+ * rather than total_writes.
+ * 
+ * @param start_block First block to zero
+ * @param block_count Number of blocks to zero
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_zero_blocks(uint64_t start_block, int block_count);
+
+/**
+ * Zero a range of blocks in the background
+ * 
+ * Starts a thread that zeroes the range DISK_ZERO_CHUNK_BLOCKS blocks at a
+ * time, as disk_zero_blocks() would. A previous job is stopped first; blocks
+ * it had not reached are left as they were. Pending blocks must not be
+ * written before they are claimed with disk_zero_blocks_claim(), or the
+ * thread may clear them afterwards. disk_close() stops the thread.
+ * 
+ * @param start_block First block to zero
+ * @param block_count Number of blocks to zero
+ * @return DISK_SUCCESS on success, DISK_ERROR_IO if the thread could not
+ *         be started, other negative error code on failure
+ */
+int disk_zero_blocks_background(uint64_t start_block, int block_count);
+
+/**
+ * Claim a block from the background zeroing job
+ * 
+ * If the block is still pending it is zeroed right away, together with
+ * every pending block before it, and the thread carries on after it. The
+ * block may be written freely once this returns 1.
+ * 
+ * @param block_num Block the caller is about to use
+ * @return 1 if the block belongs to the current job and has been zeroed,
+ *         0 if it is outside the job (or no job was started),
+ *         negative error code on failure
+ */
+int disk_zero_blocks_claim(uint64_t block_num);
+
+/**
+ * Report how far the background zeroing job has got
+ * 
+ * Blocks of the current job before its next pending block are zero on
+ * disk. This lets a caller that keeps its own high-water mark (such as
+ * the lazy inode table) record the thread's progress.
+ * 
+ * @param start_block First block of interest
+ * @return Number of consecutive zeroed blocks from start_block, 0 if
+ *         start_block is outside the current job (or no job was started),
+ *         negative error code on failure
+ */
+int disk_zero_blocks_done(uint64_t start_block);
+
+/**
+ * Discard a range of blocks
+ * 
+ * Tells the disk the blocks are no longer in use. Their space is returned
+ * to the host file system with fallocate(FALLOC_FL_PUNCH_HOLE), so the
+ * image shrinks instead of keeping stale data forever (compressed and
+ * deduplicated images drop the blocks from their index, overlays mark them
+ * zero). Until a block is written again it reads back as zeros: plain and
+ * striped images remember the discarded ranges and fill such reads in
+ * memory without any I/O, counted in stats.discard_zero_reads. If holes
+ * cannot be punched, zeros are written instead. Cached copies are dropped
+ * and queued writes to the range are dispatched first.
+ * 
+ * @param start_block First block to discard
+ * @param block_count Number of blocks to discard
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_discard_blocks(uint64_t start_block, uint64_t block_count);
 
 /**
  * Copy block data
@@ -334,38 +1133,373 @@ int disk_zero_block(int block_num);
  * @param dst_block Destination block number
  * @return DISK_SUCCESS on success, negative error code on failure
  */
-int disk_copy_block(int src_block, int dst_block);
+int disk_copy_block(uint64_t src_block, uint64_t dst_block);
+
+/*==============================================================================
+ * SNAPSHOTS
+ *============================================================================*/
+
+/**
+ * Take a point-in-time snapshot of the open disk
+ * 
+ * Pending writes (block cache, I/O queue, background zeroing) are made
+ * durable first, so the snapshot holds every write that returned before
+ * the call. The snapshot is an ordinary image file: disk_open() on it
+ * gives a read-only disk that reads through the usual disk_read_block()
+ * path, and writes to it fail with DISK_ERROR_IO. The open disk keeps
+ * its filename and stays writable.
+ * 
+ * Neither method copies blocks, so the cost does not depend on the size
+ * of the image:
+ *   - On hosts that support reflinks (Btrfs, XFS) the image file is cloned
+ *     with the FICLONE ioctl into `snapshot_name`; the two files share
+ *     their extents until either is written.
+ *   - Otherwise the current image file is renamed to `snapshot_name` and
+ *     frozen (DISK_FLAG_SNAPSHOT), and a new overlay image
+ *     (DISK_FLAG_OVERLAY) is created under the original name. The overlay
+ *     holds a remap table from block numbers to slots in the overlay file:
+ *     the first write of a block is redirected to a new slot, later writes
+ *     overwrite it in place, and blocks never written since the snapshot
+ *     are read from the frozen image. Overlays chain: a snapshot of an
+ *     overlay freezes the overlay and stacks a new one on top.
+ * 
+ * The overlay records the snapshot name as given, so relative names must
+ * stay valid from the working directory the disk is reopened from. The
+ * frozen image keeps its layout (checksums, compression, striping; striped
+ * members are renamed to "<snapshot_name>.<i>"), while the overlay itself
+ * is a plain image that uses neither mmap mode nor disk_aio_init().
+ * Like disk_close(), it must not run concurrently with other operations
+ * on the same disk. stats.snapshots_reflinked and
+ * stats.snapshots_overlaid count the snapshots taken each way;
+ * overlay_redirects and backing_reads show the overlay at work.
+ * 
+ * @param snapshot_name Path of the snapshot image (must not exist)
+ * @param flags DISK_SNAPSHOT_NO_REFLINK to skip the FICLONE attempt
+ * @return DISK_SUCCESS on success, DISK_ERROR_FILE_CREATE if the snapshot
+ *         file exists or cannot be created, DISK_ERROR_BUSY while async
+ *         requests are outstanding, other negative error code on failure
+ */
+int disk_snapshot(const char* snapshot_name, int flags);
+
+/*==============================================================================
+ * I/O TRACING
+ *============================================================================*/
+
+/**
+ * Start recording block I/O calls to a trace file
+ * 
+ * Every later disk_read_block(), disk_write_block(), disk_read_blocks(),
+ * disk_write_blocks() and disk_sync() call appends one record (issue
+ * timestamp, operation, first block, block count, latency and result; see
+ * trace_log.h). Records are buffered in memory and appended to the file in
+ * batches. The trace ends with disk_trace_stop() or disk_close(); the
+ * disk_replay program re-issues it against any disk configuration.
+ * Like disk_close(), starting and stopping must not run concurrently
+ * with I/O on the same disk.
+ * 
+ * @param trace_file Trace file to create (replaced if it exists)
+ * @return DISK_SUCCESS, DISK_ERROR_BUSY if a trace is already running,
+ *         DISK_ERROR_FILE_CREATE if the file cannot be created
+ */
+int disk_trace_start(const char* trace_file);
+
+/**
+ * Stop recording and write out the buffered records
+ * 
+ * @return DISK_SUCCESS, DISK_ERROR_INVALID_PARAM if no trace is running,
+ *         DISK_ERROR_FILE_WRITE if part of the trace could not be written
+ */
+int disk_trace_stop(void);
+
+/*==============================================================================
+ * ZERO-COPY BLOCK ACCESS
+ *============================================================================*/
+
+/**
+ * Get a read-only pointer to a block
+ * 
+ * In mmap mode the pointer refers directly to the mapped image, so no copy
+ * is made. Otherwise a private copy of the block is returned. Either way
+ * the pointer must be handed back with disk_put_block().
+ * 
+ * @param block_num Block number (0-based)
+ * @param ptr Receives a pointer to one block of data
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_get_block(uint64_t block_num, const char** ptr);
+
+/**
+ * Get a writable pointer to a block
+ * 
+ * Same as disk_get_block(), but the block may be modified in place.
+ * Changes are only guaranteed to reach the disk if the pointer is
+ * released with disk_put_block(..., dirty = 1).
+ * 
+ * @param block_num Block number (0-based)
+ * @param ptr Receives a pointer to one block of data
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_get_block_mut(uint64_t block_num, char** ptr);
+
+/**
+ * Release a block pointer
+ * 
+ * @param block_num Block number the pointer was obtained for
+ * @param ptr Pointer returned by disk_get_block()/disk_get_block_mut()
+ * @param dirty Non-zero if the block was modified
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_put_block(uint64_t block_num, const char* ptr, int dirty);
+
+/*==============================================================================
+ * ASYNCHRONOUS BLOCK I/O
+ *============================================================================*/
+
+/**
+ * Set up asynchronous I/O
+ * 
+ * Creates the async engine for the current disk: io_uring when the kernel
+ * supports it, otherwise a pool of worker threads. The engine is torn down
+ * by disk_aio_shutdown() or disk_close().
+ * 
+ * Async requests bypass the write-back cache: reads that are fully cached
+ * complete immediately, dirty cached blocks in a read range are flushed
+ * first, and writes drop the cached copies of their blocks. Reading a block
+ * while an async write to it is in flight returns undefined data. In mmap
+ * mode requests are served from the mapping and complete immediately.
+ * 
+ * @param queue_depth Maximum requests outstanding (0 = DISK_AIO_DEFAULT_DEPTH)
+ * @param flags DISK_AIO_THREADS to force the thread-pool backend
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_aio_init(uint32_t queue_depth, int flags);
+
+/**
+ * Tear down asynchronous I/O
+ * 
+ * Waits for requests in flight; completions not yet reaped are processed
+ * (block checksums recorded) and then discarded.
+ * 
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_aio_shutdown(void);
+
+/**
+ * Submit an asynchronous read of consecutive blocks
+ * 
+ * @param start_block First block to read
+ * @param block_count Number of blocks
+ * @param buffer Destination (block_count blocks), must stay
+ *               valid until the completion is reaped
+ * @param user_data Tag returned with the completion
+ * @return DISK_SUCCESS if queued, DISK_ERROR_BUSY if the queue is full,
+ *         other negative error code on failure
+ */
+int disk_aio_submit_read(uint64_t start_block, int block_count, char* buffer, uint64_t user_data);
+
+/**
+ * Submit an asynchronous write of consecutive blocks
+ * 
+ * The data reaches the disk file when the completion is reported; call
+ * disk_sync() afterwards for durability. With block checksums the new
+ * checksums are recorded when a successful completion is reaped, so the
+ * blocks should not be read while the write is in flight.
+ * 
+ * @param start_block First block to write
+ * @param block_count Number of blocks
+ * @param data Source (block_count blocks), must stay valid
+ *             until the completion is reaped
+ * @param user_data Tag returned with the completion
+ * @return DISK_SUCCESS if queued, DISK_ERROR_BUSY if the queue is full,
+ *         other negative error code on failure
+ */
+int disk_aio_submit_write(uint64_t start_block, int block_count, const char* data, uint64_t user_data);
+
+/**
+ * Reap async completions
+ * 
+ * Issues queued requests and waits until at least `min_completions` have
+ * finished (capped at the number outstanding).
+ * 
+ * @param completions Array receiving the completions
+ * @param max_completions Capacity of the array
+ * @param min_completions Number of completions to wait for (0 = don't block)
+ * @return Number of completions stored, or negative error code on failure
+ */
+int disk_aio_reap(disk_aio_completion_t* completions, int max_completions, int min_completions);
+
+/**
+ * Name of the async backend in use
+ * 
+ * @return "io_uring", "threads", or "none" if async I/O is not set up
+ */
+const char* disk_aio_backend(void);
+
+/*==============================================================================
+ * DISK HANDLES
+ *============================================================================*/
+
+/**
+ * Open or create a disk image as an independent handle
+ * 
+ * Behaves like disk_init() but stores the disk in a new disk_t instead of
+ * the default disk, so any number of images can be open at once. Settings
+ * for new disks (block size, checksums, striping, compression, cache capacity, mmap,
+ * group commit, I/O queue and timing model) are taken from the disk_set_*() configuration as for
+ * disk_init().
+ * 
+ * @param filename Path to the disk file
+ * @param disk_size Size of the disk in bytes (used when creating)
+ * @param disk Receives the new handle on success
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_open(const char* filename, uint64_t disk_size, disk_t** disk);
+
+/**
+ * Close a handle returned by disk_open() and free it
+ * 
+ * @param disk Handle to close (must not be the default disk)
+ * @return DISK_SUCCESS on success, negative error code on failure
+ */
+int disk_handle_close(disk_t* disk);
+
+/**
+ * Get the handle of the default disk used by the disk_*() functions
+ * 
+ * @return Handle of g_disk_state (valid even while no disk is open)
+ */
+disk_t* disk_default(void);
+
+/*
+ * Per-handle operations. Each disk_handle_<op>(disk, ...) does exactly
+ * what disk_<op>(...) documents below, on the given disk instead of the
+ * default one. Handles are independent; one handle follows the same
+ * threading rules as the default disk.
+ */
+
+/* Block I/O */
+int disk_handle_read_block(disk_t* disk, uint64_t block_num, char* buffer);
+int disk_handle_write_block(disk_t* disk, uint64_t block_num, const char* data);
+int disk_handle_read_blocks(disk_t* disk, uint64_t start_block, int block_count, char* buffer);
+int disk_handle_write_blocks(disk_t* disk, uint64_t start_block, int block_count, const char* data);
+int disk_handle_readv_blocks(disk_t* disk, const disk_block_vec_t* vec, int count);
+int disk_handle_writev_blocks(disk_t* disk, const disk_block_vec_t* vec, int count);
+int disk_handle_prefetch_blocks(disk_t* disk, const uint64_t* block_nums, int count);
+int disk_handle_queue_write(disk_t* disk, uint64_t block_num, const char* data);
+int disk_handle_queue_writev(disk_t* disk, const disk_block_vec_t* vec, int count);
+int disk_handle_dispatch(disk_t* disk);
+
+/* Durability and statistics */
+int disk_handle_sync(disk_t* disk);
+int disk_handle_sync_data(disk_t* disk);
+int disk_handle_sync_range(disk_t* disk, uint64_t start_block, uint64_t block_count);
+int disk_handle_get_stats(disk_t* disk, disk_stats_t* stats);
+int disk_handle_reset_stats(disk_t* disk);
+void disk_handle_print_status(disk_t* disk);
+
+/* Disk information */
+int disk_handle_get_info(disk_t* disk, uint64_t* total_blocks, uint32_t* block_size,
+                         uint64_t* disk_size);
+uint32_t disk_handle_get_block_size(disk_t* disk);
+uint64_t disk_handle_get_block_count(disk_t* disk);
+int disk_handle_is_initialized(disk_t* disk);
+int disk_handle_is_valid_block(disk_t* disk, uint64_t block_num);
+int disk_handle_is_mapped(disk_t* disk);
+int disk_handle_has_checksums(disk_t* disk);
+int disk_handle_get_striping(disk_t* disk, uint32_t* members, uint32_t* stripe_blocks);
+uint32_t disk_handle_get_compression(disk_t* disk);
+int disk_handle_has_dedup(disk_t* disk);
+int disk_handle_is_ram_disk(disk_t* disk);
+
+/*
+ * Configuration of an open disk. These change only the given disk and
+ * return DISK_ERROR_NOT_INIT if it is not open; the disk_set_*() forms
+ * also remember the setting for disks opened later.
+ */
+int disk_handle_set_cache_capacity(disk_t* disk, uint32_t capacity_blocks);
+int disk_handle_set_mmap_mode(disk_t* disk, int enabled);
+int disk_handle_set_group_commit(disk_t* disk, uint32_t window_us, uint64_t max_dirty_bytes);
+int disk_handle_set_io_queue(disk_t* disk, uint32_t depth, uint32_t deadline_us);
+int disk_handle_set_timing_model(disk_t* disk, timing_profile_t profile, uint64_t bandwidth_limit,
+                                 int real_delay);
+
+/* Zero-copy access */
+int disk_handle_get_block(disk_t* disk, uint64_t block_num, const char** ptr);
+int disk_handle_get_block_mut(disk_t* disk, uint64_t block_num, char** ptr);
+int disk_handle_put_block(disk_t* disk, uint64_t block_num, const char* ptr, int dirty);
+
+/* Block utilities */
+int disk_handle_format(disk_t* disk, uint8_t pattern);
+int disk_handle_zero_block(disk_t* disk, uint64_t block_num);
+int disk_handle_zero_blocks(disk_t* disk, uint64_t start_block, int block_count);
+int disk_handle_zero_blocks_background(disk_t* disk, uint64_t start_block, int block_count);
+int disk_handle_zero_blocks_claim(disk_t* disk, uint64_t block_num);
+int disk_handle_zero_blocks_done(disk_t* disk, uint64_t start_block);
+int disk_handle_discard_blocks(disk_t* disk, uint64_t start_block, uint64_t block_count);
+int disk_handle_copy_block(disk_t* disk, uint64_t src_block, uint64_t dst_block);
+
+/* Snapshots */
+int disk_handle_snapshot(disk_t* disk, const char* snapshot_name, int flags);
+
+/* RAM disks */
+int disk_handle_ram_dump(disk_t* disk, const char* image_file);
+const char* disk_handle_backend_name(disk_t* disk);
+
+/* I/O tracing */
+int disk_handle_trace_start(disk_t* disk, const char* trace_file);
+int disk_handle_trace_stop(disk_t* disk);
+
+/* Asynchronous I/O */
+int disk_handle_aio_init(disk_t* disk, uint32_t queue_depth, int flags);
+int disk_handle_aio_shutdown(disk_t* disk);
+int disk_handle_aio_submit_read(disk_t* disk, uint64_t start_block, int block_count, char* buffer,
+                                uint64_t user_data);
+int disk_handle_aio_submit_write(disk_t* disk, uint64_t start_block, int block_count,
+                                 const char* data, uint64_t user_data);
+int disk_handle_aio_reap(disk_t* disk, disk_aio_completion_t* completions, int max_completions,
+                         int min_completions);
+const char* disk_handle_aio_backend(disk_t* disk);
 
 /*==============================================================================
  * MACROS AND INLINE FUNCTIONS
  *============================================================================*/
 
-/* Block size validation */
-#define DISK_IS_BLOCK_ALIGNED(size) ((size) % DISK_BLOCK_SIZE == 0)
+/* Supported block size check (power of two within the allowed range) */
+#define DISK_IS_VALID_BLOCK_SIZE(size) \
+    ((size) >= DISK_MIN_BLOCK_SIZE && (size) <= DISK_MAX_BLOCK_SIZE && \
+     ((size) & ((size) - 1)) == 0)
+
+/* Block size validation (against the open disk) */
+#define DISK_IS_BLOCK_ALIGNED(size) ((size) % g_disk_state.block_size == 0)
 
 /* Block number to byte offset conversion */
-#define DISK_BLOCK_TO_OFFSET(block_num) \
-    (sizeof(disk_header_t) + ((uint64_t)(block_num) * DISK_BLOCK_SIZE))
+#define DISK_BLOCK_OFFSET(disk, block_num) \
+    ((disk)->data_offset + ((uint64_t)(block_num) * (disk)->block_size))
+#define DISK_BLOCK_TO_OFFSET(block_num) DISK_BLOCK_OFFSET(&g_disk_state, block_num)
 
 /* Byte offset to block number conversion */
 #define DISK_OFFSET_TO_BLOCK(offset) \
-    (((offset) - sizeof(disk_header_t)) / DISK_BLOCK_SIZE)
+    (((offset) - g_disk_state.data_offset) / g_disk_state.block_size)
 
 /* Calculate number of blocks needed for given size */
 #define DISK_SIZE_TO_BLOCKS(size) \
-    (((size) + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE)
+    (((size) + g_disk_state.block_size - 1) / g_disk_state.block_size)
 
 /* Calculate total file size including header */
-#define DISK_TOTAL_FILE_SIZE(blocks) \
-    (sizeof(disk_header_t) + ((uint64_t)(blocks) * DISK_BLOCK_SIZE))
+#define DISK_FILE_SIZE(disk, blocks) \
+    ((disk)->data_offset + ((uint64_t)(blocks) * (disk)->block_size))
+#define DISK_TOTAL_FILE_SIZE(blocks) DISK_FILE_SIZE(&g_disk_state, blocks)
 
 /**
  * Fast block bounds checking (inline for performance)
  */
-static inline int disk_check_block_bounds(int block_num) {
-    return (block_num >= 0 && 
-            g_disk_state.is_initialized && 
-            (uint32_t)block_num < g_disk_state.total_blocks);
+static inline int disk_block_in_range(const disk_t* disk, uint64_t block_num) {
+    return (disk->is_initialized && 
+            block_num < disk->total_blocks);
+}
+
+static inline int disk_check_block_bounds(uint64_t block_num) {
+    return disk_block_in_range(&g_disk_state, block_num);
 }
 
 #endif /* _DISK_SIMULATOR_H_ */ 
\ No newline at end of file
@@ -10,6 +10,9 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <signal.h>
 #include "disk_simulator.h"
 
 #define TEST_DISK_FILE "test_disk.img"
@@ -96,8 +99,8 @@ int test_disk_init(void) {
     TEST_ASSERT(result == DISK_ERROR_ALREADY_INIT, "重复初始化应该返回已初始化错误");
     
     // 验证磁盘信息
-    uint32_t total_blocks, block_size;
-    uint64_t disk_size;
+    uint64_t total_blocks, disk_size;
+    uint32_t block_size;
     result = disk_get_info(&total_blocks, &block_size, &disk_size);
     TEST_ASSERT(result == DISK_SUCCESS, "获取磁盘信息应该成功");
     TEST_ASSERT(total_blocks == TEST_BLOCK_COUNT, "块数应该正确");
@@ -267,7 +270,7 @@ int test_utility_functions(void) {
     TEST_ASSERT(!disk_is_valid_block(-1), "负数块号应该无效");
     
     // 测试获取块数
-    uint32_t block_count = disk_get_block_count();
+    uint64_t block_count = disk_get_block_count();
     TEST_ASSERT(block_count == TEST_BLOCK_COUNT, "获取的块数应该正确");
     
     // 测试清零块
@@ -395,6 +398,1918 @@ int test_disk_persistence(void) {
     return 1;
 }
 
+/**
+ * 测试块缓存
+ */
+int test_block_cache(void) {
+    TEST_START("块缓存");
+    
+    cleanup_test_env();
+    int result = disk_set_cache_capacity(4);
+    TEST_ASSERT(result == DISK_SUCCESS, "设置缓存容量应该成功");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    // 写入超过缓存容量的块，迫使脏块被淘汰回写
+    char buffer[DISK_BLOCK_SIZE];
+    for (int i = 0; i < 10; i++) {
+        memset(buffer, 'a' + i, DISK_BLOCK_SIZE);
+        result = disk_write_block(100 + i, buffer);
+        TEST_ASSERT(result == DISK_SUCCESS, "写入块应该成功");
+    }
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.cache_writebacks == 6, "淘汰的6个脏块应该已回写");
+    
+    // 最近写入的块应该命中缓存
+    result = disk_read_block(109, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'j', "读取缓存块应该成功");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.cache_hits == 1 && stats.cache_misses == 0, "应该命中缓存");
+    
+    // 较早的块已被淘汰，需要从磁盘读取
+    result = disk_read_block(100, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'a', "读取已淘汰块应该成功");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.cache_misses == 1, "应该未命中缓存");
+    
+    // 同步后禁用缓存，数据应该全部落盘
+    result = disk_sync();
+    TEST_ASSERT(result == DISK_SUCCESS, "同步应该成功");
+    result = disk_set_cache_capacity(0);
+    TEST_ASSERT(result == DISK_SUCCESS, "禁用缓存应该成功");
+    for (int i = 0; i < 10; i++) {
+        result = disk_read_block(100 + i, buffer);
+        TEST_ASSERT(result == DISK_SUCCESS && buffer[DISK_BLOCK_SIZE - 1] == 'a' + i,
+                    "回写的数据应该与写入一致");
+    }
+    
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试向量化与分散/聚集I/O
+ */
+int test_vectored_io(void) {
+    TEST_START("向量化I/O");
+    
+    cleanup_test_env();
+    disk_set_cache_capacity(0);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    // 64个连续块应该只需要一次pwritev和一次preadv
+    const int block_count = 64;
+    char *data = (char *)malloc(block_count * DISK_BLOCK_SIZE);
+    char *verify = (char *)malloc(block_count * DISK_BLOCK_SIZE);
+    TEST_ASSERT(data && verify, "分配缓冲区应该成功");
+    for (int i = 0; i < block_count * DISK_BLOCK_SIZE; i++) {
+        data[i] = (char)(i / DISK_BLOCK_SIZE + i);
+    }
+    
+    result = disk_write_blocks(200, block_count, data);
+    TEST_ASSERT(result == DISK_SUCCESS, "多块写入应该成功");
+    result = disk_read_blocks(200, block_count, verify);
+    TEST_ASSERT(result == DISK_SUCCESS, "多块读取应该成功");
+    TEST_ASSERT(memcmp(data, verify, block_count * DISK_BLOCK_SIZE) == 0, "多块数据应该一致");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.vectored_ios == 2, "多块读写应该各合并为一次系统调用");
+    TEST_ASSERT(stats.total_writes == (uint64_t)block_count, "写入块数统计应该正确");
+    
+    // 越界范围应该被拒绝
+    result = disk_read_blocks(TEST_BLOCK_COUNT - 2, 4, verify);
+    TEST_ASSERT(result == DISK_ERROR_BLOCK_RANGE, "越界范围应该返回错误");
+    
+    // 乱序的分散写入：块300-303合并为一段，块310单独一段；重复的块以最后一次为准
+    char blocks[6][DISK_BLOCK_SIZE];
+    uint32_t order[6] = {302, 310, 300, 303, 301, 310};
+    disk_block_vec_t vec[6];
+    for (int i = 0; i < 6; i++) {
+        memset(blocks[i], 'A' + i, DISK_BLOCK_SIZE);
+        vec[i].block_num = order[i];
+        vec[i].buffer = blocks[i];
+    }
+    
+    disk_reset_stats();
+    result = disk_writev_blocks(vec, 6);
+    TEST_ASSERT(result == DISK_SUCCESS, "聚集写入应该成功");
+    TEST_ASSERT(vec[0].block_num == 302, "调用方数组不应被修改");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.vectored_ios == 1 && stats.total_writes == 5, "相邻块应该合并写入");
+    
+    char read_blocks[6][DISK_BLOCK_SIZE];
+    for (int i = 0; i < 6; i++) {
+        vec[i].buffer = read_blocks[i];
+    }
+    result = disk_readv_blocks(vec, 6);
+    TEST_ASSERT(result == DISK_SUCCESS, "分散读取应该成功");
+    TEST_ASSERT(read_blocks[0][0] == 'A' && read_blocks[2][0] == 'C' &&
+                read_blocks[3][0] == 'D' && read_blocks[4][0] == 'E', "分散读取数据应该一致");
+    TEST_ASSERT(read_blocks[1][0] == 'F' && read_blocks[5][0] == 'F', "重复块应该保留最后一次写入");
+    
+    free(data);
+    free(verify);
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试内存映射模式与零拷贝块访问
+ */
+int test_mmap_mode(void) {
+    TEST_START("内存映射模式");
+    
+    cleanup_test_env();
+    disk_set_mmap_mode(1);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "以mmap模式初始化磁盘应该成功");
+    TEST_ASSERT(g_disk_state.map_base != NULL && g_disk_state.cache == NULL,
+                "mmap模式应该映射镜像且不使用块缓存");
+    
+    char buffer[DISK_BLOCK_SIZE];
+    memset(buffer, 'M', DISK_BLOCK_SIZE);
+    result = disk_write_block(20, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS, "mmap模式写入应该成功");
+    
+    // 只读指针直接指向映射中的数据
+    const char *block;
+    result = disk_get_block(20, &block);
+    TEST_ASSERT(result == DISK_SUCCESS && block[0] == 'M', "获取只读块指针应该成功");
+    const char *again;
+    disk_get_block(20, &again);
+    TEST_ASSERT(block == again, "mmap模式下同一块应该返回同一地址");
+    disk_put_block(20, again, 0);
+    disk_put_block(20, block, 0);
+    
+    // 就地修改
+    char *mutable_block;
+    result = disk_get_block_mut(21, &mutable_block);
+    TEST_ASSERT(result == DISK_SUCCESS, "获取可写块指针应该成功");
+    memset(mutable_block, 'Z', DISK_BLOCK_SIZE);
+    result = disk_put_block(21, mutable_block, 1);
+    TEST_ASSERT(result == DISK_SUCCESS, "释放脏块应该成功");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.zero_copy_gets == 3, "零拷贝访问次数应该正确");
+    
+    result = disk_sync();
+    TEST_ASSERT(result == DISK_SUCCESS, "msync同步应该成功");
+    
+    // 退出mmap模式后通过pread读取，数据应该一致
+    result = disk_set_mmap_mode(0);
+    TEST_ASSERT(result == DISK_SUCCESS && g_disk_state.map_base == NULL, "退出mmap模式应该成功");
+    result = disk_read_block(21, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'Z' && buffer[DISK_BLOCK_SIZE - 1] == 'Z',
+                "就地修改的数据应该已写入");
+    
+    // 非mmap模式下返回私有副本，修改后写回
+    result = disk_get_block_mut(22, &mutable_block);
+    TEST_ASSERT(result == DISK_SUCCESS, "非mmap模式获取块指针应该成功");
+    memset(mutable_block, 'C', DISK_BLOCK_SIZE);
+    result = disk_put_block(22, mutable_block, 1);
+    TEST_ASSERT(result == DISK_SUCCESS, "非mmap模式释放脏块应该成功");
+    result = disk_read_block(22, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'C', "私有副本的修改应该已写回");
+    
+    disk_close();
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 使用指定后端运行一轮异步I/O
+ */
+static int run_async_round(int flags) {
+    const int depth = 8;
+    const int blocks_per_request = 4;
+    static char write_data[8][4 * DISK_BLOCK_SIZE];
+    static char read_data[8][4 * DISK_BLOCK_SIZE];
+    disk_aio_completion_t done[8];
+    
+    int result = disk_aio_init(depth, flags);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化异步I/O应该成功");
+    TEST_ASSERT(strcmp(disk_aio_backend(), "none") != 0, "应该选定一个后端");
+    
+    // 提交一批写请求，每个请求带不同的用户数据
+    for (int i = 0; i < depth; i++) {
+        memset(write_data[i], 'a' + i, sizeof(write_data[i]));
+        result = disk_aio_submit_write(400 + i * blocks_per_request, blocks_per_request,
+                                       write_data[i], 1000 + i);
+        TEST_ASSERT(result == DISK_SUCCESS, "提交异步写应该成功");
+    }
+    
+    // 队列已满
+    result = disk_aio_submit_write(0, 1, write_data[0], 0);
+    TEST_ASSERT(result == DISK_ERROR_BUSY, "队列满时应该返回忙");
+    
+    int reaped = 0;
+    uint32_t seen = 0;
+    while (reaped < depth) {
+        int count = disk_aio_reap(done, 8, 1);
+        TEST_ASSERT(count > 0, "回收写完成事件应该成功");
+        for (int i = 0; i < count; i++) {
+            TEST_ASSERT(done[i].result == DISK_SUCCESS, "异步写应该成功");
+            TEST_ASSERT(done[i].user_data >= 1000 && done[i].user_data < 1000 + (uint64_t)depth,
+                        "用户数据应该原样返回");
+            seen |= 1u << (done[i].user_data - 1000);
+        }
+        reaped += count;
+    }
+    TEST_ASSERT(seen == (1u << depth) - 1, "每个请求都应该完成一次");
+    
+    // 异步读回并校验
+    for (int i = 0; i < depth; i++) {
+        result = disk_aio_submit_read(400 + i * blocks_per_request, blocks_per_request,
+                                      read_data[i], i);
+        TEST_ASSERT(result == DISK_SUCCESS, "提交异步读应该成功");
+    }
+    reaped = 0;
+    while (reaped < depth) {
+        int count = disk_aio_reap(done, 8, depth - reaped);
+        TEST_ASSERT(count > 0, "回收读完成事件应该成功");
+        for (int i = 0; i < count; i++) {
+            TEST_ASSERT(done[i].result == DISK_SUCCESS, "异步读应该成功");
+        }
+        reaped += count;
+    }
+    for (int i = 0; i < depth; i++) {
+        TEST_ASSERT(memcmp(read_data[i], write_data[i], sizeof(write_data[i])) == 0,
+                    "异步读取的数据应该与写入一致");
+    }
+    
+    // 同步读应该看到异步写入的数据
+    char buffer[DISK_BLOCK_SIZE];
+    result = disk_read_block(400 + 3 * blocks_per_request, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'd', "同步读取应该看到异步写入");
+    
+    // 缓存中的脏块应该先回写再异步读取
+    memset(buffer, 'Q', DISK_BLOCK_SIZE);
+    disk_write_block(401, buffer);
+    result = disk_aio_submit_read(400, blocks_per_request, read_data[0], 77);
+    TEST_ASSERT(result == DISK_SUCCESS, "提交异步读应该成功");
+    int count = disk_aio_reap(done, 8, 1);
+    TEST_ASSERT(count == 1 && done[0].user_data == 77 && done[0].result == DISK_SUCCESS,
+                "异步读应该完成");
+    TEST_ASSERT(read_data[0][DISK_BLOCK_SIZE] == 'Q', "异步读应该看到缓存中的新数据");
+    
+    result = disk_aio_shutdown();
+    TEST_ASSERT(result == DISK_SUCCESS, "关闭异步I/O应该成功");
+    return 1;
+}
+
+/**
+ * 测试异步块I/O
+ */
+int test_async_io(void) {
+    TEST_START("异步I/O");
+    
+    cleanup_test_env();
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    // 自动选择后端（io_uring不可用时为线程池），然后强制线程池后端
+    if (!run_async_round(0)) {
+        return 0;
+    }
+    if (!run_async_round(DISK_AIO_THREADS)) {
+        return 0;
+    }
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.aio_submitted == stats.aio_completed, "提交与完成次数应该相等");
+    
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 组提交测试的写线程：每个线程写入自己的一段块
+ */
+static void *group_commit_writer(void *arg) {
+    int base = *(int *)arg;
+    char buffer[DISK_BLOCK_SIZE];
+    
+    for (int i = 0; i < 16; i++) {
+        memset(buffer, 'a' + base / 16, DISK_BLOCK_SIZE);
+        if (disk_write_block(base + i, buffer) != DISK_SUCCESS) {
+            return (void *)1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 测试组提交
+ */
+int test_group_commit(void) {
+    TEST_START("组提交");
+    
+    cleanup_test_env();
+    int result = disk_set_group_commit(2000, 0);
+    TEST_ASSERT(result == DISK_SUCCESS, "配置组提交应该成功");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "启用组提交时初始化磁盘应该成功");
+    TEST_ASSERT(g_disk_state.group_commit.running, "组提交刷新线程应该已启动");
+    
+    // 多个线程并发写入，每次写入返回时都已持久化
+    const int threads = 4;
+    pthread_t tids[4];
+    int bases[4];
+    for (int i = 0; i < threads; i++) {
+        bases[i] = i * 16;
+        pthread_create(&tids[i], NULL, group_commit_writer, &bases[i]);
+    }
+    int failed = 0;
+    for (int i = 0; i < threads; i++) {
+        void *ret;
+        pthread_join(tids[i], &ret);
+        failed += (ret != NULL);
+    }
+    TEST_ASSERT(failed == 0, "并发持久写入应该全部成功");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.group_commit_writes == (uint64_t)threads * 16,
+                "每次写入都应该由组提交持久化");
+    TEST_ASSERT(stats.group_commits > 0 && stats.group_commits < stats.group_commit_writes,
+                "多个写入应该合并为一次刷新");
+    
+    char buffer[DISK_BLOCK_SIZE];
+    result = disk_read_block(3 * 16 + 15, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'd', "组提交写入的数据应该可读");
+    
+    // 达到字节阈值时立即刷新，不等时间窗口
+    result = disk_set_group_commit(10 * 1000 * 1000, DISK_BLOCK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "运行中重新配置组提交应该成功");
+    time_t wall_start = time(NULL);
+    result = disk_write_block(100, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && time(NULL) - wall_start < 5,
+                "达到阈值的写入应该立即刷新");
+    
+    // 关闭组提交后恢复普通写入
+    result = disk_set_group_commit(0, 0);
+    TEST_ASSERT(result == DISK_SUCCESS && !g_disk_state.group_commit.running,
+                "关闭组提交应该停止刷新线程");
+    result = disk_write_block(101, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS, "关闭组提交后写入应该成功");
+    
+    disk_close();
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试可配置块大小
+ */
+int test_block_size(void) {
+    TEST_START("可配置块大小");
+    
+    cleanup_test_env();
+    
+    // 只接受1KB~64KB之间的2的幂
+    TEST_ASSERT(disk_set_block_size(512) == DISK_ERROR_INVALID_PARAM, "小于1KB的块大小应该被拒绝");
+    TEST_ASSERT(disk_set_block_size(3000) == DISK_ERROR_INVALID_PARAM, "非2的幂的块大小应该被拒绝");
+    TEST_ASSERT(disk_set_block_size(128 * 1024) == DISK_ERROR_INVALID_PARAM, "大于64KB的块大小应该被拒绝");
+    
+    const uint32_t block_size = 4096;
+    int result = disk_set_block_size(block_size);
+    TEST_ASSERT(result == DISK_SUCCESS, "设置4KB块大小应该成功");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "以4KB块初始化磁盘应该成功");
+    
+    uint64_t total_blocks;
+    uint32_t info_block_size;
+    disk_get_info(&total_blocks, &info_block_size, NULL);
+    TEST_ASSERT(info_block_size == block_size && disk_get_block_size() == block_size,
+                "块大小应该为4KB");
+    TEST_ASSERT(total_blocks == TEST_DISK_SIZE / block_size, "块数应该按块大小计算");
+    
+    // 块数据按块大小对齐存放在镜像文件中
+    TEST_ASSERT(DISK_BLOCK_TO_OFFSET(1) % block_size == 0, "块偏移应该按块大小对齐");
+    
+    static char buffer[4096], read_buffer[4096];
+    for (uint32_t i = 0; i < block_size; i++) {
+        buffer[i] = (char)(i * 13 + 1);
+    }
+    result = disk_write_block(total_blocks - 1, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS, "写入最后一个4KB块应该成功");
+    disk_close();
+    
+    // 重新打开时以头部记录的块大小为准
+    disk_set_block_size(DISK_BLOCK_SIZE);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开4KB块磁盘应该成功");
+    TEST_ASSERT(disk_get_block_size() == block_size, "重新打开后块大小应该来自磁盘头部");
+    result = disk_read_block(total_blocks - 1, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(buffer, read_buffer, block_size) == 0,
+                "4KB块数据应该完整保存");
+    disk_close();
+    
+    // 打开现有镜像时不按当前配置检查大小
+    disk_set_block_size(8192);
+    result = disk_init(TEST_DISK_FILE, block_size + 1);
+    TEST_ASSERT(result == DISK_SUCCESS, "打开现有磁盘时应该忽略传入大小的块对齐");
+    TEST_ASSERT(disk_get_block_size() == block_size, "块大小仍应该来自磁盘头部");
+    disk_set_block_size(DISK_BLOCK_SIZE);
+    
+    disk_close();
+    cleanup_test_env();
+    TEST_ASSERT(disk_get_block_size() == DISK_BLOCK_SIZE, "新磁盘应该恢复默认块大小");
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试快速清零与后台清零
+ */
+int test_zero_blocks(void) {
+    TEST_START("快速清零");
+    
+    cleanup_test_env();
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    result = disk_format(0xAA);
+    TEST_ASSERT(result == DISK_SUCCESS, "按模式格式化应该成功");
+    
+    char buffer[DISK_BLOCK_SIZE], zero[DISK_BLOCK_SIZE];
+    memset(zero, 0, sizeof(zero));
+    
+    // 缓存中的旧副本不能在清零后被读到
+    disk_read_block(10, buffer);
+    result = disk_zero_blocks(10, 20);
+    TEST_ASSERT(result == DISK_SUCCESS, "清零一段块应该成功");
+    disk_read_block(10, buffer);
+    TEST_ASSERT(memcmp(buffer, zero, sizeof(buffer)) == 0, "清零后不应读到缓存中的旧数据");
+    disk_read_block(29, buffer);
+    TEST_ASSERT(memcmp(buffer, zero, sizeof(buffer)) == 0, "范围内最后一块应该被清零");
+    disk_read_block(30, buffer);
+    TEST_ASSERT((unsigned char)buffer[0] == 0xAA, "范围之外的块应该保持不变");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.blocks_zeroed == 20, "清零块数统计应该正确");
+    TEST_ASSERT(disk_zero_blocks(TEST_BLOCK_COUNT - 1, 2) == DISK_ERROR_BLOCK_RANGE,
+                "越界清零应该被拒绝");
+    
+    // 后台清零：认领的块立即清零，之后写入的数据不会被后台线程覆盖
+    result = disk_zero_blocks_background(100, 500);
+    TEST_ASSERT(result == DISK_SUCCESS, "启动后台清零应该成功");
+    TEST_ASSERT(disk_zero_blocks_claim(400) == 1, "任务范围内的块应该可以认领");
+    TEST_ASSERT(disk_zero_blocks_claim(50) == 0, "任务范围之外的块不属于后台清零");
+    memset(buffer, 'z', sizeof(buffer));
+    disk_write_block(400, buffer);
+    
+    for (int i = 0; i < 1000000 && g_disk_state.zeroer.next < g_disk_state.zeroer.end; i++) {
+        sched_yield();
+    }
+    disk_read_block(599, buffer);
+    TEST_ASSERT(memcmp(buffer, zero, sizeof(buffer)) == 0, "后台清零应该完成整个范围");
+    disk_read_block(400, buffer);
+    TEST_ASSERT(buffer[0] == 'z', "认领后写入的块不应被后台清零覆盖");
+    disk_read_block(600, buffer);
+    TEST_ASSERT((unsigned char)buffer[0] == 0xAA, "后台清零不应越过任务范围");
+    TEST_ASSERT(disk_zero_blocks_done(100) == 500 && disk_zero_blocks_done(350) == 250,
+                "完成后整个任务范围都应该报告为已清零");
+    TEST_ASSERT(disk_zero_blocks_done(50) == 0, "任务范围之外的块不应报告为已清零");
+    
+    // 全零格式化走快速路径，不计入写入次数
+    disk_reset_stats();
+    result = disk_format(0);
+    TEST_ASSERT(result == DISK_SUCCESS, "全零格式化应该成功");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.total_writes == 0 && stats.blocks_zeroed == TEST_BLOCK_COUNT,
+                "全零格式化应该清零而不是逐块写入");
+    disk_read_block(30, buffer);
+    TEST_ASSERT(memcmp(buffer, zero, sizeof(buffer)) == 0, "格式化后块应该为全零");
+    
+    disk_close();
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试延迟直方图
+ */
+int test_latency_histogram(void) {
+    TEST_START("延迟直方图");
+    
+    static latency_hist_t hist, low, high;
+    latency_hist_reset(&hist);
+    TEST_ASSERT(latency_hist_percentile(&hist, 99) == 0, "空直方图的百分位应该为0");
+    
+    // 1~1000微秒均匀分布，百分位误差不超过一个子桶宽度（6.25%）
+    latency_hist_reset(&low);
+    latency_hist_reset(&high);
+    for (uint64_t us = 1; us <= 1000; us++) {
+        latency_hist_record(&hist, us * 1000);
+        latency_hist_record(us <= 500 ? &low : &high, us * 1000);
+    }
+    uint64_t p50 = latency_hist_percentile(&hist, 50);
+    uint64_t p99 = latency_hist_percentile(&hist, 99);
+    uint64_t p999 = latency_hist_percentile(&hist, 99.9);
+    TEST_ASSERT(p50 >= 500000 && p50 <= 500000 * 1.0625, "p50应该接近500微秒");
+    TEST_ASSERT(p99 >= 990000 && p99 <= 990000 * 1.0625, "p99应该接近990微秒");
+    TEST_ASSERT(p999 >= 999000 && p999 <= 1000000, "p99.9不应超过最大值");
+    TEST_ASSERT(latency_hist_percentile(&hist, 100) == 1000000, "p100应该等于最大值");
+    TEST_ASSERT(latency_hist_mean(&hist) == 500500.0, "平均值应该精确");
+    
+    // 合并两半应该与整体一致
+    latency_hist_merge(&low, &high);
+    TEST_ASSERT(low.count == hist.count && low.max_ns == hist.max_ns &&
+                memcmp(low.buckets, hist.buckets, sizeof(hist.buckets)) == 0,
+                "合并后的直方图应该与整体一致");
+    
+    // 磁盘统计：每个请求记录一个样本，重置后清空
+    cleanup_test_env();
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    char buffer[DISK_BLOCK_SIZE * 4];
+    memset(buffer, 'h', sizeof(buffer));
+    disk_write_blocks(0, 4, buffer);
+    for (int i = 0; i < 10; i++) {
+        disk_read_block(i, buffer);
+    }
+    disk_sync();
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.write_latency.count == 1, "多块写入应该记录为一个请求");
+    TEST_ASSERT(stats.read_latency.count == 10, "每次读取应该记录一个样本");
+    TEST_ASSERT(stats.sync_latency.count >= 1, "同步延迟应该被记录");
+    TEST_ASSERT(latency_hist_percentile(&stats.read_latency, 99) <= stats.read_latency.max_ns,
+                "百分位不应超过最大值");
+    
+    disk_reset_stats();
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.read_latency.count == 0 && stats.write_latency.count == 0,
+                "重置后直方图应该为空");
+    
+    disk_close();
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试CRC32C与每块校验和
+ */
+int test_block_checksums(void) {
+    TEST_START("块校验和");
+    
+    // 标准测试向量，分段计算结果应该一致
+    TEST_ASSERT(crc32c(0, "123456789", 9) == 0xE3069283, "CRC32C测试向量应该正确");
+    TEST_ASSERT(crc32c(crc32c(0, "1234", 4), "56789", 5) == 0xE3069283, "CRC32C应该可以分段计算");
+    
+    cleanup_test_env();
+    disk_set_checksums(1);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    disk_set_checksums(0);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化带校验和的磁盘应该成功");
+    TEST_ASSERT(disk_has_checksums(), "新磁盘应该启用块校验和");
+    
+    char buffer[DISK_BLOCK_SIZE * 4], read_buffer[DISK_BLOCK_SIZE * 4];
+    memset(buffer, 'c', sizeof(buffer));
+    disk_write_block(5, buffer);
+    disk_write_blocks(6, 3, buffer);
+    result = disk_read_blocks(5, 4, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(buffer, read_buffer, sizeof(buffer)) == 0,
+                "校验通过的块应该正常读出");
+    disk_close();
+    
+    // 绕过模拟器改写镜像中的块5和块7
+    int fd = open(TEST_DISK_FILE, O_RDWR);
+    TEST_ASSERT(fd != -1, "打开镜像文件应该成功");
+    lseek(fd, DISK_BLOCK_SIZE + 5 * DISK_BLOCK_SIZE + 100, SEEK_SET);
+    TEST_ASSERT(write(fd, "X", 1) == 1, "改写块5应该成功");
+    lseek(fd, DISK_BLOCK_SIZE + 7 * DISK_BLOCK_SIZE, SEEK_SET);
+    TEST_ASSERT(write(fd, "X", 1) == 1, "改写块7应该成功");
+    close(fd);
+    
+    // 是否带校验和以磁盘头部为准
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_has_checksums(), "重新打开后应该保留块校验和");
+    TEST_ASSERT(disk_read_block(5, read_buffer) == DISK_ERROR_CHECKSUM, "损坏的块应该读取失败");
+    TEST_ASSERT(disk_read_block(6, read_buffer) == DISK_SUCCESS, "未损坏的块应该正常读出");
+    TEST_ASSERT(disk_read_blocks(6, 3, read_buffer) == DISK_ERROR_CHECKSUM, "批量读取应该发现损坏的块");
+    
+    disk_set_mmap_mode(1);
+    TEST_ASSERT(disk_read_block(7, read_buffer) == DISK_ERROR_CHECKSUM, "mmap模式也应该验证校验和");
+    disk_set_mmap_mode(0);
+    
+    // 重写后校验和随之更新
+    disk_write_block(5, buffer);
+    TEST_ASSERT(disk_read_block(5, read_buffer) == DISK_SUCCESS, "重写后的块应该通过校验");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.checksum_errors == 3, "校验失败次数统计应该正确");
+    disk_close();
+    
+    // 子进程写入后不关闭直接退出，模拟崩溃：数据已在镜像中，校验和表未回写
+    pid_t pid = fork();
+    if (pid == 0) {
+        disk_set_cache_capacity(0);
+        disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+        memset(buffer, 'k', sizeof(buffer));
+        disk_write_block(9, buffer);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+    
+    // 重新打开时重建校验和表，崩溃前写入的块不应误报损坏
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "崩溃后重新打开应该成功");
+    result = disk_read_block(9, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && read_buffer[0] == 'k', "崩溃前写入的块应该正常读出");
+    disk_close();
+    
+    // 自动同步时校验和表写不进镜像，写入应该报告错误（子进程中限制文件大小，
+    // 数据区可写而数据区之后的校验和表不可写）
+    pid = fork();
+    if (pid == 0) {
+        struct rlimit limit = { TEST_DISK_SIZE / 2, TEST_DISK_SIZE / 2 };
+        signal(SIGXFSZ, SIG_IGN);
+        disk_set_cache_capacity(0);
+        if (disk_init(TEST_DISK_FILE, TEST_DISK_SIZE) != DISK_SUCCESS) {
+            _exit(2);
+        }
+        g_disk_state.auto_sync = 1;
+        setrlimit(RLIMIT_FSIZE, &limit);
+        memset(buffer, 'f', sizeof(buffer));
+        _exit(disk_write_block(10, buffer) == DISK_ERROR_FILE_WRITE ? 0 : 1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                "校验和表写入失败时自动同步的写入应该返回错误");
+    
+    // 默认不带校验和
+    cleanup_test_env();
+    disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(!disk_has_checksums(), "默认新磁盘不应带块校验和");
+    disk_close();
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试条带集
+ */
+int test_striping(void) {
+    TEST_START("条带集");
+    
+    cleanup_test_env();
+    TEST_ASSERT(disk_set_striping(0, 4) == DISK_ERROR_INVALID_PARAM, "成员数为0应该被拒绝");
+    TEST_ASSERT(disk_set_striping(3, 0) == DISK_ERROR_INVALID_PARAM, "条带单元为0应该被拒绝");
+    
+    // 3个成员、每个条带单元4块
+    disk_set_striping(3, 4);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    disk_set_striping(1, 0);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化条带集应该成功");
+    TEST_ASSERT(access(TEST_DISK_FILE ".1", F_OK) == 0 && access(TEST_DISK_FILE ".2", F_OK) == 0,
+                "应该创建成员文件");
+    
+    uint32_t members = 0, stripe_blocks = 0;
+    disk_get_striping(&members, &stripe_blocks);
+    TEST_ASSERT(members == 3 && stripe_blocks == 4, "条带布局应该正确");
+    TEST_ASSERT(disk_aio_init(0, 0) == DISK_ERROR_INVALID_PARAM, "条带集不应支持异步I/O");
+    
+    // 跨越多个条带单元的批量读写
+    char* data = (char*)malloc(24 * DISK_BLOCK_SIZE);
+    char* read_data = (char*)malloc(24 * DISK_BLOCK_SIZE);
+    for (int i = 0; i < 24; i++) {
+        memset(data + i * DISK_BLOCK_SIZE, 'A' + i, DISK_BLOCK_SIZE);
+    }
+    result = disk_write_blocks(2, 24, data);
+    TEST_ASSERT(result == DISK_SUCCESS, "跨条带写入应该成功");
+    disk_sync();
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.striped_ios > 0, "跨条带写入应该并行分发到多个成员");
+    disk_close();
+    
+    // 块5位于第1个条带单元，即成员1的第1块
+    char byte = 0;
+    int fd = open(TEST_DISK_FILE ".1", O_RDONLY);
+    TEST_ASSERT(fd != -1, "打开成员文件应该成功");
+    lseek(fd, DISK_BLOCK_SIZE + 1 * DISK_BLOCK_SIZE, SEEK_SET);
+    TEST_ASSERT(read(fd, &byte, 1) == 1 && byte == 'A' + 3,
+                "块应该按条带单元写入对应的成员");
+    close(fd);
+    
+    // 重新打开时按头部记录重组条带集
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开条带集应该成功");
+    disk_get_striping(&members, &stripe_blocks);
+    TEST_ASSERT(members == 3 && stripe_blocks == 4, "重新打开后条带布局应该一致");
+    result = disk_read_blocks(2, 24, read_data);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(data, read_data, 24 * DISK_BLOCK_SIZE) == 0,
+                "重组后读出的数据应该一致");
+    disk_close();
+    free(data);
+    free(read_data);
+    
+    // 缺少成员时无法打开
+    unlink(TEST_DISK_FILE ".2");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result != DISK_SUCCESS, "缺少成员文件时打开应该失败");
+    
+    unlink(TEST_DISK_FILE ".1");
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试磁盘句柄
+ */
+int test_disk_handles(void) {
+    TEST_START("磁盘句柄");
+    
+    cleanup_test_env();
+    unlink(TEST_DISK_FILE ".a");
+    unlink(TEST_DISK_FILE ".b");
+    
+    // 两个句柄与默认磁盘同时打开，互不影响
+    disk_t* disk_a = NULL;
+    disk_t* disk_b = NULL;
+    int result = disk_open(TEST_DISK_FILE ".a", TEST_DISK_SIZE, &disk_a);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_a != NULL, "打开第一个句柄应该成功");
+    result = disk_open(TEST_DISK_FILE ".b", TEST_DISK_SIZE / 2, &disk_b);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_b != NULL, "打开第二个句柄应该成功");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "句柄打开时默认磁盘仍可初始化");
+    TEST_ASSERT(disk_default() == &g_disk_state, "默认磁盘句柄应该指向全局状态");
+    
+    TEST_ASSERT(disk_handle_get_block_count(disk_b) == TEST_BLOCK_COUNT / 2, "句柄应该有各自的大小");
+    
+    char buffer[DISK_BLOCK_SIZE * 2], read_buffer[DISK_BLOCK_SIZE * 2];
+    memset(buffer, 'a', sizeof(buffer));
+    disk_handle_write_blocks(disk_a, 3, 2, buffer);
+    memset(buffer, 'b', sizeof(buffer));
+    disk_handle_write_block(disk_b, 3, buffer);
+    memset(buffer, 'd', sizeof(buffer));
+    disk_write_block(3, buffer);
+    
+    disk_handle_read_block(disk_a, 3, read_buffer);
+    TEST_ASSERT(read_buffer[0] == 'a', "句柄A应该读到自己的数据");
+    disk_handle_read_block(disk_b, 3, read_buffer);
+    TEST_ASSERT(read_buffer[0] == 'b', "句柄B应该读到自己的数据");
+    disk_read_block(3, read_buffer);
+    TEST_ASSERT(read_buffer[0] == 'd', "默认磁盘应该读到自己的数据");
+    
+    disk_stats_t stats;
+    disk_handle_get_stats(disk_a, &stats);
+    TEST_ASSERT(stats.total_writes == 2 && stats.total_reads == 1, "句柄应该有各自的统计");
+    TEST_ASSERT(disk_handle_sync(disk_a) == DISK_SUCCESS, "同步句柄应该成功");
+    
+    TEST_ASSERT(disk_handle_close(disk_default()) == DISK_ERROR_INVALID_PARAM,
+                "默认磁盘不能通过句柄关闭");
+    TEST_ASSERT(disk_handle_close(disk_a) == DISK_SUCCESS, "关闭句柄应该成功");
+    TEST_ASSERT(disk_is_initialized(), "关闭句柄不应影响默认磁盘");
+    
+    // 句柄的配置只作用于该句柄，不成为之后打开的磁盘的默认值
+    TEST_ASSERT(disk_handle_set_mmap_mode(disk_b, 1) == DISK_SUCCESS, "句柄应该可以切换到映射模式");
+    TEST_ASSERT(disk_handle_set_cache_capacity(disk_b, 0) == DISK_SUCCESS, "句柄应该可以设置缓存容量");
+    TEST_ASSERT(disk_handle_set_io_queue(disk_b, 8, 0) == DISK_SUCCESS, "句柄应该可以启用调度队列");
+    TEST_ASSERT(disk_handle_is_mapped(disk_b) && !disk_is_mapped(), "映射模式不应影响默认磁盘");
+    
+    // 重新打开后数据仍在
+    result = disk_open(TEST_DISK_FILE ".a", TEST_DISK_SIZE, &disk_a);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开句柄应该成功");
+    TEST_ASSERT(!disk_handle_is_mapped(disk_a) && disk_a->cache != NULL && !disk_a->ioq.running,
+                "新打开的句柄不应继承其他句柄的配置");
+    result = disk_handle_read_blocks(disk_a, 3, 2, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && read_buffer[DISK_BLOCK_SIZE] == 'a', "句柄数据应该已持久化");
+    
+    disk_handle_close(disk_a);
+    disk_handle_close(disk_b);
+    unlink(TEST_DISK_FILE ".a");
+    unlink(TEST_DISK_FILE ".b");
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试预读
+ */
+int test_readahead(void) {
+    TEST_START("预读");
+    
+    cleanup_test_env();
+    disk_set_cache_capacity(16);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    char buffer[DISK_BLOCK_SIZE];
+    for (int i = 0; i < 8; i++) {
+        memset(buffer, 'a' + i, DISK_BLOCK_SIZE);
+        disk_write_block(200 + i, buffer);
+    }
+    disk_close();
+    
+    // 重新打开后缓存为空，预读请求会被排序去重
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开磁盘应该成功");
+    uint64_t blocks[] = {203, 200, 201, 202, 200};
+    result = disk_prefetch_blocks(blocks, 5);
+    TEST_ASSERT(result == 4, "应该预读4个不同的块");
+    TEST_ASSERT(disk_prefetch_blocks(blocks, 5) == 0, "已缓存的块不应重复预读");
+    TEST_ASSERT(disk_prefetch_blocks(blocks, -1) == DISK_ERROR_INVALID_PARAM, "无效参数应该失败");
+    
+    for (int i = 0; i < 3; i++) {
+        result = disk_read_block(200 + i, buffer);
+        TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'a' + i, "预读的数据应该正确");
+    }
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.readahead_blocks == 4, "预读块数应该为4");
+    TEST_ASSERT(stats.readahead_hits == 3 && stats.cache_hits == 3 && stats.cache_misses == 0,
+                "读取预读块应该命中缓存");
+    
+    // 预读后未读即被覆盖的块计为浪费
+    uint64_t overwritten = 205;
+    TEST_ASSERT(disk_prefetch_blocks(&overwritten, 1) == 1, "预读单个块应该成功");
+    memset(buffer, 'z', DISK_BLOCK_SIZE);
+    disk_write_block(205, buffer);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.readahead_wasted == 1 && stats.readahead_hits == 3, "覆盖的预读块应该计为浪费");
+    
+    disk_close();
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试I/O调度队列
+ */
+int test_io_queue(void) {
+    TEST_START("I/O调度队列");
+    
+    cleanup_test_env();
+    disk_set_cache_capacity(0);
+    int result = disk_set_io_queue(64, 10 * 1000 * 1000);
+    TEST_ASSERT(result == DISK_SUCCESS, "配置调度队列应该成功");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    // 乱序排队，块10写两次
+    char buffer[DISK_BLOCK_SIZE];
+    int blocks[] = {50, 10, 11, 12, 51, 10};
+    for (int i = 0; i < 6; i++) {
+        memset(buffer, 'a' + i, DISK_BLOCK_SIZE);
+        result = disk_queue_write(blocks[i], buffer);
+        TEST_ASSERT(result == DISK_SUCCESS, "排队写入应该成功");
+    }
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.ioq_queued == 6 && stats.ioq_absorbed == 1, "重复块应该被覆盖");
+    TEST_ASSERT(stats.total_writes == 0, "派发前不应写入磁盘");
+    
+    // 读取排队的块先派发队列：两段连续块各一次I/O
+    result = disk_read_block(11, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && buffer[0] == 'c', "应该读到排队的数据");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.ioq_dispatches == 1 && stats.ioq_runs == 2, "应该合并为2次I/O");
+    TEST_ASSERT(stats.total_writes == 5 && stats.vectored_ios == 2, "应该写入5个不同的块");
+    disk_read_block(10, buffer);
+    TEST_ASSERT(buffer[0] == 'f', "块10应该是最后一次写入的数据");
+    
+    // 队列满时立即派发
+    disk_set_io_queue(4, 10 * 1000 * 1000);
+    disk_reset_stats();
+    disk_block_vec_t vec[4];
+    char data[4][DISK_BLOCK_SIZE];
+    for (int i = 0; i < 4; i++) {
+        memset(data[i], 'p' + i, DISK_BLOCK_SIZE);
+        vec[i].block_num = 103 - i;
+        vec[i].buffer = data[i];
+    }
+    result = disk_queue_writev(vec, 4);
+    TEST_ASSERT(result == DISK_SUCCESS, "批量排队写入应该成功");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.ioq_dispatches == 1 && stats.ioq_runs == 1 && stats.total_writes == 4,
+                "队列满时应该合并为一次I/O派发");
+    
+    // 截止时间到期后即使没有其他访问也会派发
+    disk_set_io_queue(64, 50 * 1000);
+    disk_reset_stats();
+    memset(buffer, 'x', DISK_BLOCK_SIZE);
+    disk_queue_write(200, buffer);
+    sleep(1);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.ioq_dispatches == 1 && stats.total_writes == 1, "到期的写入应该被派发");
+    
+    // 关闭时派发剩余写入
+    memset(buffer, 'y', DISK_BLOCK_SIZE);
+    disk_queue_write(201, buffer);
+    disk_close();
+    disk_set_io_queue(0, 0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开磁盘应该成功");
+    disk_read_block(201, buffer);
+    TEST_ASSERT(buffer[0] == 'y', "关闭前排队的写入应该已落盘");
+    disk_read_block(100, buffer);
+    TEST_ASSERT(buffer[0] == 's', "批量排队的写入应该已落盘");
+    
+    // 未启用队列时直接写入
+    result = disk_queue_write(300, buffer);
+    disk_get_stats(&stats);
+    TEST_ASSERT(result == DISK_SUCCESS && stats.total_writes == 1 && stats.ioq_queued == 0,
+                "未启用队列时应该直接写入");
+    
+    disk_close();
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试设备时序模型
+ */
+int test_timing_model(void) {
+    TEST_START("设备时序模型");
+    
+    cleanup_test_env();
+    disk_set_cache_capacity(0);
+    int result = disk_set_timing_model((timing_profile_t)9, 0, 0);
+    TEST_ASSERT(result == DISK_ERROR_INVALID_PARAM, "未知设备类型应该失败");
+    result = disk_set_timing_model(TIMING_PROFILE_HDD, 0, 0);
+    TEST_ASSERT(result == DISK_SUCCESS, "配置机械硬盘模型应该成功");
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    disk_reset_stats();
+    
+    // 从磁头位置开始的顺序读：一次I/O，无需寻道
+    static char buffer[64 * DISK_BLOCK_SIZE];
+    result = disk_read_blocks(0, 64, buffer);
+    TEST_ASSERT(result == DISK_SUCCESS, "顺序读取应该成功");
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.device_ios == 1 && stats.device_seeks == 0, "顺序读取不应寻道");
+    TEST_ASSERT(stats.device_time_ns > 400000 && stats.device_time_ns < 1000000,
+                "64KB顺序读取应该约为0.5ms");
+    
+    // 随机读：每次寻道加半圈旋转，虚拟时间计入读取延迟
+    disk_read_block(900, buffer);
+    disk_read_block(100, buffer);
+    disk_read_block(700, buffer);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.device_ios == 4 && stats.device_seeks == 3, "随机读取应该寻道3次");
+    TEST_ASSERT(stats.device_time_ns > 3 * 4600000ULL, "每次随机读取至少4.6ms");
+    TEST_ASSERT(latency_hist_percentile(&stats.read_latency, 100) >= 4600000,
+                "读取延迟应该包含虚拟设备时间");
+    
+    // 带宽上限加实际延迟：16KB按1MB/s至少16ms
+    result = disk_set_timing_model(TIMING_PROFILE_NVME, 1000000, 1);
+    TEST_ASSERT(result == DISK_SUCCESS, "切换为NVMe模型应该成功");
+    disk_reset_stats();
+    disk_read_blocks(0, 16, buffer);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.device_time_ns >= 16000000 && stats.device_seeks == 0, "带宽上限应该生效");
+    TEST_ASSERT(latency_hist_percentile(&stats.read_latency, 100) >= 16000000,
+                "实际延迟应该体现在测得的延迟中");
+    
+    // 同步计为一次设备刷新
+    disk_sync();
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.device_ios == 2, "同步应该计为设备I/O");
+    
+    // 关闭模型后不再计时
+    disk_set_timing_model(TIMING_PROFILE_NONE, 0, 0);
+    disk_read_block(5, buffer);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.device_ios == 2, "关闭模型后不应计时");
+    
+    disk_close();
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试压缩镜像
+ */
+int test_compression(void) {
+    TEST_START("压缩镜像");
+    
+    cleanup_test_env();
+    TEST_ASSERT(disk_set_compression(4096) == DISK_ERROR_INVALID_PARAM, "过大的块组应该被拒绝");
+    disk_set_compression(16);
+    disk_set_checksums(1);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_ERROR_INVALID_PARAM, "压缩不应与每块校验和组合");
+    disk_set_checksums(0);
+    
+    // 新镜像只有头部和空索引（逐块写入直达块组缓存，不经块缓存）
+    disk_set_cache_capacity(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_get_compression() == 16, "创建压缩镜像应该成功");
+    struct stat st;
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_size <= 4 * DISK_BLOCK_SIZE, "新压缩镜像不应分配数据区");
+    TEST_ASSERT(disk_set_mmap_mode(1) != DISK_SUCCESS && !disk_is_mapped(), "压缩镜像不能映射");
+    
+    // 256个文本块，以及一个完全随机（不可压缩）的块组
+    static char text[256 * DISK_BLOCK_SIZE];
+    static char noise[16 * DISK_BLOCK_SIZE];
+    static char read_buffer[256 * DISK_BLOCK_SIZE];
+    for (size_t pos = 0, line = 0; pos < sizeof(text); line++) {
+        char row[96];
+        int n = snprintf(row, sizeof(row), "%06lu: the quick brown fox jumps over the lazy dog\n",
+                         (unsigned long)line);
+        for (int i = 0; i < n && pos < sizeof(text); i++) {
+            text[pos++] = row[i];
+        }
+    }
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < sizeof(noise); i++) {
+        seed = seed * 1103515245 + 12345;
+        noise[i] = (char)(seed >> 16);
+    }
+    for (int i = 0; i < 256; i++) {
+        disk_write_block(i, text + i * DISK_BLOCK_SIZE);
+    }
+    disk_write_blocks(304, 16, noise);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步应该成功");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(stats.compression.stored_chunks == 17, "应该存储17个块组");
+    TEST_ASSERT(stats.compression.ratio_chunks[0] == 1, "随机块组应该原样存放");
+    TEST_ASSERT(stats.compression.ratio_chunks[2] + stats.compression.ratio_chunks[3] +
+                stats.compression.ratio_chunks[4] + stats.compression.ratio_chunks[5] == 16,
+                "文本块组的压缩比应该至少4倍");
+    TEST_ASSERT(stats.compression.compress_latency.count >= 17, "应该记录每个块组的压缩耗时");
+    TEST_ASSERT(st.st_size < 96 * 1024, "镜像文件应该远小于写入的数据量");
+    off_t written_size = st.st_size;
+    disk_close();
+    
+    // 是否压缩以磁盘头部为准；未写过的块组读出全零且不读文件
+    disk_set_compression(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_get_compression() == 16, "重新打开后应该保持压缩");
+    result = disk_read_blocks(0, 256, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, text, sizeof(text)) == 0,
+                "文本块应该原样读出");
+    result = disk_read_blocks(304, 16, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, noise, sizeof(noise)) == 0,
+                "随机块应该原样读出");
+    TEST_ASSERT(disk_read_block(700, read_buffer) == DISK_SUCCESS && read_buffer[0] == 0 &&
+                memcmp(read_buffer, read_buffer + 1, DISK_BLOCK_SIZE - 1) == 0, "空块组应该读出全零");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.compression.chunks_read == 17 && stats.compression.zero_chunks_read == 1,
+                "每个块组应该只解压一次");
+    TEST_ASSERT(stats.compression.decompress_latency.count == 16, "应该记录每个块组的解压耗时");
+    
+    // 反复改写同一批块：被替换的空间在同步后重用，镜像不持续增长
+    for (int round = 0; round < 5; round++) {
+        text[0] = (char)('a' + round);
+        disk_write_blocks(0, 256, text);
+        disk_sync();
+    }
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_size <= 2 * written_size, "改写后的镜像应该重用旧空间");
+    result = disk_read_block(0, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && read_buffer[0] == 'e', "应该读出最后一次写入");
+    
+    // 整组清零从索引中删除，部分清零的块组重新压缩
+    result = disk_zero_blocks(8, 40);
+    disk_get_stats(&stats);
+    TEST_ASSERT(result == DISK_SUCCESS && stats.compression.stored_chunks == 15, "清零的整个块组应该释放");
+    disk_read_blocks(0, 64, read_buffer);
+    TEST_ASSERT(memcmp(read_buffer + DISK_BLOCK_SIZE, text + DISK_BLOCK_SIZE, 7 * DISK_BLOCK_SIZE) == 0 &&
+                read_buffer[8 * DISK_BLOCK_SIZE] == 0 && read_buffer[47 * DISK_BLOCK_SIZE + 5] == 0 &&
+                memcmp(read_buffer + 48 * DISK_BLOCK_SIZE, text + 48 * DISK_BLOCK_SIZE,
+                       16 * DISK_BLOCK_SIZE) == 0, "清零范围外的数据应该保留");
+    disk_close();
+    
+    // 绕过模拟器改写块组0的压缩数据（索引第一项的偏移在头部之后）
+    int fd = open(TEST_DISK_FILE, O_RDWR);
+    TEST_ASSERT(fd != -1, "打开镜像文件应该成功");
+    uint64_t chunk_offset = 0;
+    lseek(fd, DISK_BLOCK_SIZE, SEEK_SET);
+    TEST_ASSERT(read(fd, &chunk_offset, sizeof(chunk_offset)) == sizeof(chunk_offset) &&
+                chunk_offset > 0, "块组0应该有数据");
+    lseek(fd, (off_t)chunk_offset + 3, SEEK_SET);
+    TEST_ASSERT(write(fd, "X", 1) == 1, "改写压缩数据应该成功");
+    close(fd);
+    
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开应该成功");
+    TEST_ASSERT(disk_read_block(2, read_buffer) == DISK_ERROR_CHECKSUM, "损坏的块组应该读取失败");
+    TEST_ASSERT(disk_read_block(100, read_buffer) == DISK_SUCCESS, "其他块组应该正常读出");
+    
+    disk_close();
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试快照
+ */
+int test_snapshots(void) {
+    TEST_START("快照");
+    
+    cleanup_test_env();
+    unlink(TEST_DISK_FILE ".snap1");
+    unlink(TEST_DISK_FILE ".snap2");
+    
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化应该成功");
+    static char data[64 * DISK_BLOCK_SIZE];
+    static char read_buffer[64 * DISK_BLOCK_SIZE];
+    memset(data, 'A', sizeof(data));
+    disk_write_blocks(0, 64, data);
+    
+    // 强制使用叠加层：缓存中的块先写回，镜像改名冻结，原文件名下只有头部和映射表
+    TEST_ASSERT(disk_snapshot(TEST_DISK_FILE, 0) == DISK_ERROR_FILE_CREATE, "快照不能覆盖镜像本身");
+    result = disk_snapshot(TEST_DISK_FILE ".snap1", DISK_SNAPSHOT_NO_REFLINK);
+    TEST_ASSERT(result == DISK_SUCCESS, "建立快照应该成功");
+    struct stat st;
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_size <= 8 * DISK_BLOCK_SIZE, "建立快照不应复制数据块");
+    TEST_ASSERT(disk_aio_init(0, 0) == DISK_ERROR_INVALID_PARAM, "叠加层不应支持异步I/O");
+    
+    // 改写的块重定向到叠加层，其余块读自快照
+    memset(data, 'B', 4 * DISK_BLOCK_SIZE);
+    disk_write_blocks(10, 4, data);
+    disk_zero_blocks(20, 1);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步叠加层应该成功");
+    result = disk_read_blocks(0, 64, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && read_buffer[9 * DISK_BLOCK_SIZE] == 'A' &&
+                read_buffer[10 * DISK_BLOCK_SIZE] == 'B' && read_buffer[13 * DISK_BLOCK_SIZE + 5] == 'B' &&
+                read_buffer[14 * DISK_BLOCK_SIZE] == 'A' && read_buffer[20 * DISK_BLOCK_SIZE] == 0 &&
+                read_buffer[63 * DISK_BLOCK_SIZE] == 'A', "应该读出快照与叠加层合成的数据");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.snapshots_overlaid == 1 && stats.overlay_redirects == 4 &&
+                stats.backing_reads > 0, "应该统计快照、重定向写入和读自快照的块");
+    TEST_ASSERT(stats.total_writes > 0, "建立快照后应该保留统计");
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_size <= 12 * DISK_BLOCK_SIZE, "只有改写的块进入叠加层");
+    
+    // 快照通过同样的读取路径打开，保持建立时的数据且只读
+    disk_t* snap = NULL;
+    result = disk_open(TEST_DISK_FILE ".snap1", TEST_DISK_SIZE, &snap);
+    TEST_ASSERT(result == DISK_SUCCESS, "打开快照应该成功");
+    TEST_ASSERT(disk_handle_read_block(snap, 10, read_buffer) == DISK_SUCCESS &&
+                read_buffer[0] == 'A', "快照应该保持建立时的数据");
+    TEST_ASSERT(disk_handle_read_block(snap, 20, read_buffer) == DISK_SUCCESS &&
+                read_buffer[0] == 'A', "清零不应影响快照");
+    TEST_ASSERT(disk_handle_write_block(snap, 10, data) == DISK_ERROR_IO, "快照应该只读");
+    TEST_ASSERT(disk_handle_snapshot(snap, TEST_DISK_FILE ".snap2", 0) == DISK_ERROR_IO,
+                "只读的快照不能再建快照");
+    disk_handle_close(snap);
+    
+    // 第二个快照（主机支持时用reflink）叠在第一个之上
+    result = disk_snapshot(TEST_DISK_FILE ".snap2", 0);
+    TEST_ASSERT(result == DISK_SUCCESS, "建立第二个快照应该成功");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.snapshots_reflinked + stats.snapshots_overlaid == 2, "应该记录两个快照");
+    memset(data, 'C', DISK_BLOCK_SIZE);
+    disk_write_block(10, data);
+    disk_close();
+    
+    // 重新打开后整条快照链仍然完整
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开叠加层应该成功");
+    result = disk_read_blocks(0, 64, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && read_buffer[10 * DISK_BLOCK_SIZE] == 'C' &&
+                read_buffer[11 * DISK_BLOCK_SIZE] == 'B' && read_buffer[20 * DISK_BLOCK_SIZE] == 0 &&
+                read_buffer[30 * DISK_BLOCK_SIZE] == 'A', "重新打开后数据应该一致");
+    result = disk_open(TEST_DISK_FILE ".snap2", TEST_DISK_SIZE, &snap);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_handle_read_block(snap, 10, read_buffer) == DISK_SUCCESS &&
+                read_buffer[0] == 'B', "第二个快照应该保持建立时的数据");
+    disk_handle_close(snap);
+    
+    disk_close();
+    unlink(TEST_DISK_FILE ".snap1");
+    unlink(TEST_DISK_FILE ".snap2");
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试块去重
+ */
+int test_dedup(void) {
+    TEST_START("块去重");
+    
+    cleanup_test_env();
+    disk_set_dedup(1);
+    disk_set_checksums(1);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_ERROR_INVALID_PARAM, "去重不应与每块校验和组合");
+    disk_set_checksums(0);
+    
+    // 新镜像只有头部和空的映射表、指纹表（逐块写入直达去重存储，不经块缓存）
+    disk_set_cache_capacity(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_has_dedup(), "创建去重镜像应该成功");
+    struct stat st;
+    stat(TEST_DISK_FILE, &st);
+    off_t empty_size = st.st_size;
+    TEST_ASSERT(empty_size <= 24 * DISK_BLOCK_SIZE, "新去重镜像不应分配数据区");
+    TEST_ASSERT(disk_set_mmap_mode(1) != DISK_SUCCESS && !disk_is_mapped(), "去重镜像不能映射");
+    TEST_ASSERT(disk_aio_init(0, 0) == DISK_ERROR_INVALID_PARAM, "去重镜像不应支持异步I/O");
+    
+    // 8个不同的模板块重复16次，后面是64个全零的尾部块
+    static char data[192 * DISK_BLOCK_SIZE];
+    static char read_buffer[192 * DISK_BLOCK_SIZE];
+    memset(data, 0, sizeof(data));
+    for (int i = 0; i < 128; i++) {
+        memset(data + i * DISK_BLOCK_SIZE, 'a' + i % 8, DISK_BLOCK_SIZE / 2);
+        snprintf(data + i * DISK_BLOCK_SIZE, 32, "template %d", i % 8);
+    }
+    disk_write_blocks(0, 192, data);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步应该成功");
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.dedup.stored_slots == 8 && stats.dedup.referenced_blocks == 128,
+                "重复的模板块应该只存放一份");
+    TEST_ASSERT(stats.dedup.unique_blocks == 8 && stats.dedup.duplicate_blocks == 120 &&
+                stats.dedup.zero_blocks == 64, "应该统计新块、重复块和全零块");
+    TEST_ASSERT(stats.dedup.lookups == 128 && stats.dedup.verify_reads == 120 &&
+                stats.dedup.hash_collisions == 0, "每次重复都应该验证内容");
+    TEST_ASSERT(stats.dedup.lookup_latency.count == 128, "应该记录每次查找的耗时");
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_size <= empty_size + 8 * DISK_BLOCK_SIZE, "镜像只应增加8个块");
+    
+    result = disk_read_blocks(0, 192, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, data, sizeof(data)) == 0,
+                "所有块应该原样读出");
+    
+    // 清零释放引用：最后一个引用消失后槽才被释放
+    disk_zero_blocks(8, 120);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.dedup.stored_slots == 8 && stats.dedup.referenced_blocks == 8,
+                "仍被引用的槽应该保留");
+    disk_zero_blocks(0, 1);
+    memset(data, 'z', DISK_BLOCK_SIZE);
+    disk_write_block(1, data);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.dedup.stored_slots == 7 && stats.dedup.referenced_blocks == 7,
+                "改写和清零应该释放旧槽");
+    disk_close();
+    
+    // 是否去重以磁盘头部为准；重新打开后从映射表重建引用计数和指纹缓存
+    disk_set_dedup(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_has_dedup(), "重新打开后应该保持去重");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.dedup.stored_slots == 7 && stats.dedup.referenced_blocks == 7,
+                "重新打开后引用计数应该一致");
+    result = disk_read_blocks(0, 8, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && read_buffer[0] == 0 && read_buffer[DISK_BLOCK_SIZE] == 'z' &&
+                memcmp(read_buffer + 2 * DISK_BLOCK_SIZE, data + 2 * DISK_BLOCK_SIZE,
+                       6 * DISK_BLOCK_SIZE) == 0, "重新打开后数据应该一致");
+    memset(data, 0, DISK_BLOCK_SIZE);
+    memset(data, 'a' + 3, DISK_BLOCK_SIZE / 2);
+    snprintf(data, 32, "template %d", 3);
+    TEST_ASSERT(memcmp(read_buffer + 3 * DISK_BLOCK_SIZE, data, DISK_BLOCK_SIZE) == 0,
+                "模板块应该原样读出");
+    disk_write_block(500, data);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.dedup.duplicate_blocks == 1 && stats.dedup.referenced_blocks == 8,
+                "重新打开后应该找到已存放的相同块");
+    
+    disk_close();
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试I/O跟踪
+ */
+int test_io_trace(void) {
+    TEST_START("I/O跟踪");
+    
+    cleanup_test_env();
+    unlink(TEST_DISK_FILE ".trace");
+    
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化应该成功");
+    TEST_ASSERT(disk_trace_stop() == DISK_ERROR_INVALID_PARAM, "未开始时不能停止跟踪");
+    TEST_ASSERT(disk_trace_start(TEST_DISK_FILE ".trace") == DISK_SUCCESS, "开始跟踪应该成功");
+    TEST_ASSERT(disk_trace_start(TEST_DISK_FILE ".trace") == DISK_ERROR_BUSY, "不能重复开始跟踪");
+    
+    static char data[8 * DISK_BLOCK_SIZE];
+    memset(data, 'T', sizeof(data));
+    disk_write_block(5, data);
+    disk_write_blocks(100, 8, data);
+    disk_read_block(5, data);
+    disk_read_blocks(100, 8, data);
+    disk_read_block(TEST_BLOCK_COUNT, data);
+    disk_sync();
+    
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.trace_records == 6, "应该统计记录的调用数");
+    TEST_ASSERT(disk_trace_stop() == DISK_SUCCESS, "停止跟踪应该成功");
+    disk_read_block(5, data);
+    disk_close();
+    
+    // 跟踪文件按调用顺序记录操作、块范围、结果，时间戳不递减
+    trace_file_header_t header;
+    trace_record_t* records = NULL;
+    size_t count = 0;
+    result = trace_log_load(TEST_DISK_FILE ".trace", &header, &records, &count);
+    TEST_ASSERT(result == 0 && count == 6, "跟踪文件应该有6条记录");
+    TEST_ASSERT(header.block_size == DISK_BLOCK_SIZE && header.total_blocks == TEST_BLOCK_COUNT,
+                "头部应该记录磁盘几何");
+    static const uint8_t ops[6] = { TRACE_OP_WRITE, TRACE_OP_WRITE, TRACE_OP_READ, TRACE_OP_READ,
+                                    TRACE_OP_READ, TRACE_OP_SYNC };
+    static const uint32_t blocks[6] = { 5, 100, 5, 100, TEST_BLOCK_COUNT, 0 };
+    static const uint32_t counts[6] = { 1, 8, 1, 8, 1, 0 };
+    int ordered = 1;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].op != ops[i] || records[i].block != blocks[i] ||
+            records[i].count != counts[i] ||
+            (i > 0 && records[i].timestamp_ns < records[i - 1].timestamp_ns)) {
+            ordered = 0;
+        }
+    }
+    TEST_ASSERT(ordered, "记录应该与调用一致");
+    TEST_ASSERT(records[0].result == DISK_SUCCESS && records[4].result == DISK_ERROR_BLOCK_RANGE,
+                "应该记录调用结果");
+    TEST_ASSERT(records[5].latency_ns > 0, "应该记录调用延迟");
+    free(records);
+    
+    // 不是跟踪文件时报告格式错误
+    TEST_ASSERT(trace_log_load(TEST_DISK_FILE ".trace-missing", &header, &records, &count) == -ENOENT,
+                "不存在的跟踪文件应该报告错误");
+    cleanup_test_env();
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    disk_close();
+    TEST_ASSERT(trace_log_load(TEST_DISK_FILE, &header, &records, &count) == -EBADMSG,
+                "磁盘镜像不是跟踪文件");
+    
+    unlink(TEST_DISK_FILE ".trace");
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试64位块号（6TB稀疏镜像，超过2^32个1KB块）
+ */
+int test_large_disk(void) {
+    TEST_START("64位块号");
+    
+    cleanup_test_env();
+    const uint64_t disk_size = 6ULL << 40;
+    const uint64_t total = disk_size / DISK_BLOCK_SIZE;
+    
+    // 每块一项的表按32位块号存放，超过上限时不能创建
+    disk_set_checksums(1);
+    int result = disk_init(TEST_DISK_FILE, disk_size);
+    disk_set_checksums(0);
+    TEST_ASSERT(result == DISK_ERROR_INVALID_PARAM, "校验和镜像不应超过32位块数");
+    disk_set_dedup(1);
+    result = disk_init(TEST_DISK_FILE, disk_size);
+    disk_set_dedup(0);
+    TEST_ASSERT(result == DISK_ERROR_INVALID_PARAM, "去重镜像不应超过32位块数");
+    disk_set_compression(DISK_COMPRESS_DEFAULT_CHUNK_BLOCKS);
+    result = disk_init(TEST_DISK_FILE, disk_size);
+    disk_set_compression(0);
+    TEST_ASSERT(result == DISK_ERROR_INVALID_PARAM, "压缩镜像不应超过32位块数");
+    TEST_ASSERT(access(TEST_DISK_FILE, F_OK) != 0, "被拒绝时不应留下镜像");
+    
+    result = disk_init(TEST_DISK_FILE, disk_size);
+    if (result == DISK_ERROR_FILE_WRITE) {
+        // 主机文件系统不支持这么大的稀疏文件
+        printf("(跳过) ");
+        cleanup_test_env();
+        TEST_PASS();
+        return 1;
+    }
+    TEST_ASSERT(result == DISK_SUCCESS, "创建6TB稀疏镜像应该成功");
+    
+    uint64_t total_blocks, info_disk_size;
+    uint32_t block_size;
+    disk_get_info(&total_blocks, &block_size, &info_disk_size);
+    TEST_ASSERT(total_blocks == total && info_disk_size == disk_size &&
+                disk_get_block_count() == total, "块数和大小不应截断");
+    TEST_ASSERT(disk_is_valid_block(total - 1) && !disk_is_valid_block(total), "块号范围应该正确");
+    
+    // 2^32以上的块不能与低32位相同的块混淆，跨越2^32的多块读写也应正确
+    static char data[4 * DISK_BLOCK_SIZE];
+    static char read_buffer[4 * DISK_BLOCK_SIZE];
+    const uint64_t high = (1ULL << 32) + 5;
+    memset(data, 'H', DISK_BLOCK_SIZE);
+    TEST_ASSERT(disk_write_block(high, data) == DISK_SUCCESS, "写入2^32以上的块应该成功");
+    memset(data, 'L', DISK_BLOCK_SIZE);
+    TEST_ASSERT(disk_write_block(total - 1, data) == DISK_SUCCESS, "写入最后一个块应该成功");
+    for (int i = 0; i < 4; i++) {
+        memset(data + i * DISK_BLOCK_SIZE, '0' + i, DISK_BLOCK_SIZE);
+    }
+    result = disk_write_blocks((1ULL << 32) - 2, 4, data);
+    TEST_ASSERT(result == DISK_SUCCESS, "跨越2^32的多块写入应该成功");
+    TEST_ASSERT(disk_write_block(total, data) == DISK_ERROR_BLOCK_RANGE, "越界写入应该失败");
+    TEST_ASSERT(disk_write_blocks(total - 1, 2, data) == DISK_ERROR_BLOCK_RANGE,
+                "越过末尾的多块写入应该失败");
+    TEST_ASSERT(disk_snapshot(TEST_DISK_FILE ".snap", DISK_SNAPSHOT_NO_REFLINK) ==
+                DISK_ERROR_INVALID_PARAM, "叠加层快照不应超过32位块数");
+    disk_close();
+    
+    // 重新打开后块数来自头部的高低两半
+    result = disk_init(TEST_DISK_FILE, disk_size);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_get_block_count() == total, "重新打开后块数应该一致");
+    result = disk_read_blocks((1ULL << 32) - 2, 4, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, data, sizeof(data)) == 0,
+                "跨越2^32的块应该原样读出");
+    disk_read_block(high, read_buffer);
+    disk_read_block(5, read_buffer + DISK_BLOCK_SIZE);
+    TEST_ASSERT(read_buffer[0] == 'H' && read_buffer[DISK_BLOCK_SIZE] == 0,
+                "高位块不应写到低32位相同的块");
+    disk_read_block(total - 1, read_buffer);
+    TEST_ASSERT(read_buffer[0] == 'L' && read_buffer[DISK_BLOCK_SIZE - 1] == 'L',
+                "最后一个块应该原样读出");
+    disk_close();
+    
+    disk_header_t header;
+    int fd = open(TEST_DISK_FILE, O_RDONLY);
+    TEST_ASSERT(fd != -1 && read(fd, &header, sizeof(header)) == sizeof(header),
+                "应该能读出头部");
+    close(fd);
+    TEST_ASSERT(header.version == DISK_VERSION && header.total_blocks_hi == (uint32_t)(total >> 32) &&
+                header.total_blocks == (uint32_t)total && header.disk_size == UINT32_MAX,
+                "头部应该存放64位块数");
+    
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试块丢弃
+ */
+int test_discard(void) {
+    TEST_START("块丢弃");
+    
+    // 启用设备时序模型，用设备I/O次数确认丢弃的块读取时不访问镜像
+    cleanup_test_env();
+    disk_set_timing_model(TIMING_PROFILE_NVME, 0, 0);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    static char data[256 * DISK_BLOCK_SIZE];
+    static char read_buffer[256 * DISK_BLOCK_SIZE];
+    static char zero[256 * DISK_BLOCK_SIZE];
+    for (int i = 0; i < 256; i++) {
+        memset(data + i * DISK_BLOCK_SIZE, 'a' + i % 26, DISK_BLOCK_SIZE);
+    }
+    disk_write_blocks(0, 256, data);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步应该成功");
+    struct stat st;
+    stat(TEST_DISK_FILE, &st);
+    blkcnt_t allocated = st.st_blocks;
+    
+    TEST_ASSERT(disk_discard_blocks(0, 0) == DISK_ERROR_INVALID_PARAM, "丢弃0个块应该被拒绝");
+    TEST_ASSERT(disk_discard_blocks(TEST_BLOCK_COUNT - 1, 2) == DISK_ERROR_BLOCK_RANGE,
+                "越界丢弃应该被拒绝");
+    
+    // 丢弃后主机文件中的空间被释放，缓存中的旧副本也不能再被读到
+    disk_read_block(10, read_buffer);
+    result = disk_discard_blocks(0, 256);
+    TEST_ASSERT(result == DISK_SUCCESS, "丢弃一段块应该成功");
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_blocks < allocated / 4, "丢弃应该在镜像中打洞");
+    
+    disk_reset_stats();
+    result = disk_read_blocks(0, 256, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, zero, sizeof(read_buffer)) == 0,
+                "丢弃的块应该读出全零");
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.discard_zero_reads == 256 && stats.device_ios == 0,
+                "丢弃的块应该直接填零而不访问设备");
+    
+    // 不经缓存：再次写入的块读出新数据，同一次读取中的其余块仍直接填零
+    disk_close();
+    disk_set_cache_capacity(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开磁盘应该成功");
+    disk_write_blocks(0, 256, data);
+    disk_discard_blocks(100, 100);
+    disk_write_block(150, data);
+    disk_reset_stats();
+    result = disk_read_blocks(100, 100, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer + 50 * DISK_BLOCK_SIZE, data,
+                                                 DISK_BLOCK_SIZE) == 0 &&
+                memcmp(read_buffer, zero, 50 * DISK_BLOCK_SIZE) == 0 &&
+                memcmp(read_buffer + 51 * DISK_BLOCK_SIZE, zero, 49 * DISK_BLOCK_SIZE) == 0,
+                "写入过的块应该读出新数据");
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.discard_zero_reads == 99 && stats.device_ios == 1,
+                "只有写入过的块应该读取镜像");
+    result = disk_read_blocks(200, 8, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS &&
+                memcmp(read_buffer, data + 200 * DISK_BLOCK_SIZE, 8 * DISK_BLOCK_SIZE) == 0,
+                "丢弃范围之外的块应该保持不变");
+    disk_close();
+    disk_set_timing_model(TIMING_PROFILE_NONE, 0, 0);
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    
+    // mmap模式下丢弃同样释放空间，映射中读出全零
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_set_mmap_mode(1) == DISK_SUCCESS,
+                "启用mmap模式应该成功");
+    disk_discard_blocks(200, 8);
+    disk_read_block(203, read_buffer);
+    TEST_ASSERT(memcmp(read_buffer, zero, DISK_BLOCK_SIZE) == 0, "mmap模式下丢弃的块应该读出全零");
+    disk_write_block(203, data);
+    TEST_ASSERT(disk_set_mmap_mode(0) == DISK_SUCCESS, "关闭mmap模式应该成功");
+    disk_read_block(203, read_buffer);
+    TEST_ASSERT(memcmp(read_buffer, data, DISK_BLOCK_SIZE) == 0, "映射期间写入的块应该保留");
+    disk_close();
+    cleanup_test_env();
+    
+    // 校验和、压缩和去重镜像中丢弃的块同样读出全零
+    for (int kind = 0; kind < 3; kind++) {
+        disk_set_checksums(kind == 0);
+        disk_set_compression(kind == 1 ? 16 : 0);
+        disk_set_dedup(kind == 2);
+        result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+        TEST_ASSERT(result == DISK_SUCCESS, "创建镜像应该成功");
+        disk_write_blocks(0, 64, data);
+        result = disk_discard_blocks(16, 32);
+        TEST_ASSERT(result == DISK_SUCCESS, "丢弃应该成功");
+        disk_close();
+        result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+        TEST_ASSERT(result == DISK_SUCCESS && disk_read_blocks(0, 64, read_buffer) == DISK_SUCCESS,
+                    "重新打开后读取应该成功");
+        TEST_ASSERT(memcmp(read_buffer, data, 16 * DISK_BLOCK_SIZE) == 0 &&
+                    memcmp(read_buffer + 16 * DISK_BLOCK_SIZE, zero, 32 * DISK_BLOCK_SIZE) == 0 &&
+                    memcmp(read_buffer + 48 * DISK_BLOCK_SIZE, data + 48 * DISK_BLOCK_SIZE,
+                           16 * DISK_BLOCK_SIZE) == 0, "丢弃的块应该读出全零，其余块不变");
+        cleanup_test_env();
+    }
+    disk_set_checksums(0);
+    disk_set_compression(0);
+    disk_set_dedup(0);
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试内存盘
+ */
+int test_ram_disk(void) {
+    TEST_START("内存盘");
+    
+    // 新建的内存盘不创建镜像文件，读写都在映射中完成
+    cleanup_test_env();
+    TEST_ASSERT(disk_set_ram_disk(1, 0x80) == DISK_ERROR_INVALID_PARAM, "未知选项应该被拒绝");
+    disk_set_ram_disk(1, 0);
+    disk_set_checksums(1);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "创建内存盘应该成功");
+    TEST_ASSERT(disk_is_ram_disk() && disk_is_mapped(), "内存盘应该以映射方式访问");
+    TEST_ASSERT(access(TEST_DISK_FILE, F_OK) != 0, "内存盘不应创建镜像文件");
+    
+    static char data[64 * DISK_BLOCK_SIZE];
+    static char read_buffer[64 * DISK_BLOCK_SIZE];
+    for (int i = 0; i < 64; i++) {
+        memset(data + i * DISK_BLOCK_SIZE, 'A' + i % 26, DISK_BLOCK_SIZE);
+    }
+    disk_write_blocks(0, 64, data);
+    TEST_ASSERT(disk_snapshot(TEST_DISK_FILE ".snap", 0) == DISK_ERROR_INVALID_PARAM,
+                "内存盘不能建立快照");
+    
+    // 导出为普通镜像，关闭内存盘后照常打开（校验和表一并导出）
+    result = disk_ram_dump(NULL);
+    TEST_ASSERT(result == DISK_SUCCESS, "导出内存盘应该成功");
+    disk_close();
+    disk_set_ram_disk(0, 0);
+    disk_set_checksums(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && !disk_is_ram_disk(), "打开导出的镜像应该成功");
+    TEST_ASSERT(disk_has_checksums(), "导出的镜像应该保留校验和");
+    result = disk_read_blocks(0, 64, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, data, sizeof(data)) == 0,
+                "导出的镜像应该包含内存盘的数据");
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.checksum_errors == 0, "导出的校验和表应该与数据一致");
+    TEST_ASSERT(disk_ram_dump(NULL) == DISK_ERROR_INVALID_PARAM, "普通镜像不能导出");
+    disk_close();
+    
+    // 载入已有镜像：修改只留在内存中，除非再次导出
+    disk_set_ram_disk(1, DISK_RAM_HUGE_PAGES);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_is_ram_disk(), "载入内存盘应该成功");
+    result = disk_read_blocks(0, 64, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer, data, sizeof(data)) == 0,
+                "载入的内存盘应该包含镜像的数据");
+    memset(read_buffer, 'z', DISK_BLOCK_SIZE);
+    disk_write_block(5, read_buffer);
+    disk_zero_blocks(10, 4);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步内存盘应该成功");
+    disk_close();
+    
+    disk_set_ram_disk(0, 0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_read_blocks(0, 64, read_buffer) == DISK_SUCCESS &&
+                memcmp(read_buffer, data, sizeof(data)) == 0, "关闭内存盘不应改动镜像文件");
+    disk_close();
+    
+    // 另存为新文件
+    disk_set_ram_disk(1, 0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "再次载入内存盘应该成功");
+    disk_write_block(5, read_buffer + 6 * DISK_BLOCK_SIZE);
+    result = disk_ram_dump(TEST_DISK_FILE ".copy");
+    TEST_ASSERT(result == DISK_SUCCESS, "另存内存盘应该成功");
+    disk_close();
+    disk_set_ram_disk(0, 0);
+    disk_t* copy = NULL;
+    result = disk_open(TEST_DISK_FILE ".copy", TEST_DISK_SIZE, &copy);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_handle_read_block(copy, 5, read_buffer) == DISK_SUCCESS &&
+                memcmp(read_buffer, data + 6 * DISK_BLOCK_SIZE, DISK_BLOCK_SIZE) == 0,
+                "另存的镜像应该包含修改后的数据");
+    disk_handle_close(copy);
+    unlink(TEST_DISK_FILE ".copy");
+    cleanup_test_env();
+    
+    // 条带集的成员是各自的文件，不能放入内存盘
+    disk_set_ram_disk(1, 0);
+    disk_set_striping(2, 16);
+    TEST_ASSERT(disk_init(TEST_DISK_FILE, TEST_DISK_SIZE) == DISK_ERROR_INVALID_PARAM,
+                "内存盘不能分条带");
+    disk_set_striping(1, 0);
+    disk_set_ram_disk(0, 0);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试存储后端选择
+ */
+int test_storage_backends(void) {
+    TEST_START("存储后端");
+    
+    cleanup_test_env();
+    TEST_ASSERT(strcmp(disk_backend_name(), "none") == 0, "未打开磁盘时没有后端");
+    
+    // mem:后面没有路径时是不对应任何文件的临时磁盘
+    static char data[16 * DISK_BLOCK_SIZE];
+    static char read_buffer[16 * DISK_BLOCK_SIZE];
+    memset(data, 'm', sizeof(data));
+    int result = disk_init("mem:", TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && strcmp(disk_backend_name(), "mem") == 0 &&
+                disk_is_ram_disk() && disk_is_mapped(), "mem:应该创建映射的内存盘");
+    disk_write_blocks(0, 16, data);
+    TEST_ASSERT(disk_read_blocks(0, 16, read_buffer) == DISK_SUCCESS &&
+                memcmp(read_buffer, data, sizeof(data)) == 0, "内存盘读写应该一致");
+    TEST_ASSERT(disk_ram_dump(NULL) == DISK_ERROR_INVALID_PARAM, "没有文件名的内存盘需要指定导出文件");
+    disk_close();
+    
+    // file:按块缓存和pread/pwrite访问，前缀不进入文件名
+    result = disk_init("file:" TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && strcmp(disk_backend_name(), "file") == 0 &&
+                !disk_is_mapped(), "file:应该创建普通镜像");
+    TEST_ASSERT(access(TEST_DISK_FILE, F_OK) == 0, "镜像文件名不应包含前缀");
+    disk_write_blocks(0, 16, data);
+    disk_close();
+    
+    // mmap:打开同一个镜像，关闭mmap模式后切换到file后端
+    result = disk_init("mmap:" TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && strcmp(disk_backend_name(), "mmap") == 0 &&
+                disk_is_mapped(), "mmap:应该映射镜像");
+    TEST_ASSERT(disk_read_blocks(0, 16, read_buffer) == DISK_SUCCESS &&
+                memcmp(read_buffer, data, sizeof(data)) == 0, "mmap后端应该读出file后端写入的数据");
+    TEST_ASSERT(disk_set_mmap_mode(0) == DISK_SUCCESS && strcmp(disk_backend_name(), "file") == 0,
+                "关闭mmap模式应该切换到file后端");
+    memset(data, 'f', DISK_BLOCK_SIZE);
+    disk_write_block(0, data);
+    disk_close();
+    
+    // mem:载入的镜像在关闭后保持不变
+    result = disk_init("mem:" TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_read_blocks(0, 16, read_buffer) == DISK_SUCCESS &&
+                memcmp(read_buffer, data, sizeof(data)) == 0, "mem:应该载入镜像");
+    disk_zero_blocks(0, 16);
+    disk_close();
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && strcmp(disk_backend_name(), "file") == 0 &&
+                disk_read_block(0, read_buffer) == DISK_SUCCESS && read_buffer[0] == 'f',
+                "没有前缀时默认使用file后端，内存盘的修改不写回镜像");
+    disk_close();
+    cleanup_test_env();
+    
+    // 不能映射的压缩镜像在mmap:下按file后端访问
+    disk_set_compression(16);
+    result = disk_init("mmap:" TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && strcmp(disk_backend_name(), "file") == 0 &&
+                !disk_is_mapped(), "不能映射的镜像应该退回file后端");
+    disk_close();
+    disk_set_compression(0);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+    
+/**
+ * 测试全零块检测和稀疏写入
+ */
+int test_zero_writes(void) {
+    TEST_START("全零写入");
+    
+    // 任意位置的一个非零字节都能被检测到（覆盖向量部分和结尾部分）
+    static char buffer[DISK_BLOCK_SIZE + 64];
+    TEST_ASSERT(zero_detect_implementation() != NULL, "应该选出一种实现");
+    TEST_ASSERT(buffer_is_zero(buffer, 0) && buffer_is_zero(buffer + 3, DISK_BLOCK_SIZE + 61),
+                "全零缓冲区应该被识别");
+    size_t positions[] = { 0, 7, 8, 63, 64, 100, DISK_BLOCK_SIZE - 1, DISK_BLOCK_SIZE + 2 };
+    for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++) {
+        buffer[1 + positions[i]] = 1;
+        TEST_ASSERT(!buffer_is_zero(buffer + 1, DISK_BLOCK_SIZE + 3), "非零字节应该被检测到");
+        buffer[1 + positions[i]] = 0;
+    }
+    
+    cleanup_test_env();
+    disk_set_checksums(1);
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    
+    static char data[256 * DISK_BLOCK_SIZE];
+    static char read_buffer[256 * DISK_BLOCK_SIZE];
+    static char zero[256 * DISK_BLOCK_SIZE];
+    memset(data, 'z', sizeof(data));
+    disk_write_blocks(0, 256, data);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步应该成功");
+    struct stat st;
+    stat(TEST_DISK_FILE, &st);
+    blkcnt_t allocated = st.st_blocks;
+    
+    // 回写的全零块在镜像中打洞，不写入数据
+    disk_reset_stats();
+    disk_write_blocks(0, 256, zero);
+    TEST_ASSERT(disk_sync() == DISK_SUCCESS, "同步应该成功");
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.zero_writes_punched == 256 && stats.zero_writes_skipped == 0 &&
+                stats.bytes_write_avoided == 256ULL * DISK_BLOCK_SIZE, "全零块应该被打洞");
+    stat(TEST_DISK_FILE, &st);
+    TEST_ASSERT(st.st_blocks < allocated / 4, "全零写入应该释放镜像中的空间");
+    
+    // 已是洞的块再次写入全零时直接跳过；夹在中间的数据块照常写入
+    disk_close();
+    disk_set_cache_capacity(0);
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "重新打开磁盘应该成功");
+    disk_write_blocks(0, 64, zero);
+    disk_reset_stats();
+    memcpy(read_buffer, zero, 64 * DISK_BLOCK_SIZE);
+    memcpy(read_buffer + 20 * DISK_BLOCK_SIZE, data, DISK_BLOCK_SIZE);
+    disk_write_blocks(0, 64, read_buffer);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.zero_writes_skipped == 63 && stats.zero_writes_punched == 0,
+                "已是洞的全零块应该跳过");
+    result = disk_read_blocks(0, 64, read_buffer);
+    TEST_ASSERT(result == DISK_SUCCESS && memcmp(read_buffer + 20 * DISK_BLOCK_SIZE, data,
+                                                 DISK_BLOCK_SIZE) == 0 &&
+                memcmp(read_buffer, zero, 20 * DISK_BLOCK_SIZE) == 0 &&
+                memcmp(read_buffer + 21 * DISK_BLOCK_SIZE, zero, 43 * DISK_BLOCK_SIZE) == 0,
+                "全零块应该读出全零，数据块读出新数据");
+    
+    // 全零格式化整盘打洞，之后的全零写入和清零都不再访问镜像
+    TEST_ASSERT(disk_format(0) == DISK_SUCCESS, "全零格式化应该成功");
+    disk_reset_stats();
+    disk_write_block(500, zero);
+    disk_zero_blocks(600, 16);
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.zero_writes_skipped == 17 && stats.zero_writes_punched == 0,
+                "格式化后的全零写入应该跳过");
+    disk_close();
+    
+    // 重新打开后校验和与打洞的块一致
+    result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS && disk_read_blocks(0, 256, read_buffer) == DISK_SUCCESS &&
+                memcmp(read_buffer, zero, sizeof(read_buffer)) == 0, "打洞的块应该通过校验");
+    disk_close();
+    cleanup_test_env();
+    disk_set_checksums(0);
+    disk_set_cache_capacity(DISK_CACHE_DEFAULT_BLOCKS);
+    
+    TEST_PASS();
+    return 1;
+}
+
+/**
+ * 测试范围同步
+ */
+int test_sync_range(void) {
+    TEST_START("范围同步");
+    
+    TEST_ASSERT(disk_sync_range(0, 1) == DISK_ERROR_NOT_INIT, "未初始化时应该返回错误");
+    
+    cleanup_test_env();
+    int result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+    TEST_ASSERT(result == DISK_SUCCESS, "初始化磁盘应该成功");
+    TEST_ASSERT(disk_sync_range(0, 0) == DISK_ERROR_INVALID_PARAM, "空范围应该被拒绝");
+    TEST_ASSERT(disk_sync_range(TEST_BLOCK_COUNT - 1, 2) == DISK_ERROR_BLOCK_RANGE,
+                "越界范围应该被拒绝");
+    
+    // 只回写范围内的脏块，范围外的脏块留在缓存中直到完整同步
+    static char data[8 * DISK_BLOCK_SIZE];
+    static char read_buffer[8 * DISK_BLOCK_SIZE];
+    memset(data, 'r', sizeof(data));
+    disk_write_blocks(10, 4, data);
+    disk_write_blocks(500, 4, data);
+    disk_reset_stats();
+    result = disk_sync_range(10, 4);
+    TEST_ASSERT(result == DISK_SUCCESS, "范围同步应该成功");
+    disk_stats_t stats;
+    disk_get_stats(&stats);
+    TEST_ASSERT(stats.cache_writebacks == 4 && stats.range_syncs == 1,
+                "只应该回写范围内的脏块");
+    result = disk_sync_data();
+    disk_get_stats(&stats);
+    TEST_ASSERT(result == DISK_SUCCESS && stats.cache_writebacks == 8,
+                "只同步数据时应该回写其余的脏块");
+    disk_close();
+    
+    // mmap模式和校验和镜像上同样可用，同步的数据重新打开后完整
+    for (int kind = 0; kind < 2; kind++) {
+        cleanup_test_env();
+        disk_set_checksums(kind == 1);
+        disk_set_mmap_mode(kind == 0);
+        result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+        TEST_ASSERT(result == DISK_SUCCESS && disk_is_mapped() == (kind == 0), "创建镜像应该成功");
+        disk_write_blocks(100, 8, data);
+        TEST_ASSERT(disk_sync_range(100, 8) == DISK_SUCCESS, "范围同步应该成功");
+        disk_close();
+        result = disk_init(TEST_DISK_FILE, TEST_DISK_SIZE);
+        TEST_ASSERT(result == DISK_SUCCESS && disk_read_blocks(100, 8, read_buffer) == DISK_SUCCESS &&
+                    memcmp(read_buffer, data, sizeof(data)) == 0, "同步的数据应该保留");
+        disk_close();
+    }
+    disk_set_checksums(0);
+    disk_set_mmap_mode(0);
+    cleanup_test_env();
+    
+    TEST_PASS();
+    return 1;
+}
+
 /**
  * 打印测试结果
  */
@@ -430,6 +2345,30 @@ int main(void) {
     test_utility_functions();
     test_statistics();
     test_disk_persistence();
+    test_block_cache();
+    test_vectored_io();
+    test_mmap_mode();
+    test_async_io();
+    test_group_commit();
+    test_block_size();
+    test_zero_blocks();
+    test_latency_histogram();
+    test_block_checksums();
+    test_striping();
+    test_disk_handles();
+    test_readahead();
+    test_io_queue();
+    test_timing_model();
+    test_compression();
+    test_snapshots();
+    test_dedup();
+    test_io_trace();
+    test_large_disk();
+    test_discard();
+    test_ram_disk();
+    test_storage_backends();
+    test_zero_writes();
+    test_sync_range();
     
     // 清理环境
     cleanup_test_env();
@@ -0,0 +1,253 @@
+/**
+ * Block Extent Set Implementation
+ * extent_set.c
+ *
+ * 块范围集合实现 - 按起始块排序的不相交、不相邻范围数组，二分查找定位
+ */
+
+#include "extent_set.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+/**
+ * 一个范围 [start, end)
+ */
+typedef struct {
+    uint64_t        start;
+    uint64_t        end;
+} extent_t;
+
+struct extent_set {
+    pthread_mutex_t lock;           // 保护范围数组
+    extent_t        *extents;       // 按start排序
+    uint32_t        count;          // 当前范围数（无锁读取时用原子操作）
+    uint32_t        max_extents;    // 范围数上限
+};
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 查找第一个end大于block的范围（调用方持有锁）
+ */
+static uint32_t find_extent(const extent_set_t *set, uint64_t block) {
+    uint32_t lo = 0;
+    uint32_t hi = set->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (set->extents[mid].end > block) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+/**
+ * 删除下标[first, last)的范围（调用方持有锁）
+ */
+static void delete_extents(extent_set_t *set, uint32_t first, uint32_t last) {
+    if (first >= last) {
+        return;
+    }
+    memmove(&set->extents[first], &set->extents[last], (set->count - last) * sizeof(extent_t));
+    __atomic_store_n(&set->count, set->count - (last - first), __ATOMIC_RELAXED);
+}
+
+/**
+ * 在下标index处插入范围，调用方保证未满（调用方持有锁）
+ */
+static void insert_extent(extent_set_t *set, uint32_t index, uint64_t start, uint64_t end) {
+    memmove(&set->extents[index + 1], &set->extents[index], (set->count - index) * sizeof(extent_t));
+    set->extents[index].start = start;
+    set->extents[index].end = end;
+    __atomic_store_n(&set->count, set->count + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * 计算范围终点（溢出时截到UINT64_MAX）
+ */
+static uint64_t range_end(uint64_t start, uint64_t count) {
+    return count > UINT64_MAX - start ? UINT64_MAX : start + count;
+}
+
+/*==============================================================================
+ * 范围集合操作
+ *============================================================================*/
+
+/**
+ * 创建空集合
+ */
+extent_set_t* extent_set_create(uint32_t max_extents) {
+    if (max_extents == 0) {
+        return NULL;
+    }
+
+    extent_set_t *set = (extent_set_t *)calloc(1, sizeof(extent_set_t));
+    if (!set) {
+        return NULL;
+    }
+
+    set->extents = (extent_t *)malloc((size_t)max_extents * sizeof(extent_t));
+    if (!set->extents) {
+        free(set);
+        return NULL;
+    }
+
+    pthread_mutex_init(&set->lock, NULL);
+    set->max_extents = max_extents;
+    return set;
+}
+
+/**
+ * 释放集合
+ */
+void extent_set_destroy(extent_set_t *set) {
+    if (!set) {
+        return;
+    }
+
+    pthread_mutex_destroy(&set->lock);
+    free(set->extents);
+    free(set);
+}
+
+/**
+ * 加入范围，与重叠和相邻的范围合并
+ */
+int extent_set_add(extent_set_t *set, uint64_t start, uint64_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t end = range_end(start, count);
+
+    pthread_mutex_lock(&set->lock);
+
+    // [first, last)是与新范围重叠或相邻的范围
+    uint32_t first = start == 0 ? 0 : find_extent(set, start - 1);
+    uint32_t last = first;
+    while (last < set->count && set->extents[last].start <= end) {
+        last++;
+    }
+
+    int result = 0;
+    if (first == last) {
+        if (set->count < set->max_extents) {
+            insert_extent(set, first, start, end);
+        } else {
+            result = -ENOSPC;
+        }
+    } else {
+        extent_t *merged = &set->extents[first];
+        if (start < merged->start) {
+            merged->start = start;
+        }
+        merged->end = set->extents[last - 1].end > end ? set->extents[last - 1].end : end;
+        delete_extents(set, first + 1, last);
+    }
+
+    pthread_mutex_unlock(&set->lock);
+    return result;
+}
+
+/**
+ * 从集合中去掉范围
+ */
+void extent_set_remove(extent_set_t *set, uint64_t start, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    uint64_t end = range_end(start, count);
+
+    pthread_mutex_lock(&set->lock);
+
+    uint32_t first = find_extent(set, start);
+    if (first < set->count && set->extents[first].start < start) {
+        extent_t *head = &set->extents[first];
+        if (head->end > end) {
+            // 范围落在一个范围中间：拆成两段，集合已满时丢弃后一段
+            uint64_t tail_end = head->end;
+            head->end = start;
+            if (set->count < set->max_extents) {
+                insert_extent(set, first + 1, end, tail_end);
+            }
+            pthread_mutex_unlock(&set->lock);
+            return;
+        }
+        head->end = start;
+        first++;
+    }
+
+    uint32_t last = first;
+    while (last < set->count && set->extents[last].end <= end) {
+        last++;
+    }
+    delete_extents(set, first, last);
+    if (first < set->count && set->extents[first].start < end) {
+        set->extents[first].start = end;
+    }
+
+    pthread_mutex_unlock(&set->lock);
+}
+
+/**
+ * 查找块是否在集合中
+ */
+int extent_set_lookup(extent_set_t *set, uint64_t block, uint64_t *run) {
+    pthread_mutex_lock(&set->lock);
+
+    int found = 0;
+    uint64_t length = UINT64_MAX;
+    uint32_t index = find_extent(set, block);
+    if (index < set->count) {
+        if (set->extents[index].start <= block) {
+            found = 1;
+            length = set->extents[index].end - block;
+        } else {
+            length = set->extents[index].start - block;
+        }
+    }
+
+    pthread_mutex_unlock(&set->lock);
+    if (run) {
+        *run = length;
+    }
+    return found;
+}
+
+/**
+ * 清空集合
+ */
+void extent_set_clear(extent_set_t *set) {
+    pthread_mutex_lock(&set->lock);
+    __atomic_store_n(&set->count, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&set->lock);
+}
+
+/**
+ * 获取范围数
+ */
+uint32_t extent_set_count(extent_set_t *set) {
+    return __atomic_load_n(&set->count, __ATOMIC_RELAXED);
+}
+
+/**
+ * 获取集合覆盖的总块数
+ */
+uint64_t extent_set_blocks(extent_set_t *set) {
+    pthread_mutex_lock(&set->lock);
+    uint64_t blocks = 0;
+    for (uint32_t i = 0; i < set->count; i++) {
+        blocks += set->extents[i].end - set->extents[i].start;
+    }
+    pthread_mutex_unlock(&set->lock);
+    return blocks;
+}
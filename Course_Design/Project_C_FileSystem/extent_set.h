@@ -0,0 +1,81 @@
+/**
+ * Block Extent Set Header
+ * extent_set.h
+ *
+ * A thread-safe set of block ranges, kept as a sorted array of disjoint,
+ * non-adjacent [start, start + count) extents. Adding a range merges it with
+ * every extent it overlaps or touches; removing one trims or splits the
+ * extents it covers. The disk simulator uses it to remember which blocks
+ * have been discarded, so reads of them can be answered with zeros without
+ * touching the image.
+ *
+ * The array never grows beyond the limit given at creation. An add that
+ * would need more extents fails, and a remove that has to split an extent
+ * while the set is full drops the part after the removed range, so the set
+ * can only ever under-report.
+ */
+
+#ifndef _EXTENT_SET_H_
+#define _EXTENT_SET_H_
+
+#include <stdint.h>
+
+/* Set internals live in extent_set.c */
+typedef struct extent_set extent_set_t;
+
+/*==============================================================================
+ * EXTENT SET OPERATIONS
+ *============================================================================*/
+
+/**
+ * Create an empty set
+ *
+ * @param max_extents Largest number of disjoint extents the set may hold
+ * @return New set, or NULL on allocation failure or a zero limit
+ */
+extent_set_t* extent_set_create(uint32_t max_extents);
+
+/**
+ * Free a set
+ */
+void extent_set_destroy(extent_set_t *set);
+
+/**
+ * Add a range, merging it with overlapping and adjacent extents
+ *
+ * @return 0 on success, -ENOSPC if the set is full and the range could not be merged
+ */
+int extent_set_add(extent_set_t *set, uint64_t start, uint64_t count);
+
+/**
+ * Remove a range from every extent it overlaps
+ */
+void extent_set_remove(extent_set_t *set, uint64_t start, uint64_t count);
+
+/**
+ * Look up a block
+ *
+ * @param block Block to look up
+ * @param run Receives, if the block is in the set, the blocks from it to the
+ *            end of its extent; otherwise the blocks from it to the next
+ *            extent (UINT64_MAX if there is none)
+ * @return 1 if the block is in the set, 0 if not
+ */
+int extent_set_lookup(extent_set_t *set, uint64_t block, uint64_t *run);
+
+/**
+ * Remove every extent
+ */
+void extent_set_clear(extent_set_t *set);
+
+/**
+ * Number of extents (lock-free; callers use it to skip empty sets)
+ */
+uint32_t extent_set_count(extent_set_t *set);
+
+/**
+ * Total blocks covered by the set
+ */
+uint64_t extent_set_blocks(extent_set_t *set);
+
+#endif /* _EXTENT_SET_H_ */
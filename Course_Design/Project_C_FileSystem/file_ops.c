@@ -27,9 +27,12 @@ extern fs_state_t g_fs_state;
 static fs_error_t load_filesystem_state_if_needed(void);
 static fs_error_t read_inode_from_disk(uint32_t inode_number, fs_inode_t *inode);
 static fs_error_t write_inode_to_disk(uint32_t inode_number, const fs_inode_t *inode);
-static uint32_t alloc_data_block_from_bitmap(void);
-static void free_data_block_to_bitmap(uint32_t block_num);
+static uint64_t alloc_data_block_from_bitmap(void);
+static void free_data_block_to_bitmap(uint64_t block_num);
 static time_t current_time(void);
+static uint64_t monotonic_ns(void);
+static void file_readahead(fs_file_handle_t *handle, const fs_inode_t *inode,
+                           uint32_t first_index, uint32_t last_index);
 
 /*==============================================================================
  * 文件读写操作实现
@@ -40,6 +43,7 @@ static time_t current_time(void);
  */
 int fs_write(int fd, const char* data, int size) {
     printf("写入文件: fd=%d, size=%d\n", fd, size);
+    uint64_t start_ns = monotonic_ns();
     
     // 参数验证
     if (!data || size <= 0) {
@@ -89,55 +93,95 @@ int fs_write(int fd, const char* data, int size) {
     
     printf("写入范围: %lu -> %lu\n", start_offset, end_offset);
     
-    // 按块写入数据
+    // 按批写入数据：整块直接从用户缓冲区写出，首尾不完整的块先读出再合并
+    uint32_t block_size = fs_ops_block_size();
+    char *partial_blocks = (char *)malloc(2 * (size_t)block_size);
+    if (!partial_blocks) {
+        return FS_ERROR_NO_MEMORY;
+    }
     for (uint64_t current_offset = start_offset; current_offset < end_offset; ) {
-        // 计算当前块位置
-        uint32_t block_index, block_offset;
-        file_ops_calculate_block_position(current_offset, &block_index, &block_offset);
+        disk_block_vec_t vec[FILE_OPS_IO_BATCH];
+        disk_block_vec_t partial_vec[2];
+        uint32_t block_offsets[FILE_OPS_IO_BATCH];
+        uint32_t lengths[FILE_OPS_IO_BATCH];
+        int count = 0, partial_count = 0, stop = 0;
+        uint64_t batch_offset = current_offset;
         
-        // 获取或分配数据块
-        uint32_t block_num = file_ops_get_data_block(&inode, block_index);
-        if (block_num == 0) {
-            // 需要分配新块
-            block_num = file_ops_allocate_data_block(&inode, block_index);
+        while (count < FILE_OPS_IO_BATCH && batch_offset < end_offset) {
+            // 计算当前块位置
+            uint32_t block_index, block_offset;
+            file_ops_calculate_block_position(batch_offset, &block_index, &block_offset);
+            
+            // 获取或分配数据块
+            uint64_t block_num = file_ops_get_data_block(&inode, block_index);
             if (block_num == 0) {
-                printf("错误：无法分配数据块\n");
-                break;
+                // 需要分配新块
+                block_num = file_ops_allocate_data_block(&inode, block_index);
+                if (block_num == 0) {
+                    printf("错误：无法分配数据块\n");
+                    stop = 1;
+                    break;
+                }
+                printf("分配新数据块: %lu (索引: %u)\n", block_num, block_index);
+            }
+            
+            // 计算本次写入的字节数
+            uint32_t bytes_to_write = block_size - block_offset;
+            if (bytes_to_write > end_offset - batch_offset) {
+                bytes_to_write = end_offset - batch_offset;
+            }
+            
+            vec[count].block_num = block_num;
+            if (bytes_to_write == block_size) {
+                vec[count].buffer = (char *)(data + (batch_offset - start_offset));
+            } else {
+                // 部分写入需要保留块中原有数据
+                vec[count].buffer = partial_blocks + (size_t)partial_count * block_size;
+                partial_vec[partial_count++] = vec[count];
             }
-            printf("分配新数据块: %u (索引: %u)\n", block_num, block_index);
+            block_offsets[count] = block_offset;
+            lengths[count] = bytes_to_write;
+            count++;
+            batch_offset += bytes_to_write;
         }
         
-        // 读取现有块数据（用于部分写入）
-        char block_data[BLOCK_SIZE];
-        int disk_result = disk_read_block(block_num, block_data);
-        if (disk_result != DISK_SUCCESS) {
-            printf("错误：读取数据块失败\n");
+        if (count == 0) {
             break;
         }
         
-        // 计算本次写入的字节数
-        uint32_t bytes_to_write = BLOCK_SIZE - block_offset;
-        uint32_t remaining_bytes = size - bytes_written;
-        if (bytes_to_write > remaining_bytes) {
-            bytes_to_write = remaining_bytes;
+        // 读取部分写入块的现有数据
+        if (partial_count > 0 &&
+            disk_handle_readv_blocks(fs_ops_disk(), partial_vec, partial_count) != DISK_SUCCESS) {
+            printf("错误：读取数据块失败\n");
+            break;
         }
         
-        // 复制数据到块中
-        memcpy(block_data + block_offset, data + bytes_written, bytes_to_write);
+        uint64_t data_pos = current_offset - start_offset;
+        for (int i = 0; i < count; i++) {
+            if (lengths[i] != block_size) {
+                memcpy(vec[i].buffer + block_offsets[i], data + data_pos, lengths[i]);
+            }
+            data_pos += lengths[i];
+        }
         
-        // 写入块到磁盘
-        disk_result = disk_write_block(block_num, block_data);
-        if (disk_result != DISK_SUCCESS) {
+        // 整批交给I/O调度队列（未启用队列时直接写入磁盘）
+        if (disk_handle_queue_writev(fs_ops_disk(), vec, count) != DISK_SUCCESS) {
             printf("错误：写入数据块失败\n");
             break;
         }
         
         // 更新计数器
-        bytes_written += bytes_to_write;
-        current_offset += bytes_to_write;
+        for (int i = 0; i < count; i++) {
+            bytes_written += lengths[i];
+            printf("写入块 %lu: 偏移=%u, 字节=%u\n", vec[i].block_num, block_offsets[i], lengths[i]);
+        }
+        current_offset = batch_offset;
         
-        printf("写入块 %u: 偏移=%u, 字节=%u\n", block_num, block_offset, bytes_to_write);
+        if (stop) {
+            break;
+        }
     }
+    free(partial_blocks);
     
     // 更新inode信息
     if (bytes_written > 0) {
@@ -147,7 +191,7 @@ int fs_write(int fd, const char* data, int size) {
             inode.file_size = new_size;
             
             // 更新块计数（简化计算）
-            inode.block_count = (inode.file_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            inode.block_count = (inode.file_size + block_size - 1) / block_size;
         }
         
         // 更新时间戳
@@ -168,6 +212,9 @@ int fs_write(int fd, const char* data, int size) {
                bytes_written, handle->file_position, inode.file_size);
     }
     
+    latency_hist_record(&g_fs_state.write_latency, monotonic_ns() - start_ns);
+    fs_ops_update_cache_stats();
+    
     return bytes_written;
 }
 
@@ -176,6 +223,7 @@ int fs_write(int fd, const char* data, int size) {
  */
 int fs_read(int fd, char* buffer, int size) {
     printf("读取文件: fd=%d, size=%d\n", fd, size);
+    uint64_t start_ns = monotonic_ns();
     
     // 参数验证
     if (!buffer || size <= 0) {
@@ -236,46 +284,81 @@ int fs_read(int fd, char* buffer, int size) {
     
     printf("读取范围: %lu -> %lu (文件大小: %lu)\n", start_offset, end_offset, inode.file_size);
     
-    // 按块读取数据
+    // 按批读取数据：整块直接读入用户缓冲区，首尾不完整的块经中转缓冲区
+    uint32_t block_size = fs_ops_block_size();
+    char *partial_blocks = (char *)malloc(2 * (size_t)block_size);
+    if (!partial_blocks) {
+        return FS_ERROR_NO_MEMORY;
+    }
     for (uint64_t current_offset = start_offset; current_offset < end_offset; ) {
-        // 计算当前块位置
-        uint32_t block_index, block_offset;
-        file_ops_calculate_block_position(current_offset, &block_index, &block_offset);
+        disk_block_vec_t vec[FILE_OPS_IO_BATCH];
+        uint32_t block_offsets[FILE_OPS_IO_BATCH];
+        uint32_t lengths[FILE_OPS_IO_BATCH];
+        int count = 0, partial_count = 0, stop = 0;
+        uint64_t batch_offset = current_offset;
+        
+        while (count < FILE_OPS_IO_BATCH && batch_offset < end_offset) {
+            // 计算当前块位置
+            uint32_t block_index, block_offset;
+            file_ops_calculate_block_position(batch_offset, &block_index, &block_offset);
+            
+            // 获取数据块号
+            uint64_t block_num = file_ops_get_data_block(&inode, block_index);
+            if (block_num == 0) {
+                printf("错误：数据块未分配 (索引: %u)\n", block_index);
+                stop = 1;
+                break;
+            }
+            
+            // 计算本次读取的字节数
+            uint32_t bytes_to_read = block_size - block_offset;
+            if (bytes_to_read > end_offset - batch_offset) {
+                bytes_to_read = end_offset - batch_offset;
+            }
+            
+            vec[count].block_num = block_num;
+            vec[count].buffer = (bytes_to_read == block_size)
+                                ? buffer + (batch_offset - start_offset)
+                                : partial_blocks + (size_t)(partial_count++) * block_size;
+            block_offsets[count] = block_offset;
+            lengths[count] = bytes_to_read;
+            count++;
+            batch_offset += bytes_to_read;
+        }
         
-        // 获取数据块号
-        uint32_t block_num = file_ops_get_data_block(&inode, block_index);
-        if (block_num == 0) {
-            printf("错误：数据块未分配 (索引: %u)\n", block_index);
+        if (count == 0) {
             break;
         }
         
-        // 读取块数据
-        char block_data[BLOCK_SIZE];
-        int disk_result = disk_read_block(block_num, block_data);
-        if (disk_result != DISK_SUCCESS) {
+        // 整批读取块数据
+        if (disk_handle_readv_blocks(fs_ops_disk(), vec, count) != DISK_SUCCESS) {
             printf("错误：读取数据块失败\n");
             break;
         }
         
-        // 计算本次读取的字节数
-        uint32_t bytes_to_read = BLOCK_SIZE - block_offset;
-        uint32_t remaining_bytes = size - bytes_read;
-        if (bytes_to_read > remaining_bytes) {
-            bytes_to_read = remaining_bytes;
+        // 复制不完整块的数据到缓冲区，更新计数器
+        for (int i = 0; i < count; i++) {
+            if (lengths[i] != block_size) {
+                memcpy(buffer + bytes_read, vec[i].buffer + block_offsets[i], lengths[i]);
+            }
+            bytes_read += lengths[i];
+            printf("读取块 %lu: 偏移=%u, 字节=%u\n", vec[i].block_num, block_offsets[i], lengths[i]);
         }
+        current_offset = batch_offset;
         
-        // 复制数据到缓冲区
-        memcpy(buffer + bytes_read, block_data + block_offset, bytes_to_read);
-        
-        // 更新计数器
-        bytes_read += bytes_to_read;
-        current_offset += bytes_to_read;
-        
-        printf("读取块 %u: 偏移=%u, 字节=%u\n", block_num, block_offset, bytes_to_read);
+        if (stop) {
+            break;
+        }
     }
+    free(partial_blocks);
     
     // 更新文件位置和访问时间
     if (bytes_read > 0) {
+        uint32_t first_index, last_index;
+        file_ops_calculate_block_position(start_offset, &first_index, NULL);
+        file_ops_calculate_block_position(start_offset + bytes_read - 1, &last_index, NULL);
+        file_readahead(handle, &inode, first_index, last_index);
+        
         handle->file_position += bytes_read;
         
         // 更新访问时间
@@ -285,6 +368,9 @@ int fs_read(int fd, char* buffer, int size) {
         printf("文件读取完成: %d 字节，新位置: %lu\n", bytes_read, handle->file_position);
     }
     
+    latency_hist_record(&g_fs_state.read_latency, monotonic_ns() - start_ns);
+    fs_ops_update_cache_stats();
+    
     return bytes_read;
 }
 
@@ -387,6 +473,70 @@ int fs_size(int fd) {
     return inode.file_size;
 }
 
+/**
+ * 把文件写入稳定存储
+ */
+int fs_fsync(int fd) {
+    // 验证文件描述符
+    fs_error_t result = file_ops_validate_fd(fd);
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
+    // 确保文件系统状态已加载
+    result = load_filesystem_state_if_needed();
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
+    fs_file_handle_t *handle = &g_fs_state.open_files[fd];
+    fs_inode_t inode;
+    result = read_inode_from_disk(handle->inode_number, &inode);
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
+    // 数据块按块号排序（插入排序，最多DIRECT_BLOCKS个）
+    uint64_t blocks[DIRECT_BLOCKS];
+    int count = 0;
+    for (int i = 0; i < DIRECT_BLOCKS; i++) {
+        uint64_t block = inode.direct_blocks[i];
+        if (block == 0) {
+            continue;
+        }
+        int j = count++;
+        while (j > 0 && blocks[j - 1] > block) {
+            blocks[j] = blocks[j - 1];
+            j--;
+        }
+        blocks[j] = block;
+    }
+    
+    // 连续的数据块合并为一次范围同步
+    for (int i = 0; i < count; ) {
+        int run = 1;
+        while (i + run < count && blocks[i + run] == blocks[i] + run) {
+            run++;
+        }
+        if (disk_handle_sync_range(fs_ops_disk(), blocks[i], run) != DISK_SUCCESS) {
+            printf("错误：同步数据块失败\n");
+            return FS_ERROR_IO;
+        }
+        i += run;
+    }
+    
+    // 数据落盘后再同步inode所在的inode表块
+    uint32_t inodes_per_block = fs_ops_block_size() / sizeof(fs_inode_t);
+    uint64_t inode_block_num = g_fs_state.superblock.inode_table_start +
+                               handle->inode_number / inodes_per_block;
+    if (disk_handle_sync_range(fs_ops_disk(), inode_block_num, 1) != DISK_SUCCESS) {
+        printf("错误：同步inode失败\n");
+        return FS_ERROR_IO;
+    }
+    
+    return FS_SUCCESS;
+}
+
 /*==============================================================================
  * 辅助函数实现
  *============================================================================*/
@@ -396,17 +546,17 @@ int fs_size(int fd) {
  */
 void file_ops_calculate_block_position(uint64_t file_offset, uint32_t* block_index, uint32_t* block_offset) {
     if (block_index) {
-        *block_index = file_offset / BLOCK_SIZE;
+        *block_index = file_offset / fs_ops_block_size();
     }
     if (block_offset) {
-        *block_offset = file_offset % BLOCK_SIZE;
+        *block_offset = file_offset % fs_ops_block_size();
     }
 }
 
 /**
  * 获取inode中指定索引的数据块号
  */
-uint32_t file_ops_get_data_block(const fs_inode_t* inode, uint32_t block_index) {
+uint64_t file_ops_get_data_block(const fs_inode_t* inode, uint32_t block_index) {
     if (!inode) {
         return 0;
     }
@@ -424,7 +574,7 @@ uint32_t file_ops_get_data_block(const fs_inode_t* inode, uint32_t block_index)
 /**
  * 分配并设置inode中指定索引的数据块
  */
-uint32_t file_ops_allocate_data_block(fs_inode_t* inode, uint32_t block_index) {
+uint64_t file_ops_allocate_data_block(fs_inode_t* inode, uint32_t block_index) {
     if (!inode) {
         return 0;
     }
@@ -432,7 +582,7 @@ uint32_t file_ops_allocate_data_block(fs_inode_t* inode, uint32_t block_index) {
     // 只支持直接块（简化实现）
     if (block_index < DIRECT_BLOCKS) {
         if (inode->direct_blocks[block_index] == 0) {
-            uint32_t new_block = alloc_data_block_from_bitmap();
+            uint64_t new_block = alloc_data_block_from_bitmap();
             if (new_block > 0) {
                 inode->direct_blocks[block_index] = new_block;
                 return new_block;
@@ -491,6 +641,12 @@ static fs_error_t load_filesystem_state_if_needed(void) {
             return result;
         }
         
+        // 继续未完成的inode表初始化
+        result = fs_ops_start_itable_init();
+        if (result != FS_SUCCESS) {
+            return result;
+        }
+        
         printf("文件系统状态加载完成\n");
     }
     
@@ -498,67 +654,23 @@ static fs_error_t load_filesystem_state_if_needed(void) {
 }
 
 /**
- * 从磁盘读取inode
+ * 从磁盘读取inode（处理inode表延迟初始化）
  */
 static fs_error_t read_inode_from_disk(uint32_t inode_number, fs_inode_t *inode) {
-    if (!inode || inode_number == 0 || inode_number >= g_fs_state.superblock.total_inodes) {
-        return FS_ERROR_INVALID_PARAM;
-    }
-    
-    // 计算inode在inode表中的位置
-    uint32_t inodes_per_block = BLOCK_SIZE / sizeof(fs_inode_t);
-    uint32_t inode_block_num = g_fs_state.superblock.inode_table_start + (inode_number / inodes_per_block);
-    uint32_t inode_offset = (inode_number % inodes_per_block) * sizeof(fs_inode_t);
-    
-    // 读取inode块
-    char inode_block[BLOCK_SIZE];
-    int result = disk_read_block(inode_block_num, inode_block);
-    if (result != DISK_SUCCESS) {
-        return FS_ERROR_IO;
-    }
-    
-    // 复制inode数据
-    memcpy(inode, inode_block + inode_offset, sizeof(fs_inode_t));
-    
-    return FS_SUCCESS;
+    return fs_ops_read_inode(inode_number, inode);
 }
 
 /**
- * 将inode写入磁盘
+ * 将inode写入磁盘（处理inode表延迟初始化）
  */
 static fs_error_t write_inode_to_disk(uint32_t inode_number, const fs_inode_t *inode) {
-    if (!inode || inode_number == 0 || inode_number >= g_fs_state.superblock.total_inodes) {
-        return FS_ERROR_INVALID_PARAM;
-    }
-    
-    // 计算inode在inode表中的位置
-    uint32_t inodes_per_block = BLOCK_SIZE / sizeof(fs_inode_t);
-    uint32_t inode_block_num = g_fs_state.superblock.inode_table_start + (inode_number / inodes_per_block);
-    uint32_t inode_offset = (inode_number % inodes_per_block) * sizeof(fs_inode_t);
-    
-    // 读取inode块
-    char inode_block[BLOCK_SIZE];
-    int result = disk_read_block(inode_block_num, inode_block);
-    if (result != DISK_SUCCESS) {
-        return FS_ERROR_IO;
-    }
-    
-    // 复制inode数据
-    memcpy(inode_block + inode_offset, inode, sizeof(fs_inode_t));
-    
-    // 写回inode块
-    result = disk_write_block(inode_block_num, inode_block);
-    if (result != DISK_SUCCESS) {
-        return FS_ERROR_IO;
-    }
-    
-    return FS_SUCCESS;
+    return fs_ops_write_inode(inode_number, inode);
 }
 
 /**
  * 从位图分配数据块
  */
-static uint32_t alloc_data_block_from_bitmap(void) {
+static uint64_t alloc_data_block_from_bitmap(void) {
     if (g_fs_state.block_bitmap.free_count == 0) {
         return 0; // 没有可用的块
     }
@@ -577,7 +689,7 @@ static uint32_t alloc_data_block_from_bitmap(void) {
             g_fs_state.block_bitmap.last_allocated = bit_num;
             
             // 转换为绝对块号
-            uint32_t block_num = bit_num + g_fs_state.superblock.data_blocks_start;
+            uint64_t block_num = bit_num + g_fs_state.superblock.data_blocks_start;
             return block_num;
         }
     }
@@ -588,12 +700,12 @@ static uint32_t alloc_data_block_from_bitmap(void) {
 /**
  * 释放数据块到位图
  */
-static void free_data_block_to_bitmap(uint32_t block_num) {
+static void free_data_block_to_bitmap(uint64_t block_num) {
     if (block_num < g_fs_state.superblock.data_blocks_start) {
         return; // 不是数据块
     }
     
-    uint32_t bit_num = block_num - g_fs_state.superblock.data_blocks_start;
+    uint32_t bit_num = (uint32_t)(block_num - g_fs_state.superblock.data_blocks_start);
     if (bit_num >= g_fs_state.block_bitmap.total_bits) {
         return; // 超出范围
     }
@@ -613,4 +725,75 @@ static void free_data_block_to_bitmap(uint32_t block_num) {
  */
 static time_t current_time(void) {
     return time(NULL);
+}
+
+/**
+ * 获取单调时钟时间（纳秒），用于统计操作延迟
+ */
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 顺序读预读
+ *
+ * 本次读取紧接上次读取（或从文件开头开始）视为顺序访问：已预读的部分
+ * 剩余不足半个窗口时窗口翻倍（从FILE_OPS_RA_MIN_BLOCKS到FILE_OPS_RA_MAX_BLOCKS），
+ * 并把后续数据块读入块缓存；随机访问时窗口缩小到四分之一，直至关闭。
+ */
+static void file_readahead(fs_file_handle_t *handle, const fs_inode_t *inode,
+                           uint32_t first_index, uint32_t last_index) {
+    int sequential = (first_index == handle->ra_prev_end) ||
+                     (first_index + 1 == handle->ra_prev_end);
+    uint32_t next = last_index + 1;
+    handle->ra_prev_end = next;
+    
+    if (!sequential) {
+        handle->ra_window /= 4;
+        handle->ra_end = 0;
+        return;
+    }
+    
+    // 已预读的数据还够用
+    if (handle->ra_end > next && handle->ra_end - next > handle->ra_window / 2) {
+        return;
+    }
+    
+    if (handle->ra_window == 0) {
+        handle->ra_window = FILE_OPS_RA_MIN_BLOCKS;
+    } else if (handle->ra_window < FILE_OPS_RA_MAX_BLOCKS) {
+        handle->ra_window *= 2;
+        if (handle->ra_window > FILE_OPS_RA_MAX_BLOCKS) {
+            handle->ra_window = FILE_OPS_RA_MAX_BLOCKS;
+        }
+    }
+    
+    uint32_t block_size = fs_ops_block_size();
+    uint64_t file_blocks = (inode->file_size + block_size - 1) / block_size;
+    uint32_t start = handle->ra_end > next ? handle->ra_end : next;
+    uint64_t end = (uint64_t)next + handle->ra_window;
+    if (end > file_blocks) {
+        end = file_blocks;
+    }
+    if (end > DIRECT_BLOCKS) {
+        end = DIRECT_BLOCKS;
+    }
+    if (start >= end) {
+        return;
+    }
+    
+    uint64_t blocks[FILE_OPS_RA_MAX_BLOCKS];
+    int count = 0;
+    for (uint32_t index = start; index < end; index++) {
+        uint64_t block_num = file_ops_get_data_block(inode, index);
+        if (block_num != 0) {
+            blocks[count++] = block_num;
+        }
+    }
+    
+    if (count == 0 || disk_handle_prefetch_blocks(fs_ops_disk(), blocks, count) >= 0) {
+        handle->ra_end = (uint32_t)end;
+    }
 } 
\ No newline at end of file
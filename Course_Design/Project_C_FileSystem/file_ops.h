@@ -28,6 +28,13 @@
 #define SEEK_CUR            1           // 从当前位置
 #define SEEK_END            2           // 从文件末尾
 
+// 批量I/O：每次分散读写请求包含的最大块数
+#define FILE_OPS_IO_BATCH   16
+
+// 顺序读预读窗口（块数）：检测到顺序读时从最小值开始，每次触发预读翻倍
+#define FILE_OPS_RA_MIN_BLOCKS  4
+#define FILE_OPS_RA_MAX_BLOCKS  32
+
 /*==============================================================================
  * 文件读写操作函数声明
  *============================================================================*/
@@ -89,6 +96,17 @@ int fs_tell(int fd);
  */
 int fs_size(int fd);
 
+/**
+ * 把文件写入稳定存储
+ * 
+ * 只同步该文件的数据块（连续的块合并为一次范围同步）和它的inode所在
+ * 的inode表块，数据先于inode落盘；其他文件未同步的写入不受影响。
+ * 
+ * @param fd 文件描述符
+ * @return 0（成功），或负数错误码（失败）
+ */
+int fs_fsync(int fd);
+
 /*==============================================================================
  * 辅助函数声明（内部使用）
  *============================================================================*/
@@ -109,7 +127,7 @@ void file_ops_calculate_block_position(uint64_t file_offset, uint32_t* block_ind
  * @param block_index 块索引
  * @return 数据块号，0表示未分配
  */
-uint32_t file_ops_get_data_block(const fs_inode_t* inode, uint32_t block_index);
+uint64_t file_ops_get_data_block(const fs_inode_t* inode, uint32_t block_index);
 
 /**
  * 分配并设置inode中指定索引的数据块
@@ -118,7 +136,7 @@ uint32_t file_ops_get_data_block(const fs_inode_t* inode, uint32_t block_index);
  * @param block_index 块索引
  * @return 分配的数据块号，0表示失败
  */
-uint32_t file_ops_allocate_data_block(fs_inode_t* inode, uint32_t block_index);
+uint64_t file_ops_allocate_data_block(fs_inode_t* inode, uint32_t block_index);
 
 /**
  * 验证文件描述符的有效性
@@ -31,12 +31,12 @@ int main(void) {
     }
     
     // 获取磁盘信息
-    uint32_t total_blocks, block_size;
-    uint64_t disk_size;
+    uint64_t total_blocks, disk_size;
+    uint32_t block_size;
     result = disk_get_info(&total_blocks, &block_size, &disk_size);
     if (result == DISK_SUCCESS) {
         printf("磁盘已初始化:\n");
-        printf("  总块数: %u\n", total_blocks);
+        printf("  总块数: %lu\n", total_blocks);
         printf("  块大小: %u 字节\n", block_size);
         printf("  磁盘大小: %lu 字节\n", disk_size);
     }
@@ -54,15 +54,15 @@ int main(void) {
         printf("  文件系统魔数: 0x%x\n", sb.magic_number);
         printf("  版本: %u\n", sb.version);
         printf("  总inode数: %u (可用: %u)\n", sb.total_inodes, sb.free_inodes);
-        printf("  数据块起始: %u\n", sb.data_blocks_start);
+        printf("  数据块起始: %lu\n", sb.data_blocks_start);
         printf("  根目录inode: %u\n", sb.root_inode);
         
         // 计算存储效率
-        uint32_t used_blocks = total_blocks - sb.free_blocks;
+        uint64_t used_blocks = total_blocks - sb.free_blocks;
         uint32_t used_inodes = sb.total_inodes - sb.free_inodes;
         
         printf("\n存储利用率:\n");
-        printf("  已用块数: %u / %u (%.1f%%)\n", 
+        printf("  已用块数: %lu / %lu (%.1f%%)\n", 
                used_blocks, total_blocks, 
                (used_blocks * 100.0) / total_blocks);
         printf("  已用inode: %u / %u (%.1f%%)\n", 
@@ -77,12 +77,12 @@ int main(void) {
     printf("\n步骤 4: 验证根目录...\n");
     
     // 计算根目录inode在inode表中的位置
-    uint32_t inodes_per_block = DISK_BLOCK_SIZE / sizeof(fs_inode_t);
+    uint32_t inodes_per_block = disk_get_block_size() / sizeof(fs_inode_t);
     uint32_t inode_block_num = sb.inode_table_start + (ROOT_INODE_NUM / inodes_per_block);
     uint32_t inode_offset = (ROOT_INODE_NUM % inodes_per_block) * sizeof(fs_inode_t);
     
     // 读取根目录inode
-    char inode_block[DISK_BLOCK_SIZE];
+    char inode_block[disk_get_block_size()];
     result = disk_read_block(inode_block_num, inode_block);
     if (result == DISK_SUCCESS) {
         fs_inode_t *root_inode = (fs_inode_t *)(inode_block + inode_offset);
@@ -94,10 +94,10 @@ int main(void) {
         printf("  所有者: UID=%u, GID=%u\n", root_inode->owner_uid, root_inode->owner_gid);
         printf("  大小: %lu 字节\n", root_inode->file_size);
         printf("  链接数: %u\n", root_inode->link_count);
-        printf("  数据块: %u\n", root_inode->direct_blocks[0]);
+        printf("  数据块: %lu\n", root_inode->direct_blocks[0]);
         
         // 读取根目录内容
-        char dir_block[DISK_BLOCK_SIZE];
+        char dir_block[disk_get_block_size()];
         result = disk_read_block(root_inode->direct_blocks[0], dir_block);
         if (result == DISK_SUCCESS) {
             fs_dir_entry_t *entries = (fs_dir_entry_t *)dir_block;
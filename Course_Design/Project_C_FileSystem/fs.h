@@ -21,13 +21,18 @@
 #include <time.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include "latency_hist.h"
+
+/* Disk handle (disk_t in disk_simulator.h) */
+struct disk_state;
 
 /*==============================================================================
  * FILESYSTEM CONSTANTS AND CONFIGURATION
  *============================================================================*/
 
 #define FS_MAGIC_NUMBER     0x53465321      // "SFS!" - Simple File System magic
-#define BLOCK_SIZE          1024            // Size of each data block in bytes
+#define FS_VERSION          2               // On-disk format version (2 = 64-bit block numbers)
+#define BLOCK_SIZE          1024            // Default data block size (actual size is in the superblock)
 #define MAX_FILENAME_LEN    64              // Maximum length of a filename
 #define MAX_PATH_LEN        256             // Maximum path length
 #define DIRECT_BLOCKS       12              // Number of direct block pointers in inode
@@ -37,6 +42,11 @@
 #define MAX_OPEN_FILES      64              // Maximum simultaneously open files
 #define MAX_USERS           32              // Maximum number of users
 #define ROOT_INODE_NUM      1               // Root directory inode number (0 is reserved)
+#define FS_DISCARD_BATCH_BLOCKS 256         // Freed data blocks collected before an online discard
+
+/* Superblock feature flags */
+#define FS_FEATURE_LAZY_ITABLE  0x1         // Inode table is zeroed lazily (see itable_zeroed)
+#define FS_FEATURE_CRC32C       0x2         // Superblock checksum is CRC32C (CRC32 if clear)
 
 /*==============================================================================
  * FILE SYSTEM TYPES AND ENUMS
@@ -117,18 +127,18 @@ typedef struct {
     /* File system identification */
     uint32_t    magic_number;               // Magic number for file system identification
     uint32_t    version;                    // File system version number
-    uint32_t    block_size;                 // Size of each data block (should be BLOCK_SIZE)
+    uint32_t    block_size;                 // Size of each data block (matches the disk block size)
     
     /* Size and capacity information */
-    uint32_t    total_blocks;               // Total number of blocks in file system
+    uint64_t    total_blocks;               // Total number of blocks in file system
     uint32_t    total_inodes;               // Total number of inodes available
-    uint32_t    free_blocks;                // Number of free data blocks
+    uint64_t    free_blocks;                // Number of free data blocks
     uint32_t    free_inodes;                // Number of free inodes
     
     /* Layout information */
-    uint32_t    inode_table_start;          // Starting block of inode table
+    uint64_t    inode_table_start;          // Starting block of inode table
     uint32_t    inode_table_blocks;         // Number of blocks in inode table
-    uint32_t    data_blocks_start;          // Starting block of data area
+    uint64_t    data_blocks_start;          // Starting block of data area
     uint32_t    root_inode;                 // Inode number of root directory
     
     /* File system state and statistics */
@@ -139,8 +149,12 @@ typedef struct {
     time_t      last_write_time;            // Last write operation timestamp
     time_t      last_check_time;            // Last file system check timestamp
     
+    /* Optional features */
+    uint32_t    features;                   // FS_FEATURE_* flags (0 on older images)
+    uint32_t    itable_zeroed;              // Leading inode table blocks known to be initialized
+    
     /* Reserved space for future use */
-    uint32_t    reserved[16];               // Reserved for future features
+    uint32_t    reserved[10];               // Reserved for future features
     uint32_t    checksum;                   // Superblock checksum for integrity
 } __attribute__((packed)) fs_superblock_t;
 
@@ -176,10 +190,10 @@ typedef struct {
     time_t      create_time;                // Creation time (birth time)
     
     /* Block pointers for file data */
-    uint32_t    direct_blocks[DIRECT_BLOCKS];   // Direct pointers to data blocks
-    uint32_t    indirect_block;             // Pointer to indirect block
-    uint32_t    double_indirect_block;      // Pointer to double indirect block (future use)
-    uint32_t    triple_indirect_block;      // Pointer to triple indirect block (future use)
+    uint64_t    direct_blocks[DIRECT_BLOCKS];   // Direct pointers to data blocks
+    uint64_t    indirect_block;             // Pointer to indirect block
+    uint64_t    double_indirect_block;      // Pointer to double indirect block (future use)
+    uint64_t    triple_indirect_block;      // Pointer to triple indirect block (future use)
     
     /* Additional metadata */
     uint32_t    flags;                      // File flags (immutable, append-only, etc.)
@@ -237,6 +251,11 @@ typedef struct {
     uint32_t    reference_count;            // Number of references to this handle
     time_t      open_time;                  // Time when file was opened
     uint32_t    owner_uid;                  // UID of process that opened file
+    
+    /* Readahead state */
+    uint32_t    ra_prev_end;                // Logical block after the last one read
+    uint32_t    ra_window;                  // Current readahead window in blocks (0 = off)
+    uint32_t    ra_end;                     // Logical block after the last one prefetched
 } fs_file_handle_t;
 
 /**
@@ -262,6 +281,9 @@ typedef struct {
  * This structure ties together all the components.
  */
 typedef struct {
+    /* Backing device */
+    struct disk_state   *disk;                          // Disk holding the file system (NULL = default disk)
+    
     /* Core file system components */
     fs_superblock_t     superblock;                     // File system metadata
     fs_bitmap_t         inode_bitmap;                   // Inode allocation bitmap
@@ -284,6 +306,17 @@ typedef struct {
     uint32_t            total_writes;                   // Total write operations
     uint32_t            cache_hits;                     // Cache hit count
     uint32_t            cache_misses;                   // Cache miss count
+    uint32_t            readahead_blocks;               // Blocks prefetched by readahead
+    uint32_t            readahead_hits;                 // Prefetched blocks that were read
+    uint32_t            readahead_wasted;               // Prefetched blocks dropped unread
+    latency_hist_t      read_latency;                   // fs_read() latency
+    latency_hist_t      write_latency;                  // fs_write() latency
+    
+    /* Discard of freed blocks */
+    uint8_t             online_discard;                 // Discard data blocks as they are freed (batched)
+    uint32_t            discard_pending;                // Freed blocks waiting in discard_batch
+    uint64_t            discard_batch[FS_DISCARD_BATCH_BLOCKS]; // Freed data blocks not yet discarded
+    uint64_t            discarded_blocks;               // Blocks discarded online or by fs_ops_trim()
 } fs_state_t;
 
 /*==============================================================================
@@ -307,7 +340,7 @@ fs_error_t fs_init(void);
  * Create a new file system
  * Formats the storage and creates initial superblock, root directory, etc.
  */
-fs_error_t fs_create_filesystem(uint32_t total_blocks);
+fs_error_t fs_create_filesystem(uint64_t total_blocks);
 
 /**
  * Mount the file system
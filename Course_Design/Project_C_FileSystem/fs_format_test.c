@@ -96,15 +96,15 @@ void test_disk_initialization(void) {
     TEST_ASSERT(disk_is_initialized(), "磁盘初始化状态检查");
     
     // 获取磁盘信息
-    uint32_t total_blocks, block_size;
-    uint64_t disk_size;
+    uint64_t total_blocks, disk_size;
+    uint32_t block_size;
     result = disk_get_info(&total_blocks, &block_size, &disk_size);
     TEST_ASSERT(result == DISK_SUCCESS, "获取磁盘信息");
     TEST_ASSERT(block_size == DISK_BLOCK_SIZE, "块大小验证");
     TEST_ASSERT(disk_size == TEST_DISK_SIZE, "磁盘大小验证");
     TEST_ASSERT(total_blocks == TEST_DISK_SIZE / DISK_BLOCK_SIZE, "总块数验证");
     
-    printf("磁盘信息: %u 块，每块 %u 字节，总大小 %lu 字节\n", 
+    printf("磁盘信息: %lu 块，每块 %u 字节，总大小 %lu 字节\n", 
            total_blocks, block_size, disk_size);
 }
 
@@ -133,7 +133,7 @@ void test_superblock_verification(void) {
     
     if (result == FS_SUCCESS) {
         TEST_ASSERT(sb.magic_number == FS_MAGIC_NUMBER, "魔数验证");
-        TEST_ASSERT(sb.version == 1, "版本号验证");
+        TEST_ASSERT(sb.version == FS_VERSION, "版本号验证");
         TEST_ASSERT(sb.block_size == BLOCK_SIZE, "块大小验证");
         TEST_ASSERT(sb.total_inodes == FS_DEFAULT_MAX_INODES, "总inode数验证");
         TEST_ASSERT(sb.root_inode == ROOT_INODE_NUM, "根inode号验证");
@@ -143,10 +143,10 @@ void test_superblock_verification(void) {
         printf("超级块详细信息:\n");
         printf("  魔数: 0x%x\n", sb.magic_number);
         printf("  版本: %u\n", sb.version);
-        printf("  总块数: %u\n", sb.total_blocks);
+        printf("  总块数: %lu\n", sb.total_blocks);
         printf("  总inode数: %u (空闲: %u)\n", sb.total_inodes, sb.free_inodes);
-        printf("  inode表起始: %u\n", sb.inode_table_start);
-        printf("  数据块起始: %u\n", sb.data_blocks_start);
+        printf("  inode表起始: %lu\n", sb.inode_table_start);
+        printf("  数据块起始: %lu\n", sb.data_blocks_start);
         printf("  根inode: %u\n", sb.root_inode);
     }
 }
@@ -260,7 +260,7 @@ void test_root_directory_verification(void) {
     printf("  类型: %u (目录)\n", root_inode->file_type);
     printf("  权限: 0%o\n", root_inode->permissions);
     printf("  大小: %lu 字节\n", root_inode->file_size);
-    printf("  数据块: %u\n", root_inode->direct_blocks[0]);
+    printf("  数据块: %lu\n", root_inode->direct_blocks[0]);
     
     // 读取根目录数据块
     char dir_block[DISK_BLOCK_SIZE];
@@ -309,7 +309,7 @@ void test_data_persistence(void) {
     
     if (fs_result == FS_SUCCESS) {
         TEST_ASSERT(sb.magic_number == FS_MAGIC_NUMBER, "持久化后魔数验证");
-        TEST_ASSERT(sb.version == 1, "持久化后版本验证");
+        TEST_ASSERT(sb.version == FS_VERSION, "持久化后版本验证");
         TEST_ASSERT(sb.root_inode == ROOT_INODE_NUM, "持久化后根inode验证");
         
         printf("数据持久性验证通过\n");
@@ -30,18 +30,28 @@ fs_state_t g_fs_state = {0};
 #define FS_OPEN_TRUNCATE    0x10        // 截断文件
 #define FS_OPEN_EXCL        0x20        // 排他性创建
 
+// 元数据块的栈缓冲区大小，更大的块回退到disk_get_block的堆副本
+#define FS_STACK_BLOCK_SIZE 4096
+
 /*==============================================================================
  * 工具函数实现
  *============================================================================*/
 
 /**
- * 计算校验和 - 简单的CRC32实现
+ * 计算校验和 - CRC32C（支持时使用硬件指令）
  */
 uint32_t fs_ops_calculate_checksum(const void *data, size_t size) {
     if (!data || size == 0) {
         return 0;
     }
     
+    return crc32c(0, data, size);
+}
+
+/**
+ * 旧版超级块使用的逐位CRC32
+ */
+static uint32_t legacy_crc32(const void *data, size_t size) {
     const uint8_t *bytes = (const uint8_t *)data;
     uint32_t checksum = 0xFFFFFFFF;
     
@@ -59,6 +69,19 @@ uint32_t fs_ops_calculate_checksum(const void *data, size_t size) {
     return ~checksum;
 }
 
+/**
+ * 计算超级块校验和（不包括校验和字段本身）
+ * 
+ * 设置了FS_FEATURE_CRC32C的超级块使用CRC32C，更早格式化的使用CRC32。
+ */
+static uint32_t superblock_checksum(const fs_superblock_t *sb) {
+    size_t size = offsetof(fs_superblock_t, checksum);
+    if (sb->features & FS_FEATURE_CRC32C) {
+        return fs_ops_calculate_checksum(sb, size);
+    }
+    return legacy_crc32(sb, size);
+}
+
 /**
  * 获取当前时间
  */
@@ -66,6 +89,72 @@ time_t fs_ops_current_time(void) {
     return time(NULL);
 }
 
+/**
+ * 选择文件系统所在的磁盘
+ */
+void fs_ops_set_disk(disk_t *disk) {
+    g_fs_state.disk = disk;
+}
+
+/**
+ * 获取文件系统所在的磁盘（未指定时为默认磁盘）
+ */
+disk_t *fs_ops_disk(void) {
+    return g_fs_state.disk ? g_fs_state.disk : disk_default();
+}
+
+/**
+ * 获取文件系统块大小
+ */
+uint32_t fs_ops_block_size(void) {
+    if (g_fs_state.superblock.magic_number == FS_MAGIC_NUMBER) {
+        return g_fs_state.superblock.block_size;
+    }
+    return disk_handle_get_block_size(fs_ops_disk());
+}
+
+/**
+ * 获取元数据块
+ * 
+ * mmap模式下直接返回映射指针（零拷贝）；否则读入调用方的栈缓冲区，
+ * 避免每次访问都分配并复制一整块。
+ */
+static int fs_block_get(uint64_t block_num, char *stack_buf, int writable, char **data) {
+    if (disk_handle_is_mapped(fs_ops_disk()) || fs_ops_block_size() > FS_STACK_BLOCK_SIZE) {
+        if (writable) {
+            return disk_handle_get_block_mut(fs_ops_disk(), block_num, data);
+        }
+        return disk_handle_get_block(fs_ops_disk(), block_num, (const char **)data);
+    }
+    
+    *data = stack_buf;
+    return disk_handle_read_block(fs_ops_disk(), block_num, stack_buf);
+}
+
+/**
+ * 释放fs_block_get获取的元数据块，dirty非零时写回（经I/O调度队列）
+ */
+static int fs_block_put(uint64_t block_num, char *data, const char *stack_buf, int dirty) {
+    if (data != stack_buf) {
+        return disk_handle_put_block(fs_ops_disk(), block_num, data, dirty);
+    }
+    return dirty ? disk_handle_queue_write(fs_ops_disk(), block_num, data) : DISK_SUCCESS;
+}
+
+/**
+ * 更新缓存统计
+ */
+void fs_ops_update_cache_stats(void) {
+    disk_stats_t stats;
+    if (disk_handle_get_stats(fs_ops_disk(), &stats) == DISK_SUCCESS) {
+        g_fs_state.cache_hits = (uint32_t)stats.cache_hits;
+        g_fs_state.cache_misses = (uint32_t)stats.cache_misses;
+        g_fs_state.readahead_blocks = (uint32_t)stats.readahead_blocks;
+        g_fs_state.readahead_hits = (uint32_t)stats.readahead_hits;
+        g_fs_state.readahead_wasted = (uint32_t)stats.readahead_wasted;
+    }
+}
+
 /**
  * 错误码转换为字符串
  */
@@ -97,7 +186,7 @@ const char* fs_ops_error_to_string(fs_error_t error) {
 /**
  * 初始化超级块
  */
-fs_error_t fs_ops_init_superblock(fs_superblock_t *sb, uint32_t total_blocks) {
+fs_error_t fs_ops_init_superblock(fs_superblock_t *sb, uint64_t total_blocks) {
     if (!sb) {
         return FS_ERROR_INVALID_PARAM;
     }
@@ -107,20 +196,22 @@ fs_error_t fs_ops_init_superblock(fs_superblock_t *sb, uint32_t total_blocks) {
     
     // 文件系统标识信息
     sb->magic_number = FS_MAGIC_NUMBER;
-    sb->version = 1;
-    sb->block_size = BLOCK_SIZE;
-    
-    // 计算文件系统布局
-    sb->total_blocks = total_blocks;
-    sb->total_inodes = FS_DEFAULT_MAX_INODES;
+    sb->version = FS_VERSION;
+    sb->block_size = disk_handle_get_block_size(fs_ops_disk());
     
     // 计算各个区域的位置
+    sb->total_inodes = FS_DEFAULT_MAX_INODES;
     sb->inode_table_start = FS_INODE_TABLE_START;
-    sb->inode_table_blocks = (sb->total_inodes * sizeof(fs_inode_t) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    sb->inode_table_blocks = (sb->total_inodes * sizeof(fs_inode_t) + sb->block_size - 1) / sb->block_size;
     sb->data_blocks_start = sb->inode_table_start + sb->inode_table_blocks;
     
+    // 数据块位图只有FS_BITMAP_BLOCKS块，文件系统只管理位图能覆盖的部分，
+    // 更大磁盘的其余块不使用
+    uint64_t max_blocks = sb->data_blocks_start + (uint64_t)FS_BITMAP_BLOCKS * sb->block_size * 8;
+    sb->total_blocks = (total_blocks < max_blocks) ? total_blocks : max_blocks;
+    
     // 初始化空闲计数（稍后会在位图初始化时更新）
-    sb->free_blocks = total_blocks - sb->data_blocks_start;
+    sb->free_blocks = sb->total_blocks - sb->data_blocks_start;
     sb->free_inodes = sb->total_inodes - 1; // 减去根目录inode
     
     // 设置根目录inode号
@@ -137,20 +228,38 @@ fs_error_t fs_ops_init_superblock(fs_superblock_t *sb, uint32_t total_blocks) {
     sb->mount_count = 0;
     sb->max_mount_count = 100;
     
+    // inode表延迟初始化：格式化时不逐块清零，水位线之后的块由后台清零
+    sb->features = FS_FEATURE_LAZY_ITABLE | FS_FEATURE_CRC32C;
+    sb->itable_zeroed = 0;
+    
     // 计算校验和（不包括校验和字段本身）
     sb->checksum = 0;
-    sb->checksum = fs_ops_calculate_checksum(sb, offsetof(fs_superblock_t, checksum));
+    sb->checksum = superblock_checksum(sb);
     
     printf("超级块初始化完成:\n");
-    printf("  总块数: %u\n", sb->total_blocks);
+    printf("  总块数: %lu\n", sb->total_blocks);
     printf("  总inode数: %u\n", sb->total_inodes);
-    printf("  inode表起始: %u\n", sb->inode_table_start);
-    printf("  数据块起始: %u\n", sb->data_blocks_start);
-    printf("  可用块数: %u\n", sb->free_blocks);
+    printf("  inode表起始: %lu\n", sb->inode_table_start);
+    printf("  数据块起始: %lu\n", sb->data_blocks_start);
+    printf("  可用块数: %lu\n", sb->free_blocks);
     
     return FS_SUCCESS;
 }
 
+/**
+ * 将超级块写入第0块（块内其余部分清零）
+ */
+static int store_superblock(const fs_superblock_t *sb) {
+    char *buffer;
+    int result = disk_handle_get_block_mut(fs_ops_disk(), FS_SUPERBLOCK_BLOCK, &buffer);
+    if (result == DISK_SUCCESS) {
+        memset(buffer, 0, disk_handle_get_block_size(fs_ops_disk()));
+        memcpy(buffer, sb, sizeof(fs_superblock_t));
+        result = disk_handle_put_block(fs_ops_disk(), FS_SUPERBLOCK_BLOCK, buffer, 1);
+    }
+    return result;
+}
+
 /**
  * 写入超级块到磁盘
  */
@@ -159,14 +268,7 @@ fs_error_t fs_ops_write_superblock(const fs_superblock_t *sb) {
         return FS_ERROR_INVALID_PARAM;
     }
     
-    char buffer[DISK_BLOCK_SIZE];
-    memset(buffer, 0, sizeof(buffer));
-    
-    // 将超级块复制到缓冲区
-    memcpy(buffer, sb, sizeof(fs_superblock_t));
-    
-    // 写入磁盘第0块
-    int result = disk_write_block(FS_SUPERBLOCK_BLOCK, buffer);
+    int result = store_superblock(sb);
     if (result != DISK_SUCCESS) {
         printf("写入超级块失败: %s\n", disk_error_to_string(result));
         return FS_ERROR_IO;
@@ -184,10 +286,9 @@ fs_error_t fs_ops_read_superblock(fs_superblock_t *sb) {
         return FS_ERROR_INVALID_PARAM;
     }
     
-    char buffer[DISK_BLOCK_SIZE];
-    
     // 从磁盘第0块读取
-    int result = disk_read_block(FS_SUPERBLOCK_BLOCK, buffer);
+    const char *buffer;
+    int result = disk_handle_get_block(fs_ops_disk(), FS_SUPERBLOCK_BLOCK, &buffer);
     if (result != DISK_SUCCESS) {
         printf("读取超级块失败: %s\n", disk_error_to_string(result));
         return FS_ERROR_IO;
@@ -195,6 +296,7 @@ fs_error_t fs_ops_read_superblock(fs_superblock_t *sb) {
     
     // 复制到超级块结构
     memcpy(sb, buffer, sizeof(fs_superblock_t));
+    disk_handle_put_block(fs_ops_disk(), FS_SUPERBLOCK_BLOCK, buffer, 0);
     
     // 验证魔数
     if (sb->magic_number != FS_MAGIC_NUMBER) {
@@ -202,10 +304,16 @@ fs_error_t fs_ops_read_superblock(fs_superblock_t *sb) {
         return FS_ERROR_CORRUPTED;
     }
     
+    // 版本1的块号是32位的，布局不同，不能直接挂载
+    if (sb->version != FS_VERSION) {
+        printf("不支持的文件系统版本: %u\n", sb->version);
+        return FS_ERROR_CORRUPTED;
+    }
+    
     // 验证校验和
     uint32_t stored_checksum = sb->checksum;
     sb->checksum = 0;
-    uint32_t calculated_checksum = fs_ops_calculate_checksum(sb, offsetof(fs_superblock_t, checksum));
+    uint32_t calculated_checksum = superblock_checksum(sb);
     sb->checksum = stored_checksum;
     
     if (stored_checksum != calculated_checksum) {
@@ -214,10 +322,145 @@ fs_error_t fs_ops_read_superblock(fs_superblock_t *sb) {
         return FS_ERROR_CORRUPTED;
     }
     
+    // 文件系统块大小必须与磁盘块大小一致
+    if (sb->block_size != disk_handle_get_block_size(fs_ops_disk())) {
+        printf("块大小不匹配: 超级块=%u, 磁盘=%u\n", sb->block_size,
+               disk_handle_get_block_size(fs_ops_disk()));
+        return FS_ERROR_CORRUPTED;
+    }
+    
     printf("超级块验证成功\n");
     return FS_SUCCESS;
 }
 
+/*==============================================================================
+ * inode表延迟初始化
+ *============================================================================*/
+
+/**
+ * 计算inode所在的inode表块序号
+ */
+static uint32_t inode_table_index(uint32_t inode_number) {
+    return inode_number / (fs_ops_block_size() / sizeof(fs_inode_t));
+}
+
+/**
+ * 检查inode表块是否已初始化（水位线之前，或未启用延迟初始化）
+ */
+static int inode_block_initialized(uint32_t table_index) {
+    const fs_superblock_t *sb = &g_fs_state.superblock;
+    return !(sb->features & FS_FEATURE_LAZY_ITABLE) || table_index < sb->itable_zeroed;
+}
+
+/**
+ * 推进inode表水位线并写回超级块
+ * 
+ * 新计入的inode表块先落盘，再写回并同步超级块，之后才写入其中的inode：
+ * 崩溃后水位线之前不会有未清零的块，水位线之后也不会有有效的inode。
+ * 两次都只同步涉及的块，不刷新其他文件未同步的写入。
+ */
+static fs_error_t advance_itable_watermark(uint32_t itable_zeroed) {
+    fs_superblock_t *sb = &g_fs_state.superblock;
+    if (itable_zeroed > sb->itable_zeroed &&
+        disk_handle_sync_range(fs_ops_disk(), sb->inode_table_start + sb->itable_zeroed,
+                               itable_zeroed - sb->itable_zeroed) != DISK_SUCCESS) {
+        return FS_ERROR_IO;
+    }
+    
+    sb->itable_zeroed = itable_zeroed;
+    sb->checksum = 0;
+    sb->checksum = superblock_checksum(sb);
+    
+    if (store_superblock(sb) != DISK_SUCCESS ||
+        disk_handle_sync_range(fs_ops_disk(), FS_SUPERBLOCK_BLOCK, 1) != DISK_SUCCESS) {
+        return FS_ERROR_IO;
+    }
+    return FS_SUCCESS;
+}
+
+/**
+ * 按后台清零任务的进度推进水位线
+ * 
+ * 清零线程不修改超级块，已清零的块在这里（写inode、同步或卸载时）计入
+ * 水位线，任务完成后水位线到达inode表末尾。
+ */
+static fs_error_t sync_itable_watermark(void) {
+    fs_superblock_t *sb = &g_fs_state.superblock;
+    if (!(sb->features & FS_FEATURE_LAZY_ITABLE) || sb->itable_zeroed >= sb->inode_table_blocks) {
+        return FS_SUCCESS;
+    }
+    
+    int done = disk_handle_zero_blocks_done(fs_ops_disk(),
+                                            sb->inode_table_start + sb->itable_zeroed);
+    if (done <= 0) {
+        return FS_SUCCESS;
+    }
+    
+    uint32_t itable_zeroed = sb->itable_zeroed + (uint32_t)done;
+    if (itable_zeroed > sb->inode_table_blocks) {
+        itable_zeroed = sb->inode_table_blocks;
+    }
+    return advance_itable_watermark(itable_zeroed);
+}
+
+/**
+ * 准备写入inode表块
+ * 
+ * 水位线之后的块可能残留旧数据。先从后台清零任务认领该块（任务未覆盖
+ * 时自行清零水位线到该块之间的块），再推进水位线并写回超级块，然后才
+ * 允许写入inode，保证重新挂载后水位线之后没有有效inode。
+ */
+static fs_error_t prepare_inode_block(uint32_t table_index) {
+    fs_superblock_t *sb = &g_fs_state.superblock;
+    if (inode_block_initialized(table_index)) {
+        return FS_SUCCESS;
+    }
+    
+    if (table_index >= sb->inode_table_blocks) {
+        return FS_ERROR_INVALID_PARAM;
+    }
+    
+    // 后台线程可能已经清零到该块
+    fs_error_t fs_result = sync_itable_watermark();
+    if (fs_result != FS_SUCCESS || inode_block_initialized(table_index)) {
+        return fs_result;
+    }
+    
+    int result = disk_handle_zero_blocks_claim(fs_ops_disk(), sb->inode_table_start + table_index);
+    if (result == 0) {
+        result = disk_handle_zero_blocks(fs_ops_disk(), sb->inode_table_start + sb->itable_zeroed,
+                                  table_index + 1 - sb->itable_zeroed);
+    }
+    if (result < 0) {
+        printf("初始化inode表块 %u 失败: %s\n", table_index, disk_error_to_string(result));
+        return FS_ERROR_IO;
+    }
+    
+    return advance_itable_watermark(table_index + 1);
+}
+
+/**
+ * 启动inode表后台初始化
+ */
+fs_error_t fs_ops_start_itable_init(void) {
+    fs_superblock_t *sb = &g_fs_state.superblock;
+    if (!(sb->features & FS_FEATURE_LAZY_ITABLE) || sb->itable_zeroed >= sb->inode_table_blocks) {
+        return FS_SUCCESS;
+    }
+    
+    uint64_t start = sb->inode_table_start + sb->itable_zeroed;
+    int count = sb->inode_table_blocks - sb->itable_zeroed;
+    if (disk_handle_zero_blocks_background(fs_ops_disk(), start, count) == DISK_SUCCESS) {
+        return FS_SUCCESS;
+    }
+    
+    // 无法启动后台线程时同步清零
+    if (disk_handle_zero_blocks(fs_ops_disk(), start, count) != DISK_SUCCESS) {
+        return FS_ERROR_IO;
+    }
+    return advance_itable_watermark(sb->inode_table_blocks);
+}
+
 /*==============================================================================
  * 位图管理
  *============================================================================*/
@@ -274,7 +517,7 @@ fs_error_t fs_ops_write_bitmap(const fs_bitmap_t *bitmap, uint32_t start_block,
     }
     
     uint32_t bitmap_bytes = (bitmap->total_bits + 7) / 8;
-    uint32_t bytes_per_block = DISK_BLOCK_SIZE;
+    uint32_t bytes_per_block = fs_ops_block_size();
     uint32_t total_bytes_needed = (bitmap_bytes + bytes_per_block - 1) / bytes_per_block * bytes_per_block;
     
     // 确保有足够的块来存储位图
@@ -284,27 +527,28 @@ fs_error_t fs_ops_write_bitmap(const fs_bitmap_t *bitmap, uint32_t start_block,
         return FS_ERROR_NO_SPACE;
     }
     
-    char buffer[DISK_BLOCK_SIZE];
-    uint32_t bytes_written = 0;
+    // 位图按块对齐复制到连续缓冲区，作为一批写入交给I/O调度队列
+    uint32_t blocks_used = total_bytes_needed / bytes_per_block;
+    char *buffer = (char *)calloc(blocks_used, bytes_per_block);
+    disk_block_vec_t *vec = (disk_block_vec_t *)malloc(blocks_used * sizeof(disk_block_vec_t));
+    if (!buffer || !vec) {
+        free(buffer);
+        free(vec);
+        return FS_ERROR_NO_MEMORY;
+    }
+    memcpy(buffer, bitmap->bitmap, bitmap_bytes);
+    for (uint32_t i = 0; i < blocks_used; i++) {
+        vec[i].block_num = start_block + i;
+        vec[i].buffer = buffer + (size_t)i * bytes_per_block;
+    }
     
-    for (uint32_t block = 0; block < block_count && bytes_written < bitmap_bytes; block++) {
-        memset(buffer, 0, sizeof(buffer));
-        
-        uint32_t bytes_to_copy = (bitmap_bytes - bytes_written);
-        if (bytes_to_copy > bytes_per_block) {
-            bytes_to_copy = bytes_per_block;
-        }
-        
-        memcpy(buffer, bitmap->bitmap + bytes_written, bytes_to_copy);
-        
-        int result = disk_write_block(start_block + block, buffer);
-        if (result != DISK_SUCCESS) {
-            printf("写入位图块 %u 失败: %s\n", 
-                   start_block + block, disk_error_to_string(result));
-            return FS_ERROR_IO;
-        }
-        
-        bytes_written += bytes_to_copy;
+    int result = disk_handle_queue_writev(fs_ops_disk(), vec, (int)blocks_used);
+    free(vec);
+    free(buffer);
+    if (result != DISK_SUCCESS) {
+        printf("写入位图块 %u-%u 失败: %s\n", 
+               start_block, start_block + blocks_used - 1, disk_error_to_string(result));
+        return FS_ERROR_IO;
     }
     
     printf("位图已写入磁盘，起始块: %u，块数: %u\n", start_block, block_count);
@@ -320,25 +564,33 @@ fs_error_t fs_ops_read_bitmap(fs_bitmap_t *bitmap, uint32_t start_block, uint32_
     }
     
     uint32_t bitmap_bytes = (bitmap->total_bits + 7) / 8;
-    uint32_t bytes_per_block = DISK_BLOCK_SIZE;
-    char buffer[DISK_BLOCK_SIZE];
-    uint32_t bytes_read = 0;
+    uint32_t bytes_per_block = fs_ops_block_size();
+    uint32_t blocks_used = (bitmap_bytes + bytes_per_block - 1) / bytes_per_block;
+    if (blocks_used > block_count) {
+        blocks_used = block_count;
+    }
     
-    for (uint32_t block = 0; block < block_count && bytes_read < bitmap_bytes; block++) {
-        int result = disk_read_block(start_block + block, buffer);
+    // 一次批量读取全部位图块
+    if (blocks_used > 0) {
+        char *buffer = (char *)malloc((size_t)blocks_used * bytes_per_block);
+        if (!buffer) {
+            return FS_ERROR_NO_MEMORY;
+        }
+        
+        int result = disk_handle_read_blocks(fs_ops_disk(), start_block, blocks_used, buffer);
         if (result != DISK_SUCCESS) {
-            printf("读取位图块 %u 失败: %s\n", 
-                   start_block + block, disk_error_to_string(result));
+            printf("读取位图块 %u-%u 失败: %s\n", 
+                   start_block, start_block + blocks_used - 1, disk_error_to_string(result));
+            free(buffer);
             return FS_ERROR_IO;
         }
         
-        uint32_t bytes_to_copy = (bitmap_bytes - bytes_read);
-        if (bytes_to_copy > bytes_per_block) {
-            bytes_to_copy = bytes_per_block;
+        uint32_t bytes_to_copy = blocks_used * bytes_per_block;
+        if (bytes_to_copy > bitmap_bytes) {
+            bytes_to_copy = bitmap_bytes;
         }
-        
-        memcpy(bitmap->bitmap + bytes_read, buffer, bytes_to_copy);
-        bytes_read += bytes_to_copy;
+        memcpy(bitmap->bitmap, buffer, bytes_to_copy);
+        free(buffer);
     }
     
     // 重新计算空闲计数
@@ -385,13 +637,19 @@ fs_error_t fs_ops_create_root_directory(void) {
     root_inode.create_time = current_time;
     
     // 2. 分配一个数据块用于存储目录项
-    uint32_t data_block = g_fs_state.superblock.data_blocks_start; // 使用第一个数据块
+    uint64_t data_block = g_fs_state.superblock.data_blocks_start; // 使用第一个数据块
     root_inode.direct_blocks[0] = data_block;
     root_inode.block_count = 1;
     
-    // 3. 创建目录项数据
-    char dir_block[DISK_BLOCK_SIZE];
-    memset(dir_block, 0, sizeof(dir_block));
+    // 3. 创建目录项数据（直接在可写块中构造）
+    uint32_t block_size = g_fs_state.superblock.block_size;
+    char *dir_block;
+    int result = disk_handle_get_block_mut(fs_ops_disk(), data_block, &dir_block);
+    if (result != DISK_SUCCESS) {
+        printf("获取根目录数据块失败: %s\n", disk_error_to_string(result));
+        return FS_ERROR_IO;
+    }
+    memset(dir_block, 0, block_size);
     
     fs_dir_entry_t *entries = (fs_dir_entry_t *)dir_block;
     
@@ -415,34 +673,38 @@ fs_error_t fs_ops_create_root_directory(void) {
     root_inode.file_size = 2 * sizeof(fs_dir_entry_t);
     
     // 4. 将目录数据写入磁盘
-    int result = disk_write_block(data_block, dir_block);
+    result = disk_handle_put_block(fs_ops_disk(), data_block, dir_block, 1);
     if (result != DISK_SUCCESS) {
         printf("写入根目录数据块失败: %s\n", disk_error_to_string(result));
         return FS_ERROR_IO;
     }
     
     // 5. 将根目录inode写入inode表
-    char inode_block[DISK_BLOCK_SIZE];
-    memset(inode_block, 0, sizeof(inode_block));
-    
     // 计算根目录inode在inode表中的位置
-    uint32_t inodes_per_block = DISK_BLOCK_SIZE / sizeof(fs_inode_t);
-    uint32_t inode_block_num = g_fs_state.superblock.inode_table_start + 
+    uint32_t inodes_per_block = block_size / sizeof(fs_inode_t);
+    uint64_t inode_block_num = g_fs_state.superblock.inode_table_start + 
                               (ROOT_INODE_NUM / inodes_per_block);
     uint32_t inode_offset = (ROOT_INODE_NUM % inodes_per_block) * sizeof(fs_inode_t);
     
-    // 读取inode块（可能已有其他inode）
-    result = disk_read_block(inode_block_num, inode_block);
+    // 根目录inode所在块在此时才初始化
+    fs_error_t fs_result = prepare_inode_block(ROOT_INODE_NUM / inodes_per_block);
+    if (fs_result != FS_SUCCESS) {
+        return fs_result;
+    }
+    
+    // 获取可写的inode块（可能已有其他inode）
+    char *inode_block;
+    result = disk_handle_get_block_mut(fs_ops_disk(), inode_block_num, &inode_block);
     if (result != DISK_SUCCESS) {
-        // 如果读取失败，说明是新块，继续使用空白块
-        memset(inode_block, 0, sizeof(inode_block));
+        printf("读取根目录inode块失败: %s\n", disk_error_to_string(result));
+        return FS_ERROR_IO;
     }
     
     // 将根目录inode复制到正确位置
     memcpy(inode_block + inode_offset, &root_inode, sizeof(fs_inode_t));
     
     // 写回inode块
-    result = disk_write_block(inode_block_num, inode_block);
+    result = disk_handle_put_block(fs_ops_disk(), inode_block_num, inode_block, 1);
     if (result != DISK_SUCCESS) {
         printf("写入根目录inode失败: %s\n", disk_error_to_string(result));
         return FS_ERROR_IO;
@@ -454,7 +716,7 @@ fs_error_t fs_ops_create_root_directory(void) {
     
     printf("根目录创建成功:\n");
     printf("  inode号: %u\n", ROOT_INODE_NUM);
-    printf("  数据块: %u\n", data_block);
+    printf("  数据块: %lu\n", data_block);
     printf("  权限: 0%o\n", FS_ROOT_PERMISSIONS);
     printf("  大小: %lu 字节\n", root_inode.file_size);
     
@@ -472,31 +734,25 @@ void format_disk(void) {
     printf("==================== 开始格式化文件系统 ====================\n");
     
     // 1. 检查磁盘是否已初始化
-    if (!disk_is_initialized()) {
-        printf("错误：磁盘未初始化，请先调用 disk_init()\n");
+    if (!disk_handle_is_initialized(fs_ops_disk())) {
+        printf("错误：磁盘未初始化，请先打开磁盘\n");
         return;
     }
     
     // 获取磁盘信息
-    uint32_t total_blocks, block_size;
-    uint64_t disk_size;
-    int result = disk_get_info(&total_blocks, &block_size, &disk_size);
+    uint64_t total_blocks, disk_size;
+    uint32_t block_size;
+    int result = disk_handle_get_info(fs_ops_disk(), &total_blocks, &block_size, &disk_size);
     if (result != DISK_SUCCESS) {
         printf("错误：无法获取磁盘信息: %s\n", disk_error_to_string(result));
         return;
     }
     
     printf("磁盘信息:\n");
-    printf("  总块数: %u\n", total_blocks);
+    printf("  总块数: %lu\n", total_blocks);
     printf("  块大小: %u 字节\n", block_size);
     printf("  磁盘大小: %lu 字节\n", disk_size);
     
-    // 验证块大小
-    if (block_size != BLOCK_SIZE) {
-        printf("错误：块大小不匹配，期望 %d，实际 %u\n", BLOCK_SIZE, block_size);
-        return;
-    }
-    
     // 2. 初始化超级块
     printf("\n步骤 1: 初始化超级块...\n");
     fs_error_t fs_result = fs_ops_init_superblock(&g_fs_state.superblock, total_blocks);
@@ -523,7 +779,8 @@ void format_disk(void) {
     
     // 5. 初始化数据块位图
     printf("\n步骤 4: 初始化数据块位图...\n");
-    uint32_t data_blocks_count = total_blocks - g_fs_state.superblock.data_blocks_start;
+    uint32_t data_blocks_count = (uint32_t)(g_fs_state.superblock.total_blocks -
+                                            g_fs_state.superblock.data_blocks_start);
     fs_result = fs_ops_init_bitmap(&g_fs_state.block_bitmap, data_blocks_count);
     if (fs_result != FS_SUCCESS) {
         printf("错误：初始化数据块位图失败: %s\n", fs_ops_error_to_string(fs_result));
@@ -563,8 +820,7 @@ void format_disk(void) {
     
     // 重新计算超级块校验和并写入
     g_fs_state.superblock.checksum = 0;
-    g_fs_state.superblock.checksum = fs_ops_calculate_checksum(&g_fs_state.superblock, 
-                                                              offsetof(fs_superblock_t, checksum));
+    g_fs_state.superblock.checksum = superblock_checksum(&g_fs_state.superblock);
     
     fs_result = fs_ops_write_superblock(&g_fs_state.superblock);
     if (fs_result != FS_SUCCESS) {
@@ -572,9 +828,17 @@ void format_disk(void) {
         goto cleanup;
     }
     
-    // 10. 同步数据到磁盘
-    printf("\n步骤 9: 同步数据到磁盘...\n");
-    result = disk_sync();
+    // 10. 其余inode表块在后台清零
+    printf("\n步骤 9: 启动inode表后台初始化...\n");
+    fs_result = fs_ops_start_itable_init();
+    if (fs_result != FS_SUCCESS) {
+        printf("错误：初始化inode表失败: %s\n", fs_ops_error_to_string(fs_result));
+        goto cleanup;
+    }
+    
+    // 11. 同步数据到磁盘
+    printf("\n步骤 10: 同步数据到磁盘...\n");
+    result = disk_handle_sync(fs_ops_disk());
     if (result != DISK_SUCCESS) {
         printf("警告：同步磁盘失败: %s\n", disk_error_to_string(result));
     }
@@ -583,11 +847,11 @@ void format_disk(void) {
     printf("文件系统统计:\n");
     printf("  总inode数: %u (可用: %u)\n", 
            g_fs_state.superblock.total_inodes, g_fs_state.superblock.free_inodes);
-    printf("  总数据块数: %u (可用: %u)\n", 
+    printf("  总数据块数: %u (可用: %lu)\n", 
            data_blocks_count, g_fs_state.superblock.free_blocks);
     printf("  文件系统大小: %.2f MB\n", disk_size / (1024.0 * 1024.0));
     printf("  可用空间: %.2f MB\n", 
-           (g_fs_state.superblock.free_blocks * BLOCK_SIZE) / (1024.0 * 1024.0));
+           ((double)g_fs_state.superblock.free_blocks * block_size) / (1024.0 * 1024.0));
     printf("============================================================\n");
     
     return;
@@ -617,11 +881,15 @@ void fs_ops_print_status(void) {
     printf("  魔数: 0x%x\n", g_fs_state.superblock.magic_number);
     printf("  版本: %u\n", g_fs_state.superblock.version);
     printf("  块大小: %u 字节\n", g_fs_state.superblock.block_size);
-    printf("  总块数: %u\n", g_fs_state.superblock.total_blocks);
+    printf("  总块数: %lu\n", g_fs_state.superblock.total_blocks);
     printf("  总inode数: %u\n", g_fs_state.superblock.total_inodes);
-    printf("  可用块数: %u\n", g_fs_state.superblock.free_blocks);
+    printf("  可用块数: %lu\n", g_fs_state.superblock.free_blocks);
     printf("  可用inode数: %u\n", g_fs_state.superblock.free_inodes);
     printf("  根inode: %u\n", g_fs_state.superblock.root_inode);
+    if (g_fs_state.superblock.features & FS_FEATURE_LAZY_ITABLE) {
+        printf("  inode表已初始化: %u/%u 块\n",
+               g_fs_state.superblock.itable_zeroed, g_fs_state.superblock.inode_table_blocks);
+    }
     
     if (g_fs_state.inode_bitmap.bitmap) {
         printf("\ninode位图:\n");
@@ -635,6 +903,38 @@ void fs_ops_print_status(void) {
         printf("  空闲数: %u\n", g_fs_state.block_bitmap.free_count);
     }
     
+    if (g_fs_state.online_discard || g_fs_state.discarded_blocks > 0) {
+        printf("\n丢弃:\n");
+        printf("  在线丢弃: %s\n", g_fs_state.online_discard ? "开启" : "关闭");
+        printf("  已丢弃: %lu 块 (待丢弃: %u 块)\n", g_fs_state.discarded_blocks,
+               g_fs_state.discard_pending);
+    }
+    
+    fs_ops_update_cache_stats();
+    printf("\n块缓存:\n");
+    printf("  命中: %u\n", g_fs_state.cache_hits);
+    printf("  未命中: %u\n", g_fs_state.cache_misses);
+    if (g_fs_state.readahead_blocks > 0) {
+        printf("  预读: %u 块, 命中 %u (%.1f%%), 浪费 %u\n", g_fs_state.readahead_blocks,
+               g_fs_state.readahead_hits,
+               100.0 * g_fs_state.readahead_hits / g_fs_state.readahead_blocks,
+               g_fs_state.readahead_wasted);
+    }
+    
+    // 延迟分布（文件操作与底层磁盘请求）
+    printf("\n延迟分布:\n");
+    latency_hist_t hist;
+    latency_hist_snapshot(&hist, &g_fs_state.read_latency);
+    latency_hist_print(&hist, "  fs_read");
+    latency_hist_snapshot(&hist, &g_fs_state.write_latency);
+    latency_hist_print(&hist, "  fs_write");
+    disk_stats_t disk_stats;
+    if (disk_handle_get_stats(fs_ops_disk(), &disk_stats) == DISK_SUCCESS) {
+        latency_hist_print(&disk_stats.read_latency, "  磁盘读取");
+        latency_hist_print(&disk_stats.write_latency, "  磁盘写入");
+        latency_hist_print(&disk_stats.sync_latency, "  磁盘同步");
+    }
+    
     printf("=====================================================\n");
 }
 
@@ -693,6 +993,11 @@ static void free_bitmap_bit(fs_bitmap_t *bitmap, uint32_t bit_num) {
     if (bitmap->bitmap[byte_index] & (1 << bit_offset)) {
         bitmap->bitmap[byte_index] &= ~(1 << bit_offset);
         bitmap->free_count++;
+        
+        // 释放的数据块登记到在线丢弃批次
+        if (bitmap == &g_fs_state.block_bitmap) {
+            fs_ops_queue_discard(bit_num + g_fs_state.superblock.data_blocks_start);
+        }
     }
 }
 
@@ -761,21 +1066,31 @@ static uint32_t find_file_in_directory(uint32_t dir_inode_num, const char *filen
     
     // 遍历目录的数据块查找文件
     for (uint32_t block_idx = 0; block_idx < DIRECT_BLOCKS && dir_inode.direct_blocks[block_idx] != 0; block_idx++) {
-        char block_data[DISK_BLOCK_SIZE];
-        int result = disk_read_block(dir_inode.direct_blocks[block_idx], block_data);
+        // 直接在块中查找目录项（mmap模式下不复制整块）
+        uint64_t block_num = dir_inode.direct_blocks[block_idx];
+        char block_buf[FS_STACK_BLOCK_SIZE];
+        char *block_data;
+        int result = fs_block_get(block_num, block_buf, 0, &block_data);
         if (result != DISK_SUCCESS) {
             continue;
         }
         
         // 遍历目录项
-        fs_dir_entry_t *entries = (fs_dir_entry_t *)block_data;
-        uint32_t max_entries = DISK_BLOCK_SIZE / sizeof(fs_dir_entry_t);
+        const fs_dir_entry_t *entries = (const fs_dir_entry_t *)block_data;
+        uint32_t max_entries = fs_ops_block_size() / sizeof(fs_dir_entry_t);
+        uint32_t found = 0;
         
         for (uint32_t i = 0; i < max_entries; i++) {
             if (entries[i].is_valid && strcmp(entries[i].filename, filename) == 0) {
-                return entries[i].inode_number;
+                found = entries[i].inode_number;
+                break;
             }
         }
+        
+        fs_block_put(block_num, block_data, block_buf, 0);
+        if (found != 0) {
+            return found;
+        }
     }
     
     return 0; // 未找到
@@ -801,12 +1116,15 @@ static fs_error_t add_file_to_directory(uint32_t dir_inode_num, const char *file
     }
     
     // 查找空闲的目录项位置
+    uint32_t block_size = fs_ops_block_size();
     for (uint32_t block_idx = 0; block_idx < DIRECT_BLOCKS; block_idx++) {
-        char block_data[DISK_BLOCK_SIZE];
+        char block_buf[FS_STACK_BLOCK_SIZE];
+        char *block_data;
+        int is_new_block = 0;
         
         if (dir_inode.direct_blocks[block_idx] == 0) {
             // 需要分配新的数据块
-            uint32_t new_block = alloc_bitmap_bit(&g_fs_state.block_bitmap);
+            uint64_t new_block = alloc_bitmap_bit(&g_fs_state.block_bitmap);
             if (new_block == 0) {
                 return FS_ERROR_NO_SPACE;
             }
@@ -815,20 +1133,22 @@ static fs_error_t add_file_to_directory(uint32_t dir_inode_num, const char *file
             new_block += g_fs_state.superblock.data_blocks_start;
             dir_inode.direct_blocks[block_idx] = new_block;
             dir_inode.block_count++;
-            
+            is_new_block = 1;
+        }
+        
+        // 获取可写的目录块，就地修改
+        uint64_t block_num = dir_inode.direct_blocks[block_idx];
+        if (fs_block_get(block_num, block_buf, 1, &block_data) != DISK_SUCCESS) {
+            return FS_ERROR_IO;
+        }
+        if (is_new_block) {
             // 清空新块
-            memset(block_data, 0, sizeof(block_data));
-        } else {
-            // 读取现有块
-            int result = disk_read_block(dir_inode.direct_blocks[block_idx], block_data);
-            if (result != DISK_SUCCESS) {
-                return FS_ERROR_IO;
-            }
+            memset(block_data, 0, block_size);
         }
         
         // 查找空闲的目录项
         fs_dir_entry_t *entries = (fs_dir_entry_t *)block_data;
-        uint32_t max_entries = DISK_BLOCK_SIZE / sizeof(fs_dir_entry_t);
+        uint32_t max_entries = block_size / sizeof(fs_dir_entry_t);
         
         for (uint32_t i = 0; i < max_entries; i++) {
             if (!entries[i].is_valid) {
@@ -842,13 +1162,13 @@ static fs_error_t add_file_to_directory(uint32_t dir_inode_num, const char *file
                 entries[i].is_valid = 1;
                 
                 // 写回数据块
-                int result = disk_write_block(dir_inode.direct_blocks[block_idx], block_data);
+                int result = fs_block_put(block_num, block_data, block_buf, 1);
                 if (result != DISK_SUCCESS) {
                     return FS_ERROR_IO;
                 }
                 
                 // 更新目录大小
-                dir_inode.file_size = (block_idx + 1) * DISK_BLOCK_SIZE;
+                dir_inode.file_size = (uint64_t)(block_idx + 1) * block_size;
                 
                 // 更新目录inode的时间戳
                 time_t current_time = fs_ops_current_time();
@@ -861,6 +1181,9 @@ static fs_error_t add_file_to_directory(uint32_t dir_inode_num, const char *file
                 return FS_SUCCESS;
             }
         }
+        
+        // 本块已满，释放后继续查找下一块
+        fs_block_put(block_num, block_data, block_buf, 0);
     }
     
     return FS_ERROR_NO_SPACE; // 目录已满
@@ -874,20 +1197,28 @@ fs_error_t fs_ops_read_inode(uint32_t inode_number, fs_inode_t *inode) {
         return FS_ERROR_INVALID_PARAM;
     }
     
+    // 尚未初始化的inode表块中没有有效inode
+    if (!inode_block_initialized(inode_table_index(inode_number))) {
+        memset(inode, 0, sizeof(fs_inode_t));
+        return FS_SUCCESS;
+    }
+    
     // 计算inode在inode表中的位置
-    uint32_t inodes_per_block = DISK_BLOCK_SIZE / sizeof(fs_inode_t);
-    uint32_t inode_block_num = g_fs_state.superblock.inode_table_start + (inode_number / inodes_per_block);
+    uint32_t inodes_per_block = fs_ops_block_size() / sizeof(fs_inode_t);
+    uint64_t inode_block_num = g_fs_state.superblock.inode_table_start + (inode_number / inodes_per_block);
     uint32_t inode_offset = (inode_number % inodes_per_block) * sizeof(fs_inode_t);
     
-    // 读取inode块
-    char inode_block[DISK_BLOCK_SIZE];
-    int result = disk_read_block(inode_block_num, inode_block);
+    // 获取inode块（mmap模式下直接指向磁盘映射）
+    char block_buf[FS_STACK_BLOCK_SIZE];
+    char *inode_block;
+    int result = fs_block_get(inode_block_num, block_buf, 0, &inode_block);
     if (result != DISK_SUCCESS) {
         return FS_ERROR_IO;
     }
     
     // 复制inode数据
     memcpy(inode, inode_block + inode_offset, sizeof(fs_inode_t));
+    fs_block_put(inode_block_num, inode_block, block_buf, 0);
     
     return FS_SUCCESS;
 }
@@ -900,14 +1231,21 @@ fs_error_t fs_ops_write_inode(uint32_t inode_number, const fs_inode_t *inode) {
         return FS_ERROR_INVALID_PARAM;
     }
     
+    // 确保inode表块已初始化
+    fs_error_t fs_result = prepare_inode_block(inode_table_index(inode_number));
+    if (fs_result != FS_SUCCESS) {
+        return fs_result;
+    }
+    
     // 计算inode在inode表中的位置
-    uint32_t inodes_per_block = DISK_BLOCK_SIZE / sizeof(fs_inode_t);
-    uint32_t inode_block_num = g_fs_state.superblock.inode_table_start + (inode_number / inodes_per_block);
+    uint32_t inodes_per_block = fs_ops_block_size() / sizeof(fs_inode_t);
+    uint64_t inode_block_num = g_fs_state.superblock.inode_table_start + (inode_number / inodes_per_block);
     uint32_t inode_offset = (inode_number % inodes_per_block) * sizeof(fs_inode_t);
     
-    // 读取inode块
-    char inode_block[DISK_BLOCK_SIZE];
-    int result = disk_read_block(inode_block_num, inode_block);
+    // 获取可写的inode块，就地修改
+    char block_buf[FS_STACK_BLOCK_SIZE];
+    char *inode_block;
+    int result = fs_block_get(inode_block_num, block_buf, 1, &inode_block);
     if (result != DISK_SUCCESS) {
         return FS_ERROR_IO;
     }
@@ -916,7 +1254,7 @@ fs_error_t fs_ops_write_inode(uint32_t inode_number, const fs_inode_t *inode) {
     memcpy(inode_block + inode_offset, inode, sizeof(fs_inode_t));
     
     // 写回inode块
-    result = disk_write_block(inode_block_num, inode_block);
+    result = fs_block_put(inode_block_num, inode_block, block_buf, 1);
     if (result != DISK_SUCCESS) {
         return FS_ERROR_IO;
     }
@@ -946,6 +1284,12 @@ static fs_error_t load_filesystem_state(void) {
         return result;
     }
     
+    // 继续未完成的inode表初始化
+    result = fs_ops_start_itable_init();
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
     // 初始化文件句柄表
     memset(g_fs_state.open_files, 0, sizeof(g_fs_state.open_files));
     
@@ -953,6 +1297,260 @@ static fs_error_t load_filesystem_state(void) {
     return FS_SUCCESS;
 }
 
+/**
+ * 同步文件系统数据到磁盘
+ */
+fs_error_t fs_ops_sync(void) {
+    if (g_fs_state.superblock.magic_number != FS_MAGIC_NUMBER) {
+        return FS_ERROR_NOT_MOUNTED;
+    }
+    
+    // 记录后台清零的进度
+    fs_error_t result = sync_itable_watermark();
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
+    // 丢弃积累的已释放块
+    result = fs_ops_flush_discards();
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
+    return disk_handle_sync(fs_ops_disk()) == DISK_SUCCESS ? FS_SUCCESS : FS_ERROR_IO;
+}
+
+/**
+ * 卸载文件系统
+ */
+fs_error_t fs_ops_unmount(void) {
+    if (g_fs_state.superblock.magic_number != FS_MAGIC_NUMBER) {
+        return FS_ERROR_NOT_MOUNTED;
+    }
+    
+    fs_error_t result = fs_ops_sync();
+    
+    // 清理内存状态，下次访问时重新加载
+    free(g_fs_state.inode_bitmap.bitmap);
+    free(g_fs_state.block_bitmap.bitmap);
+    memset(&g_fs_state.inode_bitmap, 0, sizeof(g_fs_state.inode_bitmap));
+    memset(&g_fs_state.block_bitmap, 0, sizeof(g_fs_state.block_bitmap));
+    memset(&g_fs_state.superblock, 0, sizeof(g_fs_state.superblock));
+    g_fs_state.discard_pending = 0;
+    g_fs_state.is_mounted = 0;
+    
+    return result;
+}
+
+/*==============================================================================
+ * 已释放块的丢弃
+ *============================================================================*/
+
+/**
+ * 块号比较（qsort回调）
+ */
+static int compare_block_numbers(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * 检查数据块当前是否已分配（不在数据区或位图未加载时视为已分配）
+ */
+static int data_block_in_use(uint64_t block_num) {
+    const fs_bitmap_t *bitmap = &g_fs_state.block_bitmap;
+    if (!bitmap->bitmap || block_num < g_fs_state.superblock.data_blocks_start ||
+        block_num - g_fs_state.superblock.data_blocks_start >= bitmap->total_bits) {
+        return 1;
+    }
+    
+    uint32_t bit_num = (uint32_t)(block_num - g_fs_state.superblock.data_blocks_start);
+    return (bitmap->bitmap[bit_num / 8] >> (bit_num % 8)) & 1;
+}
+
+/**
+ * 在位图副本中把数据块标记为已用（不在数据区的块忽略）
+ */
+static void mark_block_used(uint8_t *in_use, uint64_t block_num) {
+    if (block_num < g_fs_state.superblock.data_blocks_start ||
+        block_num - g_fs_state.superblock.data_blocks_start >= g_fs_state.block_bitmap.total_bits) {
+        return;
+    }
+    
+    uint32_t bit_num = (uint32_t)(block_num - g_fs_state.superblock.data_blocks_start);
+    in_use[bit_num / 8] |= (uint8_t)(1 << (bit_num % 8));
+}
+
+/**
+ * 在位图副本中标记一个inode引用的所有数据块
+ */
+static fs_error_t mark_inode_blocks(uint8_t *in_use, const fs_inode_t *inode) {
+    for (int i = 0; i < DIRECT_BLOCKS; i++) {
+        mark_block_used(in_use, inode->direct_blocks[i]);
+    }
+    if (inode->indirect_block == 0) {
+        return FS_SUCCESS;
+    }
+    
+    mark_block_used(in_use, inode->indirect_block);
+    char block_buf[FS_STACK_BLOCK_SIZE];
+    char *block_data;
+    if (fs_block_get(inode->indirect_block, block_buf, 0, &block_data) != DISK_SUCCESS) {
+        return FS_ERROR_IO;
+    }
+    const uint64_t *pointers = (const uint64_t *)block_data;
+    for (uint32_t i = 0; i < fs_ops_block_size() / sizeof(uint64_t); i++) {
+        mark_block_used(in_use, pointers[i]);
+    }
+    fs_block_put(inode->indirect_block, block_data, block_buf, 0);
+    return FS_SUCCESS;
+}
+
+/**
+ * 设置在线丢弃
+ */
+void fs_ops_set_online_discard(int enabled) {
+    if (!enabled) {
+        fs_ops_flush_discards();
+    }
+    g_fs_state.online_discard = enabled ? 1 : 0;
+}
+
+/**
+ * 登记一个已释放的数据块
+ */
+void fs_ops_queue_discard(uint64_t block_num) {
+    if (!g_fs_state.online_discard) {
+        return;
+    }
+    
+    g_fs_state.discard_batch[g_fs_state.discard_pending++] = block_num;
+    if (g_fs_state.discard_pending == FS_DISCARD_BATCH_BLOCKS) {
+        fs_ops_flush_discards();
+    }
+}
+
+/**
+ * 丢弃批次中积累的块
+ */
+fs_error_t fs_ops_flush_discards(void) {
+    uint32_t count = g_fs_state.discard_pending;
+    uint64_t *batch = g_fs_state.discard_batch;
+    g_fs_state.discard_pending = 0;
+    if (count == 0) {
+        return FS_SUCCESS;
+    }
+    
+    // 按块号排序后合并为连续段，重复登记的块只算一次
+    qsort(batch, count, sizeof(uint64_t), compare_block_numbers);
+    
+    fs_error_t result = FS_SUCCESS;
+    for (uint32_t i = 0; i < count; ) {
+        uint64_t start = batch[i++];
+        if (data_block_in_use(start)) {
+            continue;
+        }
+        
+        uint64_t run = 1;
+        while (i < count) {
+            if (batch[i] == start + run && !data_block_in_use(batch[i])) {
+                run++;
+            } else if (batch[i] != start + run - 1) {
+                break;
+            }
+            i++;
+        }
+        
+        if (disk_handle_discard_blocks(fs_ops_disk(), start, run) == DISK_SUCCESS) {
+            g_fs_state.discarded_blocks += run;
+        } else {
+            result = FS_ERROR_IO;
+        }
+    }
+    
+    return result;
+}
+
+/**
+ * 丢弃所有空闲数据块
+ */
+fs_error_t fs_ops_trim(uint64_t *trimmed) {
+    if (trimmed) {
+        *trimmed = 0;
+    }
+    
+    // 确保文件系统状态已加载
+    if (g_fs_state.superblock.magic_number != FS_MAGIC_NUMBER) {
+        fs_error_t result = load_filesystem_state();
+        if (result != FS_SUCCESS) {
+            return result;
+        }
+    }
+    
+    if (g_fs_state.read_only) {
+        return FS_ERROR_PERMISSION;
+    }
+    
+    fs_error_t result = fs_ops_flush_discards();
+    if (result != FS_SUCCESS) {
+        return result;
+    }
+    
+    // 位图只记录本次会话中的分配，inode引用的块同样视为已用
+    fs_bitmap_t *bitmap = &g_fs_state.block_bitmap;
+    size_t bytes = (bitmap->total_bits + 7) / 8;
+    uint8_t *in_use = (uint8_t *)malloc(bytes > 0 ? bytes : 1);
+    if (!in_use) {
+        return FS_ERROR_NO_MEMORY;
+    }
+    memcpy(in_use, bitmap->bitmap, bytes);
+    
+    for (uint32_t ino = 1; ino < g_fs_state.superblock.total_inodes && result == FS_SUCCESS; ino++) {
+        fs_inode_t inode;
+        result = fs_ops_read_inode(ino, &inode);
+        if (result == FS_SUCCESS && (inode.link_count > 0 || inode.file_type != 0)) {
+            result = mark_inode_blocks(in_use, &inode);
+        }
+    }
+    
+    // 空闲块按连续段丢弃
+    uint64_t total = 0;
+    uint64_t data_start = g_fs_state.superblock.data_blocks_start;
+    for (uint32_t bit = 0; bit < bitmap->total_bits && result == FS_SUCCESS; ) {
+        if (in_use[bit / 8] & (1 << (bit % 8))) {
+            bit++;
+            continue;
+        }
+        
+        uint32_t first = bit;
+        while (bit < bitmap->total_bits && !(in_use[bit / 8] & (1 << (bit % 8)))) {
+            bit++;
+        }
+        
+        uint64_t start = data_start + first;
+        uint64_t count = bit - first;
+        if (start >= g_fs_state.superblock.total_blocks) {
+            break;
+        }
+        if (count > g_fs_state.superblock.total_blocks - start) {
+            count = g_fs_state.superblock.total_blocks - start;
+        }
+        if (disk_handle_discard_blocks(fs_ops_disk(), start, count) != DISK_SUCCESS) {
+            result = FS_ERROR_IO;
+        } else {
+            total += count;
+        }
+    }
+    free(in_use);
+    
+    g_fs_state.discarded_blocks += total;
+    if (trimmed) {
+        *trimmed = total;
+    }
+    return result;
+}
+
 /**
  * 创建文件
  */
@@ -1118,6 +1716,9 @@ int fs_open(const char* path) {
             g_fs_state.open_files[fd].reference_count = 1;
             g_fs_state.open_files[fd].open_time = fs_ops_current_time();
             g_fs_state.open_files[fd].owner_uid = user_manager_get_current_uid(); // 使用当前用户ID
+            g_fs_state.open_files[fd].ra_prev_end = 0;
+            g_fs_state.open_files[fd].ra_window = 0;
+            g_fs_state.open_files[fd].ra_end = 0;
             
             // 更新文件访问时间
             file_inode.access_time = fs_ops_current_time();
@@ -90,6 +90,48 @@ fs_error_t fs_ops_sync(void);
  */
 fs_error_t fs_ops_check(void);
 
+/**
+ * 设置在线丢弃
+ * 
+ * 开启后释放的数据块先积累在批次中，批次满、同步或卸载时按块号排序并
+ * 合并为连续段，每段一次disk_handle_discard_blocks()，主机镜像中对应的
+ * 空间随即释放。目前文件系统还没有删除或截断文件的操作，不会释放数据块，
+ * 所以这只是为今后的释放路径准备的机制；空闲块用fs_ops_trim()丢弃。
+ * 
+ * @param enabled 1开启，0关闭（关闭时先丢弃已积累的块）
+ */
+void fs_ops_set_online_discard(int enabled);
+
+/**
+ * 登记一个已释放的数据块
+ * 
+ * 释放数据块的路径应调用它（位图的释放函数已经这样做）。在线丢弃关闭时
+ * 忽略；批次积满时立即丢弃整个批次。
+ * 
+ * @param block_num 释放的数据块（绝对块号）
+ */
+void fs_ops_queue_discard(uint64_t block_num);
+
+/**
+ * 丢弃批次中积累的块
+ * 
+ * 登记之后又被重新分配的块跳过。
+ * 
+ * @return FS_SUCCESS 成功，或相应的错误码
+ */
+fs_error_t fs_ops_flush_discards(void);
+
+/**
+ * 丢弃所有空闲数据块（fstrim）
+ * 
+ * 数据块位图中空闲、且没有任何inode引用的块按连续段丢弃。位图只在格式化
+ * 时写入磁盘，因此还要扫描inode表，避免丢弃之前会话中分配的块。
+ * 
+ * @param trimmed 返回丢弃的块数（可为NULL）
+ * @return FS_SUCCESS 成功，或相应的错误码
+ */
+fs_error_t fs_ops_trim(uint64_t *trimmed);
+
 /*==============================================================================
  * 辅助函数声明
  *============================================================================*/
@@ -103,7 +145,7 @@ fs_error_t fs_ops_check(void);
  * @param total_blocks 总块数
  * @return FS_SUCCESS 成功，或相应的错误码
  */
-fs_error_t fs_ops_init_superblock(fs_superblock_t *sb, uint32_t total_blocks);
+fs_error_t fs_ops_init_superblock(fs_superblock_t *sb, uint64_t total_blocks);
 
 /**
  * 初始化位图
@@ -145,10 +187,23 @@ fs_error_t fs_ops_write_superblock(const fs_superblock_t *sb);
  */
 fs_error_t fs_ops_read_superblock(fs_superblock_t *sb);
 
+/**
+ * 启动inode表后台初始化
+ * 
+ * 启用延迟初始化时，格式化只清零根目录inode所在的块，超级块的
+ * itable_zeroed记录已初始化的前导inode表块数。本函数在后台清零其余块，
+ * 无法启动后台线程时改为同步清零。写入水位线之后的inode前会先认领并
+ * 清零所在块、推进水位线；读取这些块中的inode直接得到全零。
+ * 
+ * @return FS_SUCCESS 成功，或相应的错误码
+ */
+fs_error_t fs_ops_start_itable_init(void);
+
 /**
  * 写入位图到磁盘
  * 
- * 将位图数据写入指定的磁盘块。
+ * 将位图数据写入指定的磁盘块。写入经过磁盘的I/O调度队列
+ * （disk_set_io_queue），启用队列时在派发或同步后才落盘。
  * 
  * @param bitmap 位图结构指针
  * @param start_block 起始块号
@@ -176,7 +231,7 @@ fs_error_t fs_ops_read_bitmap(fs_bitmap_t *bitmap, uint32_t start_block, uint32_
 /**
  * 计算校验和
  * 
- * 计算数据块的校验和，用于数据完整性验证。
+ * 计算数据块的CRC32C校验和，用于数据完整性验证。
  * 
  * @param data 数据指针
  * @param size 数据大小
@@ -193,6 +248,32 @@ uint32_t fs_ops_calculate_checksum(const void *data, size_t size);
  */
 time_t fs_ops_current_time(void);
 
+/**
+ * 选择文件系统所在的磁盘
+ * 
+ * 格式化、挂载和之后的所有块读写都使用该磁盘句柄（disk_open()返回的
+ * 句柄或disk_default()）。未调用时使用默认磁盘，即disk_init()打开的磁盘。
+ * 
+ * @param disk 磁盘句柄，NULL表示默认磁盘
+ */
+void fs_ops_set_disk(disk_t *disk);
+
+/**
+ * 获取文件系统所在的磁盘
+ * 
+ * @return 磁盘句柄（未指定时为默认磁盘）
+ */
+disk_t *fs_ops_disk(void);
+
+/**
+ * 获取文件系统块大小
+ * 
+ * 已加载超级块时返回其中记录的块大小，否则返回磁盘的块大小。
+ * 
+ * @return 块大小（字节）
+ */
+uint32_t fs_ops_block_size(void);
+
 /**
  * 打印文件系统状态
  * 
@@ -200,6 +281,14 @@ time_t fs_ops_current_time(void);
  */
 void fs_ops_print_status(void);
 
+/**
+ * 更新缓存统计
+ * 
+ * 从磁盘模拟器的块缓存统计中同步命中/未命中和预读计数到文件系统状态
+ * (g_fs_state.cache_hits / cache_misses / readahead_*)。
+ */
+void fs_ops_update_cache_stats(void);
+
 /**
  * 错误码转换为字符串
  * 
@@ -0,0 +1,166 @@
+/**
+ * Latency Histogram Implementation
+ * latency_hist.c
+ *
+ * 延迟直方图实现 - 按2的幂分段、段内线性细分的对数桶
+ */
+
+#include "latency_hist.h"
+#include <stdio.h>
+#include <string.h>
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 计算数值所在的桶
+ *
+ * 小于LATENCY_HIST_SUB_BUCKETS的值每个值一个桶；更大的值按最高位所在的
+ * 指数分段，再取最高位之后的LATENCY_HIST_SUB_BITS位作为段内序号。
+ */
+static uint32_t bucket_index(uint64_t value) {
+    if (value < LATENCY_HIST_SUB_BUCKETS) {
+        return (uint32_t)value;
+    }
+
+    uint32_t exponent = 63 - (uint32_t)__builtin_clzll(value);
+    if (exponent > LATENCY_HIST_MAX_EXPONENT) {
+        return LATENCY_HIST_BUCKETS - 1;
+    }
+
+    uint32_t sub = (uint32_t)(value >> (exponent - LATENCY_HIST_SUB_BITS)) &
+                   (LATENCY_HIST_SUB_BUCKETS - 1);
+    return LATENCY_HIST_SUB_BUCKETS * (exponent - LATENCY_HIST_SUB_BITS + 1) + sub;
+}
+
+/**
+ * 计算桶所覆盖的最大值
+ */
+static uint64_t bucket_upper_bound(uint32_t index) {
+    if (index < LATENCY_HIST_SUB_BUCKETS) {
+        return index;
+    }
+
+    uint32_t exponent = index / LATENCY_HIST_SUB_BUCKETS + LATENCY_HIST_SUB_BITS - 1;
+    uint64_t sub = index % LATENCY_HIST_SUB_BUCKETS;
+    uint64_t width = 1ULL << (exponent - LATENCY_HIST_SUB_BITS);
+    return (1ULL << exponent) + (sub + 1) * width - 1;
+}
+
+/*==============================================================================
+ * 延迟直方图操作
+ *============================================================================*/
+
+/**
+ * 清空直方图
+ */
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(latency_hist_t));
+}
+
+/**
+ * 记录一个值（多线程安全）
+ */
+void latency_hist_record(latency_hist_t *hist, uint64_t value_ns) {
+    __atomic_fetch_add(&hist->buckets[bucket_index(value_ns)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->sum_ns, value_ns, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&hist->max_ns, __ATOMIC_RELAXED);
+    while (value_ns > max &&
+           !__atomic_compare_exchange_n(&hist->max_ns, &max, value_ns, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * 记录一个以秒为单位的值
+ */
+void latency_hist_record_seconds(latency_hist_t *hist, double seconds) {
+    latency_hist_record(hist, seconds > 0 ? (uint64_t)(seconds * 1e9) : 0);
+}
+
+/**
+ * 获取直方图快照
+ */
+void latency_hist_snapshot(latency_hist_t *dst, const latency_hist_t *src) {
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        dst->buckets[i] = __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED);
+        count += dst->buckets[i];
+    }
+    dst->count = count;
+    dst->sum_ns = __atomic_load_n(&src->sum_ns, __ATOMIC_RELAXED);
+    dst->max_ns = __atomic_load_n(&src->max_ns, __ATOMIC_RELAXED);
+}
+
+/**
+ * 合并直方图
+ */
+void latency_hist_merge(latency_hist_t *dst, const latency_hist_t *src) {
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    dst->sum_ns += src->sum_ns;
+    if (src->max_ns > dst->max_ns) {
+        dst->max_ns = src->max_ns;
+    }
+}
+
+/**
+ * 查询百分位数
+ */
+uint64_t latency_hist_percentile(const latency_hist_t *hist, double percentile) {
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    if (percentile < 0) {
+        percentile = 0;
+    } else if (percentile > 100) {
+        percentile = 100;
+    }
+
+    // 目标名次向上取整，至少为第1个值
+    uint64_t rank = (uint64_t)(percentile / 100.0 * hist->count + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = bucket_upper_bound(i);
+            return bound < hist->max_ns ? bound : hist->max_ns;
+        }
+    }
+
+    return hist->max_ns;
+}
+
+/**
+ * 计算平均值
+ */
+double latency_hist_mean(const latency_hist_t *hist) {
+    return hist->count ? (double)hist->sum_ns / hist->count : 0.0;
+}
+
+/**
+ * 打印直方图摘要
+ */
+void latency_hist_print(const latency_hist_t *hist, const char *label) {
+    if (hist->count == 0) {
+        printf("%s: 无记录\n", label);
+        return;
+    }
+
+    printf("%s: 次数 %lu, 平均 %.1f us, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, 最大 %.1f us\n",
+           label, hist->count, latency_hist_mean(hist) / 1000.0,
+           latency_hist_percentile(hist, 50) / 1000.0,
+           latency_hist_percentile(hist, 99) / 1000.0,
+           latency_hist_percentile(hist, 99.9) / 1000.0,
+           hist->max_ns / 1000.0);
+}
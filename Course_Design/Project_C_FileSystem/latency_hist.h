@@ -0,0 +1,115 @@
+/**
+ * Latency Histogram Header
+ * latency_hist.h
+ *
+ * Log-bucketed (HDR-style) latency histograms used for the disk simulator
+ * and file system statistics. Values are recorded in nanoseconds. Each
+ * power of two is split into LATENCY_HIST_SUB_BUCKETS linear sub-buckets,
+ * so any reported percentile is within 1/LATENCY_HIST_SUB_BUCKETS
+ * (6.25%) of the true value while a histogram stays a fixed-size array.
+ *
+ * Recording is lock-free (atomic adds) and may be done from several
+ * threads at once. A histogram that is all zero bytes is empty, so
+ * histograms embedded in statistics structures are reset with memset().
+ */
+
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+#include <stdint.h>
+
+/*==============================================================================
+ * LATENCY HISTOGRAM CONSTANTS
+ *============================================================================*/
+
+#define LATENCY_HIST_SUB_BITS       4       // log2 of sub-buckets per power of two
+#define LATENCY_HIST_SUB_BUCKETS    (1 << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_MAX_EXPONENT   39      // Values >= 2^40 ns (~18 min) share the top bucket
+#define LATENCY_HIST_BUCKETS \
+    (LATENCY_HIST_SUB_BUCKETS * (LATENCY_HIST_MAX_EXPONENT - LATENCY_HIST_SUB_BITS + 2))
+
+/*==============================================================================
+ * DATA STRUCTURES
+ *============================================================================*/
+
+/**
+ * Latency Histogram Structure
+ *
+ * Values below LATENCY_HIST_SUB_BUCKETS ns have one bucket each; larger
+ * values are grouped by their highest set bit and the following
+ * LATENCY_HIST_SUB_BITS bits.
+ */
+typedef struct {
+    uint64_t    count;                      // Number of recorded values
+    uint64_t    sum_ns;                     // Sum of recorded values (for the mean)
+    uint64_t    max_ns;                     // Largest recorded value
+    uint64_t    buckets[LATENCY_HIST_BUCKETS]; // Value counts per bucket
+} latency_hist_t;
+
+/*==============================================================================
+ * LATENCY HISTOGRAM OPERATIONS
+ *============================================================================*/
+
+/**
+ * Empty a histogram
+ */
+void latency_hist_reset(latency_hist_t *hist);
+
+/**
+ * Record one value
+ *
+ * Safe to call from several threads concurrently.
+ *
+ * @param value_ns Latency in nanoseconds
+ */
+void latency_hist_record(latency_hist_t *hist, uint64_t value_ns);
+
+/**
+ * Record one value given in seconds
+ *
+ * Convenience wrapper for callers that time operations as doubles.
+ */
+void latency_hist_record_seconds(latency_hist_t *hist, double seconds);
+
+/**
+ * Take a consistent copy of a histogram that may be updated concurrently
+ *
+ * Each counter is read atomically; `count` is recomputed from the buckets
+ * so percentiles of the snapshot are always well defined.
+ */
+void latency_hist_snapshot(latency_hist_t *dst, const latency_hist_t *src);
+
+/**
+ * Add the values of one histogram to another
+ *
+ * Used to combine snapshots, e.g. from several disks or time intervals.
+ */
+void latency_hist_merge(latency_hist_t *dst, const latency_hist_t *src);
+
+/**
+ * Query a percentile
+ *
+ * Returns the upper bound of the bucket holding the requested rank, capped
+ * at the largest recorded value, so the result never understates latency.
+ *
+ * @param percentile Percentile in [0, 100], e.g. 50, 99 or 99.9
+ * @return Latency in nanoseconds, or 0 if the histogram is empty
+ */
+uint64_t latency_hist_percentile(const latency_hist_t *hist, double percentile);
+
+/**
+ * Mean of the recorded values in nanoseconds (0 if empty)
+ */
+double latency_hist_mean(const latency_hist_t *hist);
+
+/**
+ * Print count, mean, p50/p99/p99.9 and max on one line
+ *
+ * Reads the histogram non-atomically; print a latency_hist_snapshot() copy
+ * of a histogram that other threads may still be recording into.
+ *
+ * @param label Name printed at the start of the line
+ */
+void latency_hist_print(const latency_hist_t *hist, const char *label);
+
+#endif /* _LATENCY_HIST_H_ */
@@ -22,6 +22,7 @@
 // 全局状态
 static int shell_running = 1;
 static int system_initialized = 0;
+static const char *disk_file = DISK_FILE;  // 磁盘镜像，可带后端前缀（file:、mmap:、mem:）
 
 // 函数声明
 void show_welcome(void);
@@ -37,6 +38,8 @@ int cmd_exit(int argc, char *args[]);
 int cmd_init(int argc, char *args[]);
 int cmd_format(int argc, char *args[]);
 int cmd_status(int argc, char *args[]);
+int cmd_fstrim(int argc, char *args[]);
+int cmd_discard(int argc, char *args[]);
 
 // 用户管理命令
 int cmd_login(int argc, char *args[]);
@@ -56,6 +59,7 @@ int cmd_write(int argc, char *args[]);
 int cmd_seek(int argc, char *args[]);
 int cmd_tell(int argc, char *args[]);
 int cmd_size(int argc, char *args[]);
+int cmd_fsync(int argc, char *args[]);
 int cmd_ls(int argc, char *args[]);
 
 // 命令表结构
@@ -75,6 +79,8 @@ static const command_t commands[] = {
     {"init",     cmd_init,     "init",                    "初始化文件系统"},
     {"format",   cmd_format,   "format",                  "格式化文件系统"},
     {"status",   cmd_status,   "status",                  "显示系统状态"},
+    {"fstrim",   cmd_fstrim,   "fstrim",                  "丢弃所有空闲数据块"},
+    {"discard",  cmd_discard,  "discard <on|off>",        "设置释放块的在线丢弃"},
     
     // 用户管理命令
     {"login",    cmd_login,    "login <username> <password>", "用户登录"},
@@ -94,6 +100,7 @@ static const command_t commands[] = {
     {"seek",     cmd_seek,     "seek <fd> <offset> <whence>", "移动文件指针"},
     {"tell",     cmd_tell,     "tell <fd>",               "获取文件指针位置"},
     {"size",     cmd_size,     "size <fd>",               "获取文件大小"},
+    {"fsync",    cmd_fsync,    "fsync <fd>",              "把文件写入稳定存储"},
     {"ls",       cmd_ls,       "ls",                      "列出打开的文件"},
     
     {NULL, NULL, NULL, NULL}  // 结束标记
@@ -129,7 +136,9 @@ void show_help(void) {
             strcmp(commands[i].name, "quit") == 0 ||
             strcmp(commands[i].name, "init") == 0 ||
             strcmp(commands[i].name, "format") == 0 ||
-            strcmp(commands[i].name, "status") == 0) {
+            strcmp(commands[i].name, "status") == 0 ||
+            strcmp(commands[i].name, "fstrim") == 0 ||
+            strcmp(commands[i].name, "discard") == 0) {
             printf("  %-12s - %s\n", commands[i].usage, commands[i].description);
         }
     }
@@ -213,6 +222,7 @@ void cleanup_and_exit(void) {
     if (system_initialized) {
         printf("正在清理资源...\n");
         user_manager_logout();
+        fs_ops_unmount();
         disk_close();
     }
     printf("再见！\n");
@@ -245,7 +255,7 @@ int cmd_init(int argc, char *args[]) {
     printf("正在初始化文件系统...\n");
     
     // 初始化磁盘
-    int result = disk_init(DISK_FILE, DISK_SIZE);
+    int result = disk_init(disk_file, DISK_SIZE);
     if (result != DISK_SUCCESS) {
         printf("磁盘初始化失败: %s\n", disk_error_to_string(result));
         return -1;
@@ -324,6 +334,42 @@ int cmd_status(int argc, char *args[]) {
     return 0;
 }
 
+int cmd_fstrim(int argc, char *args[]) {
+    (void)argc; (void)args;
+    
+    if (!system_initialized) {
+        printf("文件系统未初始化\n");
+        return 0;
+    }
+    
+    uint64_t trimmed = 0;
+    fs_error_t result = fs_ops_trim(&trimmed);
+    if (result != FS_SUCCESS) {
+        printf("丢弃空闲块失败: %s\n", fs_ops_error_to_string(result));
+        return 0;
+    }
+    
+    printf("已丢弃 %lu 个空闲数据块 (%lu 字节)\n", trimmed,
+           trimmed * fs_ops_block_size());
+    return 0;
+}
+
+int cmd_discard(int argc, char *args[]) {
+    if (!system_initialized) {
+        printf("文件系统未初始化\n");
+        return 0;
+    }
+    
+    if (argc < 2 || (strcmp(args[1], "on") != 0 && strcmp(args[1], "off") != 0)) {
+        printf("用法: discard <on|off>\n");
+        return 0;
+    }
+    
+    fs_ops_set_online_discard(strcmp(args[1], "on") == 0);
+    printf("在线丢弃已%s\n", strcmp(args[1], "on") == 0 ? "开启" : "关闭");
+    return 0;
+}
+
 /*==============================================================================
  * 用户管理命令实现
  *============================================================================*/
@@ -726,6 +772,29 @@ int cmd_size(int argc, char *args[]) {
     return 0;
 }
 
+int cmd_fsync(int argc, char *args[]) {
+    if (!system_initialized) {
+        printf("请先初始化文件系统\n");
+        return 0;
+    }
+    
+    if (argc < 2) {
+        printf("用法: fsync <fd>\n");
+        return 0;
+    }
+    
+    int fd = atoi(args[1]);
+    int result = fs_fsync(fd);
+    
+    if (result == FS_SUCCESS) {
+        printf("文件已写入稳定存储\n");
+    } else {
+        printf("同步文件失败: %s\n", fs_ops_error_to_string(result));
+    }
+    
+    return 0;
+}
+
 int cmd_ls(int argc, char *args[]) {
     (void)argc; (void)args;
     
@@ -764,7 +833,10 @@ int cmd_ls(int argc, char *args[]) {
  *============================================================================*/
 
 int main(int argc, char *argv[]) {
-    (void)argc; (void)argv;  // 避免未使用参数警告
+    // 可选参数指定磁盘镜像，例如 mem:scratch.img
+    if (argc > 1) {
+        disk_file = argv[1];
+    }
     
     char input[MAX_INPUT_LENGTH];
     char *args[MAX_ARGS];
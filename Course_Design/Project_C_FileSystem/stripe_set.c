@@ -0,0 +1,389 @@
+/**
+ * Striped Block Set Implementation
+ * stripe_set.c
+ *
+ * 条带集实现 - 按条带单元把逻辑块分布到多个成员文件，每个成员一个工作线程
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // preadv()/pwritev()
+#endif
+
+#include "stripe_set.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+/**
+ * 一次stripe_set_io调用的完成计数
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        pending;        // 尚未完成的成员请求数
+} stripe_wait_t;
+
+/**
+ * 交给某个成员的连续范围读写
+ */
+typedef struct stripe_job {
+    struct stripe_job *next;        // 成员队列中的下一个请求
+    struct iovec    *iov;           // 各块缓冲区（按成员内顺序）
+    uint32_t        iovcnt;
+    uint64_t        offset;         // 成员文件内的起始偏移
+    uint8_t         is_write;
+    int             result;         // 0或-errno
+    stripe_wait_t   *wait;          // 完成后通知（调用线程自己执行时为NULL）
+} stripe_job_t;
+
+/**
+ * 成员文件及其工作线程
+ */
+typedef struct {
+    struct stripe_set *set;         // 所属条带集
+    int             fd;             // 成员文件描述符（不归条带集所有）
+    pthread_t       thread;         // 工作线程
+    pthread_mutex_t lock;           // 保护请求队列
+    pthread_cond_t  cond;           // 有新请求或要求退出
+    stripe_job_t    *head;          // 请求队列
+    stripe_job_t    *tail;
+    uint8_t         stop;           // 要求工作线程退出
+} stripe_member_t;
+
+struct stripe_set {
+    uint32_t        count;          // 成员数
+    uint32_t        stripe_blocks;  // 条带单元（块）
+    uint32_t        block_size;     // 块大小（字节）
+    uint64_t        data_offset;    // 成员文件中块数据的起始偏移
+    uint32_t        started;        // 已启动的工作线程数
+    stripe_member_t members[STRIPE_SET_MAX_MEMBERS];
+};
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 执行一个成员请求，每IOV_MAX块一次preadv/pwritev
+ */
+static int run_job(int fd, const stripe_job_t *job, uint32_t block_size) {
+    uint64_t offset = job->offset;
+
+    for (uint32_t done = 0; done < job->iovcnt; ) {
+        uint32_t n = job->iovcnt - done;
+        if (n > IOV_MAX) {
+            n = IOV_MAX;
+        }
+
+        ssize_t expected = (ssize_t)n * block_size;
+        ssize_t bytes = job->is_write ? pwritev(fd, job->iov + done, (int)n, (off_t)offset)
+                                      : preadv(fd, job->iov + done, (int)n, (off_t)offset);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (bytes != expected) {
+            return -EIO;
+        }
+
+        offset += (uint64_t)expected;
+        done += n;
+    }
+
+    return 0;
+}
+
+/**
+ * 工作线程：依次执行本成员队列中的请求
+ */
+static void *member_main(void *arg) {
+    stripe_member_t *member = (stripe_member_t *)arg;
+
+    pthread_mutex_lock(&member->lock);
+    for (;;) {
+        while (!member->head && !member->stop) {
+            pthread_cond_wait(&member->cond, &member->lock);
+        }
+        if (!member->head) {
+            break;
+        }
+
+        stripe_job_t *job = member->head;
+        member->head = job->next;
+        if (!member->head) {
+            member->tail = NULL;
+        }
+
+        pthread_mutex_unlock(&member->lock);
+        job->result = run_job(member->fd, job, member->set->block_size);
+
+        stripe_wait_t *wait = job->wait;
+        pthread_mutex_lock(&wait->lock);
+        if (--wait->pending == 0) {
+            pthread_cond_signal(&wait->cond);
+        }
+        pthread_mutex_unlock(&wait->lock);
+        pthread_mutex_lock(&member->lock);
+    }
+    pthread_mutex_unlock(&member->lock);
+
+    return NULL;
+}
+
+/**
+ * 把请求放入成员队列
+ */
+static void member_enqueue(stripe_member_t *member, stripe_job_t *job) {
+    job->next = NULL;
+
+    pthread_mutex_lock(&member->lock);
+    if (member->tail) {
+        member->tail->next = job;
+    } else {
+        member->head = job;
+    }
+    member->tail = job;
+    pthread_cond_signal(&member->cond);
+    pthread_mutex_unlock(&member->lock);
+}
+
+/*==============================================================================
+ * 条带集操作
+ *============================================================================*/
+
+/**
+ * 计算每个成员需要容纳的块数
+ */
+uint64_t stripe_set_member_blocks(uint32_t count, uint32_t stripe_blocks, uint64_t total_blocks) {
+    if (count == 0 || stripe_blocks == 0) {
+        return 0;
+    }
+
+    uint64_t units = (total_blocks + stripe_blocks - 1) / stripe_blocks;
+    return (units + count - 1) / count * stripe_blocks;
+}
+
+/**
+ * 创建条带集并启动工作线程
+ */
+stripe_set_t *stripe_set_create(const int *fds, uint32_t count, uint32_t stripe_blocks,
+                                uint32_t block_size, uint64_t data_offset) {
+    if (!fds || count == 0 || count > STRIPE_SET_MAX_MEMBERS || stripe_blocks == 0 ||
+        block_size == 0) {
+        return NULL;
+    }
+
+    stripe_set_t *set = (stripe_set_t *)calloc(1, sizeof(stripe_set_t));
+    if (!set) {
+        return NULL;
+    }
+
+    set->count = count;
+    set->stripe_blocks = stripe_blocks;
+    set->block_size = block_size;
+    set->data_offset = data_offset;
+
+    for (uint32_t i = 0; i < count; i++) {
+        stripe_member_t *member = &set->members[i];
+        member->set = set;
+        member->fd = fds[i];
+        pthread_mutex_init(&member->lock, NULL);
+        pthread_cond_init(&member->cond, NULL);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (pthread_create(&set->members[i].thread, NULL, member_main, &set->members[i]) != 0) {
+            break;
+        }
+        set->started++;
+    }
+
+    if (set->started != count) {
+        stripe_set_destroy(set);
+        return NULL;
+    }
+
+    return set;
+}
+
+/**
+ * 停止工作线程并释放条带集
+ */
+void stripe_set_destroy(stripe_set_t *set) {
+    if (!set) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < set->started; i++) {
+        stripe_member_t *member = &set->members[i];
+        pthread_mutex_lock(&member->lock);
+        member->stop = 1;
+        pthread_cond_signal(&member->cond);
+        pthread_mutex_unlock(&member->lock);
+        pthread_join(member->thread, NULL);
+    }
+
+    for (uint32_t i = 0; i < set->count; i++) {
+        pthread_cond_destroy(&set->members[i].cond);
+        pthread_mutex_destroy(&set->members[i].lock);
+    }
+
+    free(set);
+}
+
+/**
+ * 定位逻辑块所在的成员和偏移
+ */
+void stripe_set_locate(const stripe_set_t *set, uint64_t block, int *fd, uint64_t *offset,
+                       uint32_t *contiguous) {
+    uint64_t unit = block / set->stripe_blocks;
+    uint32_t within = (uint32_t)(block % set->stripe_blocks);
+    uint64_t member_block = unit / set->count * set->stripe_blocks + within;
+
+    *fd = set->members[unit % set->count].fd;
+    *offset = set->data_offset + member_block * set->block_size;
+    if (contiguous) {
+        *contiguous = set->stripe_blocks - within;
+    }
+}
+
+/**
+ * 读写一段连续逻辑块
+ *
+ * 每个成员分到的块在成员文件中是连续的，按成员收集iovec后各发一个请求；
+ * 第一个成员由调用线程执行，其余交给各自的工作线程并等待全部完成。
+ */
+int stripe_set_io(stripe_set_t *set, int is_write, uint64_t start_block, uint32_t count,
+                  char *const *blocks) {
+    if (!set || !blocks || count == 0) {
+        return -EINVAL;
+    }
+
+    struct iovec *iov = (struct iovec *)malloc((size_t)count * sizeof(struct iovec));
+    if (!iov) {
+        return -ENOMEM;
+    }
+
+    stripe_job_t jobs[STRIPE_SET_MAX_MEMBERS];
+    int member_of_job[STRIPE_SET_MAX_MEMBERS];
+    uint32_t job_count = 0;
+
+    // 第一遍统计各成员的块数，确定每个成员在iov数组中的区间
+    uint32_t per_member[STRIPE_SET_MAX_MEMBERS] = {0};
+    uint64_t first_offset[STRIPE_SET_MAX_MEMBERS];
+    for (uint32_t done = 0; done < count; ) {
+        uint64_t block = start_block + done;
+        uint32_t m = (uint32_t)(block / set->stripe_blocks % set->count);
+        uint32_t n = set->stripe_blocks - (uint32_t)(block % set->stripe_blocks);
+        if (n > count - done) {
+            n = count - done;
+        }
+        if (per_member[m] == 0) {
+            int fd;
+            stripe_set_locate(set, block, &fd, &first_offset[m], NULL);
+            member_of_job[job_count++] = (int)m;
+        }
+        per_member[m] += n;
+        done += n;
+    }
+
+    uint32_t next_slot[STRIPE_SET_MAX_MEMBERS];
+    uint32_t slot = 0;
+    for (uint32_t j = 0; j < job_count; j++) {
+        uint32_t m = (uint32_t)member_of_job[j];
+        next_slot[m] = slot;
+
+        jobs[j].iov = iov + slot;
+        jobs[j].iovcnt = per_member[m];
+        jobs[j].offset = first_offset[m];
+        jobs[j].is_write = (uint8_t)(is_write != 0);
+        jobs[j].result = 0;
+        jobs[j].wait = NULL;
+        slot += per_member[m];
+    }
+
+    // 第二遍按逻辑顺序填入缓冲区，同一成员的块保持成员内顺序
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t m = (uint32_t)((start_block + i) / set->stripe_blocks % set->count);
+        iov[next_slot[m]].iov_base = blocks[i];
+        iov[next_slot[m]].iov_len = set->block_size;
+        next_slot[m]++;
+    }
+
+    stripe_wait_t wait;
+    wait.pending = job_count - 1;
+    if (job_count > 1) {
+        pthread_mutex_init(&wait.lock, NULL);
+        pthread_cond_init(&wait.cond, NULL);
+        for (uint32_t j = 1; j < job_count; j++) {
+            jobs[j].wait = &wait;
+            member_enqueue(&set->members[member_of_job[j]], &jobs[j]);
+        }
+    }
+
+    jobs[0].result = run_job(set->members[member_of_job[0]].fd, &jobs[0], set->block_size);
+
+    if (job_count > 1) {
+        pthread_mutex_lock(&wait.lock);
+        while (wait.pending > 0) {
+            pthread_cond_wait(&wait.cond, &wait.lock);
+        }
+        pthread_mutex_unlock(&wait.lock);
+        pthread_cond_destroy(&wait.cond);
+        pthread_mutex_destroy(&wait.lock);
+    }
+
+    free(iov);
+
+    for (uint32_t j = 0; j < job_count; j++) {
+        if (jobs[j].result != 0) {
+            return jobs[j].result;
+        }
+    }
+    return (int)job_count;
+}
+
+/**
+ * 同步所有成员
+ */
+int stripe_set_sync(stripe_set_t *set, int data_only) {
+    int result = 0;
+
+    for (uint32_t i = 0; i < set->count; i++) {
+        int fd = set->members[i].fd;
+        if ((data_only ? fdatasync(fd) : fsync(fd)) != 0 && result == 0) {
+            result = -errno;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * 获取成员数
+ */
+uint32_t stripe_set_count(const stripe_set_t *set) {
+    return set->count;
+}
+
+/**
+ * 获取条带单元
+ */
+uint32_t stripe_set_stripe_blocks(const stripe_set_t *set) {
+    return set->stripe_blocks;
+}
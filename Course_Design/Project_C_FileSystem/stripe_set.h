@@ -0,0 +1,109 @@
+/**
+ * Striped Block Set Header
+ * stripe_set.h
+ *
+ * RAID-0 style striping of a block address space across several files,
+ * used by the disk simulator for images split into member files. Logical
+ * blocks are dealt out in stripe units of `stripe_blocks` blocks: unit u
+ * lives on member u % count, at unit u / count of that member. A run of
+ * consecutive logical blocks therefore maps to one contiguous range per
+ * member.
+ *
+ * Every member has its own descriptor and worker thread. stripe_set_io()
+ * hands each member its share of a run and waits for all of them, so large
+ * transfers proceed on all backing files in parallel. The set knows nothing
+ * about image headers: callers pass the byte offset at which block data
+ * starts in every member.
+ */
+
+#ifndef _STRIPE_SET_H_
+#define _STRIPE_SET_H_
+
+#include <stdint.h>
+
+/*==============================================================================
+ * STRIPE SET CONSTANTS
+ *============================================================================*/
+
+#define STRIPE_SET_MAX_MEMBERS  16          // Largest number of member files
+
+/* Set internals live in stripe_set.c */
+typedef struct stripe_set stripe_set_t;
+
+/*==============================================================================
+ * STRIPE SET OPERATIONS
+ *============================================================================*/
+
+/**
+ * Blocks each member must hold for a set of the given geometry
+ *
+ * @param count Number of members
+ * @param stripe_blocks Stripe unit in blocks
+ * @param total_blocks Logical blocks in the whole set
+ * @return Blocks per member (whole stripe units)
+ */
+uint64_t stripe_set_member_blocks(uint32_t count, uint32_t stripe_blocks, uint64_t total_blocks);
+
+/**
+ * Create a set and start one worker thread per member
+ *
+ * @param fds Open descriptors of the members, in stripe order; the set
+ *            uses but does not close them
+ * @param count Number of members (1..STRIPE_SET_MAX_MEMBERS)
+ * @param stripe_blocks Stripe unit in blocks
+ * @param block_size Block size in bytes
+ * @param data_offset Byte offset of block data in every member
+ * @return New set, or NULL on invalid geometry or if a worker could not start
+ */
+stripe_set_t* stripe_set_create(const int *fds, uint32_t count, uint32_t stripe_blocks,
+                                uint32_t block_size, uint64_t data_offset);
+
+/**
+ * Stop the workers and free the set (descriptors stay open)
+ */
+void stripe_set_destroy(stripe_set_t *set);
+
+/**
+ * Find where a logical block is stored
+ *
+ * @param block Logical block number
+ * @param fd Receives the descriptor of the member holding it
+ * @param offset Receives its byte offset in that member
+ * @param contiguous Receives how many blocks from `block` on stay in the same
+ *                   stripe unit (may be NULL)
+ */
+void stripe_set_locate(const stripe_set_t *set, uint64_t block, int *fd, uint64_t *offset,
+                       uint32_t *contiguous);
+
+/**
+ * Read or write a run of consecutive logical blocks
+ *
+ * The calling thread transfers the share of the first member involved and
+ * the workers the others, all at the same time.
+ *
+ * @param blocks blocks[i] is the one-block buffer for block start_block + i
+ * @return Number of members the run touched, or -errno on failure
+ *         (-EIO for a short transfer)
+ */
+int stripe_set_io(stripe_set_t *set, int is_write, uint64_t start_block, uint32_t count,
+                  char *const *blocks);
+
+/**
+ * Flush every member to stable storage
+ *
+ * @param data_only Use fdatasync() instead of fsync()
+ * @return 0 on success, -errno of the first failure otherwise
+ */
+int stripe_set_sync(stripe_set_t *set, int data_only);
+
+/**
+ * Number of members in the set
+ */
+uint32_t stripe_set_count(const stripe_set_t *set);
+
+/**
+ * Stripe unit of the set in blocks
+ */
+uint32_t stripe_set_stripe_blocks(const stripe_set_t *set);
+
+#endif /* _STRIPE_SET_H_ */
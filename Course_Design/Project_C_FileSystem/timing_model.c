@@ -0,0 +1,254 @@
+/**
+ * Device Timing Model Implementation
+ * timing_model.c
+ *
+ * 设备时序模型实现 - 按机械硬盘、SATA固态盘和NVMe的参数计算每次请求的服务时间
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // clock_nanosleep()
+#endif
+
+#include "timing_model.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+struct timing_model {
+    timing_profile_t profile;       // 设备类型
+    timing_params_t params;         // 时序参数（已应用带宽上限）
+    int             real_delay;     // 是否实际睡眠到完成时刻
+    uint64_t        total_blocks;   // 设备块数
+    uint32_t        block_size;     // 块大小（字节）
+    pthread_mutex_t lock;           // 保护下面的字段
+    uint64_t        head;           // 上一次请求之后的块（磁头位置）
+    uint64_t        busy_until_ns;  // 设备空闲的时刻（单调时钟，实际延迟模式）
+};
+
+/*==============================================================================
+ * 内置设备参数
+ *============================================================================*/
+
+/* 7200转机械硬盘：寻道0.5~15ms，每转8.33ms，150MB/s */
+static const timing_params_t g_hdd_params = {
+    50000, 50000, 8000000, 500000, 15000000, 8333333, 150000000ULL
+};
+
+/* SATA固态盘：读80us，写30us（写入先进设备缓存），550MB/s */
+static const timing_params_t g_sata_ssd_params = {
+    80000, 30000, 500000, 0, 0, 0, 550000000ULL
+};
+
+/* NVMe固态盘：读12us，写10us，3.2GB/s */
+static const timing_params_t g_nvme_params = {
+    12000, 10000, 50000, 0, 0, 0, 3200000000ULL
+};
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 获取单调时钟时间（纳秒）
+ */
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 整数平方根（向下取整）
+ */
+static uint64_t isqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+/**
+ * 计算寻道距离对应的定位时间（寻道加平均半圈旋转）
+ *
+ * 寻道时间随距离的平方根增长：sqrt(distance / total)按16位定点数计算。
+ */
+static uint64_t positioning_ns(const timing_model_t *model, uint64_t distance) {
+    const timing_params_t *p = &model->params;
+    uint64_t fraction = ((distance << 16) / model->total_blocks) << 16;
+    uint64_t root = isqrt(fraction);            // sqrt(distance / total) * 65536
+    uint64_t seek = p->seek_min_ns + (p->seek_max_ns - p->seek_min_ns) * root / 65536;
+
+    return seek + p->rotation_ns / 2;
+}
+
+/**
+ * 实际延迟模式下排队等待设备空闲并睡眠到完成时刻
+ *
+ * @return 从调用到完成的时间（含排队）
+ */
+static uint64_t delay_until_done(timing_model_t *model, uint64_t service_ns) {
+    uint64_t now = monotonic_ns();
+    uint64_t start = model->busy_until_ns > now ? model->busy_until_ns : now;
+    uint64_t done = start + service_ns;
+    model->busy_until_ns = done;
+    pthread_mutex_unlock(&model->lock);
+
+    struct timespec ts;
+    ts.tv_sec = (time_t)(done / 1000000000ULL);
+    ts.tv_nsec = (long)(done % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+
+    return done - now;
+}
+
+/*==============================================================================
+ * 时序模型操作
+ *============================================================================*/
+
+/**
+ * 获取内置设备参数
+ */
+int timing_profile_params(timing_profile_t profile, timing_params_t *params) {
+    const timing_params_t *src;
+
+    switch (profile) {
+        case TIMING_PROFILE_HDD:      src = &g_hdd_params; break;
+        case TIMING_PROFILE_SATA_SSD: src = &g_sata_ssd_params; break;
+        case TIMING_PROFILE_NVME:     src = &g_nvme_params; break;
+        default:                      return -1;
+    }
+
+    *params = *src;
+    return 0;
+}
+
+/**
+ * 获取设备类型名称
+ */
+const char* timing_profile_name(timing_profile_t profile) {
+    switch (profile) {
+        case TIMING_PROFILE_HDD:      return "hdd";
+        case TIMING_PROFILE_SATA_SSD: return "sata-ssd";
+        case TIMING_PROFILE_NVME:     return "nvme";
+        default:                      return "none";
+    }
+}
+
+/**
+ * 创建设备时序模型
+ */
+timing_model_t *timing_model_create(timing_profile_t profile, uint64_t bandwidth_cap,
+                                    int real_delay, uint64_t total_blocks, uint32_t block_size) {
+    timing_params_t params;
+    if (timing_profile_params(profile, &params) != 0 || total_blocks == 0 || block_size == 0) {
+        return NULL;
+    }
+
+    timing_model_t *model = (timing_model_t *)calloc(1, sizeof(timing_model_t));
+    if (!model) {
+        return NULL;
+    }
+
+    if (bandwidth_cap > 0 && bandwidth_cap < params.bytes_per_sec) {
+        params.bytes_per_sec = bandwidth_cap;
+    }
+
+    model->profile = profile;
+    model->params = params;
+    model->real_delay = real_delay ? 1 : 0;
+    model->total_blocks = total_blocks;
+    model->block_size = block_size;
+    pthread_mutex_init(&model->lock, NULL);
+
+    return model;
+}
+
+/**
+ * 释放设备时序模型
+ */
+void timing_model_destroy(timing_model_t *model) {
+    if (!model) {
+        return;
+    }
+
+    pthread_mutex_destroy(&model->lock);
+    free(model);
+}
+
+/**
+ * 为一段连续块的请求计时
+ */
+uint64_t timing_model_io(timing_model_t *model, int is_write, uint64_t start_block,
+                         uint32_t count, int *seeked) {
+    const timing_params_t *p = &model->params;
+    uint64_t bytes = (uint64_t)count * model->block_size;
+    uint64_t service = (is_write ? p->write_ns : p->read_ns) +
+                       bytes * 1000000000ULL / p->bytes_per_sec;
+    int seek = 0;
+
+    pthread_mutex_lock(&model->lock);
+    if (p->rotation_ns > 0 && start_block != model->head) {
+        uint64_t distance = start_block > model->head ? start_block - model->head
+                                                      : model->head - start_block;
+        service += positioning_ns(model, distance);
+        seek = 1;
+    }
+    model->head = start_block + count;
+
+    if (seeked) {
+        *seeked = seek;
+    }
+    if (model->real_delay) {
+        return delay_until_done(model, service);
+    }
+    pthread_mutex_unlock(&model->lock);
+
+    return service;
+}
+
+/**
+ * 为一次缓存刷新计时
+ */
+uint64_t timing_model_flush(timing_model_t *model) {
+    pthread_mutex_lock(&model->lock);
+    if (model->real_delay) {
+        return delay_until_done(model, model->params.flush_ns);
+    }
+    pthread_mutex_unlock(&model->lock);
+
+    return model->params.flush_ns;
+}
+
+/**
+ * 获取设备类型
+ */
+timing_profile_t timing_model_profile(const timing_model_t *model) {
+    return model->profile;
+}
+
+/**
+ * 是否实际延迟
+ */
+int timing_model_real_delay(const timing_model_t *model) {
+    return model->real_delay;
+}
@@ -0,0 +1,125 @@
+/**
+ * Device Timing Model Header
+ * timing_model.h
+ *
+ * Service-time model of a storage device, used by the disk simulator to
+ * make I/O on the backing file cost what it would on a real drive. Each
+ * request is charged a fixed per-command cost, a positioning cost and
+ * the transfer time of its bytes:
+ *
+ *   - HDD: seeking from the block after the previous request takes
+ *     seek_min_ns plus (seek_max_ns - seek_min_ns) * sqrt(distance /
+ *     total_blocks), followed by half a revolution of rotational latency
+ *     on average. A request that continues where the last one ended
+ *     needs neither.
+ *   - SATA SSD / NVMe: no positioning cost; only command and transfer
+ *     time, which differ between the two profiles.
+ *
+ * A bandwidth cap can lower the transfer rate of any profile. The model
+ * either really delays the caller until the modeled completion time
+ * (requests from several threads then queue behind each other as on one
+ * device) or only reports the time so that the caller can account it as
+ * virtual time.
+ */
+
+#ifndef _TIMING_MODEL_H_
+#define _TIMING_MODEL_H_
+
+#include <stdint.h>
+
+/*==============================================================================
+ * DATA STRUCTURES
+ *============================================================================*/
+
+/**
+ * Device profiles
+ */
+typedef enum {
+    TIMING_PROFILE_NONE     = 0,    // No model: I/O runs at host-file speed
+    TIMING_PROFILE_HDD      = 1,    // 7200 rpm hard disk
+    TIMING_PROFILE_SATA_SSD = 2,    // SATA flash drive
+    TIMING_PROFILE_NVME     = 3     // NVMe flash drive
+} timing_profile_t;
+
+/**
+ * Timing parameters of a profile
+ */
+typedef struct {
+    uint64_t    read_ns;            // Fixed cost of a read command
+    uint64_t    write_ns;           // Fixed cost of a write command
+    uint64_t    flush_ns;           // Cost of a cache flush (fsync)
+    uint64_t    seek_min_ns;        // Shortest seek (0 for flash)
+    uint64_t    seek_max_ns;        // Full-stroke seek
+    uint64_t    rotation_ns;        // One revolution (0 for flash)
+    uint64_t    bytes_per_sec;      // Media transfer rate
+} timing_params_t;
+
+/* Model internals live in timing_model.c */
+typedef struct timing_model timing_model_t;
+
+/*==============================================================================
+ * TIMING MODEL OPERATIONS
+ *============================================================================*/
+
+/**
+ * Get the parameters of a built-in profile
+ *
+ * @return 0 on success, -1 for TIMING_PROFILE_NONE or an unknown profile
+ */
+int timing_profile_params(timing_profile_t profile, timing_params_t *params);
+
+/**
+ * Short name of a profile ("hdd", "sata-ssd", "nvme" or "none")
+ */
+const char* timing_profile_name(timing_profile_t profile);
+
+/**
+ * Create a model of one device
+ *
+ * @param profile Built-in profile to use
+ * @param bandwidth_cap Upper limit on the transfer rate in bytes per
+ *                      second (0 keeps the profile's rate)
+ * @param real_delay Nonzero to sleep until each modeled completion
+ * @param total_blocks Device size in blocks (scales HDD seek distances)
+ * @param block_size Block size in bytes
+ * @return New model, or NULL for an invalid profile or on allocation failure
+ */
+timing_model_t* timing_model_create(timing_profile_t profile, uint64_t bandwidth_cap,
+                                    int real_delay, uint64_t total_blocks, uint32_t block_size);
+
+/**
+ * Free a model
+ */
+void timing_model_destroy(timing_model_t *model);
+
+/**
+ * Charge one request for a run of consecutive blocks
+ *
+ * Moves the modeled head to the block after the run. In real-delay mode
+ * the call returns at the modeled completion time, which includes waiting
+ * for requests of other threads that the device is still busy with.
+ *
+ * @param seeked Receives 1 if the request needed a head seek (may be NULL)
+ * @return Modeled latency of the request in nanoseconds
+ */
+uint64_t timing_model_io(timing_model_t *model, int is_write, uint64_t start_block,
+                         uint32_t count, int *seeked);
+
+/**
+ * Charge one cache flush
+ *
+ * @return Modeled latency of the flush in nanoseconds
+ */
+uint64_t timing_model_flush(timing_model_t *model);
+
+/**
+ * Profile the model was created with
+ */
+timing_profile_t timing_model_profile(const timing_model_t *model);
+
+/**
+ * Whether the model really delays callers (1) or only reports time (0)
+ */
+int timing_model_real_delay(const timing_model_t *model);
+
+#endif /* _TIMING_MODEL_H_ */
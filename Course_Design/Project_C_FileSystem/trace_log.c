@@ -0,0 +1,204 @@
+/**
+ * I/O Trace Log Implementation
+ * trace_log.c
+ *
+ * I/O跟踪记录实现 - 记录缓冲在内存中，缓冲区满或关闭时追加到跟踪文件
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                     // clock_gettime()
+#endif
+
+#include "trace_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+/*==============================================================================
+ * 内部数据结构
+ *============================================================================*/
+
+struct trace_log {
+    FILE            *file;          // 跟踪文件
+    uint64_t        base_ns;        // 跟踪开始时的单调时钟时间
+    uint64_t        count;          // 已记录的条数
+    int             error;          // 第一次追加失败的错误码
+    uint32_t        buffered;       // 缓冲区中的条数
+    pthread_mutex_t lock;           // 保护缓冲区和文件
+    trace_record_t  buffer[TRACE_LOG_BUFFER_RECORDS];
+};
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 获取时钟时间（纳秒）
+ */
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 把缓冲区中的记录追加到文件（调用方持有锁）
+ */
+static void flush_buffer(trace_log_t *log) {
+    if (log->buffered > 0 && log->error == 0 &&
+        fwrite(log->buffer, sizeof(trace_record_t), log->buffered, log->file) != log->buffered) {
+        log->error = errno ? -errno : -EIO;
+    }
+    log->buffered = 0;
+}
+
+/*==============================================================================
+ * 跟踪记录操作
+ *============================================================================*/
+
+/**
+ * 创建跟踪文件
+ */
+int trace_log_open(const char *path, uint32_t block_size, uint64_t total_blocks,
+                   trace_log_t **log) {
+    if (!path || !log) {
+        return -EINVAL;
+    }
+
+    trace_log_t *tl = (trace_log_t *)calloc(1, sizeof(trace_log_t));
+    if (!tl) {
+        return -ENOMEM;
+    }
+
+    tl->file = fopen(path, "wb");
+    if (!tl->file) {
+        int result = -errno;
+        free(tl);
+        return result;
+    }
+
+    trace_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TRACE_LOG_MAGIC;
+    header.version = TRACE_LOG_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    header.block_size = block_size;
+    header.total_blocks = total_blocks;
+    header.start_time_ns = clock_ns(CLOCK_REALTIME);
+    if (fwrite(&header, sizeof(header), 1, tl->file) != 1) {
+        int result = errno ? -errno : -EIO;
+        fclose(tl->file);
+        free(tl);
+        return result;
+    }
+
+    pthread_mutex_init(&tl->lock, NULL);
+    tl->base_ns = clock_ns(CLOCK_MONOTONIC);
+    *log = tl;
+    return 0;
+}
+
+/**
+ * 追加一条记录
+ */
+void trace_log_record(trace_log_t *log, int op, uint64_t block, uint32_t count,
+                      uint64_t issue_ns, uint64_t latency_ns, int result) {
+    trace_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp_ns = issue_ns > log->base_ns ? issue_ns - log->base_ns : 0;
+    record.block = block;
+    record.count = count;
+    record.latency_ns = latency_ns > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_ns;
+    record.op = (uint8_t)op;
+    record.result = (int8_t)result;
+
+    pthread_mutex_lock(&log->lock);
+    log->buffer[log->buffered++] = record;
+    log->count++;
+    if (log->buffered == TRACE_LOG_BUFFER_RECORDS) {
+        flush_buffer(log);
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+/**
+ * 获取已记录的条数
+ */
+uint64_t trace_log_count(trace_log_t *log) {
+    pthread_mutex_lock(&log->lock);
+    uint64_t count = log->count;
+    pthread_mutex_unlock(&log->lock);
+    return count;
+}
+
+/**
+ * 写出剩余记录并关闭跟踪文件
+ */
+int trace_log_close(trace_log_t *log) {
+    if (!log) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    flush_buffer(log);
+    pthread_mutex_unlock(&log->lock);
+
+    int result = log->error;
+    if (fclose(log->file) != 0 && result == 0) {
+        result = -errno;
+    }
+    pthread_mutex_destroy(&log->lock);
+    free(log);
+    return result;
+}
+
+/**
+ * 读入整个跟踪文件
+ */
+int trace_log_load(const char *path, trace_file_header_t *header, trace_record_t **records,
+                   size_t *count) {
+    if (!path || !header || !records || !count) {
+        return -EINVAL;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return -errno;
+    }
+
+    int result = 0;
+    if (fread(header, sizeof(*header), 1, file) != 1 || header->magic != TRACE_LOG_MAGIC ||
+        header->version != TRACE_LOG_VERSION || header->record_size != sizeof(trace_record_t)) {
+        result = -EBADMSG;
+    }
+
+    // 记录数由文件大小决定（最后一条不完整时忽略）
+    long size = 0;
+    if (result == 0 && (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 ||
+                        fseek(file, (long)sizeof(*header), SEEK_SET) != 0)) {
+        result = -EIO;
+    }
+
+    size_t n = 0;
+    trace_record_t *array = NULL;
+    if (result == 0) {
+        n = ((size_t)size - sizeof(*header)) / sizeof(trace_record_t);
+        array = (trace_record_t *)malloc(n > 0 ? n * sizeof(trace_record_t) : 1);
+        if (!array) {
+            result = -ENOMEM;
+        } else if (fread(array, sizeof(trace_record_t), n, file) != n) {
+            free(array);
+            result = -EIO;
+        }
+    }
+    fclose(file);
+
+    if (result == 0) {
+        *records = array;
+        *count = n;
+    }
+    return result;
+}
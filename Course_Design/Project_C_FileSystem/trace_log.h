@@ -0,0 +1,117 @@
+/**
+ * I/O Trace Log Header
+ * trace_log.h
+ *
+ * Compact binary traces of the block I/O issued against a disk. A trace
+ * file is a trace_file_header_t followed by fixed-size trace_record_t
+ * entries, one per disk_read_block()/disk_write_block()/disk_read_blocks()/
+ * disk_write_blocks()/disk_sync() call, in completion order. Records are
+ * collected in an in-memory buffer and appended to the file whenever the
+ * buffer fills, so recording costs a mutex and a copy per call.
+ *
+ * disk_replay re-issues a trace against any disk configuration, either as
+ * fast as possible or at the original issue times.
+ */
+
+#ifndef _TRACE_LOG_H_
+#define _TRACE_LOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============================================================================
+ * TRACE LOG CONSTANTS
+ *============================================================================*/
+
+#define TRACE_LOG_MAGIC         0x43525444  // "DTRC" - Trace file magic number
+#define TRACE_LOG_VERSION       2           // Trace file format version (2 = 64-bit block numbers)
+#define TRACE_LOG_BUFFER_RECORDS 4096       // Records buffered before each file append
+
+/* trace_record_t.op */
+#define TRACE_OP_READ           1           // Read of `count` blocks from `block`
+#define TRACE_OP_WRITE          2           // Write of `count` blocks from `block`
+#define TRACE_OP_SYNC           3           // disk_sync() (count 0) or disk_sync_range() of `count` blocks
+
+/* Recorder internals live in trace_log.c */
+typedef struct trace_log trace_log_t;
+
+/*==============================================================================
+ * DATA STRUCTURES
+ *============================================================================*/
+
+/**
+ * Trace File Header (32 bytes, at offset 0)
+ */
+typedef struct {
+    uint32_t    magic;              // TRACE_LOG_MAGIC
+    uint16_t    version;            // TRACE_LOG_VERSION
+    uint16_t    record_size;        // sizeof(trace_record_t)
+    uint32_t    block_size;         // Block size of the traced disk
+    uint32_t    reserved;
+    uint64_t    total_blocks;       // Block count of the traced disk
+    uint64_t    start_time_ns;      // Wall-clock time the trace started (ns since the epoch)
+} trace_file_header_t;
+
+/**
+ * Trace Record (32 bytes)
+ */
+typedef struct {
+    uint64_t    timestamp_ns;       // Issue time relative to the start of the trace
+    uint64_t    block;              // First block
+    uint32_t    count;              // Blocks transferred
+    uint32_t    latency_ns;         // Call latency (saturates at UINT32_MAX, ~4.3 s)
+    uint8_t     op;                 // TRACE_OP_*
+    int8_t      result;             // DISK_SUCCESS or the DISK_ERROR_* code returned
+    uint8_t     reserved[6];
+} trace_record_t;
+
+/*==============================================================================
+ * TRACE LOG OPERATIONS
+ *============================================================================*/
+
+/**
+ * Create a trace file and start a recorder for it
+ *
+ * @param path Trace file to create (replaced if it exists)
+ * @param block_size Block size of the traced disk
+ * @param total_blocks Block count of the traced disk
+ * @param log Receives the new recorder
+ * @return 0 on success, -errno on failure
+ */
+int trace_log_open(const char *path, uint32_t block_size, uint64_t total_blocks,
+                   trace_log_t **log);
+
+/**
+ * Append one record (thread-safe)
+ *
+ * @param issue_ns CLOCK_MONOTONIC time the call was issued
+ * @param latency_ns Call latency
+ */
+void trace_log_record(trace_log_t *log, int op, uint64_t block, uint32_t count,
+                      uint64_t issue_ns, uint64_t latency_ns, int result);
+
+/**
+ * Number of records appended so far
+ */
+uint64_t trace_log_count(trace_log_t *log);
+
+/**
+ * Write out buffered records, close the file and free the recorder
+ *
+ * @return 0 on success, -errno if any append failed
+ */
+int trace_log_close(trace_log_t *log);
+
+/**
+ * Load a whole trace file
+ *
+ * @param path Trace file
+ * @param header Receives the file header
+ * @param records Receives a malloc()ed array of the records (free() it)
+ * @param count Receives the record count
+ * @return 0 on success, -EBADMSG for a file that is not a trace, other -errno on failure
+ */
+int trace_log_load(const char *path, trace_file_header_t *header, trace_record_t **records,
+                   size_t *count);
+
+#endif /* _TRACE_LOG_H_ */
@@ -0,0 +1,155 @@
+/**
+ * Zero Detection Implementation
+ * zero_detect.c
+ *
+ * 全零缓冲区检测 - x86-64上用SSE2/AVX2按64字节或运算归约，否则按64位字检查
+ */
+
+#include "zero_detect.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ZERO_HAVE_SIMD 1
+#include <immintrin.h>
+#else
+#define ZERO_HAVE_SIMD 0
+#endif
+
+#define ZERO_CHUNK 64               // 向量实现每次检查的字节数
+
+/*==============================================================================
+ * 全局变量
+ *============================================================================*/
+
+static int g_use_avx2 = 0;
+static pthread_once_t g_zero_once = PTHREAD_ONCE_INIT;
+
+/*==============================================================================
+ * 内部辅助函数
+ *============================================================================*/
+
+/**
+ * 选择实现（SSE2是x86-64的基线指令集，只需检测AVX2）
+ */
+static void zero_detect_init(void) {
+#if ZERO_HAVE_SIMD
+    __builtin_cpu_init();
+    g_use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+/**
+ * 按64位字检查，开头和结尾不足一个字的部分逐字节检查
+ */
+static int zero_word(const unsigned char *p, size_t len) {
+    while (len > 0 && ((uintptr_t)p & 7) != 0) {
+        if (*p++) {
+            return 0;
+        }
+        len--;
+    }
+
+    while (len >= 32) {
+        uint64_t w[4];
+        memcpy(w, p, sizeof(w));
+        if (w[0] | w[1] | w[2] | w[3]) {
+            return 0;
+        }
+        p += 32;
+        len -= 32;
+    }
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        if (w) {
+            return 0;
+        }
+        p += 8;
+        len -= 8;
+    }
+
+    while (len--) {
+        if (*p++) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#if ZERO_HAVE_SIMD
+/**
+ * SSE2实现，4个16字节向量或在一起后与零比较
+ */
+static int zero_sse2(const unsigned char *p, size_t len) {
+    const __m128i zero = _mm_setzero_si128();
+    while (len >= ZERO_CHUNK) {
+        __m128i v = _mm_or_si128(
+            _mm_or_si128(_mm_loadu_si128((const __m128i *)p),
+                         _mm_loadu_si128((const __m128i *)(p + 16))),
+            _mm_or_si128(_mm_loadu_si128((const __m128i *)(p + 32)),
+                         _mm_loadu_si128((const __m128i *)(p + 48))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) {
+            return 0;
+        }
+        p += ZERO_CHUNK;
+        len -= ZERO_CHUNK;
+    }
+    return zero_word(p, len);
+}
+
+/**
+ * AVX2实现，2个32字节向量或在一起后用vptest检查
+ */
+__attribute__((target("avx2")))
+static int zero_avx2(const unsigned char *p, size_t len) {
+    while (len >= ZERO_CHUNK) {
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)p),
+                                    _mm256_loadu_si256((const __m256i *)(p + 32)));
+        if (!_mm256_testz_si256(v, v)) {
+            return 0;
+        }
+        p += ZERO_CHUNK;
+        len -= ZERO_CHUNK;
+    }
+    return zero_word(p, len);
+}
+#endif
+
+/*==============================================================================
+ * 全零检测操作
+ *============================================================================*/
+
+/**
+ * 检查缓冲区是否全为零
+ */
+int buffer_is_zero(const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+#if ZERO_HAVE_SIMD
+    pthread_once(&g_zero_once, zero_detect_init);
+
+    // 先看首个字，非零数据块通常在这里就能判定
+    if (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        if (w) {
+            return 0;
+        }
+    }
+    if (g_use_avx2) {
+        return zero_avx2(p, len);
+    }
+    return zero_sse2(p, len);
+#else
+    return zero_word(p, len);
+#endif
+}
+
+/**
+ * 获取当前使用的实现名称
+ */
+const char* zero_detect_implementation(void) {
+    pthread_once(&g_zero_once, zero_detect_init);
+    return g_use_avx2 ? "avx2" : (ZERO_HAVE_SIMD ? "sse2" : "word");
+}
@@ -0,0 +1,37 @@
+/**
+ * Zero Detection Header
+ * zero_detect.h
+ *
+ * Fast check for all-zero buffers, used on the block write path to turn
+ * writes of zero blocks into holes. On x86-64 the buffer is OR-reduced
+ * 64 bytes at a time with SSE2 (or AVX2 when the CPU supports it) and the
+ * scan stops at the first non-zero chunk, so ordinary data blocks cost
+ * only a few loads. Other hosts use a 64-bit word loop.
+ */
+
+#ifndef _ZERO_DETECT_H_
+#define _ZERO_DETECT_H_
+
+#include <stddef.h>
+
+/*==============================================================================
+ * ZERO DETECTION OPERATIONS
+ *============================================================================*/
+
+/**
+ * Check whether a buffer contains only zero bytes
+ *
+ * @param data Buffer to check (any alignment)
+ * @param len Length of the buffer in bytes
+ * @return 1 if every byte is zero (or len is 0), 0 otherwise
+ */
+int buffer_is_zero(const void *data, size_t len);
+
+/**
+ * Name of the implementation selected for this CPU
+ *
+ * @return "avx2", "sse2" or "word"
+ */
+const char* zero_detect_implementation(void);
+
+#endif /* _ZERO_DETECT_H_ */